@@ -0,0 +1,1029 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This program measures the performance of a set of representative simulations on each
+ * Platform.  Unlike examples/benchmark.py, it does not depend on the Python application
+ * layer, so the Systems are built directly through the C++ API:
+ *
+ * <ul>
+ * <li>water-pme: a box of rigid TIP3P water with PME</li>
+ * <li>dhfr-pme: a solvated protein with the size and composition of the DHFR benchmark,
+ * using harmonic bonds and angles, periodic torsions, and PME</li>
+ * <li>large-protein: a solvated protein with 60,000 atoms.  Most of its exclusions come from
+ * the protein, so it shows how much memory the exclusions take and how long it takes to build
+ * the neighbor list</li>
+ * <li>gbsa: the same protein as dhfr-pme in implicit solvent with GBSAOBCForce</li>
+ * <li>custom-nonbonded: a water box whose nonbonded interactions are computed by a
+ * CustomNonbondedForce using reaction field electrostatics</li>
+ * <li>amoeba-pme: a box of AMOEBA water with mutual polarization (only if the AMOEBA plugin
+ * was built)</li>
+ * <li>amoeba-protein: the dhfr-pme protein and solvent with AMOEBA multipoles, mutual
+ * polarization, and vdW (only if the AMOEBA plugin was built)</li>
+ * <li>rpmd-water: a box of flexible water simulated with RPMDIntegrator.  It is run once for
+ * each number of copies given by --copies, so the results show how throughput scales with the
+ * number of beads (only if the RPMD plugin was built)</li>
+ * </ul>
+ *
+ * For every combination of test, Platform, and thread count, it reports the simulation speed
+ * in ns/day, the time spent in each kernel, the memory used by the Context, and how long it
+ * takes to create the Context, serialize the System, and write and load checkpoints.  Checkpoints
+ * are measured both with Context::createCheckpoint() and in the portable format written by
+ * CheckpointWriter, with and without compression, for both keyframes and deltas.  With
+ * --format=json, each result is written as one JSON object per line so that results can be
+ * collected and compared automatically.  Run it with --help to see all options.
+ */
+
+#include "OpenMM.h"
+#include "openmm/serialization/BinarySerializer.h"
+#include "openmm/serialization/CheckpointReader.h"
+#include "openmm/serialization/CheckpointWriter.h"
+#include "openmm/serialization/XmlSerializer.h"
+#include "openmm/internal/timer.h"
+#ifdef BENCHMARK_AMOEBA
+#include "OpenMMAmoeba.h"
+#endif
+#ifdef BENCHMARK_RPMD
+#include "openmm/RPMDIntegrator.h"
+#endif
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#endif
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Get the memory used by this process in MB.  If peak is true, this is the largest amount
+ * it has used at any time.  Otherwise, it is the amount currently in use.
+ */
+static double getMemoryUsage(bool peak) {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0.0;
+    return (peak ? counters.PeakWorkingSetSize : counters.WorkingSetSize)/1048576.0;
+#elif defined(__APPLE__)
+    if (peak) {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss/1048576.0;
+    }
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) != KERN_SUCCESS)
+        return 0.0;
+    return info.resident_size/1048576.0;
+#else
+    ifstream status("/proc/self/status");
+    string line;
+    string key = (peak ? "VmHWM:" : "VmRSS:");
+    while (getline(status, line))
+        if (line.compare(0, key.size(), key) == 0)
+            return atof(line.c_str()+key.size())/1024.0;
+    return 0.0;
+#endif
+}
+
+/**
+ * A System together with the information needed to simulate it.
+ */
+struct BenchmarkSystem {
+    BenchmarkSystem() : useRpmd(false) {
+    }
+    System system;
+    vector<Vec3> positions;
+    double stepSize;
+    bool useLangevin, useRpmd;
+};
+
+/**
+ * Add rigid TIP3P waters on a cubic lattice filling a periodic box, skipping any site closer
+ * than 0.3 nm to an existing particle.  The waters all start with the same orientation, which
+ * keeps them well separated without needing to minimize the energy first.
+ */
+static void addWaterBox(BenchmarkSystem& bench, NonbondedForce* nonbonded, double boxSize) {
+    const double spacing = 0.3107;
+    const double minDistance = 0.3;
+    int gridSize = (int) floor(boxSize/spacing);
+    double cellSize = boxSize/gridSize;
+
+    // Record which lattice sites are too close to solute atoms.
+
+    int cellsPerSide = max(1, (int) floor(boxSize/minDistance));
+    double exclusionCellSize = boxSize/cellsPerSide;
+    vector<vector<Vec3> > cells(cellsPerSide*cellsPerSide*cellsPerSide);
+    auto cellIndex = [&] (int x, int y, int z) {
+        x = (x%cellsPerSide+cellsPerSide)%cellsPerSide;
+        y = (y%cellsPerSide+cellsPerSide)%cellsPerSide;
+        z = (z%cellsPerSide+cellsPerSide)%cellsPerSide;
+        return x+cellsPerSide*(y+cellsPerSide*z);
+    };
+    for (const Vec3& pos : bench.positions)
+        cells[cellIndex((int) floor(pos[0]/exclusionCellSize), (int) floor(pos[1]/exclusionCellSize), (int) floor(pos[2]/exclusionCellSize))].push_back(pos);
+    auto isBlocked = [&] (Vec3 pos) {
+        int cx = (int) floor(pos[0]/exclusionCellSize), cy = (int) floor(pos[1]/exclusionCellSize), cz = (int) floor(pos[2]/exclusionCellSize);
+        for (int dx = -1; dx <= 1; dx++)
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dz = -1; dz <= 1; dz++)
+                    for (const Vec3& other : cells[cellIndex(cx+dx, cy+dy, cz+dz)]) {
+                        Vec3 delta = pos-other;
+                        for (int i = 0; i < 3; i++)
+                            delta[i] -= boxSize*round(delta[i]/boxSize);
+                        if (delta.dot(delta) < minDistance*minDistance)
+                            return true;
+                    }
+        return false;
+    };
+
+    // Add the waters.
+
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++) {
+                Vec3 pos((i+0.5)*cellSize, (j+0.5)*cellSize, (k+0.5)*cellSize);
+                if (isBlocked(pos))
+                    continue;
+                int oxygen = bench.system.addParticle(15.999);
+                bench.system.addParticle(1.008);
+                bench.system.addParticle(1.008);
+                nonbonded->addParticle(-0.834, 0.315061, 0.636386);
+                nonbonded->addParticle(0.417, 1.0, 0.0);
+                nonbonded->addParticle(0.417, 1.0, 0.0);
+                nonbonded->addException(oxygen, oxygen+1, 0.0, 1.0, 0.0);
+                nonbonded->addException(oxygen, oxygen+2, 0.0, 1.0, 0.0);
+                nonbonded->addException(oxygen+1, oxygen+2, 0.0, 1.0, 0.0);
+                bench.system.addConstraint(oxygen, oxygen+1, 0.09572);
+                bench.system.addConstraint(oxygen, oxygen+2, 0.09572);
+                bench.system.addConstraint(oxygen+1, oxygen+2, 0.15139);
+                bench.positions.push_back(pos);
+                bench.positions.push_back(pos+Vec3(0.075695, 0.0, 0.058588));
+                bench.positions.push_back(pos+Vec3(-0.075695, 0.0, 0.058588));
+            }
+}
+
+/**
+ * Add a protein-like chain of atoms.  The chain follows a serpentine path through a cubic
+ * lattice centered at the specified position, so that it fills space at roughly the density
+ * of a folded protein.  Equilibrium lengths and angles are taken from the starting geometry,
+ * torsions are only added where the chain turns, and charges alternate to keep it neutral.
+ */
+static void addProtein(BenchmarkSystem& bench, NonbondedForce* nonbonded, int numAtoms, Vec3 center) {
+    const double spacing = 0.25;
+    int latticeSize = (int) ceil(pow((double) numAtoms, 1.0/3.0)-1e-6);
+    Vec3 origin = center-Vec3(1, 1, 1)*(0.5*spacing*(latticeSize-1));
+    int firstAtom = bench.system.getNumParticles();
+    vector<Vec3> chain;
+    for (int z = 0; z < latticeSize && (int) chain.size() < numAtoms; z++)
+        for (int yy = 0; yy < latticeSize && (int) chain.size() < numAtoms; yy++) {
+            int y = (z%2 == 0 ? yy : latticeSize-1-yy);
+            for (int xx = 0; xx < latticeSize && (int) chain.size() < numAtoms; xx++) {
+                int x = ((z*latticeSize+yy)%2 == 0 ? xx : latticeSize-1-xx);
+
+                // Offset the positions slightly so no angle is exactly 180 degrees.
+
+                Vec3 offset(0.01*((x+2*y+3*z)%3-1), 0.01*((2*x+y+z)%3-1), 0.01*((x+y+2*z)%3-1));
+                chain.push_back(origin+Vec3(x, y, z)*spacing+offset);
+            }
+        }
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    PeriodicTorsionForce* torsions = new PeriodicTorsionForce();
+    vector<pair<int, int> > bondPairs;
+    vector<double> angleValues(numAtoms, 3.14159265358979);
+    for (int i = 0; i < numAtoms; i++) {
+        bench.system.addParticle(i%4 == 0 ? 14.007 : 12.011);
+        nonbonded->addParticle(i%2 == 0 ? 0.15 : -0.15, 0.25, 0.3);
+        bench.positions.push_back(chain[i]);
+        if (i > 0) {
+            Vec3 delta = chain[i]-chain[i-1];
+            bonds->addBond(firstAtom+i-1, firstAtom+i, sqrt(delta.dot(delta)), 250000.0);
+            bondPairs.push_back(make_pair(firstAtom+i-1, firstAtom+i));
+        }
+        if (i > 1) {
+            Vec3 v1 = chain[i-2]-chain[i-1];
+            Vec3 v2 = chain[i]-chain[i-1];
+            angleValues[i-1] = acos(max(-1.0, min(1.0, v1.dot(v2)/sqrt(v1.dot(v1)*v2.dot(v2)))));
+            angles->addAngle(firstAtom+i-2, firstAtom+i-1, firstAtom+i, angleValues[i-1], 400.0);
+        }
+        if (i > 2 && angleValues[i-2] < 2.5 && angleValues[i-1] < 2.5)
+            torsions->addTorsion(firstAtom+i-3, firstAtom+i-2, firstAtom+i-1, firstAtom+i, 3, 0.0, 0.6);
+    }
+    nonbonded->createExceptionsFromBonds(bondPairs, 0.8333, 0.5);
+    bench.system.addForce(bonds);
+    bench.system.addForce(angles);
+    bench.system.addForce(torsions);
+}
+
+/**
+ * Set the periodic box for a test.  The volume is scaled by the --scale option, but the box
+ * is never allowed to become too small for the cutoff.
+ */
+static double setBox(System& system, double size, double scale, double cutoff) {
+    double boxSize = max(size*cbrt(scale), 2*cutoff+0.2);
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    return boxSize;
+}
+
+static BenchmarkSystem* createWaterPme(double scale) {
+    BenchmarkSystem* bench = new BenchmarkSystem();
+    double boxSize = setBox(bench->system, 5.0, scale, 0.9);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(0.9);
+    addWaterBox(*bench, nonbonded, boxSize);
+    bench->system.addForce(nonbonded);
+    bench->stepSize = 0.002;
+    bench->useLangevin = true;
+    return bench;
+}
+
+static BenchmarkSystem* createDhfrPme(double scale) {
+    // DHFR has 2489 protein atoms in a 23558 atom solvated system.
+
+    BenchmarkSystem* bench = new BenchmarkSystem();
+    double boxSize = setBox(bench->system, 6.2, scale, 0.9);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(0.9);
+    addProtein(*bench, nonbonded, (int) (2489*scale), Vec3(0.5, 0.5, 0.5)*boxSize);
+    addWaterBox(*bench, nonbonded, boxSize);
+    bench->system.addForce(nonbonded);
+    bench->stepSize = 0.002;
+    bench->useLangevin = true;
+    return bench;
+}
+
+static BenchmarkSystem* createLargeProtein(double scale) {
+    // The protein fills most of the box, with only a thin layer of water around it.
+
+    BenchmarkSystem* bench = new BenchmarkSystem();
+    double boxSize = setBox(bench->system, 11.0, scale, 0.9);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(0.9);
+    addProtein(*bench, nonbonded, (int) (60000*scale), Vec3(0.5, 0.5, 0.5)*boxSize);
+    addWaterBox(*bench, nonbonded, boxSize);
+    bench->system.addForce(nonbonded);
+    bench->stepSize = 0.002;
+    bench->useLangevin = true;
+    return bench;
+}
+
+static BenchmarkSystem* createGbsa(double scale) {
+    BenchmarkSystem* bench = new BenchmarkSystem();
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffNonPeriodic);
+    nonbonded->setCutoffDistance(2.0);
+    addProtein(*bench, nonbonded, (int) (2489*scale), Vec3());
+    bench->system.addForce(nonbonded);
+    GBSAOBCForce* gb = new GBSAOBCForce();
+    gb->setNonbondedMethod(GBSAOBCForce::CutoffNonPeriodic);
+    gb->setCutoffDistance(2.0);
+    for (int i = 0; i < nonbonded->getNumParticles(); i++) {
+        double charge, sigma, epsilon;
+        nonbonded->getParticleParameters(i, charge, sigma, epsilon);
+        gb->addParticle(charge, 0.155, 0.8);
+    }
+    bench->system.addForce(gb);
+    bench->stepSize = 0.002;
+    bench->useLangevin = true;
+    return bench;
+}
+
+static BenchmarkSystem* createCustomNonbonded(double scale) {
+    // Build a water box, then move the nonbonded interactions into a CustomNonbondedForce.
+
+    BenchmarkSystem* bench = new BenchmarkSystem();
+    double boxSize = setBox(bench->system, 4.0, scale, 1.0);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    addWaterBox(*bench, nonbonded, boxSize);
+    const double cutoff = 1.0;
+    const double dielectric = 78.3;
+    double krf = (1.0/(cutoff*cutoff*cutoff))*(dielectric-1.0)/(2.0*dielectric+1.0);
+    double crf = (1.0/cutoff)*(3.0*dielectric)/(2.0*dielectric+1.0);
+    stringstream expression;
+    expression << "4*eps*((sig/r)^12-(sig/r)^6)+138.935456*q*(1/r+" << krf << "*r*r-" << crf << ");";
+    expression << "sig=0.5*(sigma1+sigma2); eps=sqrt(epsilon1*epsilon2); q=charge1*charge2";
+    CustomNonbondedForce* custom = new CustomNonbondedForce(expression.str());
+    custom->addPerParticleParameter("charge");
+    custom->addPerParticleParameter("sigma");
+    custom->addPerParticleParameter("epsilon");
+    custom->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    custom->setCutoffDistance(cutoff);
+    for (int i = 0; i < nonbonded->getNumParticles(); i++) {
+        double charge, sigma, epsilon;
+        nonbonded->getParticleParameters(i, charge, sigma, epsilon);
+        custom->addParticle({charge, sigma, epsilon});
+    }
+    for (int i = 0; i < nonbonded->getNumExceptions(); i++) {
+        int p1, p2;
+        double chargeProd, sigma, epsilon;
+        nonbonded->getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+        custom->addExclusion(p1, p2);
+    }
+    delete nonbonded;
+    bench->system.addForce(custom);
+    bench->stepSize = 0.002;
+    bench->useLangevin = true;
+    return bench;
+}
+
+#ifdef BENCHMARK_AMOEBA
+/**
+ * Replace the forces of a system built from addProtein() and addWaterBox() with AMOEBA forces:
+ * PME multipoles with mutual polarization and a buffered 14-7 vdW interaction.  The waters
+ * get AMOEBA water parameters.  The protein atoms get their point charges plus a generic
+ * polarizability, with covalent scaling along the chain.
+ */
+static void addAmoebaForces(BenchmarkSystem& bench, int numProteinAtoms) {
+    AmoebaMultipoleForce* multipoles = new AmoebaMultipoleForce();
+    multipoles->setNonbondedMethod(AmoebaMultipoleForce::PME);
+    multipoles->setPolarizationType(AmoebaMultipoleForce::Mutual);
+    multipoles->setCutoffDistance(0.7);
+    multipoles->setMutualInducedTargetEpsilon(1e-5);
+    multipoles->setEwaldErrorTolerance(5e-4);
+    AmoebaVdwForce* vdw = new AmoebaVdwForce();
+    vdw->setNonbondedMethod(AmoebaVdwForce::CutoffPeriodic);
+    vdw->setCutoffDistance(0.9);
+    vector<double> zeroDipole(3, 0.0);
+    vector<double> zeroQuadrupole(9, 0.0);
+    const double proteinPolarity = 1.0e-3;
+
+    // The protein atoms sit on a 0.25 nm lattice, so give them the same minimum energy distance
+    // as the Lennard-Jones sigma used for them in dhfr-pme (0.25*2^(1/6) nm).  AmoebaVdwForce
+    // takes the radius, which is half of that.
+
+    const double proteinVdwRadius = 0.14;
+    for (int i = 0; i < numProteinAtoms; i++) {
+        multipoles->addMultipole(i%2 == 0 ? 0.15 : -0.15, zeroDipole, zeroQuadrupole, AmoebaMultipoleForce::NoAxisType, -1, -1, -1, 0.39, pow(proteinPolarity, 1.0/6.0), proteinPolarity);
+        vector<int> exclusions;
+        for (int separation = 1; separation < 4; separation++) {
+            vector<int> covalent;
+            if (i-separation >= 0)
+                covalent.push_back(i-separation);
+            if (i+separation < numProteinAtoms)
+                covalent.push_back(i+separation);
+            multipoles->setCovalentMap(i, (AmoebaMultipoleForce::CovalentType) (AmoebaMultipoleForce::Covalent12+separation-1), covalent);
+        }
+        for (int j = max(0, i-2); j <= min(numProteinAtoms-1, i+2); j++)
+            exclusions.push_back(j);
+        vdw->addParticle(i, proteinVdwRadius, 0.4, 1.0);
+        vdw->setParticleExclusions(i, exclusions);
+    }
+    vector<double> oxygenDipole = {0.0, 0.0, 7.5561214e-03};
+    vector<double> oxygenQuadrupole = {3.5403072e-04, 0.0, 0.0, 0.0, -3.9025708e-04, 0.0, 0.0, 0.0, 3.6226356e-05};
+    vector<double> hydrogenDipole = {-2.0420949e-03, 0.0, -3.0787530e-03};
+    vector<double> hydrogenQuadrupole = {-3.4284825e-05, 0.0, -1.8948597e-06, 0.0, -1.0024088e-04, 0.0, -1.8948597e-06, 0.0, 1.3452570e-04};
+    int numAtoms = bench.system.getNumParticles();
+    for (int o = numProteinAtoms; o < numAtoms; o += 3) {
+        multipoles->addMultipole(-5.1966000e-01, oxygenDipole, oxygenQuadrupole, AmoebaMultipoleForce::Bisector, o+1, o+2, -1, 0.39, 3.0698765e-01, 8.3700000e-04);
+        multipoles->addMultipole(2.5983000e-01, hydrogenDipole, hydrogenQuadrupole, AmoebaMultipoleForce::ZThenX, o, o+2, -1, 0.39, 2.8135002e-01, 4.9600000e-04);
+        multipoles->addMultipole(2.5983000e-01, hydrogenDipole, hydrogenQuadrupole, AmoebaMultipoleForce::ZThenX, o, o+1, -1, 0.39, 2.8135002e-01, 4.9600000e-04);
+        vector<int> molecule = {o, o+1, o+2};
+        multipoles->setCovalentMap(o, AmoebaMultipoleForce::Covalent12, {o+1, o+2});
+        multipoles->setCovalentMap(o+1, AmoebaMultipoleForce::Covalent12, {o});
+        multipoles->setCovalentMap(o+1, AmoebaMultipoleForce::Covalent13, {o+2});
+        multipoles->setCovalentMap(o+2, AmoebaMultipoleForce::Covalent12, {o});
+        multipoles->setCovalentMap(o+2, AmoebaMultipoleForce::Covalent13, {o+1});
+        for (int i = 0; i < 3; i++)
+            multipoles->setCovalentMap(o+i, AmoebaMultipoleForce::PolarizationCovalent11, molecule);
+        vdw->addParticle(o, 0.17025, 0.46024, 1.0);
+        vdw->addParticle(o, 0.13275, 0.056484, 0.91);
+        vdw->addParticle(o, 0.13275, 0.056484, 0.91);
+        for (int i = 0; i < 3; i++)
+            vdw->setParticleExclusions(o+i, molecule);
+    }
+    bench.system.addForce(multipoles);
+    bench.system.addForce(vdw);
+    bench.stepSize = 0.001;
+    bench.useLangevin = true;
+}
+
+static BenchmarkSystem* createAmoebaPme(double scale) {
+    // Use a TIP3P box for the geometry, then replace the forces with AMOEBA water parameters.
+
+    BenchmarkSystem* bench = new BenchmarkSystem();
+    double boxSize = setBox(bench->system, 2.5, scale, 0.9);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    addWaterBox(*bench, nonbonded, boxSize);
+    delete nonbonded;
+    addAmoebaForces(*bench, 0);
+    return bench;
+}
+
+static BenchmarkSystem* createAmoebaProtein(double scale) {
+    // The solvated protein from dhfr-pme, with AMOEBA forces replacing the NonbondedForce.
+
+    BenchmarkSystem* bench = new BenchmarkSystem();
+    double boxSize = setBox(bench->system, 6.2, scale, 0.9);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    int numProteinAtoms = (int) (2489*scale);
+    addProtein(*bench, nonbonded, numProteinAtoms, Vec3(0.5, 0.5, 0.5)*boxSize);
+    addWaterBox(*bench, nonbonded, boxSize);
+    delete nonbonded;
+    addAmoebaForces(*bench, numProteinAtoms);
+    return bench;
+}
+#endif
+
+#ifdef BENCHMARK_RPMD
+static BenchmarkSystem* createRpmdWater(double scale) {
+    // RPMD does not support constraints, so replace the rigid water geometry with harmonic
+    // bonds and angles.  addWaterBox() adds the O-H1, O-H2, and H1-H2 constraints for each
+    // molecule in that order.
+
+    BenchmarkSystem* bench = new BenchmarkSystem();
+    double boxSize = setBox(bench->system, 3.0, scale, 0.9);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setCutoffDistance(0.9);
+    addWaterBox(*bench, nonbonded, boxSize);
+    bench->system.addForce(nonbonded);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    for (int i = 0; i < bench->system.getNumConstraints(); i++) {
+        int p1, p2;
+        double distance;
+        bench->system.getConstraintParameters(i, p1, p2, distance);
+        if (i%3 == 2)
+            angles->addAngle(p1, p1-1, p2, 1.82421813, 836.8);
+        else
+            bonds->addBond(p1, p2, distance, 462750.4);
+    }
+    while (bench->system.getNumConstraints() > 0)
+        bench->system.removeConstraint(bench->system.getNumConstraints()-1);
+    bench->system.addForce(bonds);
+    bench->system.addForce(angles);
+    bench->stepSize = 0.0005;
+    bench->useLangevin = false;
+    bench->useRpmd = true;
+    return bench;
+}
+#endif
+
+static const vector<string>& getTestNames() {
+    static const vector<string> names = {"water-pme", "dhfr-pme", "large-protein", "gbsa", "custom-nonbonded"
+#ifdef BENCHMARK_AMOEBA
+        , "amoeba-pme", "amoeba-protein"
+#endif
+#ifdef BENCHMARK_RPMD
+        , "rpmd-water"
+#endif
+    };
+    return names;
+}
+
+static BenchmarkSystem* createTest(const string& name, double scale) {
+    if (name == "water-pme")
+        return createWaterPme(scale);
+    if (name == "dhfr-pme")
+        return createDhfrPme(scale);
+    if (name == "large-protein")
+        return createLargeProtein(scale);
+    if (name == "gbsa")
+        return createGbsa(scale);
+    if (name == "custom-nonbonded")
+        return createCustomNonbonded(scale);
+#ifdef BENCHMARK_AMOEBA
+    if (name == "amoeba-pme")
+        return createAmoebaPme(scale);
+    if (name == "amoeba-protein")
+        return createAmoebaProtein(scale);
+#endif
+#ifdef BENCHMARK_RPMD
+    if (name == "rpmd-water")
+        return createRpmdWater(scale);
+#endif
+    throw OpenMMException("Unknown test: "+name);
+}
+
+/**
+ * The options specified on the command line.
+ */
+struct Options {
+    Options() : seconds(10.0), steps(0), profileSteps(20), minimizeIterations(50), minimizeAlgorithm(LocalEnergyMinimizer::LBFGS), scale(1.0), json(false) {
+        copies = {8, 16, 32};
+    }
+    vector<string> tests, platforms;
+    vector<int> threads, copies;
+    map<string, string> properties;
+    double seconds;
+    int steps, profileSteps, minimizeIterations;
+    LocalEnergyMinimizer::Algorithm minimizeAlgorithm;
+    double scale;
+    bool json;
+    string output, pluginDir;
+};
+
+/**
+ * The results of running one test on one Platform.
+ */
+struct BenchmarkResult {
+    string test, platform, error;
+    int threads, copies, atoms, steps, profileSteps;
+    double stepSize, seconds, nsPerDay, copyStepsPerSecond, memory, peakMemory;
+    map<string, double> setup, initialization, kernels;
+};
+
+/**
+ * Run the integrator for a number of steps, and return the elapsed time in seconds.
+ */
+static double timeIntegration(Context& context, int steps) {
+    context.getState(State::Energy);
+    double start = getCurrentTime();
+    context.getIntegrator().step(steps);
+    context.getState(State::Energy);
+    return getCurrentTime()-start;
+}
+
+/**
+ * Measure how long it takes to serialize and deserialize a System in both XML and binary formats.
+ */
+static void benchmarkSerialization(const System& system, map<string, double>& setup) {
+    // The memory used while loading is the change in memory usage from before the load to after
+    // it, while the System that was loaded still exists.
+
+    double start = getCurrentTime();
+    stringstream xml;
+    XmlSerializer::serialize<System>(&system, "System", xml);
+    setup["Serialize XML"] = getCurrentTime()-start;
+    setup["XML Bytes"] = xml.str().size();
+    double initialMemory = getMemoryUsage(false);
+    start = getCurrentTime();
+    System* copy = XmlSerializer::deserialize<System>(xml);
+    setup["Deserialize XML"] = getCurrentTime()-start;
+    setup["Deserialize XML Memory"] = getMemoryUsage(false)-initialMemory;
+    delete copy;
+    start = getCurrentTime();
+    stringstream binary(ios::in | ios::out | ios::binary);
+    BinarySerializer::serialize<System>(&system, "System", binary);
+    setup["Serialize Binary"] = getCurrentTime()-start;
+    setup["Binary Bytes"] = binary.str().size();
+    initialMemory = getMemoryUsage(false);
+    start = getCurrentTime();
+    copy = BinarySerializer::deserialize<System>(binary);
+    setup["Deserialize Binary"] = getCurrentTime()-start;
+    setup["Deserialize Binary Memory"] = getMemoryUsage(false)-initialMemory;
+    delete copy;
+}
+
+static BenchmarkResult runBenchmark(const string& test, const BenchmarkSystem& bench, Platform& platform, int threads, int copies, const Options& options, const map<string, double>& serialization) {
+    BenchmarkResult result;
+    result.test = test;
+    result.platform = platform.getName();
+    result.threads = threads;
+    result.copies = copies;
+    result.atoms = bench.system.getNumParticles();
+    result.stepSize = bench.stepSize;
+    result.steps = result.profileSteps = 0;
+    result.seconds = result.nsPerDay = result.copyStepsPerSecond = 0.0;
+    result.setup = serialization;
+
+    // Create the Context.
+
+    map<string, string> properties;
+    const vector<string>& propertyNames = platform.getPropertyNames();
+    for (auto& prop : options.properties)
+        if (find(propertyNames.begin(), propertyNames.end(), prop.first) != propertyNames.end())
+            properties[prop.first] = prop.second;
+    if (threads > 0)
+        properties["Threads"] = to_string(threads);
+    double initialMemory = getMemoryUsage(false);
+    unique_ptr<Integrator> integrator;
+    if (copies > 0) {
+#ifdef BENCHMARK_RPMD
+        integrator.reset(new RPMDIntegrator(copies, 300.0, 1.0, bench.stepSize));
+#endif
+    }
+    else if (bench.useLangevin)
+        integrator.reset(new LangevinMiddleIntegrator(300.0, 1.0, bench.stepSize));
+    else
+        integrator.reset(new VerletIntegrator(bench.stepSize));
+    integrator->setConstraintTolerance(1e-5);
+    double start = getCurrentTime();
+    Context context(bench.system, *integrator, platform, properties);
+    result.setup["Create Context"] = getCurrentTime()-start;
+    result.initialization = context.getInitializationTimes();
+    if (find(propertyNames.begin(), propertyNames.end(), "Threads") != propertyNames.end())
+        result.threads = atoi(platform.getPropertyValue(context, "Threads").c_str());
+    else
+        result.threads = 1;
+    context.setPositions(bench.positions);
+    context.setVelocitiesToTemperature(300.0, 1);
+
+    // Run a few steps to make sure everything is fully initialized, then time the simulation.
+    // If a fixed number of steps was not specified, choose one based on the target time.
+
+    context.getIntegrator().step(5);
+    int steps = options.steps;
+    double time;
+    if (steps > 0)
+        time = timeIntegration(context, steps);
+    else {
+        steps = 20;
+        while (true) {
+            time = timeIntegration(context, steps);
+            if (time >= 0.5*options.seconds)
+                break;
+            if (time < 0.5)
+                steps = (int) ceil(steps*1.0/max(time, 1e-3));
+            else
+                steps = (int) ceil(steps*options.seconds/time);
+        }
+    }
+    result.steps = steps;
+    result.seconds = time;
+    result.nsPerDay = bench.stepSize*1e-3*steps*86400/time;
+    result.copyStepsPerSecond = max(copies, 1)*steps/time;
+
+    // Profile a short simulation to see where the time is spent.
+
+    if (options.profileSteps > 0) {
+        context.setTimingEnabled(true);
+        context.resetTimingReport();
+        context.getIntegrator().step(options.profileSteps);
+        context.setTimingEnabled(false);
+        result.kernels = context.getTimingReport();
+        result.profileSteps = options.profileSteps;
+        auto builds = result.kernels.find("Neighbor List Builds");
+        auto buildTime = result.kernels.find("Neighbor List Time");
+        if (builds != result.kernels.end() && buildTime != result.kernels.end() && builds->second > 0)
+            result.setup["Neighbor List Build"] = buildTime->second/builds->second;
+    }
+
+    // Measure checkpointing.
+
+    start = getCurrentTime();
+    stringstream checkpoint(ios::in | ios::out | ios::binary);
+    context.createCheckpoint(checkpoint);
+    result.setup["Create Checkpoint"] = getCurrentTime()-start;
+    result.setup["Checkpoint Bytes"] = checkpoint.str().size();
+    start = getCurrentTime();
+    context.loadCheckpoint(checkpoint);
+    result.setup["Load Checkpoint"] = getCurrentTime()-start;
+
+    // Measure the portable checkpoint format with and without compression.  A series of checkpoints
+    // is written to one stream, so the first one is a keyframe and the others are deltas.  Throughput
+    // is the size of an uncompressed keyframe divided by the time to write or read a checkpoint.
+
+    const int portableCheckpoints = 5;
+    double keyframeBytes = 0.0;
+    for (bool compress : {false, true}) {
+        string name = (compress ? "Portable Checkpoint Compressed" : "Portable Checkpoint");
+        CheckpointWriter writer(compress, portableCheckpoints);
+        stringstream stream(ios::in | ios::out | ios::binary);
+        vector<double> writeTimes, readTimes, bytes;
+        for (int i = 0; i < portableCheckpoints; i++) {
+            if (i > 0)
+                context.getIntegrator().step(10);
+            size_t initialSize = stream.str().size();
+            start = getCurrentTime();
+            writer.writeCheckpoint(context, stream);
+            writeTimes.push_back(getCurrentTime()-start);
+            bytes.push_back(stream.str().size()-initialSize);
+        }
+        CheckpointReader reader;
+        State state;
+        for (int i = 0; i < portableCheckpoints; i++) {
+            start = getCurrentTime();
+            reader.readCheckpoint(stream, state);
+            readTimes.push_back(getCurrentTime()-start);
+        }
+        if (!compress)
+            keyframeBytes = bytes[0];
+        double deltaWrite = 0.0, deltaRead = 0.0, deltaBytes = 0.0;
+        for (int i = 1; i < portableCheckpoints; i++) {
+            deltaWrite += writeTimes[i]/(portableCheckpoints-1);
+            deltaRead += readTimes[i]/(portableCheckpoints-1);
+            deltaBytes += bytes[i]/(portableCheckpoints-1);
+        }
+        result.setup[name+" Keyframe Write"] = writeTimes[0];
+        result.setup[name+" Keyframe Read"] = readTimes[0];
+        result.setup[name+" Keyframe Bytes"] = bytes[0];
+        result.setup[name+" Keyframe Write MB/s"] = 1e-6*keyframeBytes/writeTimes[0];
+        result.setup[name+" Keyframe Read MB/s"] = 1e-6*keyframeBytes/readTimes[0];
+        result.setup[name+" Delta Write"] = deltaWrite;
+        result.setup[name+" Delta Read"] = deltaRead;
+        result.setup[name+" Delta Bytes"] = deltaBytes;
+        result.setup[name+" Delta Write MB/s"] = 1e-6*keyframeBytes/deltaWrite;
+        result.setup[name+" Delta Read MB/s"] = 1e-6*keyframeBytes/deltaRead;
+    }
+
+    // Measure energy minimization.  The timing report is enabled so the number of energy evaluations
+    // can be counted.
+
+    if (options.minimizeIterations > 0) {
+        context.setTimingEnabled(true);
+        context.resetTimingReport();
+        start = getCurrentTime();
+        LocalEnergyMinimizer::minimize(context, 1e-3, options.minimizeIterations, options.minimizeAlgorithm);
+        double minimizeTime = getCurrentTime()-start;
+        context.setTimingEnabled(false);
+        double evaluations = context.getTimingReport()["Force Evaluations"];
+        result.setup["Minimize"] = minimizeTime;
+        result.setup["Minimize Evaluations"] = evaluations;
+        result.setup["Minimize Evaluations per Second"] = evaluations/minimizeTime;
+    }
+    result.memory = getMemoryUsage(false)-initialMemory;
+    result.peakMemory = getMemoryUsage(true);
+    return result;
+}
+
+static string quoteJson(const string& str) {
+    stringstream quoted;
+    quoted << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            quoted << '\\' << c;
+        else if ((unsigned char) c < 0x20)
+            quoted << "\\u" << hex << setw(4) << setfill('0') << (int) c << dec;
+        else
+            quoted << c;
+    }
+    quoted << '"';
+    return quoted.str();
+}
+
+static void writeJsonMap(ostream& out, const string& name, const map<string, double>& values) {
+    out << ", " << quoteJson(name) << ": {";
+    bool first = true;
+    for (auto& value : values) {
+        out << (first ? "" : ", ") << quoteJson(value.first) << ": " << value.second;
+        first = false;
+    }
+    out << "}";
+}
+
+static void writeJson(ostream& out, const BenchmarkResult& result) {
+    out << setprecision(8);
+    out << "{\"test\": " << quoteJson(result.test) << ", \"platform\": " << quoteJson(result.platform);
+    if (result.error.size() > 0) {
+        out << ", \"error\": " << quoteJson(result.error) << "}" << endl;
+        return;
+    }
+    out << ", \"threads\": " << result.threads << ", \"atoms\": " << result.atoms;
+    if (result.copies > 0)
+        out << ", \"copies\": " << result.copies << ", \"copy_steps_per_second\": " << result.copyStepsPerSecond;
+    out << ", \"step_size_ps\": " << result.stepSize << ", \"steps\": " << result.steps << ", \"seconds\": " << result.seconds;
+    out << ", \"ns_per_day\": " << result.nsPerDay << ", \"memory_mb\": " << result.memory << ", \"peak_memory_mb\": " << result.peakMemory;
+    out << ", \"profile_steps\": " << result.profileSteps;
+    writeJsonMap(out, "kernels", result.kernels);
+    writeJsonMap(out, "setup", result.setup);
+    writeJsonMap(out, "initialization", result.initialization);
+    out << "}" << endl;
+}
+
+/**
+ * Get whether an entry in the timing report is a count of events, rather than a time in seconds.
+ */
+static bool isCount(const string& name) {
+    for (const string& suffix : {"Evaluations", "Applications", "Iterations", "Checks", "Builds"})
+        if (name.size() > suffix.size() && name.compare(name.size()-suffix.size(), suffix.size(), suffix) == 0)
+            return true;
+    return false;
+}
+
+static void writeText(ostream& out, const BenchmarkResult& result) {
+    out << "Test: " << result.test << "  Platform: " << result.platform;
+    if (result.error.size() > 0) {
+        out << endl << "Failed: " << result.error << endl << endl;
+        return;
+    }
+    out << "  Threads: " << result.threads << "  Atoms: " << result.atoms;
+    if (result.copies > 0)
+        out << "  Copies: " << result.copies;
+    out << endl;
+    out << "Integrated " << result.steps << " steps in " << result.seconds << " seconds" << endl;
+    out << result.nsPerDay << " ns/day";
+    if (result.copies > 0)
+        out << "  " << result.copyStepsPerSecond << " copy steps/second";
+    out << endl;
+    out << "Context memory: " << result.memory << " MB  Peak process memory: " << result.peakMemory << " MB" << endl;
+    if (result.profileSteps > 0) {
+        out << "Time per step (ms) over " << result.profileSteps << " steps:" << endl;
+        for (auto& value : result.kernels)
+            if (!isCount(value.first))
+                out << "    " << value.first << ": " << 1000*value.second/result.profileSteps << endl;
+        out << "Counts per step:" << endl;
+        for (auto& value : result.kernels)
+            if (isCount(value.first))
+                out << "    " << value.first << ": " << value.second/result.profileSteps << endl;
+    }
+    out << "Setup:" << endl;
+    for (auto& value : result.setup)
+        out << "    " << value.first << ": " << value.second << endl;
+    out << endl;
+}
+
+static vector<string> splitList(const string& list) {
+    vector<string> items;
+    stringstream stream(list);
+    string item;
+    while (getline(stream, item, ','))
+        if (item.size() > 0)
+            items.push_back(item);
+    return items;
+}
+
+static void printUsage() {
+    cout << "Usage: OpenMMBenchmark [options]" << endl << endl;
+    cout << "  --test=NAMES           comma separated list of tests to run [default: all].  Available tests:" << endl;
+    cout << "                         ";
+    for (const string& name : getTestNames())
+        cout << " " << name;
+    cout << endl;
+    cout << "  --platform=NAMES       comma separated list of platforms to benchmark [default: all]" << endl;
+    cout << "  --threads=COUNTS       comma separated list of thread counts for platforms with a Threads property" << endl;
+    cout << "                         [default: the platform's default]" << endl;
+    cout << "  --property=NAME=VALUE  set a platform property for platforms that support it.  May be repeated." << endl;
+    cout << "  --copies=COUNTS        comma separated list of copy counts for RPMD tests [default: 8,16,32]" << endl;
+    cout << "  --seconds=TIME         target length of each timed simulation in seconds [default: 10]" << endl;
+    cout << "  --steps=N              simulate exactly N steps instead of choosing based on --seconds" << endl;
+    cout << "  --profile-steps=N      number of steps to profile with Context::getTimingReport(), or 0 to skip [default: 20]" << endl;
+    cout << "  --minimize-iterations=N maximum number of iterations when timing energy minimization, or 0 to skip [default: 50]" << endl;
+    cout << "  --minimize-algorithm=NAME algorithm to use for energy minimization: lbfgs, preconditioned-lbfgs, or fire" << endl;
+    cout << "                         [default: lbfgs]" << endl;
+    cout << "  --scale=FACTOR         multiply the number of atoms in each test by this factor [default: 1]" << endl;
+    cout << "  --format=FORMAT        output format: text or json (one JSON object per line) [default: text]" << endl;
+    cout << "  --output=FILE          write results to a file instead of standard output" << endl;
+    cout << "  --plugin-dir=DIR       directory to load plugins from [default: the default plugins directory]" << endl;
+}
+
+static bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return false;
+        }
+        size_t split = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || split == string::npos)
+            throw OpenMMException("Illegal argument: "+arg);
+        string name = arg.substr(2, split-2);
+        string value = arg.substr(split+1);
+        if (name == "test")
+            options.tests = splitList(value);
+        else if (name == "platform")
+            options.platforms = splitList(value);
+        else if (name == "threads") {
+            for (const string& count : splitList(value))
+                options.threads.push_back(atoi(count.c_str()));
+        }
+        else if (name == "copies") {
+            options.copies.clear();
+            for (const string& count : splitList(value))
+                options.copies.push_back(atoi(count.c_str()));
+        }
+        else if (name == "property") {
+            size_t propSplit = value.find('=');
+            if (propSplit == string::npos)
+                throw OpenMMException("Properties must be specified as NAME=VALUE: "+value);
+            options.properties[value.substr(0, propSplit)] = value.substr(propSplit+1);
+        }
+        else if (name == "seconds")
+            options.seconds = atof(value.c_str());
+        else if (name == "steps")
+            options.steps = atoi(value.c_str());
+        else if (name == "profile-steps")
+            options.profileSteps = atoi(value.c_str());
+        else if (name == "minimize-iterations")
+            options.minimizeIterations = atoi(value.c_str());
+        else if (name == "minimize-algorithm") {
+            if (value == "lbfgs")
+                options.minimizeAlgorithm = LocalEnergyMinimizer::LBFGS;
+            else if (value == "preconditioned-lbfgs")
+                options.minimizeAlgorithm = LocalEnergyMinimizer::PreconditionedLBFGS;
+            else if (value == "fire")
+                options.minimizeAlgorithm = LocalEnergyMinimizer::FIRE;
+            else
+                throw OpenMMException("Unknown minimization algorithm: "+value);
+        }
+        else if (name == "scale")
+            options.scale = atof(value.c_str());
+        else if (name == "format") {
+            if (value != "text" && value != "json")
+                throw OpenMMException("Unknown format: "+value);
+            options.json = (value == "json");
+        }
+        else if (name == "output")
+            options.output = value;
+        else if (name == "plugin-dir")
+            options.pluginDir = value;
+        else
+            throw OpenMMException("Unknown option: "+arg);
+    }
+    if (options.tests.size() == 0)
+        options.tests = getTestNames();
+    for (const string& test : options.tests)
+        if (find(getTestNames().begin(), getTestNames().end(), test) == getTestNames().end())
+            throw OpenMMException("Unknown test: "+test);
+    if (options.scale <= 0.0)
+        throw OpenMMException("The scale must be positive");
+    for (int copies : options.copies)
+        if (copies < 1)
+            throw OpenMMException("The number of copies must be positive");
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool anyFailed = false;
+    try {
+        Options options;
+        if (!parseOptions(argc, argv, options))
+            return 0;
+        Platform::loadPluginsFromDirectory(options.pluginDir.size() > 0 ? options.pluginDir : Platform::getDefaultPluginsDirectory());
+        if (options.platforms.size() == 0)
+            for (int i = 0; i < Platform::getNumPlatforms(); i++)
+                options.platforms.push_back(Platform::getPlatform(i).getName());
+        ofstream outputFile;
+        if (options.output.size() > 0) {
+            outputFile.open(options.output.c_str());
+            if (!outputFile.is_open())
+                throw OpenMMException("Failed to open output file: "+options.output);
+        }
+        ostream& out = (options.output.size() > 0 ? outputFile : cout);
+        for (const string& test : options.tests) {
+            unique_ptr<BenchmarkSystem> bench(createTest(test, options.scale));
+            map<string, double> serialization;
+            benchmarkSerialization(bench->system, serialization);
+            for (const string& platformName : options.platforms) {
+                Platform& platform = Platform::getPlatformByName(platformName);
+                const vector<string>& propertyNames = platform.getPropertyNames();
+                vector<int> threadCounts = {0};
+                if (options.threads.size() > 0 && find(propertyNames.begin(), propertyNames.end(), "Threads") != propertyNames.end())
+                    threadCounts = options.threads;
+                vector<int> copyCounts = {0};
+                if (bench->useRpmd)
+                    copyCounts = options.copies;
+                for (int threads : threadCounts)
+                    for (int copies : copyCounts) {
+                        BenchmarkResult result;
+                        try {
+                            result = runBenchmark(test, *bench, platform, threads, copies, options, serialization);
+                        }
+                        catch (const exception& ex) {
+                            result.test = test;
+                            result.platform = platformName;
+                            result.error = ex.what();
+                            anyFailed = true;
+                        }
+                        if (options.json)
+                            writeJson(out, result);
+                        else
+                            writeText(out, result);
+                        out.flush();
+                    }
+            }
+        }
+    }
+    catch (const exception& ex) {
+        cerr << "Error: " << ex.what() << endl;
+        return 1;
+    }
+    return (anyFailed ? 1 : 0);
+}
@@ -150,6 +150,8 @@ def runOneTest(testName, options):
             initialSteps = 250
     if options.precision is not None and platform.getName() in ('CUDA', 'OpenCL'):
         properties['Precision'] = options.precision
+    if options.clusterPairs and platform.getName() == 'CPU':
+        properties['ClusterPairs'] = 'true'
 
     # Run the simulation.
     
@@ -192,6 +194,7 @@ parser.add_argument('--mutual-epsilon', default=1e-5, dest='epsilon', type=float
 parser.add_argument('--heavy-hydrogens', action='store_true', default=False, dest='heavy', help='repartition mass to allow a larger time step')
 parser.add_argument('--device', default=None, dest='device', help='device index for CUDA or OpenCL')
 parser.add_argument('--precision', default='single', dest='precision', choices=('single', 'mixed', 'double'), help='precision mode for CUDA or OpenCL: single, mixed, or double [default: single]')
+parser.add_argument('--cluster-pairs', action='store_true', default=False, dest='clusterPairs', help='use the cluster pair nonbonded kernel on the CPU platform')
 args = parser.parse_args()
 if args.platform is None:
     parser.error('No platform specified')
@@ -200,6 +203,8 @@ if args.platform in ('CUDA', 'OpenCL'):
     print('Precision:', args.precision)
     if args.device is not None:
         print('Device:', args.device)
+if args.platform == 'CPU' and args.clusterPairs:
+    print('Cluster pairs: true')
 
 # Run the simulations.
 
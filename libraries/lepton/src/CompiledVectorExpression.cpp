@@ -0,0 +1,570 @@
+/* -------------------------------------------------------------------------- *
+ *                                   Lepton                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the Lepton expression parser originating from              *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "lepton/CompiledVectorExpression.h"
+#include "lepton/Exception.h"
+#include "lepton/Operation.h"
+#include "lepton/ParsedExpression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+using namespace Lepton;
+using namespace std;
+#ifdef LEPTON_USE_JIT
+    using namespace asmjit;
+#endif
+
+CompiledVectorExpression::CompiledVectorExpression() : width(1), jitCode(NULL) {
+}
+
+CompiledVectorExpression::CompiledVectorExpression(const ParsedExpression& expression, int width) : width(width), jitCode(NULL) {
+    const vector<int>& allowedWidths = getAllowedWidths();
+    if (find(allowedWidths.begin(), allowedWidths.end(), width) == allowedWidths.end()) {
+        stringstream message;
+        message << "Unsupported width for vector expression: " << width;
+        throw Exception(message.str());
+    }
+    ParsedExpression expr = expression.optimize(); // Just in case it wasn't already optimized.
+    vector<pair<ExpressionTreeNode, int> > temps;
+    int workspaceSize = 0;
+    compileExpression(expr.getRootNode(), temps, workspaceSize);
+    workspace.resize(workspaceSize*width);
+    int maxArguments = 1;
+    for (int i = 0; i < (int) operation.size(); i++)
+        if (operation[i]->getNumArguments() > maxArguments)
+            maxArguments = operation[i]->getNumArguments();
+    argValues.resize(maxArguments);
+#ifdef LEPTON_USE_JIT
+    callBuffer.resize(maxArguments*width);
+#endif
+    setVariableLocations(variablePointers);
+}
+
+CompiledVectorExpression::~CompiledVectorExpression() {
+    for (int i = 0; i < (int) operation.size(); i++)
+        if (operation[i] != NULL)
+            delete operation[i];
+}
+
+CompiledVectorExpression::CompiledVectorExpression(const CompiledVectorExpression& expression) : jitCode(NULL) {
+    *this = expression;
+}
+
+CompiledVectorExpression& CompiledVectorExpression::operator=(const CompiledVectorExpression& expression) {
+    for (int i = 0; i < (int) operation.size(); i++)
+        if (operation[i] != NULL)
+            delete operation[i];
+    width = expression.width;
+    arguments = expression.arguments;
+    target = expression.target;
+    variableIndices = expression.variableIndices;
+    variableNames = expression.variableNames;
+    workspace.resize(expression.workspace.size());
+    argValues.resize(expression.argValues.size());
+#ifdef LEPTON_USE_JIT
+    callBuffer.resize(expression.callBuffer.size());
+#endif
+    operation.resize(expression.operation.size());
+    for (int i = 0; i < (int) operation.size(); i++)
+        operation[i] = expression.operation[i]->clone();
+    setVariableLocations(variablePointers);
+    return *this;
+}
+
+const vector<int>& CompiledVectorExpression::getAllowedWidths() {
+    static vector<int> widths;
+    if (widths.size() == 0) {
+#ifdef LEPTON_USE_JIT
+        if (CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX)) {
+            widths.push_back(8);
+            widths.push_back(4);
+        }
+        else {
+            widths.push_back(4);
+            widths.push_back(8);
+        }
+#else
+        widths.push_back(4);
+        widths.push_back(8);
+#endif
+    }
+    return widths;
+}
+
+void CompiledVectorExpression::compileExpression(const ExpressionTreeNode& node, vector<pair<ExpressionTreeNode, int> >& temps, int& workspaceSize) {
+    if (findTempIndex(node, temps) != -1)
+        return; // We have already processed a node identical to this one.
+    
+    // Process the child nodes.
+    
+    vector<int> args;
+    for (int i = 0; i < node.getChildren().size(); i++) {
+        compileExpression(node.getChildren()[i], temps, workspaceSize);
+        args.push_back(findTempIndex(node.getChildren()[i], temps));
+    }
+    
+    // Process this node.
+    
+    if (node.getOperation().getId() == Operation::VARIABLE) {
+        variableIndices[node.getOperation().getName()] = workspaceSize;
+        variableNames.insert(node.getOperation().getName());
+    }
+    else {
+        int stepIndex = (int) arguments.size();
+        arguments.push_back(vector<int>());
+        target.push_back(workspaceSize);
+        operation.push_back(node.getOperation().clone());
+        if (args.size() == 0)
+            arguments[stepIndex].push_back(0); // The value won't actually be used.  We just need something there.
+        else {
+            // If the arguments are sequential, we can just pass a pointer to the first one.
+            
+            bool sequential = true;
+            for (int i = 1; i < args.size(); i++)
+                if (args[i] != args[i-1]+1)
+                    sequential = false;
+            if (sequential)
+                arguments[stepIndex].push_back(args[0]);
+            else
+                arguments[stepIndex] = args;
+        }
+    }
+    temps.push_back(make_pair(node, workspaceSize));
+    workspaceSize++;
+}
+
+int CompiledVectorExpression::findTempIndex(const ExpressionTreeNode& node, vector<pair<ExpressionTreeNode, int> >& temps) {
+    for (int i = 0; i < (int) temps.size(); i++)
+        if (temps[i].first == node)
+            return i;
+    return -1;
+}
+
+int CompiledVectorExpression::getWidth() const {
+    return width;
+}
+
+const set<string>& CompiledVectorExpression::getVariables() const {
+    return variableNames;
+}
+
+float* CompiledVectorExpression::getVariablePointer(const string& name) {
+    map<string, float*>::iterator pointer = variablePointers.find(name);
+    if (pointer != variablePointers.end())
+        return pointer->second;
+    map<string, int>::iterator index = variableIndices.find(name);
+    if (index == variableIndices.end())
+        throw Exception("getVariablePointer: Unknown variable '"+name+"'");
+    return &workspace[index->second*width];
+}
+
+void CompiledVectorExpression::setVariableLocations(map<string, float*>& variableLocations) {
+    variablePointers = variableLocations;
+    jitCode = NULL;
+#ifdef LEPTON_USE_JIT
+    // Rebuild the JIT code.
+    
+    if (workspace.size() > 0 && CpuInfo::getHost().hasFeature(CpuInfo::kX86FeatureAVX))
+        generateJitCode();
+#endif
+    // Make a list of all variables we will need to copy before evaluating the expression.
+    
+    variablesToCopy.clear();
+    for (map<string, int>::const_iterator iter = variableIndices.begin(); iter != variableIndices.end(); ++iter) {
+        map<string, float*>::iterator pointer = variablePointers.find(iter->first);
+        if (pointer != variablePointers.end())
+            variablesToCopy.push_back(make_pair(&workspace[iter->second*width], pointer->second));
+    }
+}
+
+const float* CompiledVectorExpression::evaluate() const {
+    if (jitCode != NULL) {
+        jitCode();
+        return &workspace[workspace.size()-width];
+    }
+    for (int i = 0; i < variablesToCopy.size(); i++)
+        memcpy(variablesToCopy[i].first, variablesToCopy[i].second, width*sizeof(float));
+
+    // Loop over the operations and evaluate each one for every element of the vectors.
+    
+    for (int step = 0; step < operation.size(); step++) {
+        const vector<int>& args = arguments[step];
+        int numArgs = operation[step]->getNumArguments();
+        float* result = &workspace[target[step]*width];
+        for (int i = 0; i < width; i++) {
+            if (args.size() == 1) {
+                for (int j = 0; j < numArgs; j++)
+                    argValues[j] = workspace[(args[0]+j)*width+i];
+            }
+            else {
+                for (int j = 0; j < numArgs; j++)
+                    argValues[j] = workspace[args[j]*width+i];
+            }
+            result[i] = (float) operation[step]->evaluate(&argValues[0], dummyVariables);
+        }
+    }
+    return &workspace[workspace.size()-width];
+}
+
+#ifdef LEPTON_USE_JIT
+static void evaluateSingleArgFunction(float (*function)(float), float* values, int width) {
+    for (int i = 0; i < width; i++)
+        values[i] = function(values[i]);
+}
+
+static void evaluateTwoArgFunction(float (*function)(float, float), float* values, int width) {
+    for (int i = 0; i < width; i++)
+        values[i] = function(values[i], values[i+width]);
+}
+
+static void evaluateOperation(Operation* op, float* values, double* args, int width) {
+    static map<string, double> dummyVariables;
+    int numArgs = op->getNumArguments();
+    for (int i = 0; i < width; i++) {
+        for (int j = 0; j < numArgs; j++)
+            args[j] = values[j*width+i];
+        values[i] = (float) op->evaluate(args, dummyVariables);
+    }
+}
+
+void CompiledVectorExpression::generateJitCode() {
+    CodeHolder code;
+    code.init(runtime.getCodeInfo());
+    X86Compiler c(&code);
+    c.addFunc(FuncSignature0<void>());
+    int workspaceSize = workspace.size()/width;
+    vector<X86Ymm> workspaceVar(workspaceSize);
+    for (int i = 0; i < (int) workspaceVar.size(); i++)
+        workspaceVar[i] = c.newYmmPs();
+    X86Gp bufferPointer = c.newIntPtr();
+    c.mov(bufferPointer, imm_ptr(&callBuffer[0]));
+
+    // Load the arguments into variables.
+    
+    for (set<string>::const_iterator iter = variableNames.begin(); iter != variableNames.end(); ++iter) {
+        map<string, int>::iterator index = variableIndices.find(*iter);
+        X86Gp variablePointer = c.newIntPtr();
+        c.mov(variablePointer, imm_ptr(getVariablePointer(index->first)));
+        loadVector(c, workspaceVar[index->second], x86::ptr(variablePointer, 0, 0));
+    }
+
+    // Make a list of all constants that will be needed for evaluation.
+    
+    constants.clear();
+    vector<int> operationConstantIndex(operation.size(), -1);
+    for (int step = 0; step < (int) operation.size(); step++) {
+        // Find the constant value (if any) used by this operation.
+        
+        Operation& op = *operation[step];
+        double value;
+        if (op.getId() == Operation::CONSTANT)
+            value = dynamic_cast<Operation::Constant&>(op).getValue();
+        else if (op.getId() == Operation::ADD_CONSTANT)
+            value = dynamic_cast<Operation::AddConstant&>(op).getValue();
+        else if (op.getId() == Operation::MULTIPLY_CONSTANT)
+            value = dynamic_cast<Operation::MultiplyConstant&>(op).getValue();
+        else if (op.getId() == Operation::POWER_CONSTANT) {
+            // Integer powers are computed by repeated multiplication, which may need 1.0 for
+            // the reciprocal.  Other powers need the exponent.
+
+            value = dynamic_cast<Operation::PowerConstant&>(op).getValue();
+            if (value == (int) value)
+                value = 1.0;
+        }
+        else if (op.getId() == Operation::RECIPROCAL)
+            value = 1.0;
+        else if (op.getId() == Operation::STEP)
+            value = 1.0;
+        else if (op.getId() == Operation::DELTA)
+            value = 1.0;
+        else
+            continue;
+        
+        // See if we already have a variable for this constant.
+        
+        for (int i = 0; i < (int) constants.size(); i++)
+            if ((float) value == constants[i]) {
+                operationConstantIndex[step] = i;
+                break;
+            }
+        if (operationConstantIndex[step] == -1) {
+            operationConstantIndex[step] = constants.size();
+            constants.push_back((float) value);
+        }
+    }
+    
+    // Load constants into variables.
+    
+    vector<X86Ymm> constantVar(constants.size());
+    if (constants.size() > 0) {
+        X86Gp constantsPointer = c.newIntPtr();
+        c.mov(constantsPointer, imm_ptr(&constants[0]));
+        for (int i = 0; i < (int) constants.size(); i++) {
+            constantVar[i] = c.newYmmPs();
+            c.vbroadcastss(constantVar[i], x86::ptr(constantsPointer, 4*i, 0));
+        }
+    }
+    
+    // Evaluate the operations.
+    
+    for (int step = 0; step < (int) operation.size(); step++) {
+        Operation& op = *operation[step];
+        vector<int> args = arguments[step];
+        if (args.size() == 1) {
+            // One or more sequential arguments.  Fill out the list.
+            
+            for (int i = 1; i < op.getNumArguments(); i++)
+                args.push_back(args[0]+i);
+        }
+        
+        // Generate instructions to execute this operation.
+        
+        X86Ymm& dest = workspaceVar[target[step]];
+        switch (op.getId()) {
+            case Operation::CONSTANT:
+                c.vmovaps(dest, constantVar[operationConstantIndex[step]]);
+                break;
+            case Operation::ADD:
+                c.vaddps(dest, workspaceVar[args[0]], workspaceVar[args[1]]);
+                break;
+            case Operation::SUBTRACT:
+                c.vsubps(dest, workspaceVar[args[0]], workspaceVar[args[1]]);
+                break;
+            case Operation::MULTIPLY:
+                c.vmulps(dest, workspaceVar[args[0]], workspaceVar[args[1]]);
+                break;
+            case Operation::DIVIDE:
+                c.vdivps(dest, workspaceVar[args[0]], workspaceVar[args[1]]);
+                break;
+            case Operation::POWER:
+                generateTwoArgCall(c, dest, workspaceVar[args[0]], workspaceVar[args[1]], [] (float x, float y) { return std::pow(x, y); });
+                break;
+            case Operation::NEGATE:
+                c.vxorps(dest, dest, dest);
+                c.vsubps(dest, dest, workspaceVar[args[0]]);
+                break;
+            case Operation::SQRT:
+                c.vsqrtps(dest, workspaceVar[args[0]]);
+                break;
+            case Operation::EXP:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::exp(x); });
+                break;
+            case Operation::LOG:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::log(x); });
+                break;
+            case Operation::SIN:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::sin(x); });
+                break;
+            case Operation::COS:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::cos(x); });
+                break;
+            case Operation::TAN:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::tan(x); });
+                break;
+            case Operation::ASIN:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::asin(x); });
+                break;
+            case Operation::ACOS:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::acos(x); });
+                break;
+            case Operation::ATAN:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::atan(x); });
+                break;
+            case Operation::ATAN2:
+                generateTwoArgCall(c, dest, workspaceVar[args[0]], workspaceVar[args[1]], [] (float x, float y) { return std::atan2(x, y); });
+                break;
+            case Operation::SINH:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::sinh(x); });
+                break;
+            case Operation::COSH:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::cosh(x); });
+                break;
+            case Operation::TANH:
+                generateSingleArgCall(c, dest, workspaceVar[args[0]], [] (float x) { return std::tanh(x); });
+                break;
+            case Operation::STEP: {
+                X86Ymm zero = c.newYmmPs();
+                c.vxorps(zero, zero, zero);
+                c.vcmpps(dest, zero, workspaceVar[args[0]], imm(18)); // Comparison mode is _CMP_LE_OQ = 18
+                c.vandps(dest, dest, constantVar[operationConstantIndex[step]]);
+                break;
+            }
+            case Operation::DELTA: {
+                X86Ymm zero = c.newYmmPs();
+                c.vxorps(zero, zero, zero);
+                c.vcmpps(dest, zero, workspaceVar[args[0]], imm(16)); // Comparison mode is _CMP_EQ_OS = 16
+                c.vandps(dest, dest, constantVar[operationConstantIndex[step]]);
+                break;
+            }
+            case Operation::SQUARE:
+                c.vmulps(dest, workspaceVar[args[0]], workspaceVar[args[0]]);
+                break;
+            case Operation::CUBE:
+                c.vmulps(dest, workspaceVar[args[0]], workspaceVar[args[0]]);
+                c.vmulps(dest, dest, workspaceVar[args[0]]);
+                break;
+            case Operation::RECIPROCAL:
+                c.vdivps(dest, constantVar[operationConstantIndex[step]], workspaceVar[args[0]]);
+                break;
+            case Operation::ADD_CONSTANT:
+                c.vaddps(dest, workspaceVar[args[0]], constantVar[operationConstantIndex[step]]);
+                break;
+            case Operation::MULTIPLY_CONSTANT:
+                c.vmulps(dest, workspaceVar[args[0]], constantVar[operationConstantIndex[step]]);
+                break;
+            case Operation::POWER_CONSTANT: {
+                double exponent = dynamic_cast<Operation::PowerConstant&>(op).getValue();
+                if (exponent == (int) exponent) {
+                    // Compute an integer power by repeated squaring.
+
+                    int remaining = abs((int) exponent);
+                    bool hasValue = false;
+                    X86Ymm base = c.newYmmPs();
+                    c.vmovaps(base, workspaceVar[args[0]]);
+                    while (remaining > 0) {
+                        if ((remaining & 1) != 0) {
+                            if (hasValue)
+                                c.vmulps(dest, dest, base);
+                            else
+                                c.vmovaps(dest, base);
+                            hasValue = true;
+                        }
+                        remaining >>= 1;
+                        if (remaining > 0)
+                            c.vmulps(base, base, base);
+                    }
+                    if (!hasValue)
+                        c.vmovaps(dest, constantVar[operationConstantIndex[step]]);
+                    else if (exponent < 0)
+                        c.vdivps(dest, constantVar[operationConstantIndex[step]], dest);
+                }
+                else
+                    generateTwoArgCall(c, dest, workspaceVar[args[0]], constantVar[operationConstantIndex[step]], [] (float x, float y) { return std::pow(x, y); });
+                break;
+            }
+            case Operation::MIN:
+                c.vminps(dest, workspaceVar[args[0]], workspaceVar[args[1]]);
+                break;
+            case Operation::MAX:
+                c.vmaxps(dest, workspaceVar[args[0]], workspaceVar[args[1]]);
+                break;
+            case Operation::ABS: {
+                X86Ymm negated = c.newYmmPs();
+                c.vxorps(negated, negated, negated);
+                c.vsubps(negated, negated, workspaceVar[args[0]]);
+                c.vmaxps(dest, workspaceVar[args[0]], negated);
+                break;
+            }
+            case Operation::FLOOR:
+                c.vroundps(dest, workspaceVar[args[0]], imm(9));
+                break;
+            case Operation::CEIL:
+                c.vroundps(dest, workspaceVar[args[0]], imm(10));
+                break;
+            case Operation::SELECT: {
+                X86Ymm mask = c.newYmmPs();
+                c.vxorps(mask, mask, mask);
+                c.vcmpps(mask, workspaceVar[args[0]], mask, imm(0)); // Comparison mode is _CMP_EQ_OQ = 0
+                c.vblendvps(dest, workspaceVar[args[1]], workspaceVar[args[2]], mask);
+                break;
+            }
+            default: {
+                // Just invoke evaluateOperation().
+
+                for (int i = 0; i < (int) args.size(); i++)
+                    storeVector(c, x86::ptr(bufferPointer, 4*width*i, 0), workspaceVar[args[i]]);
+                X86Gp fn = c.newIntPtr();
+                c.mov(fn, imm_ptr((void*) evaluateOperation));
+                CCFuncCall* call = c.call(fn, FuncSignature4<void, Operation*, float*, double*, int>());
+                call->setArg(0, imm_ptr(&op));
+                call->setArg(1, imm_ptr(&callBuffer[0]));
+                call->setArg(2, imm_ptr(&argValues[0]));
+                call->setArg(3, imm(width));
+                loadVector(c, dest, x86::ptr(bufferPointer, 0, 0));
+            }
+        }
+    }
+
+    // Store the result.
+
+    X86Gp resultPointer = c.newIntPtr();
+    c.mov(resultPointer, imm_ptr(&workspace[workspace.size()-width]));
+    storeVector(c, x86::ptr(resultPointer, 0, 0), workspaceVar[workspaceSize-1]);
+    c.ret();
+    c.endFunc();
+    c.finalize();
+    runtime.add(&jitCode, &code);
+}
+
+void CompiledVectorExpression::generateSingleArgCall(X86Compiler& c, X86Ymm& dest, X86Ymm& arg, float (*function)(float)) {
+    X86Gp bufferPointer = c.newIntPtr();
+    c.mov(bufferPointer, imm_ptr(&callBuffer[0]));
+    storeVector(c, x86::ptr(bufferPointer, 0, 0), arg);
+    X86Gp fn = c.newIntPtr();
+    c.mov(fn, imm_ptr((void*) evaluateSingleArgFunction));
+    CCFuncCall* call = c.call(fn, FuncSignature3<void, void*, float*, int>());
+    call->setArg(0, imm_ptr((void*) function));
+    call->setArg(1, imm_ptr(&callBuffer[0]));
+    call->setArg(2, imm(width));
+    loadVector(c, dest, x86::ptr(bufferPointer, 0, 0));
+}
+
+void CompiledVectorExpression::generateTwoArgCall(X86Compiler& c, X86Ymm& dest, X86Ymm& arg1, X86Ymm& arg2, float (*function)(float, float)) {
+    X86Gp bufferPointer = c.newIntPtr();
+    c.mov(bufferPointer, imm_ptr(&callBuffer[0]));
+    storeVector(c, x86::ptr(bufferPointer, 0, 0), arg1);
+    storeVector(c, x86::ptr(bufferPointer, 4*width, 0), arg2);
+    X86Gp fn = c.newIntPtr();
+    c.mov(fn, imm_ptr((void*) evaluateTwoArgFunction));
+    CCFuncCall* call = c.call(fn, FuncSignature3<void, void*, float*, int>());
+    call->setArg(0, imm_ptr((void*) function));
+    call->setArg(1, imm_ptr(&callBuffer[0]));
+    call->setArg(2, imm(width));
+    loadVector(c, dest, x86::ptr(bufferPointer, 0, 0));
+}
+
+void CompiledVectorExpression::loadVector(X86Compiler& c, X86Ymm& dest, X86Mem src) {
+    if (width == 8)
+        c.vmovups(dest, src);
+    else
+        c.vmovups(dest.cloneAs<X86Xmm>(), src);
+}
+
+void CompiledVectorExpression::storeVector(X86Compiler& c, X86Mem dest, X86Ymm& value) {
+    if (width == 8)
+        c.vmovups(dest, value);
+    else
+        c.vmovups(dest, value.cloneAs<X86Xmm>());
+}
+#endif
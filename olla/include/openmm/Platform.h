@@ -143,6 +143,23 @@ public:
      * any platform-specific data that was stored in it.
      */
     virtual void contextDestroyed(ContextImpl& context) const;
+    /**
+     * This is called by a Context while timing is enabled to block until all work that has been queued for it
+     * has finished executing.  This allows the times reported by Context::getTimingReport() to reflect the time
+     * kernels actually take, rather than the time needed to launch them.  Platforms that execute kernels
+     * asynchronously should override it.  The default implementation does nothing.
+     */
+    virtual void synchronizeContext(ContextImpl& context) const;
+    /**
+     * Add Platform-specific performance statistics for a Context to a timing report, such as how often the
+     * neighbor list has been rebuilt.  This is called by Context::getTimingReport().  Every value should be a
+     * running total since the Context was created, so that the Context can report the change since the report
+     * was last reset by subtracting.  The default implementation adds nothing.
+     *
+     * @param context     the context to get statistics for
+     * @param statistics  the statistics should be added to this map.  Keys are the names of the statistics.
+     */
+    virtual void getTimingStatistics(ContextImpl& context, std::map<std::string, double>& statistics) const;
     /**
      * Register a KernelFactory which should be used to create Kernels with a particular name.
      * The Platform takes over ownership of the factory, and will delete it when the Platform itself
@@ -224,7 +241,9 @@ public:
      *
      * This method loops over every file contained in the specified directories and calls loadPluginLibrary()
      * for each one.  If an error occurs while trying to load a particular file, that file is simply
-     * ignored. You can retrieve a list of all such errors by calling getPluginLoadFailures().
+     * ignored. You can retrieve a list of all such errors by calling getPluginLoadFailures().  Files that fail
+     * to load are retried after the others have been loaded, so a plugin may depend on another plugin in the
+     * same directory.
      *
      * @param directory    a ':' (unix) or ';' (windows) deliminated list of paths containing libraries to load
      * @return the names of all files which were successfully loaded as libraries
@@ -56,6 +56,7 @@
 #include "openmm/KernelImpl.h"
 #include "openmm/LangevinIntegrator.h"
 #include "openmm/MonteCarloBarostat.h"
+#include "openmm/MTSLangevinIntegrator.h"
 #include "openmm/PeriodicTorsionForce.h"
 #include "openmm/RBTorsionForce.h"
 #include "openmm/RMSDForce.h"
@@ -291,6 +292,46 @@ public:
     virtual void computePositions(ContextImpl& context) = 0;
 };
 
+/**
+ * This kernel is used by LocalEnergyMinimizer to evaluate the objective function.  It works directly
+ * on the positions and forces stored by the platform, so that each evaluation avoids creating a State
+ * and copying data that is not needed.  Platforms that do not provide it fall back to a generic
+ * implementation based on the public Context API.
+ */
+class MinimizeKernel : public KernelImpl {
+public:
+    static std::string Name() {
+        return "Minimize";
+    }
+    MinimizeKernel(std::string name, const Platform& platform) : KernelImpl(name, platform) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     */
+    virtual void initialize(const System& system) = 0;
+    /**
+     * Set the particle positions, then compute the potential energy and its gradient with respect to
+     * the positions.  Distance constraints are replaced by harmonic restraints, whose energy and
+     * forces are included in the result.  The gradient for massless particles is set to zero.
+     *
+     * @param context    the context in which to execute this kernel
+     * @param x          the particle positions, stored as 3*numParticles consecutive values
+     * @param gradient   on exit, this contains the gradient of the energy, stored in the same order as x
+     * @param k          the force constant for the harmonic restraints that replace constraints
+     * @param groups     a set of bit flags for which force groups to include
+     * @return the potential energy, including the restraint energy
+     */
+    virtual double computeEnergyAndGradient(ContextImpl& context, const double* x, double* gradient, double k, int groups) = 0;
+    /**
+     * Get the largest amount by which any distance constraint is violated by the current positions.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    virtual double getMaxConstraintError(ContextImpl& context) = 0;
+};
+
 /**
  * This kernel is invoked by HarmonicBondForce to calculate the forces acting on the system and the energy of the system.
  */
@@ -1241,6 +1282,43 @@ public:
     virtual double computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) = 0;
 };
 
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.
+ */
+class IntegrateMTSLangevinStepKernel : public KernelImpl {
+public:
+    static std::string Name() {
+        return "IntegrateMTSLangevinStep";
+    }
+    IntegrateMTSLangevinStepKernel(std::string name, const Platform& platform) : KernelImpl(name, platform) {
+    }
+    /**
+     * Initialize the kernel.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    virtual void initialize(const System& system, const MTSLangevinIntegrator& integrator) = 0;
+    /**
+     * Execute the kernel.  This is responsible for computing forces for each force group as they are needed.
+     * 
+     * @param context        the context in which to execute this kernel
+     * @param integrator     the MTSLangevinIntegrator this kernel is being used for
+     * @param forcesAreValid if the context has been modified since the last time step, this will be
+     *                       false to show that cached forces are invalid and must be recalculated.
+     *                       On exit, this should specify whether the cached forces are valid at the
+     *                       end of the step.
+     */
+    virtual void execute(ContextImpl& context, const MTSLangevinIntegrator& integrator, bool& forcesAreValid) = 0;
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    virtual double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) = 0;
+};
+
 /**
  * This kernel is invoked by BrownianIntegrator to take one time step.
  */
@@ -1555,6 +1633,14 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     virtual void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const = 0;
+    /**
+     * Get the wall clock time (in seconds) spent on the most recent computation.  This covers the
+     * calculation itself, not any time the results spent waiting for finishComputation() to be called.
+     * Implementations that do not record it return 0.
+     */
+    virtual double getLastComputationTime() const {
+        return 0.0;
+    }
 };
 
 /**
@@ -1628,6 +1714,14 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     virtual void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const = 0;
+    /**
+     * Get the wall clock time (in seconds) spent on the most recent computation.  This covers the
+     * calculation itself, not any time the results spent waiting for finishComputation() to be called.
+     * Implementations that do not record it return 0.
+     */
+    virtual double getLastComputationTime() const {
+        return 0.0;
+    }
 };
 
 } // namespace OpenMM
@@ -127,6 +127,12 @@ void Platform::linkedContextCreated(ContextImpl& context, ContextImpl& originalC
 void Platform::contextDestroyed(ContextImpl& context) const {
 }
 
+void Platform::synchronizeContext(ContextImpl& context) const {
+}
+
+void Platform::getTimingStatistics(ContextImpl& context, map<string, double>& statistics) const {
+}
+
 void Platform::registerKernelFactory(const string& name, KernelFactory* factory) {
     kernelFactories[name] = factory;
 }
@@ -307,13 +313,26 @@ vector<string> Platform::loadPluginsFromDirectory(const string& directory) {
     pluginLoadFailures.resize(0);
     std::sort (files.begin(), files.end(), stringLengthComparator);
 
-    for (unsigned int i = 0; i < files.size(); ++i) {
-        try {
-            plugins.push_back(loadOneLibrary(files[i]));
-            loadedLibraries.push_back(files[i]);
-        } catch (OpenMMException& ex) {
-	    pluginLoadFailures.push_back(ex.what());
+    // Sorting by length usually causes libraries to be loaded after the ones they depend on, but not
+    // always.  If any library fails to load, keep retrying the failures for as long as some other
+    // library in the directory loads successfully, since that may be the one they depend on.
+
+    vector<string> remaining = files;
+    while (true) {
+        vector<string> failed;
+        pluginLoadFailures.resize(0);
+        for (auto& file : remaining) {
+            try {
+                plugins.push_back(loadOneLibrary(file));
+                loadedLibraries.push_back(file);
+            } catch (OpenMMException& ex) {
+                failed.push_back(file);
+                pluginLoadFailures.push_back(ex.what());
+            }
         }
+        if (failed.size() == 0 || failed.size() == remaining.size())
+            break;
+        remaining = failed;
     }
     initializePlugins(plugins);
     return loadedLibraries;
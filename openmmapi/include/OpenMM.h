@@ -62,6 +62,7 @@
 #include "openmm/MonteCarloBarostat.h"
 #include "openmm/MonteCarloFlexibleBarostat.h"
 #include "openmm/MonteCarloMembraneBarostat.h"
+#include "openmm/MTSLangevinIntegrator.h"
 #include "openmm/NonbondedForce.h"
 #include "openmm/Context.h"
 #include "openmm/OpenMMException.h"
@@ -80,6 +81,9 @@
 #include "openmm/NoseHooverChain.h"
 #include "openmm/VirtualSite.h"
 #include "openmm/Platform.h"
+#include "openmm/serialization/BinarySerializer.h"
+#include "openmm/serialization/CheckpointReader.h"
+#include "openmm/serialization/CheckpointWriter.h"
 #include "openmm/serialization/XmlSerializer.h"
 
 #endif /*OPENMM_H_*/
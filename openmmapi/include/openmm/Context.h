@@ -125,6 +125,24 @@ public:
      * and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
      */
     State getState(int types, bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
+    /**
+     * Store the current state information stored in this context into an existing State object.
+     * This is identical to getState(int, bool, int), except that it reuses the memory already
+     * held by the State.  When the same State is passed on every call, storing positions,
+     * velocities, forces, energies, parameters, and parameter derivatives does not allocate memory
+     * after the first one.  Integrator parameters are rebuilt on every call, so requesting them
+     * still allocates.  Any data previously stored in the State is discarded.
+     * 
+     * @param[out] state the State to store the data into
+     * @param types the set of data types which should be stored in the State object.  This
+     * should be a union of DataType values, e.g. (State::Positions | State::Velocities).
+     * @param enforcePeriodicBox if false, the position of each particle will be whatever position
+     * is stored in the Context, regardless of periodic boundary conditions.  If true, particle
+     * positions will be translated so the center of every molecule lies in the same periodic box.
+     * @param groups a set of bit flags for which force groups to include when computing forces
+     * and energies.  Group i will be included if (groups&(1<<i)) != 0.  The default value includes all groups.
+     */
+    void getState(State& state, int types, bool enforcePeriodicBox=false, int groups=0xFFFFFFFF) const;
     /**
      * Copy information from a State object into this Context.  This restores the Context to
      * approximately the same state it was in when the State was created.  If the State does not include
@@ -272,6 +290,9 @@ public:
      * with different versions of OpenMM are also often incompatible.  If a checkpoint cannot be loaded,
      * that is signaled by throwing an exception.
      * 
+     * If you need checkpoints that can be loaded on a different Platform or computer, use CheckpointWriter
+     * and CheckpointReader instead.
+     * 
      * @param stream    an input stream the checkpoint data should be read from
      */
     void loadCheckpoint(std::istream& stream);
@@ -284,10 +305,61 @@ public:
      * belong to exactly one molecule.
      */
     const std::vector<std::vector<int> >& getMolecules() const;
+    /**
+     * Get a breakdown of how long it took to create this Context.  This is useful for identifying
+     * what dominates startup time for very large Systems.  The keys identify phases of initialization
+     * ("Validate System", "Create ForceImpls", "Create Platform Data", "Initialize Platform Kernels",
+     * "Initialize Integrator", and "Initialize <name>" for each Force, where <name> is the value returned
+     * by the Force's getName() method).  The values are the time spent on each one, measured in seconds.
+     * If several Forces have the same name, their times are added together.  Molecules are identified
+     * lazily the first time they are needed, so "Find Molecules" is only present once that has happened.
+     */
+    const std::map<std::string, double>& getInitializationTimes() const;
+    /**
+     * Set whether to record how much time is spent on each part of a simulation.  The results can be
+     * retrieved with getTimingReport().  Timing is disabled by default, and has almost no cost while it
+     * is disabled.  When it is enabled, Platforms that execute kernels asynchronously (such as CUDA and
+     * OpenCL) wait for each operation to finish before timing the next one, so simulations may run
+     * noticeably slower.
+     */
+    void setTimingEnabled(bool enabled);
+    /**
+     * Get whether timing information is being recorded.  See setTimingEnabled().
+     */
+    bool getTimingEnabled() const;
+    /**
+     * Get a report of where time has been spent since the Context was created or resetTimingReport() was
+     * last called.  Times are only recorded while timing is enabled.  They are wall clock times in seconds,
+     * and each operation's time excludes any other timed operations that happened inside it, such as a
+     * barostat evaluating the energy.  The report includes
+     *
+     * <ul>
+     * <li>The time spent computing each Force, identified by the value returned by its getName() method.
+     * If several Forces have the same name, their times are added together.</li>
+     * <li>"Begin Force Computation" and "Finish Force Computation": work the Platform does before and after
+     * computing the individual Forces, such as clearing and summing force buffers.</li>
+     * <li>"Force Evaluations": the number of times forces and energies have been computed.</li>
+     * <li>"Integrate": the time spent in the Integrator's own kernels, excluding force computation.</li>
+     * <li>"Update Context State", "Apply Constraints", and "Compute Virtual Sites": the time spent in those
+     * operations when they are invoked outside the Integrator's kernels.</li>
+     * </ul>
+     *
+     * Platforms also may add their own entries, which are recorded whether or not timing is enabled.  For
+     * example, the Reference and CPU platforms report "Constraint Iterations" and "Constraint Applications",
+     * and the CPU platform reports "Neighbor List Checks", "Neighbor List Builds", and the "Thread Task Time"
+     * and "Thread Idle Time" that measure how evenly work is divided between threads.
+     */
+    std::map<std::string, double> getTimingReport() const;
+    /**
+     * Discard all timing information recorded so far.  Later calls to getTimingReport() only include
+     * what happens after this is called.
+     */
+    void resetTimingReport();
 private:
     friend class ContextImpl;
     friend class Force;
     friend class ForceImpl;
+    friend class LocalEnergyMinimizer;
     friend class Platform;
     Context(const System& system, Integrator& integrator, ContextImpl& linked);
     ContextImpl& getImpl();
@@ -33,12 +33,14 @@
  * -------------------------------------------------------------------------- */
 
 #include "Context.h"
+#include <vector>
 
 namespace OpenMM {
 
 /**
  * Given a Context, this class searches for a new set of particle positions that represent
- * a local minimum of the potential energy.  The search is performed with the L-BFGS algorithm.
+ * a local minimum of the potential energy.  By default the search is performed with the L-BFGS
+ * algorithm, but other algorithms can be selected with the Algorithm argument.
  * Distance constraints are enforced during minimization by adding a harmonic restraining
  * force to the potential function.  The strength of the restraining force is steadily increased
  * until the minimum energy configuration satisfies all constraints to within the tolerance
@@ -51,6 +53,29 @@ namespace OpenMM {
 
 class OPENMM_EXPORT LocalEnergyMinimizer {
 public:
+    /**
+     * This is an enumeration of the algorithms that can be used for minimization.
+     */
+    enum Algorithm {
+        /**
+         * The limited memory Broyden-Fletcher-Goldfarb-Shanno (L-BFGS) algorithm.  This is the default.
+         */
+        LBFGS = 0,
+        /**
+         * L-BFGS with a diagonal preconditioner.  The coordinates of each particle are scaled by the square root
+         * of an estimate of the corresponding diagonal element of the Hessian, based on the force constants of
+         * HarmonicBondForces and of the restraints used for constraints.  If the System has neither, particle
+         * masses are used instead.  This can reduce the number of iterations for systems whose stiffness varies
+         * widely between particles.
+         */
+        PreconditionedLBFGS = 1,
+        /**
+         * The Fast Inertial Relaxation Engine (FIRE).  This is a damped dynamics method that only uses forces,
+         * so it is robust to noise in the energy and to very rough starting structures, but usually needs more
+         * iterations than L-BFGS to converge tightly.
+         */
+        FIRE = 2
+    };
     /**
      * Search for a new set of particle positions that represent a local potential energy minimum.
      * On exit, the Context will have been updated with the new positions.
@@ -62,8 +87,29 @@ public:
      * @param maxIterations  the maximum number of iterations to perform.  If this is 0, minimation is continued
      *                       until the results converge without regard to how many iterations it takes.  The
      *                       default value is 0.
+     * @param algorithm      the algorithm to use for minimization.  The default value is LBFGS.
+     */
+    static void minimize(Context& context, double tolerance = 10, int maxIterations = 0, Algorithm algorithm = LBFGS);
+    /**
+     * Minimize many conformations of the same System, one after another, using a single Context.  This is
+     * equivalent to calling setPositions() and minimize() for each one, but the minimizer's internal
+     * data structures are created only once, which makes it faster when there are many short minimizations.
+     * On exit, the Context contains the last minimized conformation.
+     *
+     * @param context        a Context specifying the System to minimize
+     * @param positions      the initial particle positions for each conformation.  On exit, these are replaced
+     *                       by the minimized positions.
+     * @param tolerance      this specifies how precisely the energy minimum must be located.  Minimization
+     *                       will be halted once the root-mean-square value of all force components reaches
+     *                       this tolerance.  The default value is 10.
+     * @param maxIterations  the maximum number of iterations to perform for each conformation.  If this is 0,
+     *                       minimation is continued until the results converge without regard to how many
+     *                       iterations it takes.  The default value is 0.
+     * @param algorithm      the algorithm to use for minimization.  The default value is LBFGS.
+     * @return the potential energy of each minimized conformation
      */
-    static void minimize(Context& context, double tolerance = 10, int maxIterations = 0);
+    static std::vector<double> minimizeBatch(Context& context, std::vector<std::vector<Vec3> >& positions, double tolerance = 10,
+            int maxIterations = 0, Algorithm algorithm = LBFGS);
 };
 
 } // namespace OpenMM
@@ -134,6 +134,27 @@ public:
     void setRandomNumberSeed(int seed) {
         randomNumberSeed = seed;
     }
+    /**
+     * Get whether the barostat skips recomputing the energy of force groups that are unaffected by
+     * Monte Carlo moves.  See setUseIncrementalEnergy() for details.
+     */
+    bool getUseIncrementalEnergy() const {
+        return useIncrementalEnergy;
+    }
+    /**
+     * Set whether the barostat skips recomputing the energy of force groups that are unaffected by
+     * Monte Carlo moves.  A trial move scales the position of each molecule's center while leaving its
+     * internal geometry unchanged, so a bonded interaction whose particles all belong to the same molecule
+     * has the same energy before and after the move.  When this is enabled, any force group that contains
+     * only such interactions (HarmonicBondForce, HarmonicAngleForce, PeriodicTorsionForce, RBTorsionForce,
+     * CMAPTorsionForce, CustomBondForce, CustomAngleForce, and CustomTorsionForce that do not use periodic
+     * boundary conditions) is left out of the energy evaluations for trial moves.
+     * This gives the same acceptance probabilities up to roundoff error.  To benefit from it, put the
+     * bonded forces in a different force group from the nonbonded ones.  The default is false.
+     */
+    void setUseIncrementalEnergy(bool use) {
+        useIncrementalEnergy = use;
+    }
     /**
      * Returns whether or not this force makes use of periodic boundary
      * conditions.
@@ -148,6 +169,7 @@ protected:
 private:
     double defaultPressure, defaultTemperature;
     int frequency, randomNumberSeed;
+    bool useIncrementalEnergy;
 };
 
 } // namespace OpenMM
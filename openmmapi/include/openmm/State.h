@@ -50,6 +50,12 @@ namespace OpenMM {
  * important for forces and energies, since they may need to be calculated.  If you query a
  * State object for a piece of information which is not available (because it was not requested
  * when the State was created), it will throw an exception.
+ *
+ * If you retrieve States repeatedly, for example to report on a long simulation, you can pass
+ * the same State to Context::getState(State&, int, bool, int) each time.  Its internal storage
+ * is then reused, so positions, velocities, forces, energies, parameters, and parameter derivatives
+ * do not allocate memory after the first call.  Integrator parameters are rebuilt every time, so
+ * requesting them still allocates.
  */
 
 class OPENMM_EXPORT State {
@@ -84,6 +90,26 @@ public:
      * Get the force acting on each particle.  If this State does not contain forces, this will throw an exception.
      */
     const std::vector<Vec3>& getForces() const;
+    /**
+     * Get direct access to the positions, velocities, or forces stored in this State.  The values
+     * are stored as a flat array of 3*N double precision values (x, y, and z for each particle).
+     * The pointer refers to the State's internal storage, so no data is copied.  It remains valid
+     * until the State is modified or destroyed.  If this State does not contain the requested data,
+     * this will throw an exception.
+     *
+     * @param type    the type of data to return.  This must be Positions, Velocities, or Forces.
+     */
+    const double* getRawData(DataType type) const;
+    /**
+     * Copy the positions, velocities, or forces stored in this State into a flat array of 3*N single
+     * precision values (x, y, and z for each particle).  The vector is only reallocated if it is not
+     * already large enough, so passing the same vector on every call avoids allocating memory.  If this
+     * State does not contain the requested data, this will throw an exception.
+     *
+     * @param type       the type of data to return.  This must be Positions, Velocities, or Forces.
+     * @param[out] data  the values are stored into this
+     */
+    void getRawData(DataType type, std::vector<float>& data) const;
     /**
      * Get the total kinetic energy of the system.  If this State does not contain energies, this will throw an exception.
      *
@@ -131,7 +157,15 @@ public:
 private:
     friend class Context;
     friend class StateProxy;
+    friend class BinarySerializer;
     State(double time, long long stepCount);
+    void reset(double time, long long stepCount);
+    std::vector<Vec3>& updatePositions();
+    std::vector<Vec3>& updateVelocities();
+    std::vector<Vec3>& updateForces();
+    std::map<std::string, double>& updateParameters();
+    std::map<std::string, double>& updateEnergyParameterDerivatives();
+    const std::vector<Vec3>& getVectorData(DataType type) const;
     void setPositions(const std::vector<Vec3>& pos);
     void setVelocities(const std::vector<Vec3>& vel);
     void setForces(const std::vector<Vec3>& force);
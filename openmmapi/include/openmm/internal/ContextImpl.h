@@ -258,6 +258,44 @@ public:
      * same molecule if they are connected by constraints or bonds.
      */
     const std::vector<std::vector<int> >& getMolecules() const;
+    /**
+     * Get the time in seconds spent on each phase of creating this context.  See Context::getInitializationTimes()
+     * for details.
+     */
+    const std::map<std::string, double>& getInitializationTimes() const {
+        return initializationTimes;
+    }
+    /**
+     * Get whether timing information is being recorded for this context.  See Context::setTimingEnabled().
+     */
+    bool getTimingEnabled() const {
+        return timingEnabled;
+    }
+    /**
+     * Set whether timing information is being recorded for this context.
+     */
+    void setTimingEnabled(bool enabled);
+    /**
+     * Begin timing an operation.  This should only be called while timing is enabled, and every call must
+     * be matched by a call to endTiming().  Operations may be nested, in which case the time spent in the
+     * inner operation is excluded from the outer one.
+     */
+    void beginTiming();
+    /**
+     * Finish timing the operation started by the most recent call to beginTiming(), and add the elapsed
+     * time to the timing report.
+     *
+     * @param name    the name to record the time under
+     */
+    void endTiming(const std::string& name);
+    /**
+     * Get the timing report for this context.  See Context::getTimingReport() for details.
+     */
+    std::map<std::string, double> getTimingReport();
+    /**
+     * Discard all timing information recorded so far.
+     */
+    void resetTimingReport();
     /**
      * Create a checkpoint recording the current state of the Context.
      * 
@@ -298,13 +336,17 @@ public:
 private:
     friend class Context;
     void initialize();
+    double calcForcesAndEnergyWithTiming(bool includeForces, bool includeEnergy, int groups);
     Context& owner;
     const System& system;
     Integrator& integrator;
     std::vector<ForceImpl*> forceImpls;
     std::map<std::string, double> parameters;
     mutable std::vector<std::vector<int> > molecules;
-    bool hasInitializedForces, hasSetPositions, integratorIsDeleted;
+    mutable std::map<std::string, double> initializationTimes;
+    std::map<std::string, double> timingReport, platformTimingBaseline;
+    std::vector<std::pair<double, double> > timingStack;
+    bool hasInitializedForces, hasSetPositions, integratorIsDeleted, timingEnabled;
     int lastForceGroups;
     Platform* platform;
     Kernel initializeForcesKernel, updateStateDataKernel, applyConstraintsKernel, virtualSitesKernel;
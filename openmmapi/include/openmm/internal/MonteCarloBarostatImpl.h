@@ -58,8 +58,12 @@ public:
     std::map<std::string, double> getDefaultParameters();
     std::vector<std::string> getKernelNames();
 private:
+    /**
+     * Find which force groups contain forces whose energy may be changed by a trial move.
+     */
+    int findAffectedGroups(ContextImpl& context) const;
     const MonteCarloBarostat& owner;
-    int step, numAttempted, numAccepted;
+    int step, numAttempted, numAccepted, affectedGroups;
     double volumeScale;
     Kernel kernel;
 };
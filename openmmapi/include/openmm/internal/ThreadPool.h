@@ -88,9 +88,29 @@ public:
      * Instruct the threads to resume running after blocking at a synchronization point.
      */
     void resumeThreads();
+    /**
+     * Set whether to record how evenly work is divided between the threads.  While this is enabled,
+     * the pool records when each thread finishes every task (or reaches each synchronization point),
+     * which can be retrieved with getLoadBalanceStatistics().
+     */
+    void setRecordLoadBalance(bool record);
+    /**
+     * Get whether the pool is recording how evenly work is divided between the threads.
+     */
+    bool getRecordLoadBalance() const;
+    /**
+     * Get statistics on how evenly work has been divided between the threads.  The values are totals
+     * over every task executed while recording was enabled.  The fraction of thread time wasted due to
+     * load imbalance is idleTime/(getNumThreads()*taskTime).
+     *
+     * @param taskTime  on exit, the wall clock time from when tasks were started until the last thread finished them
+     * @param idleTime  on exit, the time threads spent waiting for other threads to finish, summed over all threads
+     */
+    void getLoadBalanceStatistics(double& taskTime, double& idleTime) const;
 private:
-    bool isDeleted;
+    bool isDeleted, recordLoadBalance, isRecordingTask;
     int numThreads, waitCount;
+    double taskStartTime, latestFinishTime, finishTimeSum, totalTaskTime, totalIdleTime;
     std::vector<pthread_t> thread;
     std::vector<ThreadData*> threadData;
     pthread_cond_t startCondition, endCondition;
@@ -0,0 +1,405 @@
+#ifndef OPENMM_VECTORIZE_AVX512_H_
+#define OPENMM_VECTORIZE_AVX512_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "vectorizeAvx.h"
+#include <immintrin.h>
+
+// This file defines classes and functions to simplify vectorizing code with AVX-512.
+
+bool isAvx512Supported() {
+
+    // Use the same CPUID implementation as for AVX2, since hardware.h does not set
+    // the CX register on older non-Windows OSes.
+#if !(defined(_WIN32) || defined(WIN32))
+    auto cpuid = [](int output[4], int functionnumber) {
+        int a, b, c, d;
+        __asm("cpuid" : "=a"(a),"=b"(b),"=c"(c),"=d"(d) : "a"(functionnumber), "c"(0) : );
+        output[0] = a;
+        output[1] = b;
+        output[2] = c;
+        output[3] = d;
+    };
+#endif
+
+    int cpuInfo[4];
+    cpuid(cpuInfo, 0);
+    if (cpuInfo[0] < 7)
+        return false;
+
+    // The processor must support AVX-512F, and the OS must save the full ZMM register state.
+
+    cpuid(cpuInfo, 1);
+    if ((cpuInfo[2] & ((int) 1 << 27)) == 0)
+        return false;
+    cpuInfo[2] = 0;
+    cpuid(cpuInfo, 7);
+    if ((cpuInfo[1] & ((int) 1 << 16)) == 0)
+        return false;
+#if defined(_WIN32) || defined(WIN32)
+    unsigned long long xcr0 = _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    unsigned long long xcr0 = ((unsigned long long) edx << 32) | eax;
+#endif
+    return ((xcr0 & 0xE6) == 0xE6);
+}
+
+class ivec16;
+
+/**
+ * A sixteen element mask, stored in an AVX-512 mask register.  Comparisons between
+ * fvec16s produce masks of this type, which can then be passed to blend(), blendZero(),
+ * and any().
+ */
+class mask16 {
+public:
+    __mmask16 val;
+
+    mask16() = default;
+    mask16(__mmask16 v) : val(v) {}
+    mask16 operator&(mask16 other) const {
+        return _mm512_kand(val, other.val);
+    }
+    mask16 operator|(mask16 other) const {
+        return _mm512_kor(val, other.val);
+    }
+};
+
+/**
+ * A sixteen element vector of floats.
+ */
+class fvec16 {
+public:
+    __m512 val;
+
+    fvec16() = default;
+    fvec16(float v) : val(_mm512_set1_ps(v)) {}
+    fvec16(float v1, float v2, float v3, float v4, float v5, float v6, float v7, float v8, float v9, float v10, float v11, float v12, float v13, float v14, float v15, float v16) :
+        val(_mm512_setr_ps(v1, v2, v3, v4, v5, v6, v7, v8, v9, v10, v11, v12, v13, v14, v15, v16)) {}
+    fvec16(__m512 v) : val(v) {}
+    fvec16(const float* v) : val(_mm512_loadu_ps(v)) {}
+
+    /** Create a vector by gathering individual indexes of data from a table. Element i of the vector will
+     * be loaded from table[idx[i]].
+     * @param table The table from which to do a lookup.
+     * @param indexes The indexes to gather.
+     */
+    fvec16(const float* table, const int32_t idx[16]) : val(_mm512_i32gather_ps(_mm512_loadu_si512(idx), table, 4)) {}
+
+    operator __m512() const {
+        return val;
+    }
+    fvec8 lowerVec() const {
+        return _mm512_castps512_ps256(val);
+    }
+    fvec8 upperVec() const {
+        return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(val), 1));
+    }
+    void store(float* v) const {
+        _mm512_storeu_ps(v, val);
+    }
+    fvec16 operator+(fvec16 other) const {
+        return _mm512_add_ps(val, other);
+    }
+    fvec16 operator-(fvec16 other) const {
+        return _mm512_sub_ps(val, other);
+    }
+    fvec16 operator*(fvec16 other) const {
+        return _mm512_mul_ps(val, other);
+    }
+    fvec16 operator/(fvec16 other) const {
+        return _mm512_div_ps(val, other);
+    }
+    void operator+=(fvec16 other) {
+        val = _mm512_add_ps(val, other);
+    }
+    void operator-=(fvec16 other) {
+        val = _mm512_sub_ps(val, other);
+    }
+    void operator*=(fvec16 other) {
+        val = _mm512_mul_ps(val, other);
+    }
+    void operator/=(fvec16 other) {
+        val = _mm512_div_ps(val, other);
+    }
+    fvec16 operator-() const {
+        return _mm512_sub_ps(_mm512_set1_ps(0.0f), val);
+    }
+    fvec16 operator&(fvec16 other) const {
+        return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(val), _mm512_castps_si512(other)));
+    }
+    fvec16 operator|(fvec16 other) const {
+        return _mm512_castsi512_ps(_mm512_or_si512(_mm512_castps_si512(val), _mm512_castps_si512(other)));
+    }
+    mask16 operator==(fvec16 other) const {
+        return _mm512_cmp_ps_mask(val, other, _CMP_EQ_OQ);
+    }
+    mask16 operator!=(fvec16 other) const {
+        return _mm512_cmp_ps_mask(val, other, _CMP_NEQ_OQ);
+    }
+    mask16 operator>(fvec16 other) const {
+        return _mm512_cmp_ps_mask(val, other, _CMP_GT_OQ);
+    }
+    mask16 operator<(fvec16 other) const {
+        return _mm512_cmp_ps_mask(val, other, _CMP_LT_OQ);
+    }
+    mask16 operator>=(fvec16 other) const {
+        return _mm512_cmp_ps_mask(val, other, _CMP_GE_OQ);
+    }
+    mask16 operator<=(fvec16 other) const {
+        return _mm512_cmp_ps_mask(val, other, _CMP_LE_OQ);
+    }
+    operator ivec16() const;
+
+    /**
+     * Convert an integer bitmask into a mask which can be used by the blend function.
+     * With AVX-512 this is simply the low 16 bits of the bitmask.
+     */
+    static mask16 expandBitsToMask(int bitmask);
+};
+
+/**
+ * A sixteen element vector of ints.
+ */
+class ivec16 {
+public:
+    __m512i val;
+
+    ivec16() {}
+    ivec16(int v) : val(_mm512_set1_epi32(v)) {}
+    ivec16(__m512i v) : val(v) {}
+    ivec16(const int* v) : val(_mm512_loadu_si512(v)) {}
+    operator __m512i() const {
+        return val;
+    }
+    ivec8 lowerVec() const {
+        return _mm512_castsi512_si256(val);
+    }
+    ivec8 upperVec() const {
+        return _mm512_extracti64x4_epi64(val, 1);
+    }
+    void store(int* v) const {
+        _mm512_storeu_si512(v, val);
+    }
+    ivec16 operator+(ivec16 other) const {
+        return _mm512_add_epi32(val, other);
+    }
+    ivec16 operator-(ivec16 other) const {
+        return _mm512_sub_epi32(val, other);
+    }
+    ivec16 operator&(ivec16 other) const {
+        return _mm512_and_si512(val, other);
+    }
+    ivec16 operator|(ivec16 other) const {
+        return _mm512_or_si512(val, other);
+    }
+    mask16 operator==(ivec16 other) const {
+        return _mm512_cmpeq_epi32_mask(val, other);
+    }
+    mask16 operator!=(ivec16 other) const {
+        return _mm512_cmpneq_epi32_mask(val, other);
+    }
+    mask16 operator>(ivec16 other) const {
+        return _mm512_cmpgt_epi32_mask(val, other);
+    }
+    mask16 operator<(ivec16 other) const {
+        return _mm512_cmplt_epi32_mask(val, other);
+    }
+    mask16 operator>=(ivec16 other) const {
+        return _mm512_cmpge_epi32_mask(val, other);
+    }
+    mask16 operator<=(ivec16 other) const {
+        return _mm512_cmple_epi32_mask(val, other);
+    }
+    operator fvec16() const;
+};
+
+// Conversion operators.
+
+inline fvec16::operator ivec16() const {
+    return _mm512_cvttps_epi32(val);
+}
+
+inline ivec16::operator fvec16() const {
+    return _mm512_cvtepi32_ps(val);
+}
+
+inline mask16 fvec16::expandBitsToMask(int bitmask) {
+    return (__mmask16) bitmask;
+}
+
+// Functions that operate on fvec16s.
+
+static inline fvec16 floor(fvec16 v) {
+    return fvec16(_mm512_roundscale_ps(v.val, 0x09));
+}
+
+static inline fvec16 ceil(fvec16 v) {
+    return fvec16(_mm512_roundscale_ps(v.val, 0x0A));
+}
+
+static inline fvec16 round(fvec16 v) {
+    return fvec16(_mm512_roundscale_ps(v.val, _MM_FROUND_TO_NEAREST_INT));
+}
+
+static inline fvec16 min(fvec16 v1, fvec16 v2) {
+    return fvec16(_mm512_min_ps(v1.val, v2.val));
+}
+
+static inline fvec16 max(fvec16 v1, fvec16 v2) {
+    return fvec16(_mm512_max_ps(v1.val, v2.val));
+}
+
+static inline fvec16 abs(fvec16 v) {
+    return fvec16(_mm512_abs_ps(v.val));
+}
+
+static inline fvec16 sqrt(fvec16 v) {
+    return fvec16(_mm512_sqrt_ps(v.val));
+}
+
+static inline fvec16 rsqrt(fvec16 v) {
+    // Initial estimate of rsqrt(), accurate to 14 bits.
+
+    fvec16 y(_mm512_rsqrt14_ps(v.val));
+
+    // Perform an iteration of Newton refinement.
+
+    fvec16 x2 = v*0.5f;
+    y *= fvec16(1.5f)-x2*y*y;
+    return y;
+}
+
+static inline float reduceAdd(fvec16 v) {
+    return _mm512_reduce_add_ps(v.val);
+}
+
+/**
+ * Combine two eight element vectors into the lower and upper halves of a sixteen element vector.
+ */
+static inline fvec16 combine(fvec8 lower, fvec8 upper) {
+    return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(lower)), _mm256_castps_pd(upper), 1));
+}
+
+/** Given a vec4[16] input array, generate 4 vec16 outputs. The first output contains all the first elements
+ * the second output the second elements, and so on. Note that the prototype is essentially differing only
+ * in output type so it can be overloaded in other SIMD fvec types.
+ */
+static inline void transpose(const fvec4 in[16], fvec16& out1, fvec16& out2, fvec16& out3, fvec16& out4) {
+    fvec8 lower1, lower2, lower3, lower4, upper1, upper2, upper3, upper4;
+    transpose(in, lower1, lower2, lower3, lower4);
+    transpose(in+8, upper1, upper2, upper3, upper4);
+    out1 = combine(lower1, upper1);
+    out2 = combine(lower2, upper2);
+    out3 = combine(lower3, upper3);
+    out4 = combine(lower4, upper4);
+}
+
+/**
+ * Given 4 input vectors of 16 elements, transpose them to form 16 output vectors of 4 elements.
+ */
+static inline void transpose(fvec16 in1, fvec16 in2, fvec16 in3, fvec16 in4, fvec4 out[16]) {
+    transpose(in1.lowerVec(), in2.lowerVec(), in3.lowerVec(), in4.lowerVec(), out);
+    transpose(in1.upperVec(), in2.upperVec(), in3.upperVec(), in4.upperVec(), out+8);
+}
+
+// Functions that operate on masks.
+
+static inline bool any(mask16 m) {
+    return m.val != 0;
+}
+
+// Mathematical operators involving a scalar and a vector.
+
+static inline fvec16 operator+(float v1, fvec16 v2) {
+    return fvec16(v1)+v2;
+}
+
+static inline fvec16 operator-(float v1, fvec16 v2) {
+    return fvec16(v1)-v2;
+}
+
+static inline fvec16 operator*(float v1, fvec16 v2) {
+    return fvec16(v1)*v2;
+}
+
+static inline fvec16 operator/(float v1, fvec16 v2) {
+    return fvec16(v1)/v2;
+}
+
+// Operations for blending fvec16 using a mask register.  Elements whose mask bit is
+// set are taken from v2, and the others from v1.
+
+static inline fvec16 blend(fvec16 v1, fvec16 v2, mask16 mask) {
+    return fvec16(_mm512_mask_blend_ps(mask.val, v1.val, v2.val));
+}
+
+static inline fvec16 blendZero(fvec16 v, mask16 mask) {
+    return fvec16(_mm512_maskz_mov_ps(mask.val, v.val));
+}
+
+static inline mask16 blendZero(mask16 v, mask16 mask) {
+    return v & mask;
+}
+
+/**
+ * Given a table of floating-point values and a set of indexes, perform a gather read into a pair
+ * of vectors. The first result vector contains the values at the given indexes, and the second
+ * result vector contains the values from each respective index+1.
+ */
+static inline void gatherVecPair(const float* table, ivec16 index, fvec16& out0, fvec16& out1) {
+    // Each index refers to a pair of adjacent floats, so gather them as doubles. This gives
+    // two vectors of interleaved pairs, one for the lower eight indexes and one for the upper.
+    const auto lowerGather = _mm512_castpd_ps(_mm512_i32gather_pd(index.lowerVec(), table, 4));
+    const auto upperGather = _mm512_castpd_ps(_mm512_i32gather_pd(index.upperVec(), table, 4));
+
+    // Deinterleave them, taking the even elements from both for the first output and the
+    // odd elements for the second.
+    const auto evenIdx = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const auto oddIdx = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    out0 = fvec16(_mm512_permutex2var_ps(lowerGather, evenIdx, upperGather));
+    out1 = fvec16(_mm512_permutex2var_ps(lowerGather, oddIdx, upperGather));
+}
+
+/**
+ * Given 3 vectors of floating-point data, reduce them to a single 3-element position
+ * value by adding all the elements in each vector.  The upper and lower halves are first
+ * added together, then the result is reduced with the AVX implementation.
+ */
+static inline fvec4 reduceToVec3(fvec16 x, fvec16 y, fvec16 z) {
+    return reduceToVec3(x.lowerVec()+x.upperVec(), y.lowerVec()+y.upperVec(), z.lowerVec()+z.upperVec());
+}
+
+#endif /*OPENMM_VECTORIZE_AVX512_H_*/
@@ -93,6 +93,10 @@ void BrownianIntegrator::step(int steps) {
     for (int i = 0; i < steps; ++i) {
         context->updateContextState();
         context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
+        if (context->getTimingEnabled())
+            context->beginTiming();
         kernel.getAs<IntegrateBrownianStepKernel>().execute(*context, *this);
+        if (context->getTimingEnabled())
+            context->endTiming("Integrate");
     }
 }
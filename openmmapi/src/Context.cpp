@@ -87,10 +87,16 @@ Platform& Context::getPlatform() {
 }
 
 State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
-    State::StateBuilder builder(impl->getTime(), impl->getStepCount());
+    State state;
+    getState(state, types, enforcePeriodicBox, groups);
+    return state;
+}
+
+void Context::getState(State& state, int types, bool enforcePeriodicBox, int groups) const {
+    state.reset(impl->getTime(), impl->getStepCount());
     Vec3 periodicBoxSize[3];
     impl->getPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
-    builder.setPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
+    state.setPeriodicBoxVectors(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2]);
     bool includeForces = types&State::Forces;
     bool includeEnergy = types&State::Energy;
     bool includeParameterDerivs = types&State::ParameterDerivatives;
@@ -98,26 +104,18 @@ State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
     if (includeForces || includeEnergy || includeParameterDerivs) {
         double energy = impl->calcForcesAndEnergy(includeForces || needForcesForEnergy || includeParameterDerivs, includeEnergy, groups);
         if (includeEnergy)
-            builder.setEnergy(impl->calcKineticEnergy(), energy);
-        if (includeForces) {
-            vector<Vec3> forces;
-            impl->getForces(forces);
-            builder.setForces(forces);
-        }
-    }
-    if (types&State::Parameters) {
-        map<string, double> params;
-        for (auto& param : impl->parameters)
-            params[param.first] = param.second;
-        builder.setParameters(params);
-    }
-    if (types&State::ParameterDerivatives) {
-        map<string, double> derivs;
-        impl->getEnergyParameterDerivatives(derivs);
-        builder.setEnergyParameterDerivatives(derivs);
+            state.setEnergy(impl->calcKineticEnergy(), energy);
+        if (includeForces)
+            impl->getForces(state.updateForces());
     }
+    // Assigning to the existing maps lets them reuse their nodes instead of allocating new ones.
+
+    if (types&State::Parameters)
+        state.updateParameters() = impl->parameters;
+    if (types&State::ParameterDerivatives)
+        impl->getEnergyParameterDerivatives(state.updateEnergyParameterDerivatives());
     if (types&State::Positions) {
-        vector<Vec3> positions;
+        vector<Vec3>& positions = state.updatePositions();
         impl->getPositions(positions);
         if (enforcePeriodicBox) {
             const vector<vector<int> >& molecules = impl->getMolecules();
@@ -140,17 +138,12 @@ State Context::getState(int types, bool enforcePeriodicBox, int groups) const {
                     positions[j] -= diff;
             }
         }
-        builder.setPositions(positions);
-    }
-    if (types&State::Velocities) {
-        vector<Vec3> velocities;
-        impl->getVelocities(velocities);
-        builder.setVelocities(velocities);
     }
+    if (types&State::Velocities)
+        impl->getVelocities(state.updateVelocities());
     if (types&State::IntegratorParameters) {
-        getIntegrator().serializeParameters(builder.updateIntegratorParameters());
+        getIntegrator().serializeParameters(state.updateIntegratorParameters());
     }
-    return builder.getState();
 }
 
 void Context::setState(const State& state) {
@@ -279,3 +272,23 @@ const ContextImpl& Context::getImpl() const {
 const vector<vector<int> >& Context::getMolecules() const {
     return impl->getMolecules();
 }
+
+const map<string, double>& Context::getInitializationTimes() const {
+    return impl->getInitializationTimes();
+}
+
+void Context::setTimingEnabled(bool enabled) {
+    impl->setTimingEnabled(enabled);
+}
+
+bool Context::getTimingEnabled() const {
+    return impl->getTimingEnabled();
+}
+
+map<string, double> Context::getTimingReport() const {
+    return impl->getTimingReport();
+}
+
+void Context::resetTimingReport() {
+    impl->resetTimingReport();
+}
@@ -36,10 +36,13 @@
 #include "openmm/kernels.h"
 #include "openmm/internal/ForceImpl.h"
 #include "openmm/internal/ContextImpl.h"
+#include "openmm/internal/ThreadPool.h"
+#include "openmm/internal/timer.h"
 #include "openmm/State.h"
 #include "openmm/VirtualSite.h"
 #include "openmm/Context.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
@@ -55,7 +58,8 @@ const static char CHECKPOINT_MAGIC_BYTES[] = "OpenMM Binary Checkpoint\n";
 
 ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integrator, Platform* platform, const map<string, string>& properties, ContextImpl* originalContext) :
         owner(owner), system(system), integrator(integrator), hasInitializedForces(false), hasSetPositions(false), integratorIsDeleted(false),
-        lastForceGroups(-1), platform(platform), platformData(NULL) {
+        timingEnabled(false), lastForceGroups(-1), platform(platform), platformData(NULL) {
+    double startTime = getCurrentTime();
     int numParticles = system.getNumParticles();
     if (numParticles == 0)
         throw OpenMMException("Cannot create a Context for a System with no particles");
@@ -72,7 +76,7 @@ ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integ
                     throw OpenMMException("A virtual site cannot depend on another virtual site");
         }
     }
-    set<pair<int, int> > constraintAtoms;
+    vector<pair<int, int> > constraintAtoms(system.getNumConstraints());
     for (int i = 0; i < system.getNumConstraints(); i++) {
         int particle1, particle2;
         double distance;
@@ -85,30 +89,36 @@ ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integ
         double mass2 = system.getParticleMass(particle2);
         if ((mass1 == 0.0 && mass2 != 0.0) || (mass2 == 0.0 && mass1 != 0.0))
             throw OpenMMException("A constraint cannot involve a massless particle");
-        pair<int, int> atoms = make_pair(min(particle1, particle2), max(particle1, particle2));
-        if (constraintAtoms.find(atoms) != constraintAtoms.end())
-            throw OpenMMException("The System has two constraints between the same atoms.  This will produce a singular constraint matrix.");
-        constraintAtoms.insert(atoms);
+        constraintAtoms[i] = make_pair(min(particle1, particle2), max(particle1, particle2));
     }
+    sort(constraintAtoms.begin(), constraintAtoms.end());
+    if (adjacent_find(constraintAtoms.begin(), constraintAtoms.end()) != constraintAtoms.end())
+        throw OpenMMException("The System has two constraints between the same atoms.  This will produce a singular constraint matrix.");
     
-    // Validate the list of properties.
+    // Validate the list of properties.  If no Platform was specified, no properties can have been specified
+    // either.
 
-    const vector<string>& platformProperties = platform->getPropertyNames();
     map<string, string> validatedProperties;
-    for (auto& prop : properties) {
-        string property = prop.first;
-        if (platform->deprecatedPropertyReplacements.find(property) != platform->deprecatedPropertyReplacements.end())
-            property = platform->deprecatedPropertyReplacements[property];
-        bool valid = false;
-        for (auto& p : platformProperties)
-            if (p == property) {
-                valid = true;
-                break;
-            }
-        if (!valid)
-            throw OpenMMException("Illegal property name: "+prop.first);
-        validatedProperties[property] = prop.second;
+    if (platform != NULL) {
+        const vector<string>& platformProperties = platform->getPropertyNames();
+        for (auto& prop : properties) {
+            string property = prop.first;
+            if (platform->deprecatedPropertyReplacements.find(property) != platform->deprecatedPropertyReplacements.end())
+                property = platform->deprecatedPropertyReplacements[property];
+            bool valid = false;
+            for (auto& p : platformProperties)
+                if (p == property) {
+                    valid = true;
+                    break;
+                }
+            if (!valid)
+                throw OpenMMException("Illegal property name: "+prop.first);
+            validatedProperties[property] = prop.second;
+        }
     }
+    double time = getCurrentTime();
+    initializationTimes["Validate System"] = time-startTime;
+    startTime = time;
     
     // Find the list of kernels required.
     
@@ -125,6 +135,9 @@ ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integ
     hasInitializedForces = true;
     vector<string> integratorKernels = integrator.getKernelNames();
     kernelNames.insert(kernelNames.begin(), integratorKernels.begin(), integratorKernels.end());
+    time = getCurrentTime();
+    initializationTimes["Create ForceImpls"] = time-startTime;
+    startTime = time;
     
     // Select a platform to use.
     
@@ -164,11 +177,13 @@ ContextImpl::ContextImpl(Context& owner, const System& system, Integrator& integ
             throw;
         }
     }
+    initializationTimes["Create Platform Data"] = getCurrentTime()-startTime;
 }
 
 void ContextImpl::initialize() {
-    // Create and initialize kernels and other objects.
+    // Create and initialize kernels and other objects.  Record how long each step takes.
     
+    double startTime = getCurrentTime();
     initializeForcesKernel = platform->createKernel(CalcForcesAndEnergyKernel::Name(), *this);
     initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>().initialize(system);
     updateStateDataKernel = platform->createKernel(UpdateStateDataKernel::Name(), *this);
@@ -180,13 +195,20 @@ void ContextImpl::initialize() {
     Vec3 periodicBoxVectors[3];
     system.getDefaultPeriodicBoxVectors(periodicBoxVectors[0], periodicBoxVectors[1], periodicBoxVectors[2]);
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setPeriodicBoxVectors(*this, periodicBoxVectors[0], periodicBoxVectors[1], periodicBoxVectors[2]);
+    double time = getCurrentTime();
+    initializationTimes["Initialize Platform Kernels"] = time-startTime;
+    startTime = time;
     for (size_t i = 0; i < forceImpls.size(); ++i) {
         forceImpls[i]->initialize(*this);
         map<string, double> forceParameters = forceImpls[i]->getDefaultParameters();
         parameters.insert(forceParameters.begin(), forceParameters.end());
+        time = getCurrentTime();
+        initializationTimes["Initialize "+forceImpls[i]->getOwner().getName()] += time-startTime;
+        startTime = time;
     }
     integrator.initialize(*this);
     updateStateDataKernel.getAs<UpdateStateDataKernel>().setVelocities(*this, vector<Vec3>(system.getNumParticles()));
+    initializationTimes["Initialize Integrator"] = getCurrentTime()-startTime;
 }
 
 ContextImpl::~ContextImpl() {
@@ -285,23 +307,37 @@ void ContextImpl::setPeriodicBoxVectors(const Vec3& a, const Vec3& b, const Vec3
 void ContextImpl::applyConstraints(double tol) {
     if (!hasSetPositions)
         throw OpenMMException("Particle positions have not been set");
+    if (timingEnabled)
+        beginTiming();
     applyConstraintsKernel.getAs<ApplyConstraintsKernel>().apply(*this, tol);
+    if (timingEnabled)
+        endTiming("Apply Constraints");
 }
 
 void ContextImpl::applyVelocityConstraints(double tol) {
     if (!hasSetPositions)
         throw OpenMMException("Particle positions have not been set");
+    if (timingEnabled)
+        beginTiming();
     applyConstraintsKernel.getAs<ApplyConstraintsKernel>().applyToVelocities(*this, tol);
+    if (timingEnabled)
+        endTiming("Apply Constraints");
 }
 
 void ContextImpl::computeVirtualSites() {
+    if (timingEnabled)
+        beginTiming();
     virtualSitesKernel.getAs<VirtualSitesKernel>().computePositions(*this);
+    if (timingEnabled)
+        endTiming("Compute Virtual Sites");
 }
 
 double ContextImpl::calcForcesAndEnergy(bool includeForces, bool includeEnergy, int groups) {
     if (!hasSetPositions)
         throw OpenMMException("Particle positions have not been set");
     lastForceGroups = groups;
+    if (timingEnabled)
+        return calcForcesAndEnergyWithTiming(includeForces, includeEnergy, groups);
     CalcForcesAndEnergyKernel& kernel = initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>();
     while (true) {
         double energy = 0.0;
@@ -327,13 +363,82 @@ void ContextImpl::computeShiftedVelocities(double timeShift, std::vector<Vec3>&
     updateStateDataKernel.getAs<UpdateStateDataKernel>().computeShiftedVelocities(*this, timeShift, velocities);
 }
 
+double ContextImpl::calcForcesAndEnergyWithTiming(bool includeForces, bool includeEnergy, int groups) {
+    // This is identical to calcForcesAndEnergy(), except that it records the time spent on each step.
+
+    CalcForcesAndEnergyKernel& kernel = initializeForcesKernel.getAs<CalcForcesAndEnergyKernel>();
+    while (true) {
+        double energy = 0.0;
+        beginTiming();
+        kernel.beginComputation(*this, includeForces, includeEnergy, groups);
+        endTiming("Begin Force Computation");
+        for (auto force : forceImpls) {
+            beginTiming();
+            energy += force->calcForcesAndEnergy(*this, includeForces, includeEnergy, groups);
+            endTiming(force->getOwner().getName());
+        }
+        bool valid = true;
+        beginTiming();
+        energy += kernel.finishComputation(*this, includeForces, includeEnergy, groups, valid);
+        endTiming("Finish Force Computation");
+        timingReport["Force Evaluations"]++;
+        if (valid)
+            return energy;
+    }
+}
+
 bool ContextImpl::updateContextState() {
+    if (timingEnabled)
+        beginTiming();
     bool forcesInvalid = false;
     for (auto force : forceImpls)
         force->updateContextState(*this, forcesInvalid);
+    if (timingEnabled)
+        endTiming("Update Context State");
     return forcesInvalid;
 }
 
+void ContextImpl::setTimingEnabled(bool enabled) {
+    timingEnabled = enabled;
+    timingStack.clear();
+}
+
+void ContextImpl::beginTiming() {
+    platform->synchronizeContext(*this);
+    timingStack.push_back(make_pair(getCurrentTime(), 0.0));
+}
+
+void ContextImpl::endTiming(const string& name) {
+    if (timingStack.empty())
+        return;
+    platform->synchronizeContext(*this);
+    double elapsed = getCurrentTime()-timingStack.back().first;
+    timingReport[name] += elapsed-timingStack.back().second;
+    timingStack.pop_back();
+    if (timingStack.size() > 0)
+        timingStack.back().second += elapsed;
+}
+
+map<string, double> ContextImpl::getTimingReport() {
+    // Platforms report running totals, so subtract the values from when the report was last reset.
+
+    map<string, double> report = timingReport;
+    map<string, double> statistics;
+    platform->getTimingStatistics(*this, statistics);
+    for (auto& stat : statistics) {
+        auto baseline = platformTimingBaseline.find(stat.first);
+        report[stat.first] += stat.second - (baseline == platformTimingBaseline.end() ? 0.0 : baseline->second);
+    }
+    return report;
+}
+
+void ContextImpl::resetTimingReport() {
+    timingReport.clear();
+    timingStack.clear();
+    platformTimingBaseline.clear();
+    platform->getTimingStatistics(*this, platformTimingBaseline);
+}
+
 const vector<ForceImpl*>& ContextImpl::getForceImpls() const {
     return forceImpls;
 }
@@ -381,18 +486,94 @@ const vector<vector<int> >& ContextImpl::getMolecules() const {
         }
     }
 
-    // Make a list of every other particle to which each particle is connected
+    // Identify particles by which molecule they belong to.  This uses a concurrent union-find in which
+    // the root of every tree is always the lowest index particle in it, so molecules come out in the
+    // same order as from findMolecules().
 
+    double startTime = getCurrentTime();
     int numParticles = system.getNumParticles();
-    vector<vector<int> > particleBonds(numParticles);
-    for (auto& bond : bonds) {
-        particleBonds[bond.first].push_back(bond.second);
-        particleBonds[bond.second].push_back(bond.first);
+    vector<atomic<int> > parent(numParticles);
+    auto findRoot = [&] (int particle) {
+        while (true) {
+            int p = parent[particle].load(memory_order_relaxed);
+            if (p == particle)
+                return particle;
+            int grandparent = parent[p].load(memory_order_relaxed);
+            if (grandparent != p)
+                parent[particle].compare_exchange_weak(p, grandparent, memory_order_relaxed);
+            particle = grandparent;
+        }
+    };
+    vector<int> particleMolecule(numParticles);
+    auto processBlock = [&] (int start, int end, int bondStart, int bondEnd, int stage) {
+        if (stage == 0) {
+            for (int i = start; i < end; i++)
+                parent[i].store(i, memory_order_relaxed);
+        }
+        else if (stage == 1) {
+            for (int i = bondStart; i < bondEnd; i++) {
+                int root1 = bonds[i].first, root2 = bonds[i].second;
+                while (true) {
+                    root1 = findRoot(root1);
+                    root2 = findRoot(root2);
+                    if (root1 == root2)
+                        break;
+                    if (root1 < root2)
+                        swap(root1, root2);
+                    int expected = root1;
+                    if (parent[root1].compare_exchange_strong(expected, root2))
+                        break;
+                }
+            }
+        }
+        else {
+            for (int i = start; i < end; i++)
+                particleMolecule[i] = findRoot(i);
+        }
+    };
+    int numBonds = bonds.size();
+    if (numParticles < 10000)
+        for (int stage = 0; stage < 3; stage++)
+            processBlock(0, numParticles, 0, numBonds, stage);
+    else {
+        // Use as many threads as the Platform was told to use.  If it does not have a Threads property,
+        // fall back to OPENMM_CPU_THREADS, and then to the number of processors.
+
+        int numThreads = 0;
+        const vector<string>& platformProperties = platform->getPropertyNames();
+        if (find(platformProperties.begin(), platformProperties.end(), "Threads") != platformProperties.end())
+            numThreads = atoi(platform->getPropertyValue(owner, "Threads").c_str());
+        else if (getenv("OPENMM_CPU_THREADS") != NULL)
+            numThreads = atoi(getenv("OPENMM_CPU_THREADS"));
+        ThreadPool threads(numThreads);
+        numThreads = threads.getNumThreads();
+        for (int stage = 0; stage < 3; stage++) {
+            threads.execute([&] (ThreadPool& pool, int threadIndex) {
+                processBlock((int) ((long long) threadIndex*numParticles/numThreads), (int) ((long long) (threadIndex+1)*numParticles/numThreads),
+                        (int) ((long long) threadIndex*numBonds/numThreads), (int) ((long long) (threadIndex+1)*numBonds/numThreads), stage);
+            });
+            threads.waitForThreads();
+        }
     }
 
-    // Now identify particles by which molecule they belong to.
+    // Build the final output vector.
 
-    molecules = findMolecules(numParticles, particleBonds);
+    vector<int> moleculeSize;
+    for (int i = 0; i < numParticles; i++) {
+        if (particleMolecule[i] == i) {
+            particleMolecule[i] = moleculeSize.size();
+            moleculeSize.push_back(0);
+        }
+        else
+            particleMolecule[i] = particleMolecule[particleMolecule[i]];
+        moleculeSize[particleMolecule[i]]++;
+    }
+    molecules.resize(moleculeSize.size());
+    for (int i = 0; i < moleculeSize.size(); i++)
+        molecules[i].reserve(moleculeSize[i]);
+    for (int i = 0; i < numParticles; i++)
+        molecules[particleMolecule[i]].push_back(i);
+    initializationTimes["Find Molecules"] = getCurrentTime()-startTime;
     return molecules;
 }
 
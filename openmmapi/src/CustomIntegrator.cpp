@@ -144,7 +144,11 @@ void CustomIntegrator::step(int steps) {
         throw OpenMMException("This Integrator is not bound to a context!");  
     globalsAreCurrent = false;
     for (int i = 0; i < steps; ++i) {
+        if (context->getTimingEnabled())
+            context->beginTiming();
         kernel.getAs<IntegrateCustomStepKernel>().execute(*context, *this, forcesAreValid);
+        if (context->getTimingEnabled())
+            context->endTiming("Integrate");
     }
 }
 
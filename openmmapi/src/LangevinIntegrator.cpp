@@ -89,6 +89,10 @@ void LangevinIntegrator::step(int steps) {
     for (int i = 0; i < steps; ++i) {
         context->updateContextState();
         context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
+        if (context->getTimingEnabled())
+            context->beginTiming();
         kernel.getAs<IntegrateLangevinStepKernel>().execute(*context, *this);
+        if (context->getTimingEnabled())
+            context->endTiming("Integrate");
     }
 }
@@ -93,6 +93,10 @@ void LangevinMiddleIntegrator::step(int steps) {
     for (int i = 0; i < steps; ++i) {
         context->updateContextState();
         context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
+        if (context->getTimingEnabled())
+            context->beginTiming();
         kernel.getAs<IntegrateLangevinMiddleStepKernel>().execute(*context, *this);
+        if (context->getTimingEnabled())
+            context->endTiming("Integrate");
     }
 }
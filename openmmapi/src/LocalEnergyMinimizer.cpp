@@ -30,11 +30,15 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/LocalEnergyMinimizer.h"
+#include "openmm/HarmonicBondForce.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/Platform.h"
 #include "openmm/VerletIntegrator.h"
+#include "openmm/internal/ContextImpl.h"
+#include "openmm/kernels.h"
 #include "lbfgs.h"
 #include <cmath>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -45,15 +49,34 @@ using namespace std;
 
 struct MinimizerData {
     Context& context;
-    double k;
-    bool checkLargeForces;
+    ContextImpl& impl;
+    double k, epsilon;
+    bool checkLargeForces, hasKernel;
+    Kernel kernel;
+    vector<Vec3> positions;
+    lbfgsfloatval_t *x, *scaledX;
+    vector<double> scale, velocity, gradient;
     VerletIntegrator cpuIntegrator;
     Context* cpuContext;
-    MinimizerData(Context& context, double k) : context(context), k(k), cpuIntegrator(1.0), cpuContext(NULL) {
+    MinimizerData(Context& context, ContextImpl& impl) : context(context), impl(impl), k(0.0), epsilon(0.0), hasKernel(false),
+            positions(context.getSystem().getNumParticles()), x(NULL), scaledX(NULL), cpuIntegrator(1.0), cpuContext(NULL) {
+        x = lbfgs_malloc(3*positions.size());
+        if (x == NULL)
+            throw OpenMMException("LocalEnergyMinimizer: Failed to allocate memory");
         string platformName = context.getPlatform().getName();
-        checkLargeForces = (platformName == "CUDA" || platformName == "OpenCL");
+        checkLargeForces = (platformName == "CUDA" || platformName == "OpenCL" || platformName == "CPU");
+        if (context.getPlatform().supportsKernels(vector<string>(1, MinimizeKernel::Name()))) {
+            // The platform can evaluate the objective function directly on its own data structures.
+
+            kernel = context.getPlatform().createKernel(MinimizeKernel::Name(), impl);
+            kernel.getAs<MinimizeKernel>().initialize(context.getSystem());
+            hasKernel = true;
+        }
     }
     ~MinimizerData() {
+        lbfgs_free(x);
+        if (scaledX != NULL)
+            lbfgs_free(scaledX);
         if (cpuContext != NULL)
             delete cpuContext;
     }
@@ -64,7 +87,10 @@ struct MinimizerData {
         if (cpuContext == NULL) {
             Platform* cpuPlatform;
             try {
-                cpuPlatform = &Platform::getPlatformByName("CPU");
+                if (context.getPlatform().getName() == "CPU")
+                    cpuPlatform = &Platform::getPlatformByName("Reference");
+                else
+                    cpuPlatform = &Platform::getPlatformByName("CPU");
             }
             catch (...) {
                 cpuPlatform = &Platform::getPlatformByName("Reference");
@@ -74,6 +100,24 @@ struct MinimizerData {
         }
         return *cpuContext;
     }
+    double getMaxConstraintError() {
+        if (hasKernel)
+            return kernel.getAs<MinimizeKernel>().getMaxConstraintError(impl);
+        vector<Vec3> positions = context.getState(State::Positions).getPositions();
+        const System& system = context.getSystem();
+        double maxError = 0.0;
+        for (int i = 0; i < system.getNumConstraints(); i++) {
+            int particle1, particle2;
+            double distance;
+            system.getConstraintParameters(i, particle1, particle2, distance);
+            Vec3 delta = positions[particle2]-positions[particle1];
+            double r = sqrt(delta.dot(delta));
+            double error = fabs(r-distance);
+            if (error > maxError)
+                maxError = error;
+        }
+        return maxError;
+    }
 };
 
 static double computeForcesAndEnergy(Context& context, const vector<Vec3>& positions, lbfgsfloatval_t *g) {
@@ -97,29 +141,42 @@ static double computeForcesAndEnergy(Context& context, const vector<Vec3>& posit
     return state.getPotentialEnergy();
 }
 
+static bool hasLargeForces(const lbfgsfloatval_t *g, int n) {
+    for (int i = 0; i < n; i++)
+        if (!(fabs(g[i]) < 2e9))
+            return true;
+    return false;
+}
+
 static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsfloatval_t *g, const int n, const lbfgsfloatval_t step) {
     MinimizerData* data = reinterpret_cast<MinimizerData*>(instance);
     Context& context = data->context;
     const System& system = context.getSystem();
     int numParticles = system.getNumParticles();
 
+    // The CUDA and OpenCL platforms accumulate forces in fixed point, and the CPU platform
+    // computes them in single precision, so they can't handle very large forces.  Check for
+    // problematic forces (very large, infinite, or NaN) and if necessary recompute them with
+    // a different platform.
+
+    if (data->hasKernel) {
+        double energy = data->kernel.getAs<MinimizeKernel>().computeEnergyAndGradient(data->impl, x, g, data->k, context.getIntegrator().getIntegrationForceGroups());
+        if (!data->checkLargeForces || !hasLargeForces(g, 3*numParticles))
+            return energy;
+    }
+
     // Compute the force and energy for this configuration.
 
-    vector<Vec3> positions(numParticles);
+    vector<Vec3>& positions = data->positions;
     for (int i = 0; i < numParticles; i++)
         positions[i] = Vec3(x[3*i], x[3*i+1], x[3*i+2]);
-    double energy = computeForcesAndEnergy(context, positions, g);
-    if (data->checkLargeForces) {
-        // The CUDA and OpenCL platforms accumulate forces in fixed point, so they
-        // can't handle very large forces.  Check for problematic forces (very large,
-        // infinite, or NaN) and if necessary recompute them on the CPU.
-
-        for (int i = 0; i < 3*numParticles; i++) {
-            if (!(fabs(g[i]) < 2e9)) {
-                energy = computeForcesAndEnergy(data->getCpuContext(), positions, g);
-                break;
-            }
-        }
+    double energy;
+    if (data->hasKernel)
+        energy = computeForcesAndEnergy(data->getCpuContext(), positions, g);
+    else {
+        energy = computeForcesAndEnergy(context, positions, g);
+        if (data->checkLargeForces && hasLargeForces(g, 3*numParticles))
+            energy = computeForcesAndEnergy(data->getCpuContext(), positions, g);
     }
 
     // Add harmonic forces for any constraints.
@@ -147,98 +204,286 @@ static lbfgsfloatval_t evaluate(void *instance, const lbfgsfloatval_t *x, lbfgsf
     return energy;
 }
 
-void LocalEnergyMinimizer::minimize(Context& context, double tolerance, int maxIterations) {
+static double computeNorm(const double* values, int n) {
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+        sum += values[i]*values[i];
+    return sqrt(sum);
+}
+
+/**
+ * Compute the diagonal preconditioner used by PreconditionedLBFGS.  Each coordinate is scaled by the square
+ * root of an estimate of the corresponding diagonal element of the Hessian.
+ */
+static void computePreconditioner(MinimizerData& data) {
+    const System& system = data.context.getSystem();
+    int numParticles = system.getNumParticles();
+    vector<double> stiffness(numParticles, 0.0);
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const HarmonicBondForce* bonds = dynamic_cast<const HarmonicBondForce*>(&system.getForce(i));
+        if (bonds != NULL) {
+            for (int j = 0; j < bonds->getNumBonds(); j++) {
+                int particle1, particle2;
+                double length, k;
+                bonds->getBondParameters(j, particle1, particle2, length, k);
+                stiffness[particle1] += fabs(k);
+                stiffness[particle2] += fabs(k);
+            }
+        }
+    }
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        int particle1, particle2;
+        double distance;
+        system.getConstraintParameters(i, particle1, particle2, distance);
+        stiffness[particle1] += data.k;
+        stiffness[particle2] += data.k;
+    }
+
+    // If nothing is bonded, fall back to using masses.
+
+    int numNonzero = 0;
+    double sum = 0.0;
+    for (int i = 0; i < numParticles; i++)
+        if (stiffness[i] > 0) {
+            numNonzero++;
+            sum += stiffness[i];
+        }
+    if (numNonzero == 0) {
+        for (int i = 0; i < numParticles; i++)
+            if (system.getParticleMass(i) > 0) {
+                stiffness[i] = system.getParticleMass(i);
+                numNonzero++;
+                sum += stiffness[i];
+            }
+    }
+    double average = (numNonzero == 0 ? 1.0 : sum/numNonzero);
+    data.scale.resize(3*numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        double s = (stiffness[i] > 0 ? sqrt(stiffness[i]/average) : 1.0);
+        data.scale[3*i] = s;
+        data.scale[3*i+1] = s;
+        data.scale[3*i+2] = s;
+    }
+}
+
+static lbfgsfloatval_t evaluatePreconditioned(void *instance, const lbfgsfloatval_t *y, lbfgsfloatval_t *g, const int n, const lbfgsfloatval_t step) {
+    // L-BFGS works with the scaled coordinates y = scale*x, so convert to the real coordinates,
+    // then transform the gradient back.
+
+    MinimizerData* data = reinterpret_cast<MinimizerData*>(instance);
+    for (int i = 0; i < n; i++)
+        data->x[i] = y[i]/data->scale[i];
+    double energy = evaluate(instance, data->x, g, n, step);
+    for (int i = 0; i < n; i++)
+        g[i] /= data->scale[i];
+    return energy;
+}
+
+static int checkPreconditionedConvergence(void *instance, const lbfgsfloatval_t *y, const lbfgsfloatval_t *g, const lbfgsfloatval_t fx,
+            const lbfgsfloatval_t xnorm, const lbfgsfloatval_t gnorm, const lbfgsfloatval_t step, int n, int k, int ls) {
+    // Apply the same convergence test that regular L-BFGS does, but to the unscaled gradient and coordinates.
+
+    MinimizerData* data = reinterpret_cast<MinimizerData*>(instance);
+    double realGnorm = 0.0, realXnorm = 0.0;
+    for (int i = 0; i < n; i++) {
+        double gi = g[i]*data->scale[i];
+        double xi = y[i]/data->scale[i];
+        realGnorm += gi*gi;
+        realXnorm += xi*xi;
+    }
+    return (sqrt(realGnorm) <= data->epsilon*max(1.0, sqrt(realXnorm)) ? 1 : 0);
+}
+
+static void minimizePreconditionedLBFGS(MinimizerData& data, lbfgs_parameter_t& param) {
+    int n = 3*data.positions.size();
+    if (data.scaledX == NULL) {
+        data.scaledX = lbfgs_malloc(n);
+        if (data.scaledX == NULL)
+            throw OpenMMException("LocalEnergyMinimizer: Failed to allocate memory");
+    }
+    computePreconditioner(data);
+    for (int i = 0; i < n; i++)
+        data.scaledX[i] = data.x[i]*data.scale[i];
+    lbfgs_parameter_t scaledParam = param;
+    scaledParam.epsilon = 0.0;
+    lbfgsfloatval_t fx;
+    lbfgs(n, data.scaledX, &fx, evaluatePreconditioned, checkPreconditionedConvergence, &data, &scaledParam);
+    for (int i = 0; i < n; i++)
+        data.x[i] = data.scaledX[i]/data.scale[i];
+}
+
+/**
+ * Minimize the energy with the FIRE algorithm (Bitzek et al., Phys. Rev. Lett. 97, 170201 (2006)).
+ * All particles are treated as having unit mass, and no particle may move more than maxStep
+ * in a single iteration.
+ */
+static void minimizeFIRE(MinimizerData& data, int maxIterations) {
+    const int nMin = 5;
+    const double fInc = 1.1, fDec = 0.5, alphaStart = 0.1, fAlpha = 0.99;
+    const double dtStart = 0.001, dtMax = 0.01, maxStep = 0.02;
+    const int maxStalledIterations = 1000;
+    int n = 3*data.positions.size();
+    lbfgsfloatval_t* x = data.x;
+    vector<double>& v = data.velocity;
+    vector<double>& g = data.gradient;
+    v.assign(n, 0.0);
+    g.resize(n);
+    double dt = dtStart, alpha = alphaStart;
+    double bestEnergy = numeric_limits<double>::infinity();
+    int numPositive = 0, numStalled = 0;
+    for (int iteration = 1; ; iteration++) {
+        double energy = evaluate(&data, x, &g[0], n, 0.0);
+        double gnorm = computeNorm(&g[0], n);
+        if (gnorm <= data.epsilon*max(1.0, computeNorm(x, n)))
+            break; // It has converged.
+        if (maxIterations > 0 && iteration >= maxIterations)
+            break;
+        if (energy < bestEnergy) {
+            bestEnergy = energy;
+            numStalled = 0;
+        }
+        else if (++numStalled >= maxStalledIterations)
+            break; // It is no longer making progress.
+
+        // Mix the velocity toward the direction of the force, or stop if it is moving uphill.
+
+        double power = 0.0;
+        for (int i = 0; i < n; i++)
+            power -= g[i]*v[i];
+        if (power > 0) {
+            double vnorm = computeNorm(&v[0], n);
+            for (int i = 0; i < n; i++)
+                v[i] = (1-alpha)*v[i] - alpha*vnorm*g[i]/gnorm;
+            if (++numPositive > nMin) {
+                dt = min(dt*fInc, dtMax);
+                alpha *= fAlpha;
+            }
+        }
+        else {
+            v.assign(n, 0.0);
+            dt *= fDec;
+            alpha = alphaStart;
+            numPositive = 0;
+        }
+
+        // Take a step, limiting how far any particle can move.
+
+        double maxDisplacement2 = 0.0;
+        for (int i = 0; i < n; i += 3) {
+            double d2 = 0.0;
+            for (int j = 0; j < 3; j++) {
+                v[i+j] -= dt*g[i+j];
+                d2 += dt*v[i+j]*dt*v[i+j];
+            }
+            maxDisplacement2 = max(maxDisplacement2, d2);
+        }
+        double stepScale = (maxDisplacement2 > maxStep*maxStep ? maxStep/sqrt(maxDisplacement2) : 1.0);
+        for (int i = 0; i < n; i++)
+            x[i] += stepScale*dt*v[i];
+    }
+}
+
+static void minimizeConformation(Context& context, MinimizerData& data, double tolerance, int maxIterations, LocalEnergyMinimizer::Algorithm algorithm) {
     const System& system = context.getSystem();
     int numParticles = system.getNumParticles();
     double constraintTol = context.getIntegrator().getConstraintTolerance();
     double workingConstraintTol = std::max(1e-4, constraintTol);
-    double k = 100/workingConstraintTol;
-    lbfgsfloatval_t *x = lbfgs_malloc(numParticles*3);
-    if (x == NULL)
-        throw OpenMMException("LocalEnergyMinimizer: Failed to allocate memory");
-    try {
+    data.k = 100/workingConstraintTol;
+    lbfgsfloatval_t *x = data.x;
 
-        // Initialize the minimizer.
+    // Initialize the minimizer.
 
-        lbfgs_parameter_t param;
-        lbfgs_parameter_init(&param);
-        if (!context.getPlatform().supportsDoublePrecision())
-            param.xtol = 1e-7;
-        param.max_iterations = maxIterations;
-        param.linesearch = LBFGS_LINESEARCH_BACKTRACKING_STRONG_WOLFE;
+    lbfgs_parameter_t param;
+    lbfgs_parameter_init(&param);
+    if (!context.getPlatform().supportsDoublePrecision())
+        param.xtol = 1e-7;
+    param.max_iterations = maxIterations;
+    param.linesearch = LBFGS_LINESEARCH_BACKTRACKING_STRONG_WOLFE;
 
-        // Make sure the initial configuration satisfies all constraints.
+    // Make sure the initial configuration satisfies all constraints.
 
-        context.applyConstraints(workingConstraintTol);
+    context.applyConstraints(workingConstraintTol);
 
-        // Record the initial positions and determine a normalization constant for scaling the tolerance.
+    // Record the initial positions and determine a normalization constant for scaling the tolerance.
 
-        vector<Vec3> initialPos = context.getState(State::Positions).getPositions();
-        double norm = 0.0;
-        for (int i = 0; i < numParticles; i++) {
-            x[3*i] = initialPos[i][0];
-            x[3*i+1] = initialPos[i][1];
-            x[3*i+2] = initialPos[i][2];
-            norm += initialPos[i].dot(initialPos[i]);
-        }
-        norm /= numParticles;
-        norm = (norm < 1 ? 1 : sqrt(norm));
-        param.epsilon = tolerance/norm;
+    vector<Vec3> initialPos = context.getState(State::Positions).getPositions();
+    double norm = 0.0;
+    for (int i = 0; i < numParticles; i++) {
+        x[3*i] = initialPos[i][0];
+        x[3*i+1] = initialPos[i][1];
+        x[3*i+2] = initialPos[i][2];
+        norm += initialPos[i].dot(initialPos[i]);
+    }
+    norm /= numParticles;
+    norm = (norm < 1 ? 1 : sqrt(norm));
+    param.epsilon = tolerance/norm;
+    data.epsilon = param.epsilon;
 
-        // Repeatedly minimize, steadily increasing the strength of the springs until all constraints are satisfied.
+    // Repeatedly minimize, steadily increasing the strength of the springs until all constraints are satisfied.
 
-        double prevMaxError = 1e10;
-        MinimizerData data(context, k);
-        while (true) {
-            // Perform the minimization.
+    double prevMaxError = 1e10;
+    while (true) {
+        // Perform the minimization.
 
+        if (algorithm == LocalEnergyMinimizer::FIRE)
+            minimizeFIRE(data, maxIterations);
+        else if (algorithm == LocalEnergyMinimizer::PreconditionedLBFGS)
+            minimizePreconditionedLBFGS(data, param);
+        else {
             lbfgsfloatval_t fx;
             lbfgs(numParticles*3, x, &fx, evaluate, NULL, &data, &param);
+        }
 
-            // Check whether all constraints are satisfied.
+        // Check whether all constraints are satisfied.
 
-            vector<Vec3> positions = context.getState(State::Positions).getPositions();
-            int numConstraints = system.getNumConstraints();
-            double maxError = 0.0;
-            for (int i = 0; i < numConstraints; i++) {
-                int particle1, particle2;
-                double distance;
-                system.getConstraintParameters(i, particle1, particle2, distance);
-                Vec3 delta = positions[particle2]-positions[particle1];
-                double r = sqrt(delta.dot(delta));
-                double error = fabs(r-distance);
-                if (error > maxError)
-                    maxError = error;
-            }
-            if (maxError <= workingConstraintTol)
-                break; // All constraints are satisfied.
-            context.setPositions(initialPos);
-            if (maxError >= prevMaxError)
-                break; // Further tightening the springs doesn't seem to be helping, so just give up.
-            prevMaxError = maxError;
-            data.k *= 10;
-            if (maxError > 100*workingConstraintTol) {
-                // We've gotten far enough from a valid state that we might have trouble getting
-                // back, so reset to the original positions.
-
-                for (int i = 0; i < numParticles; i++) {
-                    x[3*i] = initialPos[i][0];
-                    x[3*i+1] = initialPos[i][1];
-                    x[3*i+2] = initialPos[i][2];
-                }
+        double maxError = data.getMaxConstraintError();
+        if (maxError <= workingConstraintTol) {
+            // All constraints are satisfied.  The platform kernel modifies positions directly,
+            // so set them through the Context to let the Integrator know they have changed.
+
+            if (data.hasKernel)
+                context.setPositions(context.getState(State::Positions).getPositions());
+            break;
+        }
+        context.setPositions(initialPos);
+        if (maxError >= prevMaxError)
+            break; // Further tightening the springs doesn't seem to be helping, so just give up.
+        prevMaxError = maxError;
+        data.k *= 10;
+        if (maxError > 100*workingConstraintTol) {
+            // We've gotten far enough from a valid state that we might have trouble getting
+            // back, so reset to the original positions.
+
+            for (int i = 0; i < numParticles; i++) {
+                x[3*i] = initialPos[i][0];
+                x[3*i+1] = initialPos[i][1];
+                x[3*i+2] = initialPos[i][2];
             }
         }
     }
-    catch (...) {
-        lbfgs_free(x);
-        throw;
-    }
-    lbfgs_free(x);
-    
+
     // If necessary, do a final constraint projection to make sure they are satisfied
     // to the full precision requested by the user.
-    
+
     if (constraintTol < workingConstraintTol)
         context.applyConstraints(workingConstraintTol);
 }
 
+void LocalEnergyMinimizer::minimize(Context& context, double tolerance, int maxIterations, Algorithm algorithm) {
+    MinimizerData data(context, context.getImpl());
+    minimizeConformation(context, data, tolerance, maxIterations, algorithm);
+}
+
+vector<double> LocalEnergyMinimizer::minimizeBatch(Context& context, vector<vector<Vec3> >& positions, double tolerance, int maxIterations, Algorithm algorithm) {
+    MinimizerData data(context, context.getImpl());
+    int groups = context.getIntegrator().getIntegrationForceGroups();
+    vector<double> energies;
+    for (vector<Vec3>& conformation : positions) {
+        context.setPositions(conformation);
+        minimizeConformation(context, data, tolerance, maxIterations, algorithm);
+        State state = context.getState(State::Positions | State::Energy, false, groups);
+        conformation = state.getPositions();
+        energies.push_back(state.getPotentialEnergy());
+    }
+    return energies;
+}
@@ -41,6 +41,7 @@ MonteCarloBarostat::MonteCarloBarostat(double defaultPressure, double defaultTem
     setDefaultTemperature(defaultTemperature);
     setFrequency(frequency);
     setRandomNumberSeed(0);
+    setUseIncrementalEnergy(false);
 }
 
 void MonteCarloBarostat::setDefaultPressure(double pressure) {
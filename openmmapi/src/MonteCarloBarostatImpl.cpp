@@ -32,9 +32,17 @@
 #include "openmm/internal/MonteCarloBarostatImpl.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/OSRngSeed.h"
+#include "openmm/CMAPTorsionForce.h"
 #include "openmm/Context.h"
+#include "openmm/CustomAngleForce.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/CustomTorsionForce.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
 #include "openmm/kernels.h"
 #include "openmm/OpenMMException.h"
+#include "openmm/PeriodicTorsionForce.h"
+#include "openmm/RBTorsionForce.h"
 #include "SimTKOpenMMUtilities.h"
 #include <cmath>
 #include <vector>
@@ -43,7 +51,7 @@
 using namespace OpenMM;
 using namespace std;
 
-MonteCarloBarostatImpl::MonteCarloBarostatImpl(const MonteCarloBarostat& owner) : owner(owner), step(0) {
+MonteCarloBarostatImpl::MonteCarloBarostatImpl(const MonteCarloBarostat& owner) : owner(owner), step(0), affectedGroups(-1) {
 }
 
 void MonteCarloBarostatImpl::initialize(ContextImpl& context) {
@@ -65,9 +73,15 @@ void MonteCarloBarostatImpl::updateContextState(ContextImpl& context, bool& forc
         return;
     step = 0;
 
-    // Compute the current potential energy.
+    // Compute the current potential energy.  If requested, skip force groups whose energy cannot
+    // be changed by the move.
 
     int groups = context.getIntegrator().getIntegrationForceGroups();
+    if (owner.getUseIncrementalEnergy()) {
+        if (affectedGroups == -1)
+            affectedGroups = findAffectedGroups(context);
+        groups &= affectedGroups;
+    }
     double initialEnergy = context.getOwner().getState(State::Energy, false, groups).getPotentialEnergy();
 
     // Modify the periodic box size.
@@ -112,6 +126,116 @@ void MonteCarloBarostatImpl::updateContextState(ContextImpl& context, bool& forc
     }
 }
 
+/**
+ * Determine whether a Force's energy is unchanged when every molecule is translated.  This is true if it
+ * is one of the standard bonded forces, does not use periodic boundary conditions, and every interaction
+ * involves particles from a single molecule.
+ */
+static bool isInvariantToMoleculeTranslation(const Force& force, const vector<int>& moleculeIndex) {
+    if (force.usesPeriodicBoundaryConditions())
+        return false;
+    auto inOneMolecule = [&] (const vector<int>& particles) {
+        for (int p : particles)
+            if (moleculeIndex[p] != moleculeIndex[particles[0]])
+                return false;
+        return true;
+    };
+    vector<double> params;
+    if (const HarmonicBondForce* f = dynamic_cast<const HarmonicBondForce*>(&force)) {
+        for (int i = 0; i < f->getNumBonds(); i++) {
+            int p1, p2;
+            double length, k;
+            f->getBondParameters(i, p1, p2, length, k);
+            if (!inOneMolecule({p1, p2}))
+                return false;
+        }
+        return true;
+    }
+    if (const HarmonicAngleForce* f = dynamic_cast<const HarmonicAngleForce*>(&force)) {
+        for (int i = 0; i < f->getNumAngles(); i++) {
+            int p1, p2, p3;
+            double angle, k;
+            f->getAngleParameters(i, p1, p2, p3, angle, k);
+            if (!inOneMolecule({p1, p2, p3}))
+                return false;
+        }
+        return true;
+    }
+    if (const PeriodicTorsionForce* f = dynamic_cast<const PeriodicTorsionForce*>(&force)) {
+        for (int i = 0; i < f->getNumTorsions(); i++) {
+            int p1, p2, p3, p4, periodicity;
+            double phase, k;
+            f->getTorsionParameters(i, p1, p2, p3, p4, periodicity, phase, k);
+            if (!inOneMolecule({p1, p2, p3, p4}))
+                return false;
+        }
+        return true;
+    }
+    if (const RBTorsionForce* f = dynamic_cast<const RBTorsionForce*>(&force)) {
+        for (int i = 0; i < f->getNumTorsions(); i++) {
+            int p1, p2, p3, p4;
+            double c0, c1, c2, c3, c4, c5;
+            f->getTorsionParameters(i, p1, p2, p3, p4, c0, c1, c2, c3, c4, c5);
+            if (!inOneMolecule({p1, p2, p3, p4}))
+                return false;
+        }
+        return true;
+    }
+    if (const CMAPTorsionForce* f = dynamic_cast<const CMAPTorsionForce*>(&force)) {
+        for (int i = 0; i < f->getNumTorsions(); i++) {
+            int map, a1, a2, a3, a4, b1, b2, b3, b4;
+            f->getTorsionParameters(i, map, a1, a2, a3, a4, b1, b2, b3, b4);
+            if (!inOneMolecule({a1, a2, a3, a4, b1, b2, b3, b4}))
+                return false;
+        }
+        return true;
+    }
+    if (const CustomBondForce* f = dynamic_cast<const CustomBondForce*>(&force)) {
+        for (int i = 0; i < f->getNumBonds(); i++) {
+            int p1, p2;
+            f->getBondParameters(i, p1, p2, params);
+            if (!inOneMolecule({p1, p2}))
+                return false;
+        }
+        return true;
+    }
+    if (const CustomAngleForce* f = dynamic_cast<const CustomAngleForce*>(&force)) {
+        for (int i = 0; i < f->getNumAngles(); i++) {
+            int p1, p2, p3;
+            f->getAngleParameters(i, p1, p2, p3, params);
+            if (!inOneMolecule({p1, p2, p3}))
+                return false;
+        }
+        return true;
+    }
+    if (const CustomTorsionForce* f = dynamic_cast<const CustomTorsionForce*>(&force)) {
+        for (int i = 0; i < f->getNumTorsions(); i++) {
+            int p1, p2, p3, p4;
+            f->getTorsionParameters(i, p1, p2, p3, p4, params);
+            if (!inOneMolecule({p1, p2, p3, p4}))
+                return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+int MonteCarloBarostatImpl::findAffectedGroups(ContextImpl& context) const {
+    const System& system = context.getSystem();
+    vector<int> moleculeIndex(system.getNumParticles());
+    const vector<vector<int> >& molecules = context.getMolecules();
+    for (int i = 0; i < (int) molecules.size(); i++)
+        for (int particle : molecules[i])
+            moleculeIndex[particle] = i;
+    int groups = 0;
+    for (int i = 0; i < system.getNumForces(); i++) {
+        const Force& force = system.getForce(i);
+        if (&force != &owner && !isInvariantToMoleculeTranslation(force, moleculeIndex))
+            groups |= 1<<force.getForceGroup();
+    }
+    return groups;
+}
+
 map<string, double> MonteCarloBarostatImpl::getDefaultParameters() {
     map<string, double> parameters;
     parameters[MonteCarloBarostat::Pressure()] = getOwner().getDefaultPressure();
@@ -362,7 +362,11 @@ void NoseHooverIntegrator::step(int steps) {
         if(context->updateContextState())
             forcesAreValid = false;
         context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
+        if (context->getTimingEnabled())
+            context->beginTiming();
         kernel.getAs<IntegrateNoseHooverStepKernel>().execute(*context, *this, forcesAreValid);
+        if (context->getTimingEnabled())
+            context->endTiming("Integrate");
     }
 }
 
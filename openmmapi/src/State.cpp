@@ -84,6 +84,29 @@ const map<string, double>& State::getEnergyParameterDerivatives() const {
         throw OpenMMException("Invoked getEnergyParameterDerivatives() on a State which does not contain parameter derivatives.");
     return energyParameterDerivatives;
 }
+const vector<Vec3>& State::getVectorData(DataType type) const {
+    if (type == Positions)
+        return getPositions();
+    if (type == Velocities)
+        return getVelocities();
+    if (type == Forces)
+        return getForces();
+    throw OpenMMException("getRawData() can only be used for positions, velocities, or forces.");
+}
+const double* State::getRawData(DataType type) const {
+    const vector<Vec3>& values = getVectorData(type);
+    if (values.size() == 0)
+        return NULL;
+    return reinterpret_cast<const double*>(&values[0]);
+}
+void State::getRawData(DataType type, vector<float>& data) const {
+    const vector<Vec3>& values = getVectorData(type);
+    int numValues = 3*values.size();
+    data.resize(numValues);
+    const double* source = getRawData(type);
+    for (int i = 0; i < numValues; i++)
+        data[i] = (float) source[i];
+}
 const SerializationNode& State::getIntegratorParameters() const {
     if ((types&IntegratorParameters) == 0)
         throw OpenMMException("Invoked getPIntegratorarameters() on a State which does not contain integrator parameters.");
@@ -99,7 +122,35 @@ int State::getDataTypes() const {
 }
 State::State(double time, long long stepCount) : types(0), time(time), stepCount(stepCount), ke(0), pe(0) {
 }
-State::State() : types(0), time(0.0), ke(0), pe(0) {
+State::State() : types(0), time(0.0), ke(0), pe(0), stepCount(0) {
+}
+void State::reset(double time, long long stepCount) {
+    this->time = time;
+    this->stepCount = stepCount;
+    types = 0;
+    ke = 0;
+    pe = 0;
+    integratorParameters = SerializationNode();
+}
+vector<Vec3>& State::updatePositions() {
+    types |= Positions;
+    return positions;
+}
+vector<Vec3>& State::updateVelocities() {
+    types |= Velocities;
+    return velocities;
+}
+vector<Vec3>& State::updateForces() {
+    types |= Forces;
+    return forces;
+}
+map<string, double>& State::updateParameters() {
+    types |= Parameters;
+    return parameters;
+}
+map<string, double>& State::updateEnergyParameterDerivatives() {
+    types |= ParameterDerivatives;
+    return energyParameterDerivatives;
 }
 void State::setPositions(const std::vector<Vec3>& pos) {
     positions = pos;
@@ -31,6 +31,8 @@
 
 #include "openmm/internal/ThreadPool.h"
 #include "openmm/internal/hardware.h"
+#include "openmm/internal/timer.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -67,7 +69,7 @@ static void* threadBody(void* args) {
     return 0;
 }
 
-ThreadPool::ThreadPool(int numThreads) : currentTask(NULL) {
+ThreadPool::ThreadPool(int numThreads) : recordLoadBalance(false), isRecordingTask(false), totalTaskTime(0.0), totalIdleTime(0.0), currentTask(NULL) {
     if (numThreads <= 0)
         numThreads = getNumProcessors();
     this->numThreads = numThreads;
@@ -118,6 +120,11 @@ void ThreadPool::execute(function<void (ThreadPool&, int)> task) {
 
 void ThreadPool::syncThreads() {
     pthread_mutex_lock(&lock);
+    if (isRecordingTask) {
+        double time = getCurrentTime();
+        latestFinishTime = max(latestFinishTime, time);
+        finishTimeSum += time;
+    }
     waitCount++;
     pthread_cond_signal(&endCondition);
     pthread_cond_wait(&startCondition, &lock);
@@ -128,14 +135,38 @@ void ThreadPool::waitForThreads() {
     pthread_mutex_lock(&lock);
     while (waitCount < numThreads)
         pthread_cond_wait(&endCondition, &lock);
+    if (isRecordingTask) {
+        totalTaskTime += latestFinishTime-taskStartTime;
+        totalIdleTime += numThreads*latestFinishTime-finishTimeSum;
+        isRecordingTask = false;
+    }
     pthread_mutex_unlock(&lock);
 }
 
 void ThreadPool::resumeThreads() {
     pthread_mutex_lock(&lock);
     waitCount = 0;
+    if (recordLoadBalance) {
+        isRecordingTask = true;
+        taskStartTime = getCurrentTime();
+        latestFinishTime = taskStartTime;
+        finishTimeSum = 0.0;
+    }
     pthread_cond_broadcast(&startCondition);
     pthread_mutex_unlock(&lock);
 }
 
+void ThreadPool::setRecordLoadBalance(bool record) {
+    recordLoadBalance = record;
+}
+
+bool ThreadPool::getRecordLoadBalance() const {
+    return recordLoadBalance;
+}
+
+void ThreadPool::getLoadBalanceStatistics(double& taskTime, double& idleTime) const {
+    taskTime = totalTaskTime;
+    idleTime = totalIdleTime;
+}
+
 } // namespace OpenMM
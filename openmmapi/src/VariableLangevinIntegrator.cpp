@@ -105,7 +105,11 @@ void VariableLangevinIntegrator::step(int steps) {
     for (int i = 0; i < steps; ++i) {
         context->updateContextState();
         context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
+        if (context->getTimingEnabled())
+            context->beginTiming();
         setStepSize(kernel.getAs<IntegrateVariableLangevinStepKernel>().execute(*context, *this, std::numeric_limits<double>::infinity()));
+        if (context->getTimingEnabled())
+            context->endTiming("Integrate");
     }
 }
 
@@ -115,6 +119,10 @@ void VariableLangevinIntegrator::stepTo(double time) {
     while (time > context->getTime()) {
         context->updateContextState();
         context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
+        if (context->getTimingEnabled())
+            context->beginTiming();
         setStepSize(kernel.getAs<IntegrateVariableLangevinStepKernel>().execute(*context, *this, time));
+        if (context->getTimingEnabled())
+            context->endTiming("Integrate");
     }
 }
@@ -74,6 +74,10 @@ void VerletIntegrator::step(int steps) {
     for (int i = 0; i < steps; ++i) {
         context->updateContextState();
         context->calcForcesAndEnergy(true, false, getIntegrationForceGroups());
+        if (context->getTimingEnabled())
+            context->beginTiming();
         kernel.getAs<IntegrateVerletStepKernel>().execute(*context, *this);
+        if (context->getTimingEnabled())
+            context->endTiming("Integrate");
     }
 }
@@ -56,11 +56,21 @@ public:
      */
     void calculateForce(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters, std::vector<OpenMM::Vec3>& forces, 
             double* totalEnergy, ReferenceBondIxn& referenceBondIxn);
+    /**
+     * Compute the forces from all bonds, using a different ReferenceBondIxn for each thread.  This should be used
+     * when the ReferenceBondIxn is not thread safe, such as when it evaluates custom expressions.
+     *
+     * @param threadBondIxn         one ReferenceBondIxn for each thread
+     * @param energyParamDerivs     if not null, derivatives of the energy with respect to parameters are added to this
+     * @param numEnergyParamDerivs  the number of elements in energyParamDerivs
+     */
+    void calculateForce(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters, std::vector<OpenMM::Vec3>& forces, 
+            double* totalEnergy, double* energyParamDerivs, int numEnergyParamDerivs, std::vector<ReferenceBondIxn*>& threadBondIxn);
     /**
      * This routine contains the code executed by each thread.
      */
     void threadComputeForce(ThreadPool& threads, int threadIndex, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<std::vector<double> >& parameters,
-            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, ReferenceBondIxn& referenceBondIxn);
+            std::vector<OpenMM::Vec3>& forces, double* totalEnergy, double* energyParamDerivs, ReferenceBondIxn& referenceBondIxn);
 private:
     bool canAssignBond(int bond, int thread, std::vector<int>& atomThread);
     void assignBond(int bond, int thread, std::vector<int>& atomThread, std::vector<int>& bondThread, std::vector<std::set<int> >& atomBonds, std::list<int>& candidateBonds);
@@ -69,6 +79,7 @@ private:
     ThreadPool* threads;
     std::vector<std::vector<int> > threadBonds;
     std::vector<int> extraBonds;
+    std::vector<std::vector<double> > threadEnergyParamDerivs;
 };
 
 } // namespace OpenMM
@@ -25,8 +25,11 @@
 #ifndef OPENMM_CPU_CUSTOM_GB_FORCE_H__
 #define OPENMM_CPU_CUSTOM_GB_FORCE_H__
 
+#include "AlignedArray.h"
+#include "CpuExclusions.h"
 #include "CpuNeighborList.h"
 #include "lepton/CompiledExpression.h"
+#include "lepton/CompiledVectorExpression.h"
 #include "openmm/CustomGBForce.h"
 #include "openmm/internal/CompiledExpressionSet.h"
 #include "openmm/internal/ThreadPool.h"
@@ -48,7 +51,7 @@ private:
     float periodicBoxSize[3];
     float cutoffDistance, cutoffDistance2;
     int numValues, numParams;
-    const std::vector<std::set<int> > exclusions;
+    const CpuExclusions& exclusions;
     std::vector<CustomGBForce::ComputationType> valueTypes;
     std::vector<CustomGBForce::ComputationType> energyTypes;
     ThreadPool& threads;
@@ -57,6 +60,7 @@ private:
     std::vector<std::vector<std::vector<float> > > dValuedParam;
     // Workspace vectors
     std::vector<std::vector<float> > values, dEdV;
+    std::vector<float> chainRuleFactor;
     // The following variables are used to make information accessible to the individual threads.
     int numberOfAtoms;
     float* posq;
@@ -72,9 +76,8 @@ private:
     void threadComputeForce(ThreadPool& threads, int threadIndex);
 
     /**
-     * Calculate a computed value that is based on particle pairs
+     * Calculate the first computed value, which is based on particle pairs
      * 
-     * @param index            the index of the value to compute
      * @param data             workspace for the current thread
      * @param numAtoms         number of atoms
      * @param posq             atom coordinates
@@ -82,22 +85,16 @@ private:
      * @param useExclusions    specifies whether to use exclusions
      */
 
-    void calculateParticlePairValue(int index, ThreadData& data, int numAtoms, float* posq, std::vector<double>* atomParameters,
+    void calculateParticlePairValue(ThreadData& data, int numAtoms, float* posq, std::vector<double>* atomParameters,
                                     bool useExclusions, const fvec4& boxSize, const fvec4& invBoxSize);
 
     /**
-     * Evaluate a single atom pair as part of calculating a computed value
+     * Evaluate the first computed value for all pairs in the current batch
      * 
-     * @param index            the index of the value to compute
-     * @param atom1            the index of the first atom in the pair
-     * @param atom2            the index of the second atom in the pair
      * @param data             workspace for the current thread
-     * @param posq             atom coordinates
-     * @param atomParameters   atomParameters[atomIndex][paramterIndex]
      */
 
-    void calculateOnePairValue(int index, int atom1, int atom2, ThreadData& data, float* posq, std::vector<double>* atomParameters,
-                               std::vector<float>& valueArray, const fvec4& boxSize, const fvec4& invBoxSize);
+    void calculateBatchValue(ThreadData& data);
 
     /**
      * Calculate an energy term of type SingleParticle
@@ -130,20 +127,15 @@ private:
                                     bool useExclusions, float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
 
     /**
-     * Evaluate a single atom pair as part of calculating an energy term
+     * Evaluate an energy term for all pairs in the current batch
      * 
      * @param index            the index of the term to compute
-     * @param atom1            the index of the first atom in the pair
-     * @param atom2            the index of the second atom in the pair
      * @param data             workspace for the current thread
-     * @param posq             atom coordinates
-     * @param atomParameters   atomParameters[atomIndex][paramterIndex]
      * @param forces           forces on atoms are added to this
      * @param totalEnergy      the energy contribution is added to this
      */
 
-    void calculateOnePairEnergyTerm(int index, int atom1, int atom2, ThreadData& data, float* posq, std::vector<double>* atomParameters,
-                               float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
+    void calculateBatchEnergyTerm(int index, ThreadData& data, float* forces, double& totalEnergy);
 
     /**
      * Apply the chain rule to compute forces on atoms
@@ -159,19 +151,37 @@ private:
                                     float* forces, const fvec4& boxSize, const fvec4& invBoxSize);
 
     /**
-     * Evaluate a single atom pair as part of applying the chain rule
+     * Apply the chain rule to all pairs in the current batch
+     * 
+     * @param data             workspace for the current thread
+     * @param forces           forces on atoms are added to this
+     */
+
+    void calculateBatchChainRule(ThreadData& data, float* forces);
+
+    /**
+     * Add a particle pair to the current batch if it is inside the cutoff.
      * 
      * @param atom1            the index of the first atom in the pair
      * @param atom2            the index of the second atom in the pair
      * @param data             workspace for the current thread
      * @param posq             atom coordinates
      * @param atomParameters   atomParameters[atomIndex][paramterIndex]
-     * @param forces           forces on atoms are added to this
-     * @param isExcluded       specifies whether this is an excluded pair
+     * @param numValues        the number of computed values to record for the pair
+     * @return true if the batch is now full
+     */
+
+    bool addPairToBatch(int atom1, int atom2, ThreadData& data, float* posq, std::vector<double>* atomParameters,
+                        int numValues, const fvec4& boxSize, const fvec4& invBoxSize);
+
+    /**
+     * Fill the unused slots of a partial batch with copies of the first pair.
+     * 
+     * @param data             workspace for the current thread
+     * @param numValues        the number of computed values recorded for each pair
      */
 
-    void calculateOnePairChainRule(int atom1, int atom2, ThreadData& data, float* posq, std::vector<double>* atomParameters,
-                               float* forces, bool isExcluded, const fvec4& boxSize, const fvec4& invBoxSize);
+    void padBatch(ThreadData& data, int numValues);
 
     /**
      * Compute the displacement and squared distance between two points, optionally using
@@ -183,19 +193,31 @@ public:
 
     /**
      * Construct a new CpuCustomGBForce.
+     *
+     * Expressions that are evaluated for particle pairs are computed for a batch of pairs at once,
+     * so they are given as CompiledVectorExpressions.  pairValueExpression, pairValueDerivExpression,
+     * and pairValueParamDerivExpressions are the first computed value and its derivatives with respect
+     * to r and to each parameter.  For each energy term of a pair type, pairEnergyExpressions holds the
+     * energy, its derivative with respect to r, and its derivatives with respect to each computed value
+     * of the first and second particle.  It is empty for SingleParticle terms.
      */
 
-     CpuCustomGBForce(int numAtoms, const std::vector<std::set<int> >& exclusions,
+     CpuCustomGBForce(int numAtoms, const CpuExclusions& exclusions,
                         const std::vector<Lepton::CompiledExpression>& valueExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& valueDerivExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& valueGradientExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& valueParamDerivExpressions,
+                        const Lepton::CompiledVectorExpression& pairValueExpression,
+                        const Lepton::CompiledVectorExpression& pairValueDerivExpression,
+                        const std::vector<Lepton::CompiledVectorExpression>& pairValueParamDerivExpressions,
                         const std::vector<std::string>& valueNames,
                         const std::vector<CustomGBForce::ComputationType>& valueTypes,
                         const std::vector<Lepton::CompiledExpression>& energyExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& energyDerivExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& energyGradientExpressions,
                         const std::vector<std::vector<Lepton::CompiledExpression> >& energyParamDerivExpressions,
+                        const std::vector<std::vector<Lepton::CompiledVectorExpression> >& pairEnergyExpressions,
+                        const std::vector<std::vector<Lepton::CompiledVectorExpression> >& pairEnergyParamDerivExpressions,
                         const std::vector<CustomGBForce::ComputationType>& energyTypes,
                         const std::vector<std::string>& parameterNames, ThreadPool& threads);
 
@@ -243,11 +265,16 @@ public:
                const std::vector<std::vector<Lepton::CompiledExpression> >& valueDerivExpressions,
                const std::vector<std::vector<Lepton::CompiledExpression> >& valueGradientExpressions,
                const std::vector<std::vector<Lepton::CompiledExpression> >& valueParamDerivExpressions,
+               const Lepton::CompiledVectorExpression& pairValueExpression,
+               const Lepton::CompiledVectorExpression& pairValueDerivExpression,
+               const std::vector<Lepton::CompiledVectorExpression>& pairValueParamDerivExpressions,
                const std::vector<std::string>& valueNames,
                const std::vector<Lepton::CompiledExpression>& energyExpressions,
                const std::vector<std::vector<Lepton::CompiledExpression> >& energyDerivExpressions,
                const std::vector<std::vector<Lepton::CompiledExpression> >& energyGradientExpressions,
                const std::vector<std::vector<Lepton::CompiledExpression> >& energyParamDerivExpressions,
+               const std::vector<std::vector<Lepton::CompiledVectorExpression> >& pairEnergyExpressions,
+               const std::vector<std::vector<Lepton::CompiledVectorExpression> >& pairEnergyParamDerivExpressions,
                const std::vector<std::string>& parameterNames);
     CompiledExpressionSet expressionSet;
     std::vector<Lepton::CompiledExpression> valueExpressions;
@@ -265,10 +292,22 @@ public:
     double x, y, z, r;
     int firstAtom, lastAtom;
     // Workspace vectors
-    std::vector<float> value0, dVdR1, dVdR2, dVdX, dVdY, dVdZ;
+    std::vector<float> value0, dVdV0, dVdX, dVdY, dVdZ;
     std::vector<std::vector<float> > dEdV;
     std::vector<std::vector<float> > dValue0dParam;
     std::vector<float> energyParamDerivs;
+    // Expressions for particle pairs.  Each of their variables holds one value for every pair in the current batch.
+    Lepton::CompiledVectorExpression pairValueExpression;
+    Lepton::CompiledVectorExpression pairValueDerivExpression;
+    std::vector<Lepton::CompiledVectorExpression> pairValueParamDerivExpressions;
+    std::vector<std::vector<Lepton::CompiledVectorExpression> > pairEnergyExpressions;
+    std::vector<std::vector<Lepton::CompiledVectorExpression> > pairEnergyParamDerivExpressions;
+    int width, numPairs;
+    std::vector<float> pairR, pairParam, pairValue;
+    std::vector<std::vector<float> > globalValues;
+    std::vector<std::string> globalNames;
+    std::vector<int> pairAtom1, pairAtom2;
+    AlignedArray<fvec4> pairDeltaR;
 };
 
 } // namespace OpenMM
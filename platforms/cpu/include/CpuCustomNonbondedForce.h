@@ -26,10 +26,12 @@
 #define OPENMM_CPU_CUSTOM_NONBONDED_FORCE_H__
 
 #include "AlignedArray.h"
+#include "CpuExclusions.h"
 #include "CpuNeighborList.h"
 #include "openmm/internal/CompiledExpressionSet.h"
 #include "openmm/internal/ThreadPool.h"
 #include "openmm/internal/vectorize.h"
+#include "lepton/CompiledVectorExpression.h"
 #include <atomic>
 #include <map>
 #include <set>
@@ -47,9 +49,9 @@ class CpuCustomNonbondedForce {
 
          --------------------------------------------------------------------------------------- */
 
-       CpuCustomNonbondedForce(const Lepton::CompiledExpression& energyExpression, const Lepton::CompiledExpression& forceExpression,
-                               const std::vector<std::string>& parameterNames, const std::vector<std::set<int> >& exclusions,
-                               const std::vector<Lepton::CompiledExpression> energyParamDerivExpressions,
+       CpuCustomNonbondedForce(const Lepton::CompiledVectorExpression& energyExpression, const Lepton::CompiledVectorExpression& forceExpression,
+                               const std::vector<std::string>& parameterNames, const CpuExclusions& exclusions,
+                               const std::vector<Lepton::CompiledVectorExpression> energyParamDerivExpressions,
                                const std::vector<std::string>& computedValueNames, const std::vector<Lepton::CompiledExpression> computedValueExpressions,
                                ThreadPool& threads);
 
@@ -74,10 +76,11 @@ class CpuCustomNonbondedForce {
 
       /**---------------------------------------------------------------------------------------
 
-         Restrict the force to a list of interaction groups.
+         Restrict the force to a list of interaction groups.  When a cutoff is used and there are
+         no more than 64 groups, interactions are taken from the neighbor list and filtered by
+         group membership.  Otherwise an explicit list of all pairs in the groups is built.
 
-         @param distance            the cutoff distance
-         @param neighbors           the neighbor list to use
+         @param groups              the interaction groups
 
          --------------------------------------------------------------------------------------- */
 
@@ -137,10 +140,13 @@ private:
     AlignedArray<fvec4> periodicBoxVec4;
     double cutoffDistance, switchingDistance;
     ThreadPool& threads;
-    const std::vector<std::set<int> > exclusions;
+    const CpuExclusions& exclusions;
     std::vector<ThreadData*> threadData;
     std::vector<std::string> paramNames, computedValueNames;
+    std::vector<std::pair<std::set<int>, std::set<int> > > interactionGroups;
     std::vector<std::pair<int, int> > groupInteractions;
+    std::vector<unsigned long long> groupMask1, groupMask2;
+    bool hasGroupInteractions, useGroupMasks;
     std::vector<double> threadEnergy;
     std::vector<std::vector<double> > atomComputedValues;
     // The following variables are used to make information accessible to the individual threads.
@@ -153,13 +159,20 @@ private:
     bool includeForce, includeEnergy;
     std::atomic<int> atomicCounter;
 
+    /**
+     * Build the explicit list of all pairs of atoms in the interaction groups.
+     */
+    void createGroupInteractions();
+
     /**
      * This routine contains the code executed by each thread.
      */
     void threadComputeForce(ThreadPool& threads, int threadIndex);
 
     /**
-     * Calculate the interaction between two atoms.
+     * Add the interaction between two atoms to the batch of interactions being accumulated by a thread.
+     * Once the batch contains as many interactions as the width of the vector expressions, they are
+     * all computed at once.
      * 
      * @param atom1            the index of the first atom
      * @param atom2            the index of the second atom
@@ -171,6 +184,15 @@ private:
      */
     void calculateOneIxn(int atom1, int atom2, ThreadData& data, float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
 
+    /**
+     * Compute all interactions in the current batch and clear it.
+     * 
+     * @param data             workspace for the current thread
+     * @param forces           force array (forces added)
+     * @param totalEnergy      total energy
+     */
+    void calculateBatchIxn(ThreadData& data, float* forces, double& totalEnergy);
+
     /**
      * Compute the displacement and squared distance between two points, optionally using
      * periodic boundary conditions.
@@ -180,15 +202,23 @@ private:
 
 class CpuCustomNonbondedForce::ThreadData {
 public:
-    ThreadData(const Lepton::CompiledExpression& energyExpression, const Lepton::CompiledExpression& forceExpression, const std::vector<std::string>& parameterNames,
-            const std::vector<Lepton::CompiledExpression> energyParamDerivExpressions, const std::vector<std::string>& computedValueNames,
+    ThreadData(const Lepton::CompiledVectorExpression& energyExpression, const Lepton::CompiledVectorExpression& forceExpression, const std::vector<std::string>& parameterNames,
+            const std::vector<Lepton::CompiledVectorExpression> energyParamDerivExpressions, const std::vector<std::string>& computedValueNames,
             const std::vector<Lepton::CompiledExpression> computedValueExpressions, std::vector<std::vector<double> >& atomComputedValues);
-    Lepton::CompiledExpression energyExpression;
-    Lepton::CompiledExpression forceExpression;
-    std::vector<Lepton::CompiledExpression> computedValueExpressions, energyParamDerivExpressions;
+    Lepton::CompiledVectorExpression energyExpression;
+    Lepton::CompiledVectorExpression forceExpression;
+    std::vector<Lepton::CompiledVectorExpression> energyParamDerivExpressions;
+    std::vector<Lepton::CompiledExpression> computedValueExpressions;
     CompiledExpressionSet expressionSet;
-    std::vector<double> particleParam, computedValues;
-    double r;
+    std::vector<double> particleParam;
+    // Each of the following holds one value for every interaction in the current batch.
+    int width, numPairs;
+    std::vector<float> r, pairParam, pairComputedValues;
+    std::vector<std::vector<float> > globalValues;
+    std::vector<std::string> globalNames;
+    std::vector<int> pairAtom1, pairAtom2;
+    AlignedArray<fvec4> pairDeltaR;
+    std::vector<double> switchValue;
     std::vector<double> energyParamDerivs; 
     std::vector<std::vector<double> >& atomComputedValues;
 };
@@ -0,0 +1,153 @@
+#ifndef OPENMM_CPUEXCLUSIONS_H_
+#define OPENMM_CPUEXCLUSIONS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "windowsExportCpu.h"
+#include "openmm/internal/ThreadPool.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class stores the set of particles excluded from interacting with each particle.  It uses a
+ * compressed sparse row layout: the excluded particles for all particles are stored in a single array,
+ * with the ones for each particle sorted in increasing order, and a second array holds the offset at
+ * which each particle's list begins.  Exclusions are symmetric: if particle i excludes j, j also excludes i.
+ */
+class OPENMM_EXPORT_CPU CpuExclusions {
+public:
+    /**
+     * The list of particles excluded from interacting with a single particle.  This allows it to be used
+     * in range-based for loops.
+     */
+    class Range {
+    public:
+        Range(const int* first, const int* last) : first(first), last(last) {
+        }
+        const int* begin() const {
+            return first;
+        }
+        const int* end() const {
+            return last;
+        }
+    private:
+        const int* first;
+        const int* last;
+    };
+    /**
+     * Create an empty object with no particles.
+     */
+    CpuExclusions();
+    /**
+     * Create an object with the specified exclusions.
+     *
+     * @param numParticles   the number of particles
+     * @param excludedPairs  the pairs of particles that are excluded from interacting.  Duplicates are allowed
+     *                       and are ignored.
+     */
+    CpuExclusions(int numParticles, const std::vector<std::pair<int, int> >& excludedPairs);
+    /**
+     * Set the exclusions, replacing any that were set previously.  If a ThreadPool is provided, the
+     * per-particle lists are sorted in parallel.
+     *
+     * @param numParticles   the number of particles
+     * @param excludedPairs  the pairs of particles that are excluded from interacting.  Duplicates are allowed
+     *                       and are ignored.
+     * @param threads        an optional ThreadPool to use for building the lists
+     */
+    void setExclusions(int numParticles, const std::vector<std::pair<int, int> >& excludedPairs, ThreadPool* threads=NULL);
+    /**
+     * Get the number of particles.
+     */
+    int getNumParticles() const {
+        return offset.size()-1;
+    }
+    /**
+     * Get the number of particles excluded from interacting with a particle.
+     */
+    int getNumExclusions(int particle) const {
+        return offset[particle+1]-offset[particle];
+    }
+    /**
+     * Get a pointer to the start of the (sorted) list of particles excluded from interacting with a particle.
+     */
+    const int* begin(int particle) const {
+        return excluded.data()+offset[particle];
+    }
+    /**
+     * Get a pointer to the end of the (sorted) list of particles excluded from interacting with a particle.
+     */
+    const int* end(int particle) const {
+        return excluded.data()+offset[particle+1];
+    }
+    /**
+     * Get the (sorted) list of particles excluded from interacting with a particle.
+     */
+    Range operator[](int particle) const {
+        return Range(begin(particle), end(particle));
+    }
+    /**
+     * Get whether two particles are excluded from interacting with each other.
+     */
+    bool isExcluded(int particle1, int particle2) const {
+        const int* first = begin(particle1);
+        const int* last = end(particle1);
+        if (last-first < 8) {
+            for (; first != last; ++first)
+                if (*first == particle2)
+                    return true;
+            return false;
+        }
+        return std::binary_search(first, last, particle2);
+    }
+    /**
+     * Get the amount of memory used to store the exclusions, in bytes.
+     */
+    long long getMemoryUsage() const {
+        return sizeof(int)*(long long) (offset.size()+excluded.size());
+    }
+    bool operator==(const CpuExclusions& other) const {
+        return offset == other.offset && excluded == other.excluded;
+    }
+    bool operator!=(const CpuExclusions& other) const {
+        return !(*this == other);
+    }
+private:
+    std::vector<int> offset, excluded;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CPUEXCLUSIONS_H_*/
@@ -34,6 +34,7 @@
 
 #include "openmm/GayBerneForce.h"
 #include "openmm/internal/ThreadPool.h"
+#include "CpuExclusions.h"
 #include "CpuNeighborList.h"
 #include "CpuPlatform.h"
 #include "openmm/Vec3.h"
@@ -71,7 +72,7 @@ public:
     /**
      * Get the exclusions being used by the force.
      */
-    const std::vector<std::set<int> >& getExclusions() const;
+    const CpuExclusions& getExclusions() const;
 
 private:
     struct ParticleInfo;
@@ -79,7 +80,7 @@ private:
     std::vector<ParticleInfo> particles;
     std::vector<ExceptionInfo> exceptions;
     std::set<std::pair<int, int> > exclusions;
-    std::vector<std::set<int> > particleExclusions;
+    CpuExclusions particleExclusions;
     GayBerneForce::NonbondedMethod nonbondedMethod;
     double cutoffDistance, switchingDistance;
     bool useSwitchingFunction;
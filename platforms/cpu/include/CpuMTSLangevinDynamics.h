@@ -0,0 +1,105 @@
+
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __CPU_MTS_LANGEVIN_DYNAMICS_H__
+#define __CPU_MTS_LANGEVIN_DYNAMICS_H__
+
+#include "ReferenceMTSLangevinDynamics.h"
+#include "CpuLangevinMiddleDynamics.h"
+#include "CpuRandom.h"
+#include "openmm/internal/ThreadPool.h"
+
+namespace OpenMM {
+
+/**
+ * This class parallelizes ReferenceMTSLangevinDynamics.  The innermost substeps are delegated
+ * to a CpuLangevinMiddleDynamics, and the force kicks for each group are divided between threads.
+ */
+class CpuMTSLangevinDynamics : public ReferenceMTSLangevinDynamics {
+public:
+    /**
+     * Constructor.
+     *
+     * @param numberOfAtoms  number of atoms
+     * @param deltaT         outermost step size
+     * @param friction       friction coefficient
+     * @param temperature    temperature
+     * @param groups         (force group, substeps) pairs, sorted by increasing number of substeps
+     * @param threads        thread pool for parallelizing computation
+     * @param random         random number generator
+     */
+    CpuMTSLangevinDynamics(int numberOfAtoms, double deltaT, double friction, double temperature, const std::vector<std::pair<int, int> >& groups,
+                           OpenMM::ThreadPool& threads, OpenMM::CpuRandom& random);
+
+    /**
+     * Destructor.
+     */
+    ~CpuMTSLangevinDynamics();
+
+    /**
+     * Apply the forces from one group to the velocities.
+     * 
+     * @param numberOfAtoms       number of atoms
+     * @param velocities          velocities
+     * @param forces              forces
+     * @param inverseMasses       inverse atom masses
+     * @param dt                  the time interval over which to apply the forces
+     */
+    void kick(int numberOfAtoms, std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces,
+              std::vector<double>& inverseMasses, double dt);
+
+    /**
+     * Second update step.
+     * 
+     * @param numberOfAtoms       number of atoms
+     * @param atomCoordinates     atom coordinates
+     * @param velocities          velocities
+     * @param inverseMasses       inverse atom masses
+     * @param xPrime              xPrime
+     */
+    void updatePart2(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                     std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime);
+
+    /**  
+     * Third update
+     * 
+     * @param context             the context this integrator is updating
+     * @param numberOfAtoms       number of atoms
+     * @param atomCoordinates     atom coordinates
+     * @param velocities          velocities
+     * @param inverseMasses       inverse atom masses
+     * @param xPrime              xPrime
+     */
+    void updatePart3(OpenMM::ContextImpl& context, int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                     std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime);
+
+private:
+    OpenMM::ThreadPool& threads;
+    CpuLangevinMiddleDynamics innerDynamics;
+};
+
+} // namespace OpenMM
+
+#endif // __CPU_MTS_LANGEVIN_DYNAMICS_H__
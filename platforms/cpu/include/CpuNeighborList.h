@@ -33,11 +33,11 @@
  * -------------------------------------------------------------------------- */
 
 #include "AlignedArray.h"
+#include "CpuExclusions.h"
 #include "openmm/Vec3.h"
 #include "windowsExportCpu.h"
 #include "openmm/internal/ThreadPool.h"
 #include <atomic>
-#include <set>
 #include <utility>
 #include <vector>
 
@@ -47,7 +47,7 @@ class OPENMM_EXPORT_CPU CpuNeighborList {
 public:
     class Voxels;
     CpuNeighborList(int blockSize);
-    void computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const std::vector<std::set<int> >& exclusions,
+    void computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const CpuExclusions& exclusions,
             const Vec3* periodicBoxVectors, bool usePeriodic, float maxDistance, ThreadPool& threads);
     int getNumBlocks() const;
     int getBlockSize() const;
@@ -61,6 +61,32 @@ public:
     using BlockExclusionMask = int16_t;
 
     const std::vector<BlockExclusionMask>& getBlockExclusions(int blockIndex) const;
+    /**
+     * Set whether to build the list as cluster pairs.  Each block is then paired with whole blocks
+     * (clusters) of the sorted atoms rather than with individual atoms, which lets a kernel compute the
+     * interactions between a block and a cluster with vector loads alone.  In this mode getBlockClusters()
+     * and getBlockClusterExclusions() describe the interactions, and the lists returned by getBlockNeighbors()
+     * and getBlockExclusions() are empty.
+     */
+    void setUseClusterPairs(bool use);
+    /**
+     * Get whether the list is built as cluster pairs.
+     */
+    bool getUseClusterPairs() const;
+    /**
+     * Get the clusters that may interact with a block.  Each cluster is identified by its block index, and
+     * only clusters whose index is no greater than blockIndex are included, so each pair of blocks appears once.
+     * Clusters that are subject to exclusions come first, in the same order as getBlockClusterExclusions().
+     */
+    const std::vector<int>& getBlockClusters(int blockIndex) const;
+    /**
+     * Get the exclusions for the clusters at the start of getBlockClusters().  For each of those clusters it
+     * contains blockSize masks, one for each atom of the block, in which bit j is set if that atom is excluded
+     * from interacting with atom j of the cluster.  This covers the pairs of atoms that are both in the block
+     * (each of them is computed only once), padding atoms, and excluded pairs.  Clusters past the end of it
+     * are not subject to any exclusions.
+     */
+    const std::vector<BlockExclusionMask>& getBlockClusterExclusions(int blockIndex) const;
 
     /**
      * This routine contains the code executed by each thread.
@@ -68,16 +94,21 @@ public:
     void threadComputeNeighborList(ThreadPool& threads, int threadIndex);
     void runThread(int index);
 private:
+    void computeClusterExclusions(int blockIndex, int atomsInBlock, std::vector<int>& clusterMaskIndex, std::vector<int>& orderedClusters);
     int blockSize;
     std::vector<int> sortedAtoms;
     std::vector<float> sortedPositions;
     std::vector<std::vector<int> > blockNeighbors;
     std::vector<std::vector<BlockExclusionMask> > blockExclusions;
+    bool useClusterPairs;
+    std::vector<int> atomSortedIndex;
+    std::vector<std::vector<int> > blockClusters;
+    std::vector<std::vector<BlockExclusionMask> > blockClusterExclusions;
     // The following variables are used to make information accessible to the individual threads.
     float minx, maxx, miny, maxy, minz, maxz;
     std::vector<std::pair<int, int> > atomBins;
     Voxels* voxels;
-    const std::vector<std::set<int> >* exclusions;
+    const CpuExclusions* exclusions;
     const float* atomLocations;
     Vec3 periodicBoxVectors[3];
     int numAtoms;
@@ -26,6 +26,7 @@
 #define OPENMM_CPU_NONBONDED_FORCE_H__
 
 #include "AlignedArray.h"
+#include "CpuExclusions.h"
 #include "CpuNeighborList.h"
 #include "ReferencePairIxn.h"
 #include "openmm/internal/ThreadPool.h"
@@ -151,7 +152,7 @@ class CpuNonbondedForce {
 
       void calculateReciprocalIxn(int numberOfAtoms, float* posq, const std::vector<Vec3>& atomCoordinates,
                                   const std::vector<std::pair<float, float> >& atomParameters, const std::vector<float> &C6params,
-                                  const std::vector<std::set<int> >& exclusions, std::vector<Vec3>& forces, double* totalEnergy) const;
+                                  const CpuExclusions& exclusions, std::vector<Vec3>& forces, double* totalEnergy) const;
       
       /**---------------------------------------------------------------------------------------
       
@@ -170,7 +171,7 @@ class CpuNonbondedForce {
          --------------------------------------------------------------------------------------- */
           
       void calculateDirectIxn(int numberOfAtoms, float* posq, const std::vector<Vec3>& atomCoordinates, const std::vector<std::pair<float, float> >& atomParameters,
-            const std::vector<float>& C6params, const std::vector<std::set<int> >& exclusions, std::vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads);
+            const std::vector<float>& C6params, const CpuExclusions& exclusions, std::vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads);
 
     /**
      * This routine contains the code executed by each thread.
@@ -198,13 +199,18 @@ protected:
         std::vector<float> exptermsTable, dExptermsTable;
         float ewaldDX, ewaldDXInv, erfcDXInv, exptermsDX, exptermsDXInv;
         std::vector<double> threadEnergy;
+        // When the neighbor list is built as cluster pairs, this holds the positions and parameters of the atoms
+        // in the order of the sorted atoms.  Each block has NUM_CLUSTER_VALUES consecutive arrays of blockSize
+        // elements: x, y, z, charge, sigma, epsilon, and C6.
+        AlignedArray<float> clusterData;
+        static const int NUM_CLUSTER_VALUES = 7;
         // The following variables are used to make information accessible to the individual threads.
         int numberOfAtoms;
         float* posq;
         Vec3 const* atomCoordinates;
         std::pair<float, float> const* atomParameters;        
         float const *C6params;
-        std::set<int> const* exclusions;
+        const CpuExclusions* exclusions;
         std::vector<AlignedArray<float> >* threadForce;
         bool includeEnergy;
         float inverseRcut6;
@@ -250,6 +256,32 @@ protected:
          --------------------------------------------------------------------------------------- */
           
       virtual void calculateBlockEwaldIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) = 0;
+            
+      /**---------------------------------------------------------------------------------------
+      
+         Calculate all the interactions for one atom block, when the neighbor list is built
+         as cluster pairs.
+      
+         @param blockIndex       the index of the atom block
+         @param forces           force array (forces added)
+         @param totalEnergy      total energy
+            
+         --------------------------------------------------------------------------------------- */
+          
+      virtual void calculateBlockClusterIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) = 0;
+            
+      /**---------------------------------------------------------------------------------------
+      
+         Calculate all the interactions for one atom block, when the neighbor list is built
+         as cluster pairs.
+      
+         @param blockIndex       the index of the atom block
+         @param forces           force array (forces added)
+         @param totalEnergy      total energy
+            
+         --------------------------------------------------------------------------------------- */
+          
+      virtual void calculateBlockClusterEwaldIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) = 0;
 
       /**
        * Compute the displacement and squared distance between two points, optionally using
@@ -64,13 +64,16 @@ protected:
       */
     void calculateBlockIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
     void calculateBlockEwaldIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
+    void calculateBlockClusterIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
+    void calculateBlockClusterEwaldIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
     /** @} */
 
     /**---------------------------------------------------------------------------------------
       Calculate all the interactions for one atom block. Identical to function prototypes above but
-      with an extra template parameter to choose whether to use Ewald processing or not.
+      with extra template parameters to choose whether to use Ewald processing or not, and whether
+      the neighbor list is built as cluster pairs.
       --------------------------------------------------------------------------------------- */
-    template<BlockType BLOCK_TYPE>
+    template<BlockType BLOCK_TYPE, bool CLUSTER_PAIRS>
     void calculateBlockIxnHandler(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize);
 
     /**
@@ -81,6 +84,15 @@ protected:
     template <int PERIODIC_TYPE, BlockType BLOCK_TYPE>
     void calculateBlockIxnImpl(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter);
 
+    /**
+     * Templatized implementation of calculateBlockClusterIxn.  Rather than pairing the block with one
+     * neighbor atom at a time, it pairs each atom of the block with a whole cluster of neighbors, so
+     * the cluster's positions and parameters are loaded as vectors and the forces on it are written
+     * once for each cluster instead of once for each pair.
+     */
+    template <int PERIODIC_TYPE, BlockType BLOCK_TYPE>
+    void calculateBlockClusterIxnImpl(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter);
+
     /**
      * Compute the displacement and squared distance between a collection of points, optionally using
      * periodic boundary conditions.
@@ -115,16 +127,26 @@ CpuNonbondedForceFvec<FVEC>::approximateFunctionFromTable(const std::vector<floa
 
 template<typename FVEC>
 void CpuNonbondedForceFvec<FVEC>::calculateBlockIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) {
-    calculateBlockIxnHandler<BlockType::NON_EWALD>(blockIndex, forces, totalEnergy, boxSize, invBoxSize);
+    calculateBlockIxnHandler<BlockType::NON_EWALD, false>(blockIndex, forces, totalEnergy, boxSize, invBoxSize);
 }
 
 template<typename FVEC>
 void CpuNonbondedForceFvec<FVEC>::calculateBlockEwaldIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) {
-    calculateBlockIxnHandler<BlockType::EWALD>(blockIndex, forces, totalEnergy, boxSize, invBoxSize);
+    calculateBlockIxnHandler<BlockType::EWALD, false>(blockIndex, forces, totalEnergy, boxSize, invBoxSize);
+}
+
+template<typename FVEC>
+void CpuNonbondedForceFvec<FVEC>::calculateBlockClusterIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) {
+    calculateBlockIxnHandler<BlockType::NON_EWALD, true>(blockIndex, forces, totalEnergy, boxSize, invBoxSize);
+}
+
+template<typename FVEC>
+void CpuNonbondedForceFvec<FVEC>::calculateBlockClusterEwaldIxn(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) {
+    calculateBlockIxnHandler<BlockType::EWALD, true>(blockIndex, forces, totalEnergy, boxSize, invBoxSize);
 }
 
 template<typename FVEC>
-template<BlockType BLOCK_TYPE>
+template<BlockType BLOCK_TYPE, bool CLUSTER_PAIRS>
 void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnHandler(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) {
     // Determine whether we need to apply periodic boundary conditions.
 
@@ -166,7 +188,17 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnHandler(int blockIndex, float
     }
     
     // Call the appropriate version depending on what calculation is required for periodic boundary conditions.
-    if (periodicType == NoPeriodic)
+    if (CLUSTER_PAIRS) {
+        if (periodicType == NoPeriodic)
+            calculateBlockClusterIxnImpl<NoPeriodic, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        else if (periodicType == PeriodicPerAtom)
+            calculateBlockClusterIxnImpl<PeriodicPerAtom, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        else if (periodicType == PeriodicPerInteraction)
+            calculateBlockClusterIxnImpl<PeriodicPerInteraction, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+        else if (periodicType == PeriodicTriclinic)
+            calculateBlockClusterIxnImpl<PeriodicTriclinic, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
+    }
+    else if (periodicType == NoPeriodic)
         calculateBlockIxnImpl<NoPeriodic, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
     else if (periodicType == PeriodicPerAtom)
         calculateBlockIxnImpl<PeriodicPerAtom, BLOCK_TYPE>(blockIndex, forces, totalEnergy, boxSize, invBoxSize, blockCenter);
@@ -324,6 +356,144 @@ void CpuNonbondedForceFvec<FVEC>::calculateBlockIxnImpl(int blockIndex, float* f
         (fvec4(forces+4*blockAtom[j])+f[j]).store(forces+4*blockAtom[j]);
 }
 
+template<typename FVEC>
+template <int PERIODIC_TYPE, BlockType BLOCK_TYPE>
+void CpuNonbondedForceFvec<FVEC>::calculateBlockClusterIxnImpl(int blockIndex, float* forces, double* totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize, const fvec4& blockCenter) {
+    // Load the positions and parameters of the atoms in the block.  Each of them is paired with a whole cluster
+    // at once, so they are kept as scalars, and the forces on them are accumulated in vectors that are only
+    // reduced at the end.
+
+    const int32_t* sortedAtoms = &neighborList->getSortedAtoms()[0];
+    const int32_t* blockAtom = &sortedAtoms[blockSize * blockIndex];
+    fvec4 blockAtomPosq[blockSize];
+    float blockAtomSigma[blockSize], blockAtomEpsilon[blockSize], blockAtomC6[blockSize];
+    FVEC blockAtomForceX[blockSize], blockAtomForceY[blockSize], blockAtomForceZ[blockSize];
+    for (int i = 0; i < blockSize; i++) {
+        blockAtomPosq[i] = fvec4(posq+4*blockAtom[i]);
+        if (PERIODIC_TYPE == PeriodicPerAtom)
+            blockAtomPosq[i] -= floor((blockAtomPosq[i]-blockCenter)*invBoxSize+0.5f)*boxSize;
+        blockAtomSigma[i] = atomParameters[blockAtom[i]].first;
+        blockAtomEpsilon[i] = atomParameters[blockAtom[i]].second;
+        blockAtomC6[i] = (BLOCK_TYPE == BlockType::EWALD && ljpme ? C6params[blockAtom[i]] : 0.0f);
+        blockAtomForceX[i] = blockAtomForceY[i] = blockAtomForceZ[i] = 0.0f;
+    }
+
+    const float invSwitchingInterval = 1/(cutoffDistance-switchingDistance);
+    const FVEC cutoffDistanceSquared = cutoffDistance * cutoffDistance;
+
+    // Loop over the clusters that interact with this block.  The ones that are subject to exclusions come first.
+    const auto& clusters = neighborList->getBlockClusters(blockIndex);
+    const auto& exclusions = neighborList->getBlockClusterExclusions(blockIndex);
+    const int numExcludedClusters = exclusions.size()/blockSize;
+    FVEC partialEnergy = {};
+
+    for (int c = 0; c < (int) clusters.size(); c++) {
+        // Load the positions and parameters of the cluster.
+
+        const int cluster = clusters[c];
+        const float* data = &clusterData[NUM_CLUSTER_VALUES*blockSize*cluster];
+        FVEC clusterX(data), clusterY(data+blockSize), clusterZ(data+2*blockSize);
+        const FVEC clusterCharge(data+3*blockSize), clusterSigma(data+4*blockSize), clusterEpsilon(data+5*blockSize);
+        const FVEC clusterC6 = (BLOCK_TYPE == BlockType::EWALD && ljpme ? FVEC(data+6*blockSize) : FVEC(0.0f));
+        if (PERIODIC_TYPE == PeriodicPerAtom) {
+            clusterX -= floor((clusterX-blockCenter[0])*invBoxSize[0]+0.5f)*boxSize[0];
+            clusterY -= floor((clusterY-blockCenter[1])*invBoxSize[1]+0.5f)*boxSize[1];
+            clusterZ -= floor((clusterZ-blockCenter[2])*invBoxSize[2]+0.5f)*boxSize[2];
+        }
+        FVEC clusterForceX(0.0f), clusterForceY(0.0f), clusterForceZ(0.0f);
+
+        for (int i = 0; i < blockSize; i++) {
+            // Compute the distances from this block atom to the cluster atoms.
+
+            FVEC dx, dy, dz, r2;
+            getDeltaR<PERIODIC_TYPE>(blockAtomPosq[i], clusterX, clusterY, clusterZ, dx, dy, dz, r2, boxSize, invBoxSize);
+            auto include = r2 < cutoffDistanceSquared;
+            if (c < numExcludedClusters)
+                include = blendZero(include, FVEC::expandBitsToMask(~exclusions[blockSize*c+i]));
+            if (!any(include))
+                continue; // No interactions to compute.
+
+            // Compute the interactions.
+            const auto inverseR = rsqrt(r2);
+            const auto r = r2*inverseR;
+            FVEC energy, dEdR;
+            if (blockAtomEpsilon[i] != 0.0f) {
+                const auto sig = clusterSigma+blockAtomSigma[i];
+                const auto sig2 = (inverseR*sig)*(inverseR*sig);
+                const auto sig6 = sig2*sig2*sig2;
+                const auto eps = clusterEpsilon*blockAtomEpsilon[i];
+                const auto epsSig6 = eps*sig6;
+                dEdR = epsSig6*(12.0f*sig6 - 6.0f);
+                energy = epsSig6*(sig6-1.0f);
+                if (useSwitch) {
+                    const auto t = blendZero((r-switchingDistance)*invSwitchingInterval, r>switchingDistance);
+                    const auto switchValue = 1+t*t*t*(-10.0f+t*(15.0f-t*6.0f));
+                    const auto switchDeriv = t*t*(-30.0f+t*(60.0f-t*30.0f))*invSwitchingInterval;
+                    dEdR = switchValue*dEdR - energy*switchDeriv*r;
+                    energy *= switchValue;
+                }
+                if (BLOCK_TYPE == BlockType::EWALD && ljpme) {
+                    const auto C6ij = clusterC6*blockAtomC6[i];
+                    const auto inverseR2 = inverseR*inverseR;
+                    const auto mysig2 = sig*sig;
+                    const auto mysig6 = mysig2*mysig2*mysig2;
+                    const auto emult = C6ij*inverseR2*inverseR2*inverseR2*approximateFunctionFromTable(exptermsTable, r, FVEC(exptermsDXInv));
+                    const auto potentialShift = eps*(1.0f-mysig6*inverseRcut6)*mysig6*inverseRcut6 - C6ij*inverseRcut6Expterm;
+                    dEdR += 6.0f*C6ij*inverseR2*inverseR2*inverseR2*approximateFunctionFromTable(dExptermsTable, r, FVEC(exptermsDXInv));
+                    energy += emult + potentialShift;
+                }
+            }
+            else {
+                energy = 0.0f;
+                dEdR = 0.0f;
+            }
+            const auto chargeProd = clusterCharge*(ONE_4PI_EPS0*blockAtomPosq[i][3]);
+            if (BLOCK_TYPE == BlockType::EWALD)
+                dEdR += chargeProd*inverseR*approximateFunctionFromTable(ewaldScaleTable, r, FVEC(ewaldDXInv));
+            else
+                dEdR += chargeProd*(inverseR-2.0f*krf*r2);
+            dEdR *= inverseR*inverseR;
+
+            // Accumulate energies.
+            if (totalEnergy) {
+                if (BLOCK_TYPE == BlockType::EWALD)
+                    energy += chargeProd*inverseR*approximateFunctionFromTable(erfcTable, alphaEwald*r, FVEC(erfcDXInv));
+                else
+                    energy += chargeProd*(inverseR+krf*r2-crf);
+                partialEnergy += blendZero(energy, include);
+            }
+
+            // Accumulate forces.
+            dEdR = blendZero(dEdR, include);
+            const auto fx = dx*dEdR;
+            const auto fy = dy*dEdR;
+            const auto fz = dz*dEdR;
+            clusterForceX += fx;
+            clusterForceY += fy;
+            clusterForceZ += fz;
+            blockAtomForceX[i] -= fx;
+            blockAtomForceY[i] -= fy;
+            blockAtomForceZ[i] -= fz;
+        }
+
+        // Record the forces on the cluster atoms.
+        fvec4 f[blockSize];
+        transpose(clusterForceX, clusterForceY, clusterForceZ, 0.0f, f);
+        const int32_t* clusterAtom = &sortedAtoms[blockSize*cluster];
+        for (int j = 0; j < blockSize; j++)
+            (fvec4(forces+4*clusterAtom[j])+f[j]).store(forces+4*clusterAtom[j]);
+    }
+
+    if (totalEnergy)
+        *totalEnergy += reduceAdd(partialEnergy);
+
+    // Record the forces on the block atoms.
+    for (int i = 0; i < blockSize; i++) {
+        float* const atomForce = forces+4*blockAtom[i];
+        (fvec4(atomForce)+reduceToVec3(blockAtomForceX[i], blockAtomForceY[i], blockAtomForceZ[i])).store(atomForce);
+    }
+}
+
 template<typename FVEC>
 template <int PERIODIC_TYPE>
 void CpuNonbondedForceFvec<FVEC>::getDeltaR(const fvec4& posI, const FVEC& x, const FVEC& y, const FVEC& z, FVEC& dx, FVEC& dy, FVEC& dz, FVEC& r2, const fvec4& boxSize, const fvec4& invBoxSize) const {
@@ -33,6 +33,7 @@
  * -------------------------------------------------------------------------- */
 
 #include "AlignedArray.h"
+#include "CpuExclusions.h"
 #include "CpuRandom.h"
 #include "CpuNeighborList.h"
 #include "ReferencePlatform.h"
@@ -61,6 +62,7 @@ public:
     static bool isProcessorSupported();
     void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
     void contextDestroyed(ContextImpl& context) const;
+    void getTimingStatistics(ContextImpl& context, std::map<std::string, double>& statistics) const;
     /**
      * This is the name of the parameter for selecting the number of threads to use.
      */
@@ -77,21 +79,84 @@ public:
         static const std::string key = "DeterministicForces";
         return key;
     }
+    /**
+     * This is the name of the parameter for selecting how many threads are dedicated to the reciprocal space
+     * part of PME.  If this is 0 (the default), reciprocal space is computed after direct space, and each of
+     * them uses all the threads.  Otherwise, this many of the threads specified by the Threads property are
+     * reserved for reciprocal space, which then runs concurrently with the direct space and exception
+     * calculations on the remaining threads.  It must be less than the total number of threads.
+     */
+    static const std::string& CpuPmeThreads() {
+        static const std::string key = "PmeThreads";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting how many copies of the system simulated by an
+     * RPMDIntegrator are evaluated at once.  If this is 1 (the default), copies are evaluated one at a time,
+     * each using all the threads.  Otherwise the threads are divided evenly between this many private
+     * Contexts, each of which computes the forces on a different copy concurrently.  This is most useful
+     * for small systems with many copies, where a single force evaluation does not scale to all the threads.
+     * It must be between 1 and the number of threads.
+     */
+    static const std::string& CpuRpmdParallelCopies() {
+        static const std::string key = "RpmdParallelCopies";
+        return key;
+    }
+    /**
+     * This is the name of the parameter for selecting whether NonbondedForce uses a cluster pair neighbor list.
+     * If this is "true", each block of atoms is paired with whole blocks of neighboring atoms, and the kernel
+     * computes the interactions between them with vector loads instead of gathering one neighbor at a time.
+     * This only affects NonbondedForce.  If any other Force in the System shares the neighbor list (for
+     * example CustomNonbondedForce), the standard list is used instead.  The default is "false".
+     */
+    static const std::string& CpuClusterPairs() {
+        static const std::string key = "ClusterPairs";
+        return key;
+    }
     /**
      * We cannot use the standard mechanism for platform data, because that is already used by the superclass.
      * Instead, we maintain a table of ContextImpls to PlatformDatas.
      */
     static PlatformData& getPlatformData(ContextImpl& context);
     static const PlatformData& getPlatformData(const ContextImpl& context);
+    /**
+     * Get statistics about how often the neighbor list has been rebuilt in a Context.  Comparing the two
+     * values is useful for deciding whether the padding added to the cutoff is appropriate for a system.
+     *
+     * @param context      the Context to get statistics for
+     * @param numChecks    on exit, the number of force evaluations that checked whether the neighbor list was still valid
+     * @param numRebuilds  on exit, the number of times the neighbor list was rebuilt
+     */
+    void getNeighborListStatistics(const Context& context, long long& numChecks, long long& numRebuilds) const;
+    /**
+     * Get the total time spent on each part of computing PME forces in a Context.  This is useful for choosing
+     * a value for the PmeThreads property.  If reciprocal space usually finishes first, waitTime will be close
+     * to 0, and some of its threads can be given to direct space.  If direct space finishes first, reciprocal
+     * space should get more threads.  All times are measured in seconds and cover every force evaluation since
+     * the Context was created.
+     *
+     * @param context             the Context to get timings for
+     * @param directSpaceTime     on exit, the time spent computing direct space and exception interactions
+     * @param reciprocalSpaceTime on exit, the time spent computing reciprocal space interactions.  This is 0 if
+     *                            the optimized PME implementation is not available.
+     * @param waitTime            on exit, the time spent waiting for reciprocal space to finish after direct
+     *                            space was complete
+     * @param numEvaluations      on exit, the number of times PME forces were computed
+     */
+    void getPmeTimings(const Context& context, double& directSpaceTime, double& reciprocalSpaceTime, double& waitTime, long long& numEvaluations) const;
 private:
     static std::map<const ContextImpl*, PlatformData*> contextData;
 };
 
 class CpuPlatform::PlatformData {
 public:
-    PlatformData(int numParticles, int numThreads, bool deterministicForces);
+    PlatformData(int numParticles, int numThreads, bool deterministicForces, int pmeThreads=0, int rpmdParallelCopies=1, bool useClusterPairs=false);
     ~PlatformData();
-    void requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const std::vector<std::set<int> >& exclusionList);
+    /**
+     * Request that a neighbor list be built.  If allowClusterPairs is false, the list is built in the standard way
+     * even if the ClusterPairs property was set, since only NonbondedForce can use cluster pairs.
+     */
+    void requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const CpuExclusions& exclusionList, bool allowClusterPairs=false);
     int requestPosqIndex();
     AlignedArray<float> posq;
     std::vector<AlignedArray<float> > threadForce;
@@ -101,9 +166,11 @@ public:
     std::map<std::string, std::string> propertyValues;
     CpuNeighborList* neighborList;
     double cutoff, paddedCutoff;
-    bool anyExclusions, deterministicForces;
-    int currentPosqIndex, nextPosqIndex;
-    std::vector<std::set<int> > exclusions;
+    bool anyExclusions, deterministicForces, useClusterPairs;
+    int currentPosqIndex, nextPosqIndex, pmeThreads, rpmdParallelCopies;
+    long long numNeighborListChecks, numNeighborListRebuilds, numPmeEvaluations;
+    double neighborListTime, pmeDirectSpaceTime, pmeReciprocalSpaceTime, pmeWaitTime;
+    CpuExclusions exclusions;
 };
 
 } // namespace OpenMM
@@ -171,7 +171,7 @@ void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<d
     vector<double> threadEnergy(threads->getNumThreads(), 0);
     threads->execute([&] (ThreadPool& threads, int threadIndex) {
         double* energy = (totalEnergy == NULL ? NULL : &threadEnergy[threadIndex]);
-        threadComputeForce(threads, threadIndex, atomCoordinates, parameters, forces, energy, referenceBondIxn);
+        threadComputeForce(threads, threadIndex, atomCoordinates, parameters, forces, energy, NULL, referenceBondIxn);
     });
     threads->waitForThreads();
     
@@ -189,12 +189,46 @@ void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<d
             *totalEnergy += threadEnergy[i];
 }
 
+void CpuBondForce::calculateForce(vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, vector<Vec3>& forces, 
+        double* totalEnergy, double* energyParamDerivs, int numEnergyParamDerivs, vector<ReferenceBondIxn*>& threadBondIxn) {
+    // Have the worker threads compute their forces.  Each one accumulates parameter derivatives
+    // into its own buffer, since they cannot safely be written to the same array.
+    
+    int numThreads = threads->getNumThreads();
+    vector<double> threadEnergy(numThreads, 0);
+    threadEnergyParamDerivs.resize(numThreads);
+    for (auto& derivs : threadEnergyParamDerivs)
+        derivs.assign(numEnergyParamDerivs+1, 0.0);
+    threads->execute([&] (ThreadPool& threads, int threadIndex) {
+        double* energy = (totalEnergy == NULL ? NULL : &threadEnergy[threadIndex]);
+        threadComputeForce(threads, threadIndex, atomCoordinates, parameters, forces, energy, &threadEnergyParamDerivs[threadIndex][0], *threadBondIxn[threadIndex]);
+    });
+    threads->waitForThreads();
+    
+    // Compute any "extra" bonds.
+    
+    for (int i = 0; i < extraBonds.size(); i++) {
+        int bond = extraBonds[i];
+        threadBondIxn[0]->calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, &threadEnergyParamDerivs[0][0]);
+    }
+
+    // Compute the total energy and parameter derivatives.
+    
+    for (int i = 0; i < numThreads; i++) {
+        if (totalEnergy != NULL)
+            *totalEnergy += threadEnergy[i];
+        if (energyParamDerivs != NULL)
+            for (int j = 0; j < numEnergyParamDerivs; j++)
+                energyParamDerivs[j] += threadEnergyParamDerivs[i][j];
+    }
+}
+
 void CpuBondForce::threadComputeForce(ThreadPool& threads, int threadIndex, vector<Vec3>& atomCoordinates, vector<vector<double> >& parameters, vector<Vec3>& forces, 
-            double* totalEnergy, ReferenceBondIxn& referenceBondIxn) {
+            double* totalEnergy, double* energyParamDerivs, ReferenceBondIxn& referenceBondIxn) {
     vector<int>& bonds = threadBonds[threadIndex];
     int numBonds = bonds.size();
     for (int i = 0; i < numBonds; i++) {
         int bond = bonds[i];
-        referenceBondIxn.calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, NULL);
+        referenceBondIxn.calculateBondIxn(bondAtoms[bond], atomCoordinates, parameters[bond], forces, totalEnergy, energyParamDerivs);
     }
 }
\ No newline at end of file
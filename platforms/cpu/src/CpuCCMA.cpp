@@ -0,0 +1,161 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors: Pande Group                                                  *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuCCMA.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <queue>
+#include <utility>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuCCMA::CpuCCMA(const System& system, const ReferenceCCMAAlgorithm& ccma, ThreadPool& threads) : threads(threads) {
+    int numAtoms = system.getNumParticles();
+    int numConstraints = ccma.getNumberOfConstraints();
+    vector<pair<int, int> > atoms(numConstraints);
+    vector<double> distance(numConstraints);
+    for (int i = 0; i < numConstraints; i++)
+        ccma.getConstraintParameters(i, atoms[i].first, atoms[i].second, distance[i]);
+
+    // Identify clusters of constraints that are connected by sharing atoms.  Constraints in different
+    // clusters are independent, and the inverse constraint matrix never couples them.
+
+    vector<int> atomCluster(numAtoms);
+    for (int i = 0; i < numAtoms; i++)
+        atomCluster[i] = i;
+    function<int(int)> findRoot = [&] (int atom) {
+        while (atomCluster[atom] != atom) {
+            atomCluster[atom] = atomCluster[atomCluster[atom]];
+            atom = atomCluster[atom];
+        }
+        return atom;
+    };
+    for (int i = 0; i < numConstraints; i++) {
+        int root1 = findRoot(atoms[i].first);
+        int root2 = findRoot(atoms[i].second);
+        if (root1 != root2)
+            atomCluster[max(root1, root2)] = min(root1, root2);
+    }
+    vector<int> clusterIndex(numAtoms, -1);
+    vector<vector<int> > clusters;
+    for (int i = 0; i < numConstraints; i++) {
+        int root = findRoot(atoms[i].first);
+        if (clusterIndex[root] == -1) {
+            clusterIndex[root] = clusters.size();
+            clusters.push_back(vector<int>());
+        }
+        clusters[clusterIndex[root]].push_back(i);
+    }
+
+    // Divide the clusters into blocks, trying to keep the number of constraints in each block similar.
+    // Start with the largest clusters and always add to the block with the fewest constraints.
+
+    int numBlocks = min((int) clusters.size(), 10*threads.getNumThreads());
+    sort(clusters.begin(), clusters.end(), [] (const vector<int>& a, const vector<int>& b) { return a.size() > b.size(); });
+    vector<vector<int> > blockConstraints(numBlocks);
+    priority_queue<pair<int, int>, vector<pair<int, int> >, greater<pair<int, int> > > blockSizes;
+    for (int i = 0; i < numBlocks; i++)
+        blockSizes.push(make_pair(0, i));
+    for (auto& cluster : clusters) {
+        pair<int, int> smallest = blockSizes.top();
+        blockSizes.pop();
+        vector<int>& block = blockConstraints[smallest.second];
+        block.insert(block.end(), cluster.begin(), cluster.end());
+        blockSizes.push(make_pair((int) block.size(), smallest.second));
+    }
+
+    // Create a ReferenceCCMAAlgorithm for each block, extracting the corresponding part of the inverse matrix.
+
+    const vector<vector<pair<int, double> > >& matrix = ccma.getMatrix();
+    vector<int> localIndex(numConstraints);
+    for (auto& block : blockConstraints) {
+        int numBlockConstraints = block.size();
+        vector<pair<int, int> > blockAtoms(numBlockConstraints);
+        vector<double> blockDistance(numBlockConstraints);
+        for (int i = 0; i < numBlockConstraints; i++) {
+            localIndex[block[i]] = i;
+            blockAtoms[i] = atoms[block[i]];
+            blockDistance[i] = distance[block[i]];
+        }
+        vector<vector<pair<int, double> > > blockMatrix;
+        if (matrix.size() > 0) {
+            blockMatrix.resize(numBlockConstraints);
+            for (int i = 0; i < numBlockConstraints; i++)
+                for (auto& element : matrix[block[i]])
+                    blockMatrix[i].push_back(make_pair(localIndex[element.first], element.second));
+        }
+        ReferenceCCMAAlgorithm* blockCCMA = new ReferenceCCMAAlgorithm(numBlockConstraints, blockAtoms, blockDistance, blockMatrix);
+        blockCCMA->setMaximumNumberOfIterations(ccma.getMaximumNumberOfIterations());
+        threadCCMA.push_back(blockCCMA);
+    }
+}
+
+CpuCCMA::~CpuCCMA() {
+    for (auto ccma : threadCCMA)
+        delete ccma;
+}
+
+void CpuCCMA::apply(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& atomCoordinatesP, vector<double>& inverseMasses, double tolerance) {
+    atomic<int> atomicCounter;
+    atomicCounter = 0;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        while (true) {
+            int index = atomicCounter++;
+            if (index >= threadCCMA.size())
+                break;
+            threadCCMA[index]->apply(atomCoordinates, atomCoordinatesP, inverseMasses, tolerance);
+        }
+    });
+    threads.waitForThreads();
+}
+
+void CpuCCMA::applyToVelocities(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& velocities, vector<double>& inverseMasses, double tolerance) {
+    atomic<int> atomicCounter;
+    atomicCounter = 0;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        while (true) {
+            int index = atomicCounter++;
+            if (index >= threadCCMA.size())
+                break;
+            threadCCMA[index]->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
+        }
+    });
+    threads.waitForThreads();
+}
+
+int CpuCCMA::getLastNumberOfIterations() const {
+    int iterations = 0;
+    for (auto ccma : threadCCMA)
+        iterations = max(iterations, ccma->getLastNumberOfIterations());
+    return iterations;
+}
@@ -0,0 +1,165 @@
+
+/* Portions copyright (c) 2021 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuCustomDynamics.h"
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+using namespace Lepton;
+
+/**
+ * This holds the copies of the expressions and the variables they reference that are used by a single thread.
+ * CompiledExpression and VectorExpression are not thread safe, so every thread needs its own copy.
+ */
+class CpuCustomDynamics::ThreadData {
+public:
+    struct ThreadExpression {
+        CompiledExpression expression;
+        vector<pair<double*, double*> > sharedVariables;
+        bool needsUniform, needsGaussian;
+    };
+    double x, v, m, f, gaussian, uniform;
+    vector<double> perDofVariable;
+    map<string, double*> variableLocations;
+    map<const CompiledExpression*, ThreadExpression> expressions;
+    map<const VectorExpression*, VectorExpression> vectorExpressions;
+};
+
+CpuCustomDynamics::CpuCustomDynamics(int numberOfAtoms, const CustomIntegrator& integrator, ThreadPool& threads, CpuRandom& random) :
+           ReferenceCustomDynamics(numberOfAtoms, integrator), threads(threads), random(random) {
+    for (int i = 0; i < threads.getNumThreads(); i++) {
+        ThreadData* data = new ThreadData();
+        threadData.push_back(data);
+        data->perDofVariable.resize(integrator.getNumPerDofVariables());
+        data->variableLocations["x"] = &data->x;
+        data->variableLocations["v"] = &data->v;
+        data->variableLocations["m"] = &data->m;
+        data->variableLocations["f"] = &data->f;
+        data->variableLocations["gaussian"] = &data->gaussian;
+        data->variableLocations["uniform"] = &data->uniform;
+        for (int j = 0; j < integrator.getNumPerDofVariables(); j++)
+            data->variableLocations[integrator.getPerDofVariableName(j)] = &data->perDofVariable[j];
+        for (int j = 0; j < 32; j++) {
+            stringstream fname;
+            fname << "f" << j;
+            data->variableLocations[fname.str()] = &data->f;
+        }
+    }
+}
+
+CpuCustomDynamics::~CpuCustomDynamics() {
+    for (auto data : threadData)
+        delete data;
+}
+
+void CpuCustomDynamics::createThreadExpressions(const CompiledExpression& expression) {
+    if (threadData[0]->expressions.find(&expression) != threadData[0]->expressions.end())
+        return;
+    CompiledExpression& master = const_cast<CompiledExpression&>(expression);
+    for (auto data : threadData) {
+        ThreadData::ThreadExpression& threadExpression = data->expressions[&expression];
+        threadExpression.expression = expression;
+        threadExpression.expression.setVariableLocations(data->variableLocations);
+
+        // Global variables, context parameters, and energies are the same for every DOF.  Record where to copy them from
+        // at the start of each computation.
+
+        for (const string& name : expression.getVariables())
+            if (data->variableLocations.find(name) == data->variableLocations.end())
+                threadExpression.sharedVariables.push_back(make_pair(&master.getVariableReference(name), &threadExpression.expression.getVariableReference(name)));
+        threadExpression.needsUniform = (expression.getVariables().find("uniform") != expression.getVariables().end());
+        threadExpression.needsGaussian = (expression.getVariables().find("gaussian") != expression.getVariables().end());
+    }
+}
+
+void CpuCustomDynamics::createThreadExpressions(const VectorExpression& expression) {
+    if (threadData[0]->vectorExpressions.find(&expression) != threadData[0]->vectorExpressions.end())
+        return;
+    for (auto data : threadData)
+        data->vectorExpressions.insert(make_pair(&expression, expression));
+}
+
+void CpuCustomDynamics::computePerDof(int numberOfAtoms, vector<Vec3>& results, const vector<Vec3>& atomCoordinates,
+              const vector<Vec3>& velocities, const vector<Vec3>& forces, const vector<double>& masses,
+              const vector<vector<Vec3> >& perDof, const CompiledExpression& expression) {
+    createThreadExpressions(expression);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        ThreadData& data = *threadData[threadIndex];
+        ThreadData::ThreadExpression& threadExpression = data.expressions[&expression];
+        for (auto& variable : threadExpression.sharedVariables)
+            *variable.second = *variable.first;
+        int start = (int) ((long long) threadIndex*numberOfAtoms/threads.getNumThreads());
+        int end = (int) ((long long) (threadIndex+1)*numberOfAtoms/threads.getNumThreads());
+        for (int i = start; i < end; i++) {
+            if (masses[i] != 0.0) {
+                data.m = masses[i];
+                for (int j = 0; j < 3; j++) {
+                    // Compute the expression.
+
+                    data.x = atomCoordinates[i][j];
+                    data.v = velocities[i][j];
+                    data.f = forces[i][j];
+                    if (threadExpression.needsUniform)
+                        data.uniform = random.getUniformRandom(threadIndex);
+                    if (threadExpression.needsGaussian)
+                        data.gaussian = random.getGaussianRandom(threadIndex);
+                    for (int k = 0; k < (int) perDof.size(); k++)
+                        data.perDofVariable[k] = perDof[k][i][j];
+                    results[i][j] = threadExpression.expression.evaluate();
+                }
+            }
+        }
+    });
+    threads.waitForThreads();
+}
+
+void CpuCustomDynamics::computePerParticle(int numberOfAtoms, vector<Vec3>& results, const vector<Vec3>& atomCoordinates,
+              const vector<Vec3>& velocities, const vector<Vec3>& forces, const vector<double>& masses,
+              const vector<vector<Vec3> >& perDof, const map<string, double>& globals, const VectorExpression& expression) {
+    createThreadExpressions(expression);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        const VectorExpression& threadExpression = threadData[threadIndex]->vectorExpressions.find(&expression)->second;
+        map<string, Vec3> variables;
+        for (auto& entry : globals)
+            variables[entry.first] = Vec3(entry.second, entry.second, entry.second);
+        int start = (int) ((long long) threadIndex*numberOfAtoms/threads.getNumThreads());
+        int end = (int) ((long long) (threadIndex+1)*numberOfAtoms/threads.getNumThreads());
+        for (int i = start; i < end; i++) {
+            if (masses[i] != 0.0) {
+                variables["m"] = Vec3(masses[i], masses[i], masses[i]);
+                variables["x"] = atomCoordinates[i];
+                variables["v"] = velocities[i];
+                variables["f"] = forces[i];
+                variables["uniform"] = Vec3(random.getUniformRandom(threadIndex), random.getUniformRandom(threadIndex), random.getUniformRandom(threadIndex));
+                variables["gaussian"] = Vec3(random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex), random.getGaussianRandom(threadIndex));
+                for (int j = 0; j < perDof.size(); j++)
+                    variables[integrator.getPerDofVariableName(j)] = perDof[j][i];
+                results[i] = threadExpression.evaluate(variables);
+            }
+        }
+    });
+    threads.waitForThreads();
+}
@@ -37,15 +37,23 @@ CpuCustomGBForce::ThreadData::ThreadData(int numAtoms, int numThreads, int threa
                       const vector<vector<Lepton::CompiledExpression> >& valueDerivExpressions,
                       const vector<vector<Lepton::CompiledExpression> >& valueGradientExpressions,
                       const vector<vector<Lepton::CompiledExpression> >& valueParamDerivExpressions,
+                      const Lepton::CompiledVectorExpression& pairValueExpression,
+                      const Lepton::CompiledVectorExpression& pairValueDerivExpression,
+                      const vector<Lepton::CompiledVectorExpression>& pairValueParamDerivExpressions,
                       const vector<string>& valueNames,
                       const vector<Lepton::CompiledExpression>& energyExpressions,
                       const vector<vector<Lepton::CompiledExpression> >& energyDerivExpressions,
                       const vector<vector<Lepton::CompiledExpression> >& energyGradientExpressions,
                       const vector<vector<Lepton::CompiledExpression> >& energyParamDerivExpressions,
+                      const vector<vector<Lepton::CompiledVectorExpression> >& pairEnergyExpressions,
+                      const vector<vector<Lepton::CompiledVectorExpression> >& pairEnergyParamDerivExpressions,
                       const vector<string>& parameterNames) :
             valueExpressions(valueExpressions), valueDerivExpressions(valueDerivExpressions), valueGradientExpressions(valueGradientExpressions),
             valueParamDerivExpressions(valueParamDerivExpressions), energyExpressions(energyExpressions), energyDerivExpressions(energyDerivExpressions),
-            energyGradientExpressions(energyGradientExpressions), energyParamDerivExpressions(energyParamDerivExpressions) {
+            energyGradientExpressions(energyGradientExpressions), energyParamDerivExpressions(energyParamDerivExpressions),
+            pairValueExpression(pairValueExpression), pairValueDerivExpression(pairValueDerivExpression),
+            pairValueParamDerivExpressions(pairValueParamDerivExpressions), pairEnergyExpressions(pairEnergyExpressions),
+            pairEnergyParamDerivExpressions(pairEnergyParamDerivExpressions), numPairs(0) {
     firstAtom = (threadIndex*(long long) numAtoms)/numThreads;
     lastAtom = ((threadIndex+1)*(long long) numAtoms)/numThreads;
     map<string, double*> variableLocations;
@@ -115,42 +123,99 @@ CpuCustomGBForce::ThreadData::ThreadData(int numAtoms, int numThreads, int threa
     dEdV.resize(valueNames.size());
     for (auto& v : dEdV)
         v.resize(numAtoms);
+    dVdV0.resize(valueDerivExpressions.size());
     dVdX.resize(valueDerivExpressions.size());
     dVdY.resize(valueDerivExpressions.size());
     dVdZ.resize(valueDerivExpressions.size());
-    dVdR1.resize(valueDerivExpressions.size());
-    dVdR2.resize(valueDerivExpressions.size());
-    dValue0dParam.resize(valueParamDerivExpressions[0].size(), vector<float>(numAtoms));
-    energyParamDerivs.resize(valueParamDerivExpressions[0].size());
+    dValue0dParam.resize(pairValueParamDerivExpressions.size(), vector<float>(numAtoms));
+    energyParamDerivs.resize(pairValueParamDerivExpressions.size());
+
+    // Prepare for passing variables to the expressions for particle pairs.  Every variable holds
+    // one value for each pair in a batch.
+
+    width = this->pairValueExpression.getWidth();
+    pairR.resize(width);
+    pairParam.resize(2*parameterNames.size()*width);
+    pairValue.resize(2*valueNames.size()*width);
+    pairAtom1.resize(width);
+    pairAtom2.resize(width);
+    pairDeltaR.resize(width);
+    map<string, float*> pairVariableLocations;
+    pairVariableLocations["r"] = &pairR[0];
+    for (int i = 0; i < (int) parameterNames.size(); i++) {
+        for (int j = 0; j < 2; j++) {
+            stringstream name;
+            name << parameterNames[i] << (j+1);
+            pairVariableLocations[name.str()] = &pairParam[(i*2+j)*width];
+        }
+    }
+    for (int i = 0; i < (int) valueNames.size(); i++) {
+        for (int j = 0; j < 2; j++) {
+            stringstream name;
+            name << valueNames[i] << (j+1);
+            pairVariableLocations[name.str()] = &pairValue[(i*2+j)*width];
+        }
+    }
+
+    // Any other variable must be a global parameter.
+
+    vector<Lepton::CompiledVectorExpression*> pairExpressions = {&this->pairValueExpression, &this->pairValueDerivExpression};
+    for (auto& expression : this->pairValueParamDerivExpressions)
+        pairExpressions.push_back(&expression);
+    for (auto& expressions : this->pairEnergyExpressions)
+        for (auto& expression : expressions)
+            pairExpressions.push_back(&expression);
+    for (auto& expressions : this->pairEnergyParamDerivExpressions)
+        for (auto& expression : expressions)
+            pairExpressions.push_back(&expression);
+    set<string> globals;
+    for (auto expression : pairExpressions)
+        for (auto& name : expression->getVariables())
+            if (pairVariableLocations.find(name) == pairVariableLocations.end())
+                globals.insert(name);
+    globalNames.insert(globalNames.end(), globals.begin(), globals.end());
+    globalValues.resize(globalNames.size(), vector<float>(width));
+    for (int i = 0; i < (int) globalNames.size(); i++)
+        pairVariableLocations[globalNames[i]] = &globalValues[i][0];
+    for (auto expression : pairExpressions)
+        expression->setVariableLocations(pairVariableLocations);
 }
 
-CpuCustomGBForce::CpuCustomGBForce(int numAtoms, const std::vector<std::set<int> >& exclusions,
+CpuCustomGBForce::CpuCustomGBForce(int numAtoms, const CpuExclusions& exclusions,
                      const vector<Lepton::CompiledExpression>& valueExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& valueDerivExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& valueGradientExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& valueParamDerivExpressions,
+                     const Lepton::CompiledVectorExpression& pairValueExpression,
+                     const Lepton::CompiledVectorExpression& pairValueDerivExpression,
+                     const vector<Lepton::CompiledVectorExpression>& pairValueParamDerivExpressions,
                      const vector<string>& valueNames,
                      const vector<CustomGBForce::ComputationType>& valueTypes,
                      const vector<Lepton::CompiledExpression>& energyExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& energyDerivExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& energyGradientExpressions,
                      const vector<vector<Lepton::CompiledExpression> >& energyParamDerivExpressions,
+                     const vector<vector<Lepton::CompiledVectorExpression> >& pairEnergyExpressions,
+                     const vector<vector<Lepton::CompiledVectorExpression> >& pairEnergyParamDerivExpressions,
                      const vector<CustomGBForce::ComputationType>& energyTypes,
                      const vector<string>& parameterNames, ThreadPool& threads) :
             exclusions(exclusions), cutoff(false), periodic(false), valueTypes(valueTypes), energyTypes(energyTypes), numValues(valueNames.size()),
             numParams(parameterNames.size()), threads(threads) {
     for (int i = 0; i < threads.getNumThreads(); i++)
         threadData.push_back(new ThreadData(numAtoms, threads.getNumThreads(), i, valueExpressions, valueDerivExpressions, valueGradientExpressions,
-                valueParamDerivExpressions, valueNames, energyExpressions, energyDerivExpressions, energyGradientExpressions, energyParamDerivExpressions, parameterNames));
+                valueParamDerivExpressions, pairValueExpression, pairValueDerivExpression, pairValueParamDerivExpressions, valueNames, energyExpressions,
+                energyDerivExpressions, energyGradientExpressions, energyParamDerivExpressions, pairEnergyExpressions, pairEnergyParamDerivExpressions,
+                parameterNames));
     values.resize(numValues);
     dEdV.resize(numValues);
     for (int i = 0; i < (int) values.size(); i++) {
         values[i].resize(numAtoms);
         dEdV[i].resize(numAtoms);
     }
+    chainRuleFactor.resize(numAtoms);
     dValuedParam.resize(numValues);
     for (int i = 0; i < numValues; i++)
-        dValuedParam[i].resize(valueParamDerivExpressions[0].size(), vector<float>(numAtoms));
+        dValuedParam[i].resize(pairValueParamDerivExpressions.size(), vector<float>(numAtoms));
 }
 
 CpuCustomGBForce::~CpuCustomGBForce() {
@@ -254,6 +319,12 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
     fvec4 invBoxSize((1/periodicBoxSize[0]), (1/periodicBoxSize[1]), (1/periodicBoxSize[2]), 0);
     for (auto& param : *globalParameters)
         data.expressionSet.setVariable(data.expressionSet.getVariableIndex(param.first), param.second);
+    for (int i = 0; i < (int) data.globalNames.size(); i++) {
+        auto param = globalParameters->find(data.globalNames[i]);
+        if (param != globalParameters->end())
+            for (int j = 0; j < data.width; j++)
+                data.globalValues[i][j] = (float) param->second;
+    }
 
     // Calculate the first computed value.
 
@@ -262,10 +333,7 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
     for (auto& vals : data.dValue0dParam)
         for (auto& v : vals)
             v = 0.0f;
-    if (valueTypes[0] == CustomGBForce::ParticlePair)
-        calculateParticlePairValue(0, data, numberOfAtoms, posq, atomParameters, true, boxSize, invBoxSize);
-    else
-        calculateParticlePairValue(0, data, numberOfAtoms, posq, atomParameters, false, boxSize, invBoxSize);
+    calculateParticlePairValue(data, numberOfAtoms, posq, atomParameters, valueTypes[0] == CustomGBForce::ParticlePair, boxSize, invBoxSize);
     threads.syncThreads();
     
     // Sum derivatives of the first computed value with respect to global parameters.
@@ -331,7 +399,9 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
         threads.syncThreads();
     }
 
-    // Sum the energy derivatives.
+    // Sum the energy derivatives.  Then find the total derivative of the energy with respect to the
+    // first computed value of each atom, including its effect through the other computed values.
+    // The chain rule multiplies dV/dr for every pair by this.
 
     for (int atom = data.firstAtom; atom < data.lastAtom; atom++) {
         for (int i = 0; i < (int) dEdV.size(); i++) {
@@ -340,6 +410,22 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
                 sum += data->dEdV[i][atom];
             dEdV[i][atom] = sum;
         }
+        data.x = posq[4*atom];
+        data.y = posq[4*atom+1];
+        data.z = posq[4*atom+2];
+        for (int j = 0; j < numParams; j++)
+            data.param[j] = atomParameters[atom][j];
+        for (int i = 0; i < numValues; i++)
+            data.value[i] = values[i][atom];
+        float factor = dEdV[0][atom];
+        data.dVdV0[0] = 1.0f;
+        for (int i = 1; i < numValues; i++) {
+            data.dVdV0[i] = 0.0f;
+            for (int j = 0; j < i; j++)
+                data.dVdV0[i] += (float) data.valueDerivExpressions[i][j].evaluate()*data.dVdV0[j];
+            factor += dEdV[i][atom]*data.dVdV0[i];
+        }
+        chainRuleFactor[atom] = factor;
     }
     threads.syncThreads();
 
@@ -348,11 +434,8 @@ void CpuCustomGBForce::threadComputeForce(ThreadPool& threads, int threadIndex)
     calculateChainRuleForces(data, numberOfAtoms, posq, atomParameters, forces, boxSize, invBoxSize);
 }
 
-void CpuCustomGBForce::calculateParticlePairValue(int index, ThreadData& data, int numAtoms, float* posq, vector<double>* atomParameters,
+void CpuCustomGBForce::calculateParticlePairValue(ThreadData& data, int numAtoms, float* posq, vector<double>* atomParameters,
         bool useExclusions, const fvec4& boxSize, const fvec4& invBoxSize) {
-    for (int i = 0; i < numAtoms; i++)
-        values[index][i] = 0.0f;
-    vector<float>& valueArray = (index == 0 ? data.value0 : values[index]);
     if (cutoff) {
         // Loop over all pairs in the neighbor list.
 
@@ -369,10 +452,12 @@ void CpuCustomGBForce::calculateParticlePairValue(int index, ThreadData& data, i
                 for (int k = 0; k < blockSize; k++) {
                     if ((blockExclusions[i] & (1<<k)) == 0) {
                         int second = blockAtom[k];
-                        if (useExclusions && exclusions[first].find(second) != exclusions[first].end())
+                        if (useExclusions && exclusions.isExcluded(first, second))
                             continue;
-                        calculateOnePairValue(index, first, second, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
-                        calculateOnePairValue(index, second, first, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
+                        if (addPairToBatch(first, second, data, posq, atomParameters, 0, boxSize, invBoxSize))
+                            calculateBatchValue(data);
+                        if (addPairToBatch(second, first, data, posq, atomParameters, 0, boxSize, invBoxSize))
+                            calculateBatchValue(data);
                     }
                 }
             }
@@ -386,39 +471,38 @@ void CpuCustomGBForce::calculateParticlePairValue(int index, ThreadData& data, i
             if (i >= numAtoms)
                 break;
             for (int j = i+1; j < numAtoms; j++) {
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
-                calculateOnePairValue(index, i, j, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
-                calculateOnePairValue(index, j, i, data, posq, atomParameters, valueArray, boxSize, invBoxSize);
+                if (addPairToBatch(i, j, data, posq, atomParameters, 0, boxSize, invBoxSize))
+                    calculateBatchValue(data);
+                if (addPairToBatch(j, i, data, posq, atomParameters, 0, boxSize, invBoxSize))
+                    calculateBatchValue(data);
            }
         }
     }
+
+    // Compute any pairs left over in a partial batch.
+
+    calculateBatchValue(data);
 }
 
-void CpuCustomGBForce::calculateOnePairValue(int index, int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
-        vector<float>& valueArray, const fvec4& boxSize, const fvec4& invBoxSize) {
-    fvec4 deltaR;
-    fvec4 pos1(posq+4*atom1);
-    fvec4 pos2(posq+4*atom2);
-    float r2;
-    getDeltaR(pos2, pos1, deltaR, r2, periodic, boxSize, invBoxSize);
-    if (cutoff && r2 >= cutoffDistance2)
+void CpuCustomGBForce::calculateBatchValue(ThreadData& data) {
+    if (data.numPairs == 0)
         return;
-    data.r = sqrtf(r2);
-    for (int i = 0; i < numParams; i++) {
-        data.particleParam[i*2] = atomParameters[atom1][i];
-        data.particleParam[i*2+1] = atomParameters[atom2][i];
-    }
-    for (int i = 0; i < index; i++) {
-        data.particleValue[i*2] = values[i][atom1];
-        data.particleValue[i*2+1] = values[i][atom2];
-    }
-    valueArray[atom1] += (float) data.valueExpressions[index].evaluate();
+    padBatch(data, 0);
+    int numPairs = data.numPairs;
+    data.numPairs = 0;
+    const float* value = data.pairValueExpression.evaluate();
+    for (int i = 0; i < numPairs; i++)
+        data.value0[data.pairAtom1[i]] += value[i];
     
     // Calculate derivatives with respect to parameters.
     
-    for (int i = 0; i < data.valueParamDerivExpressions[index].size(); i++)
-        data.dValue0dParam[i][atom1] += data.valueParamDerivExpressions[index][i].evaluate();
+    for (int j = 0; j < data.pairValueParamDerivExpressions.size(); j++) {
+        const float* deriv = data.pairValueParamDerivExpressions[j].evaluate();
+        for (int i = 0; i < numPairs; i++)
+            data.dValue0dParam[j][data.pairAtom1[i]] += deriv[i];
+    }
 }
 
 void CpuCustomGBForce::calculateSingleParticleEnergyTerm(int index, ThreadData& data, int numAtoms, float* posq,
@@ -464,9 +548,10 @@ void CpuCustomGBForce::calculateParticlePairEnergyTerm(int index, ThreadData& da
                 for (int k = 0; k < blockSize; k++) {
                     if ((blockExclusions[i] & (1<<k)) == 0) {
                         int second = blockAtom[k];
-                        if (useExclusions && exclusions[first].find(second) != exclusions[first].end())
+                        if (useExclusions && exclusions.isExcluded(first, second))
                             continue;
-                        calculateOnePairEnergyTerm(index, first, second, data, posq, atomParameters, forces, totalEnergy, boxSize, invBoxSize);
+                        if (addPairToBatch(first, second, data, posq, atomParameters, numValues, boxSize, invBoxSize))
+                            calculateBatchEnergyTerm(index, data, forces, totalEnergy);
                     }
                 }
             }
@@ -480,61 +565,66 @@ void CpuCustomGBForce::calculateParticlePairEnergyTerm(int index, ThreadData& da
             if (i >= numAtoms)
                 break;
             for (int j = i+1; j < numAtoms; j++) {
-                if (useExclusions && exclusions[i].find(j) != exclusions[i].end())
+                if (useExclusions && exclusions.isExcluded(i, j))
                     continue;
-                calculateOnePairEnergyTerm(index, i, j, data, posq, atomParameters, forces, totalEnergy, boxSize, invBoxSize);
+                if (addPairToBatch(i, j, data, posq, atomParameters, numValues, boxSize, invBoxSize))
+                    calculateBatchEnergyTerm(index, data, forces, totalEnergy);
            }
         }
     }
-}
 
-void CpuCustomGBForce::calculateOnePairEnergyTerm(int index, int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
-        float* forces, double& totalEnergy, const fvec4& boxSize, const fvec4& invBoxSize) {
-    // Compute the displacement.
+    // Compute any pairs left over in a partial batch.
 
-    fvec4 deltaR;
-    fvec4 pos1(posq+4*atom1);
-    fvec4 pos2(posq+4*atom2);
-    float r2;
-    getDeltaR(pos2, pos1, deltaR, r2, periodic, boxSize, invBoxSize);
-    if (cutoff && r2 >= cutoffDistance2)
+    calculateBatchEnergyTerm(index, data, forces, totalEnergy);
+}
+
+void CpuCustomGBForce::calculateBatchEnergyTerm(int index, ThreadData& data, float* forces, double& totalEnergy) {
+    if (data.numPairs == 0)
         return;
-    float r = sqrtf(r2);
-    data.r = r;
+    padBatch(data, numValues);
+    int numPairs = data.numPairs;
+    data.numPairs = 0;
+    vector<Lepton::CompiledVectorExpression>& expressions = data.pairEnergyExpressions[index];
 
-    // Record variables for evaluating expressions.
+    // Evaluate the energy and its derivatives.
 
-    for (int i = 0; i < numParams; i++) {
-        data.particleParam[i*2] = atomParameters[atom1][i];
-        data.particleParam[i*2+1] = atomParameters[atom2][i];
+    if (includeEnergy) {
+        const float* energy = expressions[0].evaluate();
+        for (int i = 0; i < numPairs; i++)
+            totalEnergy += energy[i];
     }
-    for (int i = 0; i < (int) values.size(); i++) {
-        data.particleValue[i*2] = values[i][atom1];
-        data.particleValue[i*2+1] = values[i][atom2];
+    const float* dEdR = expressions[1].evaluate();
+    for (int i = 0; i < numPairs; i++) {
+        int atom1 = data.pairAtom1[i];
+        int atom2 = data.pairAtom2[i];
+        fvec4 result = data.pairDeltaR[i]*(dEdR[i]/data.pairR[i]);
+        (fvec4(forces+4*atom1)-result).store(forces+4*atom1);
+        (fvec4(forces+4*atom2)+result).store(forces+4*atom2);
     }
-
-    // Evaluate the energy and its derivatives.
-
-    if (includeEnergy)
-        totalEnergy += (float) data.energyExpressions[index].evaluate();
-    float dEdR = (float) data.energyDerivExpressions[index][0].evaluate();
-    dEdR *= 1/r;
-    fvec4 result = deltaR*dEdR;
-    (fvec4(forces+4*atom1)-result).store(forces+4*atom1);
-    (fvec4(forces+4*atom2)+result).store(forces+4*atom2);
-    for (int i = 0; i < (int) values.size(); i++) {
-        data.dEdV[i][atom1] += (float) data.energyDerivExpressions[index][2*i+1].evaluate();
-        data.dEdV[i][atom2] += (float) data.energyDerivExpressions[index][2*i+2].evaluate();
+    for (int j = 0; j < numValues; j++) {
+        const float* dEdV1 = expressions[2*j+2].evaluate();
+        for (int i = 0; i < numPairs; i++)
+            data.dEdV[j][data.pairAtom1[i]] += dEdV1[i];
+        const float* dEdV2 = expressions[2*j+3].evaluate();
+        for (int i = 0; i < numPairs; i++)
+            data.dEdV[j][data.pairAtom2[i]] += dEdV2[i];
     }
         
     // Compute derivatives with respect to parameters.
 
-    for (int i = 0; i < data.energyParamDerivExpressions[index].size(); i++)
-        data.energyParamDerivs[i] += data.energyParamDerivExpressions[index][i].evaluate();
+    for (int j = 0; j < data.pairEnergyParamDerivExpressions[index].size(); j++) {
+        const float* deriv = data.pairEnergyParamDerivExpressions[index][j].evaluate();
+        for (int i = 0; i < numPairs; i++)
+            data.energyParamDerivs[j] += deriv[i];
+    }
 }
 
 void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms, float* posq, vector<double>* atomParameters,
         float* forces, const fvec4& boxSize, const fvec4& invBoxSize) {
+    // Excluded pairs do not contribute to the first computed value if it is of type ParticlePair,
+    // so they can be skipped.
+
+    bool useExclusions = (valueTypes[0] == CustomGBForce::ParticlePair);
     if (cutoff) {
         // Loop over all pairs in the neighbor list.
 
@@ -551,9 +641,12 @@ void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms,
                 for (int k = 0; k < blockSize; k++) {
                     if ((blockExclusions[i] & (1<<k)) == 0) {
                         int second = blockAtom[k];
-                        bool isExcluded = (exclusions[first].find(second) != exclusions[first].end());
-                        calculateOnePairChainRule(first, second, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
-                        calculateOnePairChainRule(second, first, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
+                        if (useExclusions && exclusions.isExcluded(first, second))
+                            continue;
+                        if (addPairToBatch(first, second, data, posq, atomParameters, 0, boxSize, invBoxSize))
+                            calculateBatchChainRule(data, forces);
+                        if (addPairToBatch(second, first, data, posq, atomParameters, 0, boxSize, invBoxSize))
+                            calculateBatchChainRule(data, forces);
                     }
                 }
             }
@@ -567,12 +660,16 @@ void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms,
             if (i >= numAtoms)
                 break;
             for (int j = i+1; j < numAtoms; j++) {
-                bool isExcluded = (exclusions[i].find(j) != exclusions[i].end());
-                calculateOnePairChainRule(i, j, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
-                calculateOnePairChainRule(j, i, data, posq, atomParameters, forces, isExcluded, boxSize, invBoxSize);
+                if (useExclusions && exclusions.isExcluded(i, j))
+                    continue;
+                if (addPairToBatch(i, j, data, posq, atomParameters, 0, boxSize, invBoxSize))
+                    calculateBatchChainRule(data, forces);
+                if (addPairToBatch(j, i, data, posq, atomParameters, 0, boxSize, invBoxSize))
+                    calculateBatchChainRule(data, forces);
            }
         }
     }
+    calculateBatchChainRule(data, forces);
 
     // Compute chain rule terms for computed values that depend explicitly on particle coordinates.
 
@@ -610,8 +707,28 @@ void CpuCustomGBForce::calculateChainRuleForces(ThreadData& data, int numAtoms,
                 data.energyParamDerivs[k] += dEdV[j][i]*dValuedParam[j][k][i];
 }
 
-void CpuCustomGBForce::calculateOnePairChainRule(int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
-        float* forces, bool isExcluded, const fvec4& boxSize, const fvec4& invBoxSize) {
+void CpuCustomGBForce::calculateBatchChainRule(ThreadData& data, float* forces) {
+    if (data.numPairs == 0)
+        return;
+    padBatch(data, 0);
+    int numPairs = data.numPairs;
+    data.numPairs = 0;
+
+    // The derivative of the first computed value of atom1 with respect to r is multiplied by the
+    // derivative of the energy with respect to that value, which was computed in advance.
+
+    const float* dVdR = data.pairValueDerivExpression.evaluate();
+    for (int i = 0; i < numPairs; i++) {
+        int atom1 = data.pairAtom1[i];
+        int atom2 = data.pairAtom2[i];
+        fvec4 result = data.pairDeltaR[i]*(chainRuleFactor[atom1]*dVdR[i]/data.pairR[i]);
+        (fvec4(forces+4*atom1)-result).store(forces+4*atom1);
+        (fvec4(forces+4*atom2)+result).store(forces+4*atom2);
+    }
+}
+
+bool CpuCustomGBForce::addPairToBatch(int atom1, int atom2, ThreadData& data, float* posq, vector<double>* atomParameters,
+        int numValues, const fvec4& boxSize, const fvec4& invBoxSize) {
     // Compute the displacement.
 
     fvec4 deltaR;
@@ -620,49 +737,39 @@ void CpuCustomGBForce::calculateOnePairChainRule(int atom1, int atom2, ThreadDat
     float r2;
     getDeltaR(pos2, pos1, deltaR, r2, periodic, boxSize, invBoxSize);
     if (cutoff && r2 >= cutoffDistance2)
-        return;
-    float r = sqrtf(r2);
-    data.r = r;
+        return false;
 
-    // Record variables for evaluating expressions.
+    // Record the pair in the next slot of the batch.
 
+    int width = data.width;
+    int index = data.numPairs++;
+    data.pairR[index] = sqrtf(r2);
+    data.pairAtom1[index] = atom1;
+    data.pairAtom2[index] = atom2;
+    data.pairDeltaR[index] = deltaR;
     for (int i = 0; i < numParams; i++) {
-        data.particleParam[i*2] = atomParameters[atom1][i];
-        data.particleParam[i*2+1] = atomParameters[atom2][i];
-        data.param[i] = atomParameters[atom1][i];
-    }
-    data.value[0] = values[0][atom1];
-    data.x = posq[4*atom1];
-    data.y = posq[4*atom1+1];
-    data.z = posq[4*atom1+2];
-    data.particleValue[0] = values[0][atom1];
-    data.particleValue[1] = values[0][atom2];
-
-    // Evaluate the derivative of each parameter with respect to position and apply forces.
-
-    float rinv = 1/r;
-    deltaR *= rinv;
-    fvec4 f1(0.0f), f2(0.0f);
-    if (!isExcluded || valueTypes[0] != CustomGBForce::ParticlePair) {
-        data.dVdR1[0] = (float) data.valueDerivExpressions[0][0].evaluate();
-        data.dVdR2[0] = -data.dVdR1[0];
-        f1 -= deltaR*(dEdV[0][atom1]*data.dVdR1[0]);
-        f2 -= deltaR*(dEdV[0][atom1]*data.dVdR2[0]);
-    }
-    for (int i = 1; i < (int) values.size(); i++) {
-        data.value[i] = values[i][atom1];
-        data.dVdR1[i] = 0.0;
-        data.dVdR2[i] = 0.0;
-        for (int j = 0; j < i; j++) {
-            float dVdV = (float) data.valueDerivExpressions[i][j].evaluate();
-            data.dVdR1[i] += dVdV*data.dVdR1[j];
-            data.dVdR2[i] += dVdV*data.dVdR2[j];
-        }
-        f1 -= deltaR*(dEdV[i][atom1]*data.dVdR1[i]);
-        f2 -= deltaR*(dEdV[i][atom1]*data.dVdR2[i]);
+        data.pairParam[(i*2)*width+index] = (float) atomParameters[atom1][i];
+        data.pairParam[(i*2+1)*width+index] = (float) atomParameters[atom2][i];
+    }
+    for (int i = 0; i < numValues; i++) {
+        data.pairValue[(i*2)*width+index] = values[i][atom1];
+        data.pairValue[(i*2+1)*width+index] = values[i][atom2];
+    }
+    return (data.numPairs == width);
+}
+
+void CpuCustomGBForce::padBatch(ThreadData& data, int numValues) {
+    // Fill any unused slots with copies of the first pair, so the expressions never see
+    // uninitialized values.
+
+    int width = data.width;
+    for (int i = data.numPairs; i < width; i++) {
+        data.pairR[i] = data.pairR[0];
+        for (int j = 0; j < 2*numParams; j++)
+            data.pairParam[j*width+i] = data.pairParam[j*width];
+        for (int j = 0; j < 2*numValues; j++)
+            data.pairValue[j*width+i] = data.pairValue[j*width];
     }
-    (fvec4(forces+4*atom1)+f1).store(forces+4*atom1);
-    (fvec4(forces+4*atom2)+f2).store(forces+4*atom2);
 }
 
 void CpuCustomGBForce::getDeltaR(const fvec4& posI, const fvec4& posJ, fvec4& deltaR, float& r2, bool periodic, const fvec4& boxSize, const fvec4& invBoxSize) const {
@@ -32,45 +32,62 @@
 using namespace OpenMM;
 using namespace std;
 
-CpuCustomNonbondedForce::ThreadData::ThreadData(const Lepton::CompiledExpression& energyExpression, const Lepton::CompiledExpression& forceExpression,
-            const vector<string>& parameterNames, const std::vector<Lepton::CompiledExpression> energyParamDerivExpressions,
+CpuCustomNonbondedForce::ThreadData::ThreadData(const Lepton::CompiledVectorExpression& energyExpression, const Lepton::CompiledVectorExpression& forceExpression,
+            const vector<string>& parameterNames, const std::vector<Lepton::CompiledVectorExpression> energyParamDerivExpressions,
             const vector<string>& computedValueNames, const vector<Lepton::CompiledExpression> computedValueExpressions,
             vector<vector<double> >& atomComputedValues) :
             energyExpression(energyExpression), forceExpression(forceExpression), energyParamDerivExpressions(energyParamDerivExpressions),
-            computedValueExpressions(computedValueExpressions), atomComputedValues(atomComputedValues) {
-    // Prepare for passing variables to expressions.
+            computedValueExpressions(computedValueExpressions), numPairs(0), atomComputedValues(atomComputedValues) {
+    // Prepare for passing variables to expressions.  Every variable holds one value for each
+    // interaction in a batch.
 
-    map<string, double*> variableLocations;
-    variableLocations["r"] = &r;
-    particleParam.resize(2*parameterNames.size());
-    computedValues.resize(2*computedValueNames.size());
+    width = energyExpression.getWidth();
+    r.resize(width);
+    pairParam.resize(2*parameterNames.size()*width);
+    pairComputedValues.resize(2*computedValueNames.size()*width);
+    pairAtom1.resize(width);
+    pairAtom2.resize(width);
+    pairDeltaR.resize(width);
+    switchValue.resize(width);
+    map<string, float*> variableLocations;
+    variableLocations["r"] = &r[0];
     for (int i = 0; i < (int) parameterNames.size(); i++) {
         for (int j = 0; j < 2; j++) {
             stringstream name;
             name << parameterNames[i] << (j+1);
-            variableLocations[name.str()] = &particleParam[i*2+j];
+            variableLocations[name.str()] = &pairParam[(i*2+j)*width];
         }
     }
     for (int i = 0; i < (int) computedValueNames.size(); i++) {
         for (int j = 0; j < 2; j++) {
             stringstream name;
             name << computedValueNames[i] << (j+1);
-            variableLocations[name.str()] = &computedValues[i*2+j];
+            variableLocations[name.str()] = &pairComputedValues[(i*2+j)*width];
         }
     }
+
+    // Any other variable must be a global parameter.
+
+    set<string> globals;
+    vector<Lepton::CompiledVectorExpression*> pairExpressions = {&this->energyExpression, &this->forceExpression};
+    for (auto& expression : this->energyParamDerivExpressions)
+        pairExpressions.push_back(&expression);
+    for (auto expression : pairExpressions)
+        for (auto& name : expression->getVariables())
+            if (variableLocations.find(name) == variableLocations.end())
+                globals.insert(name);
+    globalNames.insert(globalNames.end(), globals.begin(), globals.end());
+    globalValues.resize(globalNames.size(), vector<float>(width));
+    for (int i = 0; i < (int) globalNames.size(); i++)
+        variableLocations[globalNames[i]] = &globalValues[i][0];
     energyParamDerivs.resize(energyParamDerivExpressions.size());
-    this->energyExpression.setVariableLocations(variableLocations);
-    this->forceExpression.setVariableLocations(variableLocations);
-    expressionSet.registerExpression(this->energyExpression);
-    expressionSet.registerExpression(this->forceExpression);
-    for (auto& expression : this->energyParamDerivExpressions) {
-        expression.setVariableLocations(variableLocations);
-        expressionSet.registerExpression(expression);
-    }
+    for (auto expression : pairExpressions)
+        expression->setVariableLocations(variableLocations);
 
     // Prepare for passing variables to the computed value expressions.
 
     map<string, double*> valueVariableLocations;
+    particleParam.resize(parameterNames.size());
     for (int i = 0; i < parameterNames.size(); i++)
         valueVariableLocations[parameterNames[i]] = &particleParam[i];
     for (auto& expression : this->computedValueExpressions) {
@@ -79,11 +96,11 @@ CpuCustomNonbondedForce::ThreadData::ThreadData(const Lepton::CompiledExpression
     }
 }
 
-CpuCustomNonbondedForce::CpuCustomNonbondedForce(const Lepton::CompiledExpression& energyExpression,
-            const Lepton::CompiledExpression& forceExpression, const vector<string>& parameterNames, const vector<set<int> >& exclusions,
-            const vector<Lepton::CompiledExpression> energyParamDerivExpressions, const vector<string>& computedValueNames,
+CpuCustomNonbondedForce::CpuCustomNonbondedForce(const Lepton::CompiledVectorExpression& energyExpression,
+            const Lepton::CompiledVectorExpression& forceExpression, const vector<string>& parameterNames, const CpuExclusions& exclusions,
+            const vector<Lepton::CompiledVectorExpression> energyParamDerivExpressions, const vector<string>& computedValueNames,
             const vector<Lepton::CompiledExpression> computedValueExpressions, ThreadPool& threads) :
-            cutoff(false), useSwitch(false), periodic(false), useInteractionGroups(false), paramNames(parameterNames), exclusions(exclusions),
+            cutoff(false), useSwitch(false), periodic(false), useInteractionGroups(false), hasGroupInteractions(false), paramNames(parameterNames), exclusions(exclusions),
             computedValueNames(computedValueNames), threads(threads) {
     for (int i = 0; i < threads.getNumThreads(); i++)
         threadData.push_back(new ThreadData(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions, computedValueNames, computedValueExpressions, atomComputedValues));
@@ -102,12 +119,36 @@ void CpuCustomNonbondedForce::setUseCutoff(double distance, const CpuNeighborLis
 
 void CpuCustomNonbondedForce::setInteractionGroups(const vector<pair<set<int>, set<int> > >& groups) {
     useInteractionGroups = true;
-    for (auto& group : groups) {
+    interactionGroups = groups;
+    hasGroupInteractions = false;
+    groupInteractions.clear();
+
+    // Record which groups each atom belongs to.  Bit i of groupMask1 (groupMask2) is set if the
+    // atom is in the first (second) set of group i.
+
+    groupMask1.clear();
+    groupMask2.clear();
+    if (groups.size() <= 64) {
+        int numAtoms = exclusions.getNumParticles();
+        groupMask1.resize(numAtoms, 0);
+        groupMask2.resize(numAtoms, 0);
+        for (int i = 0; i < (int) groups.size(); i++) {
+            unsigned long long bit = 1ULL<<i;
+            for (int atom : groups[i].first)
+                groupMask1[atom] |= bit;
+            for (int atom : groups[i].second)
+                groupMask2[atom] |= bit;
+        }
+    }
+}
+
+void CpuCustomNonbondedForce::createGroupInteractions() {
+    for (auto& group : interactionGroups) {
         const set<int>& set1 = group.first;
         const set<int>& set2 = group.second;
         for (set<int>::const_iterator atom1 = set1.begin(); atom1 != set1.end(); ++atom1) {
             for (set<int>::const_iterator atom2 = set2.begin(); atom2 != set2.end(); ++atom2) {
-                if (*atom1 == *atom2 || exclusions[*atom1].find(*atom2) != exclusions[*atom1].end())
+                if (*atom1 == *atom2 || exclusions.isExcluded(*atom1, *atom2))
                     continue; // This is an excluded interaction.
                 if (*atom1 > *atom2 && set1.find(*atom2) != set1.end() && set2.find(*atom1) != set2.end())
                     continue; // Both atoms are in both sets, so skip duplicate interactions.
@@ -115,6 +156,7 @@ void CpuCustomNonbondedForce::setInteractionGroups(const vector<pair<set<int>, s
             }
         }
     }
+    hasGroupInteractions = true;
 }
 
 void CpuCustomNonbondedForce::setUseSwitchingFunction(double distance) {
@@ -160,6 +202,9 @@ void CpuCustomNonbondedForce::calculatePairIxn(int numberOfAtoms, float* posq, v
     threadEnergy.resize(threads.getNumThreads());
     atomComputedValues.resize(computedValueNames.size(), vector<double>(numberOfAtoms));
     atomicCounter = 0;
+    useGroupMasks = (useInteractionGroups && cutoff && groupMask1.size() > 0);
+    if (useInteractionGroups && !useGroupMasks && !hasGroupInteractions)
+        createGroupInteractions();
     
     // Signal the threads to start running and wait for them to finish.
     
@@ -189,6 +234,12 @@ void CpuCustomNonbondedForce::threadComputeForce(ThreadPool& threads, int thread
     ThreadData& data = *threadData[threadIndex];
     for (auto& param : *globalParameters)
         data.expressionSet.setVariable(data.expressionSet.getVariableIndex(param.first), param.second);
+    for (int i = 0; i < (int) data.globalNames.size(); i++) {
+        auto param = globalParameters->find(data.globalNames[i]);
+        if (param != globalParameters->end())
+            for (int j = 0; j < data.width; j++)
+                data.globalValues[i][j] = (float) param->second;
+    }
 
     // Process computed values for this thread's subset of interactions.
 
@@ -214,7 +265,47 @@ void CpuCustomNonbondedForce::threadComputeForce(ThreadPool& threads, int thread
         deriv = 0.0;
     fvec4 boxSize(periodicBoxVectors[0][0], periodicBoxVectors[1][1], periodicBoxVectors[2][2], 0);
     fvec4 invBoxSize(recipBoxSize[0], recipBoxSize[1], recipBoxSize[2], 0);
-    if (useInteractionGroups) {
+    if (useGroupMasks) {
+        // The user has specified interaction groups.  Get the interactions from the neighbor list,
+        // keeping only the ones between atoms in the same group.
+
+        while (true) {
+            int blockIndex = atomicCounter++;
+            if (blockIndex >= neighborList->getNumBlocks())
+                break;
+            const int blockSize = neighborList->getBlockSize();
+            const int32_t* blockAtom = &neighborList->getSortedAtoms()[blockSize*blockIndex];
+            unsigned long long blockMask1 = 0, blockMask2 = 0;
+            for (int k = 0; k < blockSize; k++) {
+                blockMask1 |= groupMask1[blockAtom[k]];
+                blockMask2 |= groupMask2[blockAtom[k]];
+            }
+            if (blockMask1 == 0 && blockMask2 == 0)
+                continue;
+            const vector<int>& neighbors = neighborList->getBlockNeighbors(blockIndex);
+            const auto& exclusions = neighborList->getBlockExclusions(blockIndex);
+            for (int i = 0; i < (int) neighbors.size(); i++) {
+                int first = neighbors[i];
+                unsigned long long mask1 = groupMask1[first];
+                unsigned long long mask2 = groupMask2[first];
+                if ((mask1 & blockMask2) == 0 && (mask2 & blockMask1) == 0)
+                    continue;
+                for (int k = 0; k < blockSize; k++) {
+                    if ((exclusions[i] & (1<<k)) == 0) {
+                        // The interaction is computed once for every group that contains it.
+
+                        int second = blockAtom[k];
+                        unsigned long long groups = (mask1 & groupMask2[second]) | (mask2 & groupMask1[second]);
+                        while (groups != 0) {
+                            calculateOneIxn(first, second, data, forces, energy, boxSize, invBoxSize);
+                            groups &= groups-1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    else if (useInteractionGroups) {
         // The user has specified interaction groups, so compute only the requested interactions.
         
         int start = threadIndex*groupInteractions.size()/numThreads;
@@ -222,14 +313,6 @@ void CpuCustomNonbondedForce::threadComputeForce(ThreadPool& threads, int thread
         for (int i = start; i < end; i++) {
             int atom1 = groupInteractions[i].first;
             int atom2 = groupInteractions[i].second;
-            for (int j = 0; j < paramNames.size(); j++) {
-                data.particleParam[j*2] = atomParameters[atom1][j];
-                data.particleParam[j*2+1] = atomParameters[atom2][j];
-            }
-            for (int j = 0; j < computedValueNames.size(); j++) {
-                data.computedValues[j*2] = atomComputedValues[j][atom1];
-                data.computedValues[j*2+1] = atomComputedValues[j][atom2];
-            }
             calculateOneIxn(atom1, atom2, data, forces, energy, boxSize, invBoxSize);
         }
     }
@@ -246,20 +329,9 @@ void CpuCustomNonbondedForce::threadComputeForce(ThreadPool& threads, int thread
             const auto& exclusions = neighborList->getBlockExclusions(blockIndex);
             for (int i = 0; i < (int) neighbors.size(); i++) {
                 int first = neighbors[i];
-                for (int j = 0; j < paramNames.size(); j++)
-                    data.particleParam[j*2] = atomParameters[first][j];
-                for (int j = 0; j < computedValueNames.size(); j++)
-                    data.computedValues[j*2] = atomComputedValues[j][first];
-                for (int k = 0; k < blockSize; k++) {
-                    if ((exclusions[i] & (1<<k)) == 0) {
-                        int second = blockAtom[k];
-                        for (int j = 0; j < paramNames.size(); j++)
-                            data.particleParam[j*2+1] = atomParameters[second][j];
-                        for (int j = 0; j < computedValueNames.size(); j++)
-                            data.computedValues[j*2+1] = atomComputedValues[j][second];
-                        calculateOneIxn(first, second, data, forces, energy, boxSize, invBoxSize);
-                    }
-                }
+                for (int k = 0; k < blockSize; k++)
+                    if ((exclusions[i] & (1<<k)) == 0)
+                        calculateOneIxn(first, blockAtom[k], data, forces, energy, boxSize, invBoxSize);
             }
         }
     }
@@ -271,20 +343,15 @@ void CpuCustomNonbondedForce::threadComputeForce(ThreadPool& threads, int thread
             if (ii >= numberOfAtoms)
                 break;
             for (int jj = ii+1; jj < numberOfAtoms; jj++) {
-                if (exclusions[jj].find(ii) == exclusions[jj].end()) {
-                    for (int j = 0; j < paramNames.size(); j++) {
-                        data.particleParam[j*2] = atomParameters[ii][j];
-                        data.particleParam[j*2+1] = atomParameters[jj][j];
-                    }
-                    for (int j = 0; j < computedValueNames.size(); j++) {
-                        data.computedValues[j*2] = atomComputedValues[j][ii];
-                        data.computedValues[j*2+1] = atomComputedValues[j][jj];
-                    }
+                if (!exclusions.isExcluded(jj, ii))
                     calculateOneIxn(ii, jj, data, forces, energy, boxSize, invBoxSize);
-                }
             }
         }
     }
+
+    // Compute any interactions left over in a partial batch.
+
+    calculateBatchIxn(data, forces, energy);
 }
 
 void CpuCustomNonbondedForce::calculateOneIxn(int ii, int jj, ThreadData& data, 
@@ -298,37 +365,87 @@ void CpuCustomNonbondedForce::calculateOneIxn(int ii, int jj, ThreadData& data,
     getDeltaR(posI, posJ, deltaR, r2, boxSize, invBoxSize);
     if (cutoff && r2 >= cutoffDistance*cutoffDistance)
         return;
-    float r = sqrtf(r2);
-    data.r = r;
-
-    // accumulate forces
-
-    double dEdR = (includeForce ? data.forceExpression.evaluate()/r : 0.0);
-    double energy = 0.0;
-    if (includeEnergy || (useSwitch && r > switchingDistance))
-        energy = data.energyExpression.evaluate();
-    double switchValue = 1.0;
-    if (useSwitch) {
-        if (r > switchingDistance) {
-            double t = (r-switchingDistance)/(cutoffDistance-switchingDistance);
-            switchValue = 1+t*t*t*(-10+t*(15-t*6));
-            double switchDeriv = t*t*(-30+t*(60-t*30))/(cutoffDistance-switchingDistance);
-            dEdR = switchValue*dEdR + energy*switchDeriv/r;
-            energy *= switchValue;
-        }
+
+    // Record the interaction in the next slot of the batch.
+
+    int width = data.width;
+    int index = data.numPairs;
+    data.r[index] = sqrtf(r2);
+    data.pairAtom1[index] = ii;
+    data.pairAtom2[index] = jj;
+    data.pairDeltaR[index] = deltaR;
+    for (int j = 0; j < paramNames.size(); j++) {
+        data.pairParam[(j*2)*width+index] = (float) atomParameters[ii][j];
+        data.pairParam[(j*2+1)*width+index] = (float) atomParameters[jj][j];
+    }
+    for (int j = 0; j < computedValueNames.size(); j++) {
+        data.pairComputedValues[(j*2)*width+index] = (float) atomComputedValues[j][ii];
+        data.pairComputedValues[(j*2+1)*width+index] = (float) atomComputedValues[j][jj];
     }
-    fvec4 result = deltaR*dEdR;
-    (fvec4(forces+4*ii)+result).store(forces+4*ii);
-    (fvec4(forces+4*jj)-result).store(forces+4*jj);
+    data.numPairs++;
+    if (data.numPairs == width)
+        calculateBatchIxn(data, forces, totalEnergy);
+}
+
+void CpuCustomNonbondedForce::calculateBatchIxn(ThreadData& data, float* forces, double& totalEnergy) {
+    int numPairs = data.numPairs;
+    if (numPairs == 0)
+        return;
+    data.numPairs = 0;
 
-    // accumulate energies
+    // Fill any unused slots with copies of the first interaction, so the expressions never see
+    // uninitialized values.
+
+    int width = data.width;
+    for (int i = numPairs; i < width; i++) {
+        data.r[i] = data.r[0];
+        for (int j = 0; j < 2*paramNames.size(); j++)
+            data.pairParam[j*width+i] = data.pairParam[j*width];
+        for (int j = 0; j < 2*computedValueNames.size(); j++)
+            data.pairComputedValues[j*width+i] = data.pairComputedValues[j*width];
+    }
+
+    // Evaluate the expressions for all interactions at once.
+
+    const float* dEdRValues = (includeForce ? data.forceExpression.evaluate() : NULL);
+    const float* energyValues = NULL;
+    if (includeEnergy || useSwitch)
+        energyValues = data.energyExpression.evaluate();
+
+    // Accumulate forces and energies.
+
+    for (int i = 0; i < numPairs; i++) {
+        double r = data.r[i];
+        double dEdR = (includeForce ? dEdRValues[i]/r : 0.0);
+        double energy = (energyValues == NULL ? 0.0 : energyValues[i]);
+        double switchValue = 1.0;
+        if (useSwitch) {
+            if (r > switchingDistance) {
+                double t = (r-switchingDistance)/(cutoffDistance-switchingDistance);
+                switchValue = 1+t*t*t*(-10+t*(15-t*6));
+                double switchDeriv = t*t*(-30+t*(60-t*30))/(cutoffDistance-switchingDistance);
+                dEdR = switchValue*dEdR + energy*switchDeriv/r;
+                energy *= switchValue;
+            }
+        }
+        data.switchValue[i] = switchValue;
+        if (includeForce) {
+            int ii = data.pairAtom1[i];
+            int jj = data.pairAtom2[i];
+            fvec4 result = data.pairDeltaR[i]*dEdR;
+            (fvec4(forces+4*ii)+result).store(forces+4*ii);
+            (fvec4(forces+4*jj)-result).store(forces+4*jj);
+        }
+        totalEnergy += energy;
+    }
 
-    totalEnergy += energy;
-    
     // Accumulate energy derivatives.
 
-    for (int i = 0; i < data.energyParamDerivExpressions.size(); i++)
-        data.energyParamDerivs[i] += switchValue*data.energyParamDerivExpressions[i].evaluate();
+    for (int i = 0; i < data.energyParamDerivExpressions.size(); i++) {
+        const float* derivValues = data.energyParamDerivExpressions[i].evaluate();
+        for (int j = 0; j < numPairs; j++)
+            data.energyParamDerivs[i] += data.switchValue[j]*derivValues[j];
+    }
 }
 
 void CpuCustomNonbondedForce::getDeltaR(const fvec4& posI, const fvec4& posJ, fvec4& deltaR, float& r2, const fvec4& boxSize, const fvec4& invBoxSize) const {
@@ -0,0 +1,84 @@
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuExclusions.h"
+
+using namespace std;
+using namespace OpenMM;
+
+CpuExclusions::CpuExclusions() : offset(1, 0) {
+}
+
+CpuExclusions::CpuExclusions(int numParticles, const vector<pair<int, int> >& excludedPairs) {
+    setExclusions(numParticles, excludedPairs);
+}
+
+void CpuExclusions::setExclusions(int numParticles, const vector<pair<int, int> >& excludedPairs, ThreadPool* threads) {
+    // Count the exclusions for each particle and bucket them.
+
+    vector<int> count(numParticles+1, 0);
+    for (auto& p : excludedPairs) {
+        count[p.first+1]++;
+        count[p.second+1]++;
+    }
+    for (int i = 0; i < numParticles; i++)
+        count[i+1] += count[i];
+    vector<int> bucketed(count[numParticles]);
+    vector<int> next(count.begin(), count.end()-1);
+    for (auto& p : excludedPairs) {
+        bucketed[next[p.first]++] = p.second;
+        bucketed[next[p.second]++] = p.first;
+    }
+
+    // Sort each particle's list and remove duplicates, recording how many remain.
+
+    auto sortLists = [&] (int start, int end) {
+        for (int i = start; i < end; i++) {
+            auto first = bucketed.begin()+count[i];
+            auto last = bucketed.begin()+count[i+1];
+            sort(first, last);
+            next[i] = unique(first, last)-first;
+        }
+    };
+    if (threads == NULL)
+        sortLists(0, numParticles);
+    else {
+        int numThreads = threads->getNumThreads();
+        threads->execute([&] (ThreadPool& threads, int threadIndex) {
+            sortLists((int) ((long long) threadIndex*numParticles/numThreads), (int) ((long long) (threadIndex+1)*numParticles/numThreads));
+        });
+        threads->waitForThreads();
+    }
+
+    // Compact the lists into the final arrays.
+
+    offset.resize(numParticles+1);
+    offset[0] = 0;
+    for (int i = 0; i < numParticles; i++)
+        offset[i+1] = offset[i]+next[i];
+    excluded.resize(offset[numParticles]);
+    for (int i = 0; i < numParticles; i++)
+        copy(bucketed.begin()+count[i], bucketed.begin()+count[i]+next[i], excluded.begin()+offset[i]);
+    excluded.shrink_to_fit();
+}
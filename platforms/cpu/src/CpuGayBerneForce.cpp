@@ -64,7 +64,7 @@ CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
     }
     int numExceptions = force.getNumExceptions();
     exceptions.resize(numExceptions);
-    particleExclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs(numExceptions);
     for (int i = 0; i < numExceptions; i++) {
         ExceptionInfo& e = exceptions[i];
         double sigma, epsilon;
@@ -72,9 +72,9 @@ CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
         e.sigma = sigma;
         e.epsilon = epsilon;
         exclusions.insert(make_pair(min(e.particle1, e.particle2), max(e.particle1, e.particle2)));
-        particleExclusions[e.particle1].insert(e.particle2);
-        particleExclusions[e.particle2].insert(e.particle1);
+        excludedPairs[i] = make_pair(e.particle1, e.particle2);
     }
+    particleExclusions.setExclusions(numParticles, excludedPairs);
     nonbondedMethod = force.getNonbondedMethod();
     cutoffDistance = force.getCutoffDistance();
     switchingDistance = force.getSwitchingDistance();
@@ -95,7 +95,7 @@ CpuGayBerneForce::CpuGayBerneForce(const GayBerneForce& force) {
     }
 }
 
-const vector<set<int> >& CpuGayBerneForce::getExclusions() const {
+const CpuExclusions& CpuGayBerneForce::getExclusions() const {
     return particleExclusions;
 }
 
@@ -167,7 +167,7 @@ void CpuGayBerneForce::threadComputeForce(ThreadPool& threads, int threadIndex,
             for (int j = 0; j < i; j++) {
                 if (particles[j].sqrtEpsilon == 0.0f)
                     continue;
-                if (particleExclusions[i].find(j) != particleExclusions[i].end())
+                if (particleExclusions.isExcluded(i, j))
                     continue; // This interaction will be handled by an exception.
                 double sigma = particles[i].sigmaOver2+particles[j].sigmaOver2;
                 double epsilon = particles[i].sqrtEpsilon*particles[j].sqrtEpsilon;
@@ -33,25 +33,31 @@
 #include "ReferenceAngleBondIxn.h"
 #include "ReferenceBondForce.h"
 #include "ReferenceConstraints.h"
+#include "ReferenceHarmonicBondIxn.h"
 #include "ReferenceKernelFactory.h"
 #include "ReferenceKernels.h"
 #include "ReferenceLJCoulomb14.h"
 #include "ReferenceProperDihedralBond.h"
 #include "ReferenceRbDihedralBond.h"
 #include "ReferenceTabulatedFunction.h"
+#include "SimTKOpenMMUtilities.h"
 #include "openmm/Context.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/Vec3.h"
 #include "openmm/internal/ContextImpl.h"
 #include "openmm/internal/NonbondedForceImpl.h"
+#include "openmm/internal/timer.h"
 #include "openmm/internal/vectorize.h"
 #include "openmm/serialization/XmlSerializer.h"
 #include "lepton/CompiledExpression.h"
 #include "lepton/CustomFunction.h"
 #include "lepton/Operation.h"
 #include "lepton/Parser.h"
-#include <iostream>
 #include "lepton/ParsedExpression.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
 
 using namespace OpenMM;
 using namespace std;
@@ -161,26 +167,54 @@ CpuCalcForcesAndEnergyKernel::CpuCalcForcesAndEnergyKernel(std::string name, con
 
 void CpuCalcForcesAndEnergyKernel::initialize(const System& system) {
     referenceKernel.getAs<ReferenceCalcForcesAndEnergyKernel>().initialize(system);
-    lastPositions.resize(system.getNumParticles(), Vec3(1e10, 1e10, 1e10));
+    int numParticles = system.getNumParticles();
+    lastPosq.resize(4*numParticles);
+    threadMoved.resize(data.threads.getNumThreads());
+    hasComputedNeighborList = false;
 }
 
 void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool includeForce, bool includeEnergy, int groups) {
     referenceKernel.getAs<ReferenceCalcForcesAndEnergyKernel>().beginComputation(context, includeForce, includeEnergy, groups);
+    data.threads.setRecordLoadBalance(context.getTimingEnabled());
     
-    // Convert positions to single precision and clear the forces.
+    // Convert positions to single precision and clear the forces.  At the same time, find particles
+    // that have moved far enough they might require the neighbor list to be rebuilt.
 
     int numParticles = context.getSystem().getNumParticles();
     bool positionsValid = true;
+    bool checkNeighborList = (data.neighborList != NULL && hasComputedNeighborList);
+    double padding = data.paddedCutoff-data.cutoff;
+    float closeCutoff2 = (float) (0.25*padding*padding);
+    float farCutoff2 = (float) (0.5*padding*padding);
+    int maxNumMoved = numParticles/10;
+    atomic<bool> needRecompute(data.neighborList != NULL && !hasComputedNeighborList);
+    Vec3* boxVectors = extractBoxVectors(context);
+    bool triclinic = (boxVectors[0][1] != 0 || boxVectors[0][2] != 0 || boxVectors[1][0] != 0 || boxVectors[1][2] != 0 || boxVectors[2][0] != 0 || boxVectors[2][1] != 0);
+    fvec4 boxSize((float) boxVectors[0][0], (float) boxVectors[1][1], (float) boxVectors[2][2], 0);
+    fvec4 invBoxSize((float) (1/boxVectors[0][0]), (float) (1/boxVectors[1][1]), (float) (1/boxVectors[2][2]), 0);
+    fvec4 boxVec4[3];
+    for (int i = 0; i < 3; i++)
+        boxVec4[i] = fvec4((float) boxVectors[i][0], (float) boxVectors[i][1], (float) boxVectors[i][2], 0);
+    auto getDeltaR = [&] (const fvec4& posI, const fvec4& posJ) {
+        fvec4 deltaR = posJ-posI;
+        if (data.isPeriodic) {
+            if (triclinic) {
+                deltaR -= boxVec4[2]*floorf(deltaR[2]*invBoxSize[2]+0.5f);
+                deltaR -= boxVec4[1]*floorf(deltaR[1]*invBoxSize[1]+0.5f);
+                deltaR -= boxVec4[0]*floorf(deltaR[0]*invBoxSize[0]+0.5f);
+            }
+            else
+                deltaR -= round(deltaR*invBoxSize)*boxSize;
+        }
+        return deltaR;
+    };
     data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
         // Convert the positions to single precision and apply periodic boundary conditions
 
         AlignedArray<float>& posq = data.posq;
         vector<Vec3>& posData = extractPositions(context);
-        Vec3* boxVectors = extractBoxVectors(context);
         double boxSize[3] = {boxVectors[0][0], boxVectors[1][1], boxVectors[2][2]};
         double invBoxSize[3] = {1/boxVectors[0][0], 1/boxVectors[1][1], 1/boxVectors[2][2]};
-        bool triclinic = (boxVectors[0][1] != 0 || boxVectors[0][2] != 0 || boxVectors[1][0] != 0 || boxVectors[1][2] != 0 || boxVectors[2][0] != 0 || boxVectors[2][1] != 0);
-        int numParticles = context.getSystem().getNumParticles();
         int numThreads = threads.getNumThreads();
         int start = threadIndex*numParticles/numThreads;
         int end = (threadIndex+1)*numParticles/numThreads;
@@ -219,6 +253,23 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
             if (posq[i] != posq[i] || posq[i+1] != posq[i+1] || posq[i+2] != posq[i+2])
                 positionsValid = false;
 
+        // Find particles that have moved by more than half the padding distance since the
+        // neighbor list was built.
+
+        vector<int>& moved = threadMoved[threadIndex];
+        moved.clear();
+        if (checkNeighborList) {
+            for (int i = start; i < end && !needRecompute; i++) {
+                fvec4 delta = getDeltaR(fvec4(&lastPosq[4*i]), fvec4(&posq[4*i]));
+                float dist2 = dot3(delta, delta);
+                if (dist2 > closeCutoff2) {
+                    moved.push_back(i);
+                    if (dist2 > farCutoff2 || moved.size() > maxNumMoved)
+                        needRecompute = true;
+                }
+            }
+        }
+
         // Clear the forces.
 
         fvec4 zero(0.0f);
@@ -232,48 +283,49 @@ void CpuCalcForcesAndEnergyKernel::beginComputation(ContextImpl& context, bool i
     // Determine whether we need to recompute the neighbor list.
         
     if (data.neighborList != NULL) {
-        double padding = data.paddedCutoff-data.cutoff;;
-        bool needRecompute = false;
-        double closeCutoff2 = 0.25*padding*padding;
-        double farCutoff2 = 0.5*padding*padding;
-        int maxNumMoved = numParticles/10;
-        vector<int> moved;
-        vector<Vec3>& posData = extractPositions(context);
-        for (int i = 0; i < numParticles; i++) {
-            Vec3 delta = posData[i]-lastPositions[i];
-            double dist2 = delta.dot(delta);
-            if (dist2 > closeCutoff2) {
-                moved.push_back(i);
-                if (dist2 > farCutoff2 || moved.size() > maxNumMoved) {
-                    needRecompute = true;
-                    break;
-                }
-            }
+        if (!needRecompute) {
+            moved.clear();
+            for (auto& m : threadMoved)
+                moved.insert(moved.end(), m.begin(), m.end());
+            if (moved.size() > maxNumMoved)
+                needRecompute = true;
         }
         if (!needRecompute && moved.size() > 0) {
             // Some particles have moved further than half the padding distance.  Look for pairs
-            // that are missing from the neighbor list.
+            // that are missing from the neighbor list.  Rows are interleaved between threads to
+            // balance the triangular loop.
 
             int numMoved = moved.size();
-            double cutoff2 = data.cutoff*data.cutoff;
-            double paddedCutoff2 = data.paddedCutoff*data.paddedCutoff;
-            for (int i = 1; i < numMoved && !needRecompute; i++)
-                for (int j = 0; j < i; j++) {
-                    Vec3 delta = posData[moved[i]]-posData[moved[j]];
-                    if (delta.dot(delta) < cutoff2) {
-                        // These particles should interact.  See if they are in the neighbor list.
-                        
-                        Vec3 oldDelta = lastPositions[moved[i]]-lastPositions[moved[j]];
-                        if (oldDelta.dot(oldDelta) > paddedCutoff2) {
-                            needRecompute = true;
-                            break;
+            float cutoff2 = (float) (data.cutoff*data.cutoff);
+            float paddedCutoff2 = (float) (data.paddedCutoff*data.paddedCutoff);
+            data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+                for (int i = threadIndex+1; i < numMoved && !needRecompute; i += threads.getNumThreads()) {
+                    fvec4 posI(&data.posq[4*moved[i]]);
+                    fvec4 lastPosI(&lastPosq[4*moved[i]]);
+                    for (int j = 0; j < i; j++) {
+                        fvec4 delta = getDeltaR(posI, fvec4(&data.posq[4*moved[j]]));
+                        if (dot3(delta, delta) < cutoff2) {
+                            // These particles should interact.  See if they are in the neighbor list.
+
+                            fvec4 oldDelta = getDeltaR(lastPosI, fvec4(&lastPosq[4*moved[j]]));
+                            if (dot3(oldDelta, oldDelta) > paddedCutoff2) {
+                                needRecompute = true;
+                                break;
+                            }
                         }
                     }
                 }
+            });
+            data.threads.waitForThreads();
         }
+        data.numNeighborListChecks++;
         if (needRecompute) {
-            data.neighborList->computeNeighborList(numParticles, data.posq, data.exclusions, extractBoxVectors(context), data.isPeriodic, data.paddedCutoff, data.threads);
-            lastPositions = posData;
+            double startTime = getCurrentTime();
+            data.neighborList->computeNeighborList(numParticles, data.posq, data.exclusions, boxVectors, data.isPeriodic, data.paddedCutoff, data.threads);
+            data.neighborListTime += getCurrentTime()-startTime;
+            memcpy(&lastPosq[0], &data.posq[0], 4*numParticles*sizeof(float));
+            hasComputedNeighborList = true;
+            data.numNeighborListRebuilds++;
         }
     }
 }
@@ -302,6 +354,245 @@ double CpuCalcForcesAndEnergyKernel::finishComputation(ContextImpl& context, boo
     return referenceKernel.getAs<ReferenceCalcForcesAndEnergyKernel>().finishComputation(context, includeForce, includeEnergy, groups, valid);
 }
 
+void CpuMinimizeKernel::initialize(const System& system) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        masses[i] = system.getParticleMass(i);
+    int numConstraints = system.getNumConstraints();
+    constraintAtoms.resize(numConstraints);
+    constraintDistances.resize(numConstraints);
+    constraintForces.resize(numConstraints);
+    particleConstraintStart.resize(numParticles+1, 0);
+    for (int i = 0; i < numConstraints; i++) {
+        system.getConstraintParameters(i, constraintAtoms[i].first, constraintAtoms[i].second, constraintDistances[i]);
+        particleConstraintStart[constraintAtoms[i].first+1]++;
+        particleConstraintStart[constraintAtoms[i].second+1]++;
+    }
+    for (int i = 0; i < numParticles; i++)
+        particleConstraintStart[i+1] += particleConstraintStart[i];
+    particleConstraints.resize(2*numConstraints);
+    vector<int> count(numParticles, 0);
+    for (int i = 0; i < numConstraints; i++) {
+        int p1 = constraintAtoms[i].first, p2 = constraintAtoms[i].second;
+        particleConstraints[particleConstraintStart[p1]+count[p1]++] = -i-1;
+        particleConstraints[particleConstraintStart[p2]+count[p2]++] = i;
+    }
+    threadValues.resize(data.threads.getNumThreads());
+}
+
+double CpuMinimizeKernel::computeEnergyAndGradient(ContextImpl& context, const double* x, double* gradient, double k, int groups) {
+    vector<Vec3>& positions = extractPositions(context);
+    int numParticles = masses.size();
+    int numConstraints = constraintAtoms.size();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numParticles/threads.getNumThreads();
+        int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            positions[i] = Vec3(x[3*i], x[3*i+1], x[3*i+2]);
+    });
+    data.threads.waitForThreads();
+    context.computeVirtualSites();
+    double energy = context.calcForcesAndEnergy(true, true, groups);
+    const vector<Vec3>& forces = extractForces(context);
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        // Compute the restraint force for each constraint.
+
+        int start = threadIndex*numConstraints/threads.getNumThreads();
+        int end = (threadIndex+1)*numConstraints/threads.getNumThreads();
+        double threadEnergy = 0.0;
+        for (int i = start; i < end; i++) {
+            Vec3 delta = positions[constraintAtoms[i].second]-positions[constraintAtoms[i].first];
+            double r = sqrt(delta.dot(delta));
+            double dr = r-constraintDistances[i];
+            double kdr = k*dr;
+            threadEnergy += 0.5*kdr*dr;
+            constraintForces[i] = delta*(kdr/r);
+        }
+        threadValues[threadIndex] = threadEnergy;
+    });
+    data.threads.waitForThreads();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        // Compute the gradient for each particle.  The restraint forces are gathered for each particle
+        // rather than scattered from each constraint, so no two threads ever write to the same element.
+
+        int start = threadIndex*numParticles/threads.getNumThreads();
+        int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+        for (int i = start; i < end; i++) {
+            Vec3 g = (masses[i] == 0.0 ? Vec3() : -forces[i]);
+            for (int j = particleConstraintStart[i]; j < particleConstraintStart[i+1]; j++) {
+                int c = particleConstraints[j];
+                if (c < 0)
+                    g -= constraintForces[-c-1];
+                else
+                    g += constraintForces[c];
+            }
+            gradient[3*i] = g[0];
+            gradient[3*i+1] = g[1];
+            gradient[3*i+2] = g[2];
+        }
+    });
+    data.threads.waitForThreads();
+    for (double threadEnergy : threadValues)
+        energy += threadEnergy;
+    return energy;
+}
+
+double CpuMinimizeKernel::getMaxConstraintError(ContextImpl& context) {
+    const vector<Vec3>& positions = extractPositions(context);
+    int numConstraints = constraintAtoms.size();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numConstraints/threads.getNumThreads();
+        int end = (threadIndex+1)*numConstraints/threads.getNumThreads();
+        double maxError = 0.0;
+        for (int i = start; i < end; i++) {
+            Vec3 delta = positions[constraintAtoms[i].second]-positions[constraintAtoms[i].first];
+            maxError = max(maxError, fabs(sqrt(delta.dot(delta))-constraintDistances[i]));
+        }
+        threadValues[threadIndex] = maxError;
+    });
+    data.threads.waitForThreads();
+    return *max_element(threadValues.begin(), threadValues.end());
+}
+
+void CpuCalcHarmonicBondForceKernel::initialize(const System& system, const HarmonicBondForce& force) {
+    numBonds = force.getNumBonds();
+    bondIndexArray.resize(numBonds, vector<int>(2));
+    bondParamArray.resize(numBonds, vector<double>(2));
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        double length, k;
+        force.getBondParameters(i, particle1, particle2, length, k);
+        bondIndexArray[i][0] = particle1;
+        bondIndexArray[i][1] = particle2;
+        bondParamArray[i][0] = length;
+        bondParamArray[i][1] = k;
+    }
+    bondForce.initialize(system.getNumParticles(), numBonds, 2, bondIndexArray, data.threads);
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+}
+
+double CpuCalcHarmonicBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    ReferenceHarmonicBondIxn harmonicBond;
+    if (usePeriodic)
+        harmonicBond.setPeriodic(extractBoxVectors(context));
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, harmonicBond);
+    return energy;
+}
+
+void CpuCalcHarmonicBondForceKernel::copyParametersToContext(ContextImpl& context, const HarmonicBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        double length, k;
+        force.getBondParameters(i, particle1, particle2, length, k);
+        if (particle1 != bondIndexArray[i][0] || particle2 != bondIndexArray[i][1])
+            throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        bondParamArray[i][0] = length;
+        bondParamArray[i][1] = k;
+    }
+}
+
+CpuCalcCustomBondForceKernel::~CpuCalcCustomBondForceKernel() {
+    for (auto ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomBondForceKernel::initialize(const System& system, const CustomBondForce& force) {
+    numBonds = force.getNumBonds();
+    int numParameters = force.getNumPerBondParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    bondIndexArray.resize(numBonds, vector<int>(2));
+    bondParamArray.resize(numBonds, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        force.getBondParameters(i, particle1, particle2, params);
+        bondIndexArray[i][0] = particle1;
+        bondIndexArray[i][1] = particle2;
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+    bondForce.initialize(system.getNumParticles(), numBonds, 2, bondIndexArray, data.threads);
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = expression.differentiate("r").createCompiledExpression();
+    vector<string> parameterNames;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerBondParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("r");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // CompiledExpressions are not thread safe, so each thread needs its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomBondIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+}
+
+double CpuCalcCustomBondForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    vector<ReferenceBondIxn*> bondIxn;
+    for (auto ixn : threadIxn) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+        bondIxn.push_back(ixn);
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size(), 0.0);
+    bondForce.calculateForce(posData, bondParamArray, forceData, includeEnergy ? &energy : NULL, energyParamDerivValues.data(), energyParamDerivNames.size(), bondIxn);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomBondForceKernel::copyParametersToContext(ContextImpl& context, const CustomBondForce& force) {
+    if (numBonds != force.getNumBonds())
+        throw OpenMMException("updateParametersInContext: The number of bonds has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerBondParameters();
+    vector<double> params;
+    for (int i = 0; i < numBonds; ++i) {
+        int particle1, particle2;
+        force.getBondParameters(i, particle1, particle2, params);
+        if (particle1 != bondIndexArray[i][0] || particle2 != bondIndexArray[i][1])
+            throw OpenMMException("updateParametersInContext: The set of particles in a bond has changed");
+        for (int j = 0; j < numParameters; j++)
+            bondParamArray[i][j] = params[j];
+    }
+}
+
 void CpuCalcHarmonicAngleForceKernel::initialize(const System& system, const HarmonicAngleForce& force) {
     numAngles = force.getNumAngles();
     angleIndexArray.resize(numAngles, vector<int>(3));
@@ -348,6 +639,100 @@ void CpuCalcHarmonicAngleForceKernel::copyParametersToContext(ContextImpl& conte
     }
 }
 
+CpuCalcCustomAngleForceKernel::~CpuCalcCustomAngleForceKernel() {
+    for (auto ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomAngleForceKernel::initialize(const System& system, const CustomAngleForce& force) {
+    numAngles = force.getNumAngles();
+    int numParameters = force.getNumPerAngleParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    angleIndexArray.resize(numAngles, vector<int>(3));
+    angleParamArray.resize(numAngles, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numAngles; ++i) {
+        int particle1, particle2, particle3;
+        force.getAngleParameters(i, particle1, particle2, particle3, params);
+        angleIndexArray[i][0] = particle1;
+        angleIndexArray[i][1] = particle2;
+        angleIndexArray[i][2] = particle3;
+        for (int j = 0; j < numParameters; j++)
+            angleParamArray[i][j] = params[j];
+    }
+    bondForce.initialize(system.getNumParticles(), numAngles, 3, angleIndexArray, data.threads);
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = expression.differentiate("theta").createCompiledExpression();
+    vector<string> parameterNames;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerAngleParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("theta");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // CompiledExpressions are not thread safe, so each thread needs its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomAngleIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+}
+
+double CpuCalcCustomAngleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    vector<ReferenceBondIxn*> bondIxn;
+    for (auto ixn : threadIxn) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+        bondIxn.push_back(ixn);
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size(), 0.0);
+    bondForce.calculateForce(posData, angleParamArray, forceData, includeEnergy ? &energy : NULL, energyParamDerivValues.data(), energyParamDerivNames.size(), bondIxn);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomAngleForceKernel::copyParametersToContext(ContextImpl& context, const CustomAngleForce& force) {
+    if (numAngles != force.getNumAngles())
+        throw OpenMMException("updateParametersInContext: The number of angles has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerAngleParameters();
+    vector<double> params;
+    for (int i = 0; i < numAngles; ++i) {
+        int particle1, particle2, particle3;
+        force.getAngleParameters(i, particle1, particle2, particle3, params);
+        if (particle1 != angleIndexArray[i][0] || particle2 != angleIndexArray[i][1] || particle3 != angleIndexArray[i][2])
+            throw OpenMMException("updateParametersInContext: The set of particles in an angle has changed");
+        for (int j = 0; j < numParameters; j++)
+            angleParamArray[i][j] = params[j];
+    }
+}
+
 void CpuCalcPeriodicTorsionForceKernel::initialize(const System& system, const PeriodicTorsionForce& force) {
     numTorsions = force.getNumTorsions();
     torsionIndexArray.resize(numTorsions, vector<int>(4));
@@ -452,6 +837,101 @@ void CpuCalcRBTorsionForceKernel::copyParametersToContext(ContextImpl& context,
     }
 }
 
+CpuCalcCustomTorsionForceKernel::~CpuCalcCustomTorsionForceKernel() {
+    for (auto ixn : threadIxn)
+        delete ixn;
+}
+
+void CpuCalcCustomTorsionForceKernel::initialize(const System& system, const CustomTorsionForce& force) {
+    numTorsions = force.getNumTorsions();
+    int numParameters = force.getNumPerTorsionParameters();
+    usePeriodic = force.usesPeriodicBoundaryConditions();
+
+    // Build the arrays.
+
+    torsionIndexArray.resize(numTorsions, vector<int>(4));
+    torsionParamArray.resize(numTorsions, vector<double>(numParameters));
+    vector<double> params;
+    for (int i = 0; i < numTorsions; ++i) {
+        int particle1, particle2, particle3, particle4;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, params);
+        torsionIndexArray[i][0] = particle1;
+        torsionIndexArray[i][1] = particle2;
+        torsionIndexArray[i][2] = particle3;
+        torsionIndexArray[i][3] = particle4;
+        for (int j = 0; j < numParameters; j++)
+            torsionParamArray[i][j] = params[j];
+    }
+    bondForce.initialize(system.getNumParticles(), numTorsions, 4, torsionIndexArray, data.threads);
+
+    // Parse the expression used to calculate the force.
+
+    Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction()).optimize();
+    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
+    Lepton::CompiledExpression forceExpression = expression.differentiate("theta").createCompiledExpression();
+    vector<string> parameterNames;
+    for (int i = 0; i < numParameters; i++)
+        parameterNames.push_back(force.getPerTorsionParameterName(i));
+    for (int i = 0; i < force.getNumGlobalParameters(); i++)
+        globalParameterNames.push_back(force.getGlobalParameterName(i));
+    vector<Lepton::CompiledExpression> energyParamDerivExpressions;
+    for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
+        string param = force.getEnergyParameterDerivativeName(i);
+        energyParamDerivNames.push_back(param);
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+    }
+    set<string> variables;
+    variables.insert("theta");
+    variables.insert(parameterNames.begin(), parameterNames.end());
+    variables.insert(globalParameterNames.begin(), globalParameterNames.end());
+    validateVariables(expression.getRootNode(), variables);
+
+    // CompiledExpressions are not thread safe, so each thread needs its own copy.
+
+    for (int i = 0; i < data.threads.getNumThreads(); i++)
+        threadIxn.push_back(new ReferenceCustomTorsionIxn(energyExpression, forceExpression, parameterNames, energyParamDerivExpressions));
+}
+
+double CpuCalcCustomTorsionForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double energy = 0;
+    map<string, double> globalParameters;
+    for (auto& name : globalParameterNames)
+        globalParameters[name] = context.getParameter(name);
+    vector<ReferenceBondIxn*> bondIxn;
+    for (auto ixn : threadIxn) {
+        ixn->setGlobalParameters(globalParameters);
+        if (usePeriodic)
+            ixn->setPeriodic(extractBoxVectors(context));
+        bondIxn.push_back(ixn);
+    }
+    vector<double> energyParamDerivValues(energyParamDerivNames.size(), 0.0);
+    bondForce.calculateForce(posData, torsionParamArray, forceData, includeEnergy ? &energy : NULL, energyParamDerivValues.data(), energyParamDerivNames.size(), bondIxn);
+    map<string, double>& energyParamDerivs = extractEnergyParameterDerivatives(context);
+    for (int i = 0; i < energyParamDerivNames.size(); i++)
+        energyParamDerivs[energyParamDerivNames[i]] += energyParamDerivValues[i];
+    return energy;
+}
+
+void CpuCalcCustomTorsionForceKernel::copyParametersToContext(ContextImpl& context, const CustomTorsionForce& force) {
+    if (numTorsions != force.getNumTorsions())
+        throw OpenMMException("updateParametersInContext: The number of torsions has changed");
+
+    // Record the values.
+
+    int numParameters = force.getNumPerTorsionParameters();
+    vector<double> params;
+    for (int i = 0; i < numTorsions; ++i) {
+        int particle1, particle2, particle3, particle4;
+        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, params);
+        if (particle1 != torsionIndexArray[i][0] || particle2 != torsionIndexArray[i][1] || particle3 != torsionIndexArray[i][2] || particle4 != torsionIndexArray[i][3])
+            throw OpenMMException("updateParametersInContext: The set of particles in a torsion has changed");
+        for (int j = 0; j < numParameters; j++)
+            torsionParamArray[i][j] = params[j];
+    }
+}
+
 class CpuCalcNonbondedForceKernel::PmeIO : public CalcPmeReciprocalForceKernel::IO {
 public:
     PmeIO(float* posq, float* force, int numParticles) : posq(posq), force(force), numParticles(numParticles) {
@@ -499,20 +979,20 @@ void CpuCalcNonbondedForceKernel::initialize(const System& system, const Nonbond
         exceptionsWithOffsets.insert(exception);
     }
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
+    vector<pair<int, int> > excludedPairs(force.getNumExceptions());
     vector<int> nb14s;
     map<int, int> nb14Index;
     for (int i = 0; i < force.getNumExceptions(); i++) {
         int particle1, particle2;
         double chargeProd, sigma, epsilon;
         force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
+        excludedPairs[i] = make_pair(particle1, particle2);
         if (chargeProd != 0.0 || epsilon != 0.0 || exceptionsWithOffsets.find(i) != exceptionsWithOffsets.end()) {
             nb14Index[i] = nb14s.size();
             nb14s.push_back(i);
         }
     }
+    exclusions.setExclusions(numParticles, excludedPairs, &data.threads);
 
     // Record the particle parameters.
 
@@ -582,7 +1062,7 @@ void CpuCalcNonbondedForceKernel::initialize(const System& system, const Nonbond
     if (nonbondedMethod == NoCutoff)
         useSwitchingFunction = false;
     else {
-        data.requestNeighborList(nonbondedCutoff, 0.25*nonbondedCutoff, true, exclusions);
+        data.requestNeighborList(nonbondedCutoff, 0.25*nonbondedCutoff, true, exclusions, true);
         useSwitchingFunction = force.getUseSwitchingFunction();
         switchingDistance = force.getSwitchingDistance();
     }
@@ -679,34 +1159,60 @@ double CpuCalcNonbondedForceKernel::execute(ContextImpl& context, bool includeFo
         nonbonded->setUseLJPME(ewaldDispersionAlpha, dispersionGridSize);
     }
     double nonbondedEnergy = 0;
+    bool timePme = (includeReciprocal && (pme || ljpme));
+    PmeIO io(&posq[0], &data.threadForce[0][0], numParticles);
+    Vec3 periodicBoxVectors[3] = {boxVectors[0], boxVectors[1], boxVectors[2]};
+
+    // If some threads are reserved for reciprocal space, start it now so it runs concurrently
+    // with the direct space and exception calculations.  The forces are only added to threadForce[0]
+    // inside finishComputation(), so this does not conflict with the direct space kernel.  LJPME
+    // dispersion is still done afterward, since it needs to overwrite the charges in posq.
+
+    bool overlapPme = (includeReciprocal && useOptimizedPme && data.pmeThreads > 0);
+    if (overlapPme)
+        optimizedPme.getAs<CalcPmeReciprocalForceKernel>().beginComputation(io, periodicBoxVectors, includeEnergy);
+    double startTime = (timePme ? getCurrentTime() : 0.0);
     if (includeDirect)
         nonbonded->calculateDirectIxn(numParticles, &posq[0], posData, particleParams, C6params, exclusions, data.threadForce, includeEnergy ? &nonbondedEnergy : NULL, data.threads);
+    if (includeDirect) {
+        ReferenceLJCoulomb14 nonbonded14;
+        if (exceptionsArePeriodic) {
+            Vec3* boxVectors = extractBoxVectors(context);
+            nonbonded14.setPeriodic(boxVectors);
+        }
+        bondForce.calculateForce(posData, bonded14ParamArray, forceData, includeEnergy ? &energy : NULL, nonbonded14);
+        if (data.isPeriodic && nonbondedMethod != LJPME)
+            energy += dispersionCoefficient/(boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2]);
+    }
+    if (timePme) {
+        double directTime = getCurrentTime();
+        data.pmeDirectSpaceTime += directTime-startTime;
+        startTime = directTime;
+    }
     if (includeReciprocal) {
         if (useOptimizedPme) {
-            PmeIO io(&posq[0], &data.threadForce[0][0], numParticles);
-            Vec3 periodicBoxVectors[3] = {boxVectors[0], boxVectors[1], boxVectors[2]};
-            optimizedPme.getAs<CalcPmeReciprocalForceKernel>().beginComputation(io, periodicBoxVectors, includeEnergy);
+            if (!overlapPme)
+                optimizedPme.getAs<CalcPmeReciprocalForceKernel>().beginComputation(io, periodicBoxVectors, includeEnergy);
             nonbondedEnergy += optimizedPme.getAs<CalcPmeReciprocalForceKernel>().finishComputation(io);
+            if (overlapPme)
+                data.pmeWaitTime += getCurrentTime()-startTime;
+            data.pmeReciprocalSpaceTime += optimizedPme.getAs<CalcPmeReciprocalForceKernel>().getLastComputationTime();
             if (nonbondedMethod == LJPME) {
                 copyChargesToPosq(context, C6params, ljPosqIndex);
                 optimizedDispersionPme.getAs<CalcDispersionPmeReciprocalForceKernel>().beginComputation(io, periodicBoxVectors, includeEnergy);
                 nonbondedEnergy += optimizedDispersionPme.getAs<CalcDispersionPmeReciprocalForceKernel>().finishComputation(io);
+                data.pmeReciprocalSpaceTime += optimizedDispersionPme.getAs<CalcDispersionPmeReciprocalForceKernel>().getLastComputationTime();
             }
         }
         else
             nonbonded->calculateReciprocalIxn(numParticles, &posq[0], posData, particleParams, C6params, exclusions, forceData, includeEnergy ? &nonbondedEnergy : NULL);
     }
-    energy += nonbondedEnergy;
-    if (includeDirect) {
-        ReferenceLJCoulomb14 nonbonded14;
-        if (exceptionsArePeriodic) {
-            Vec3* boxVectors = extractBoxVectors(context);
-            nonbonded14.setPeriodic(boxVectors);
-        }
-        bondForce.calculateForce(posData, bonded14ParamArray, forceData, includeEnergy ? &energy : NULL, nonbonded14);
-        if (data.isPeriodic && nonbondedMethod != LJPME)
-            energy += dispersionCoefficient/(boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2]);
+    if (timePme) {
+        if (!useOptimizedPme)
+            data.pmeReciprocalSpaceTime += getCurrentTime()-startTime;
+        data.numPmeEvaluations++;
     }
+    energy += nonbondedEnergy;
     return energy;
 }
 
@@ -859,13 +1365,10 @@ void CpuCalcCustomNonbondedForceKernel::initialize(const System& system, const C
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
-    for (int i = 0; i < force.getNumExclusions(); i++) {
-        int particle1, particle2;
-        force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-    }
+    vector<pair<int, int> > excludedPairs(force.getNumExclusions());
+    for (int i = 0; i < force.getNumExclusions(); i++)
+        force.getExclusionParticles(i, excludedPairs[i].first, excludedPairs[i].second);
+    exclusions.setExclusions(numParticles, excludedPairs, &data.threads);
 
     // Build the arrays.
 
@@ -921,9 +1424,10 @@ void CpuCalcCustomNonbondedForceKernel::createInteraction(const CustomNonbondedF
 
     // Parse the various expressions used to calculate the force.
 
+    int width = Lepton::CompiledVectorExpression::getAllowedWidths()[0];
     Lepton::ParsedExpression expression = Lepton::Parser::parse(force.getEnergyFunction(), functions).optimize();
-    Lepton::CompiledExpression energyExpression = expression.createCompiledExpression();
-    Lepton::CompiledExpression forceExpression = expression.differentiate("r").createCompiledExpression();
+    Lepton::CompiledVectorExpression energyExpression = expression.createCompiledVectorExpression(width);
+    Lepton::CompiledVectorExpression forceExpression = expression.differentiate("r").createCompiledVectorExpression(width);
     for (int i = 0; i < force.getNumPerParticleParameters(); i++)
         parameterNames.push_back(force.getPerParticleParameterName(i));
     for (int i = 0; i < force.getNumGlobalParameters(); i++) {
@@ -940,7 +1444,8 @@ void CpuCalcCustomNonbondedForceKernel::createInteraction(const CustomNonbondedF
     }
     particleVariables.insert(globalParameterNames.begin(), globalParameterNames.end());
     pairVariables.insert(globalParameterNames.begin(), globalParameterNames.end());
-    vector<Lepton::CompiledExpression> computedValueExpressions, energyParamDerivExpressions;
+    vector<Lepton::CompiledExpression> computedValueExpressions;
+    vector<Lepton::CompiledVectorExpression> energyParamDerivExpressions;
     for (int i = 0; i < force.getNumComputedValues(); i++) {
         string name, exp;
         force.getComputedValueParameters(i, name, exp);
@@ -952,7 +1457,7 @@ void CpuCalcCustomNonbondedForceKernel::createInteraction(const CustomNonbondedF
     for (int i = 0; i < force.getNumEnergyParameterDerivatives(); i++) {
         string param = force.getEnergyParameterDerivativeName(i);
         energyParamDerivNames.push_back(param);
-        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledExpression());
+        energyParamDerivExpressions.push_back(expression.differentiate(param).createCompiledVectorExpression(width));
     }
     for (auto& name : computedValueNames) {
         pairVariables.insert(name+"1");
@@ -1137,13 +1642,10 @@ void CpuCalcCustomGBForceKernel::initialize(const System& system, const CustomGB
     // Record the exclusions.
 
     numParticles = force.getNumParticles();
-    exclusions.resize(numParticles);
-    for (int i = 0; i < force.getNumExclusions(); i++) {
-        int particle1, particle2;
-        force.getExclusionParticles(i, particle1, particle2);
-        exclusions[particle1].insert(particle2);
-        exclusions[particle2].insert(particle1);
-    }
+    vector<pair<int, int> > excludedPairs(force.getNumExclusions());
+    for (int i = 0; i < force.getNumExclusions(); i++)
+        force.getExclusionParticles(i, excludedPairs[i].first, excludedPairs[i].second);
+    exclusions.setExclusions(numParticles, excludedPairs, &data.threads);
 
     // Build the arrays.
 
@@ -1187,6 +1689,9 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
     vector<vector<Lepton::CompiledExpression> > valueParamDerivExpressions(force.getNumComputedValues());
     vector<Lepton::CompiledExpression> valueExpressions;
     vector<Lepton::CompiledExpression> energyExpressions;
+    int width = Lepton::CompiledVectorExpression::getAllowedWidths()[0];
+    Lepton::CompiledVectorExpression pairValueExpression, pairValueDerivExpression;
+    vector<Lepton::CompiledVectorExpression> pairValueParamDerivExpressions;
     set<string> particleVariables, pairVariables;
     pairVariables.insert("r");
     particleVariables.insert("x");
@@ -1208,7 +1713,8 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
         valueTypes.push_back(type);
         valueNames.push_back(name);
         if (i == 0) {
-            valueDerivExpressions[i].push_back(ex.differentiate("r").createCompiledExpression());
+            pairValueExpression = ex.createCompiledVectorExpression(width);
+            pairValueDerivExpression = ex.differentiate("r").createCompiledVectorExpression(width);
             validateVariables(ex.getRootNode(), pairVariables);
         }
         else {
@@ -1222,7 +1728,10 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
         for (int j = 0; j < force.getNumEnergyParameterDerivatives(); j++) {
             string param = force.getEnergyParameterDerivativeName(j);
             energyParamDerivNames.push_back(param);
-            valueParamDerivExpressions[i].push_back(ex.differentiate(param).createCompiledExpression());
+            if (i == 0)
+                pairValueParamDerivExpressions.push_back(ex.differentiate(param).createCompiledVectorExpression(width));
+            else
+                valueParamDerivExpressions[i].push_back(ex.differentiate(param).createCompiledExpression());
         }
         particleVariables.insert(name);
         pairVariables.insert(name+"1");
@@ -1235,6 +1744,8 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
     vector<vector<Lepton::CompiledExpression> > energyDerivExpressions(force.getNumEnergyTerms());
     vector<vector<Lepton::CompiledExpression> > energyGradientExpressions(force.getNumEnergyTerms());
     vector<vector<Lepton::CompiledExpression> > energyParamDerivExpressions(force.getNumEnergyTerms());
+    vector<vector<Lepton::CompiledVectorExpression> > pairEnergyExpressions(force.getNumEnergyTerms());
+    vector<vector<Lepton::CompiledVectorExpression> > pairEnergyParamDerivExpressions(force.getNumEnergyTerms());
     for (int i = 0; i < force.getNumEnergyTerms(); i++) {
         string expression;
         CustomGBForce::ComputationType type;
@@ -1242,8 +1753,10 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
         Lepton::ParsedExpression ex = Lepton::Parser::parse(expression, functions).optimize();
         energyExpressions.push_back(ex.createCompiledExpression());
         energyTypes.push_back(type);
-        if (type != CustomGBForce::SingleParticle)
-            energyDerivExpressions[i].push_back(ex.differentiate("r").createCompiledExpression());
+        if (type != CustomGBForce::SingleParticle) {
+            pairEnergyExpressions[i].push_back(ex.createCompiledVectorExpression(width));
+            pairEnergyExpressions[i].push_back(ex.differentiate("r").createCompiledVectorExpression(width));
+        }
         for (int j = 0; j < force.getNumComputedValues(); j++) {
             if (type == CustomGBForce::SingleParticle) {
                 energyDerivExpressions[i].push_back(ex.differentiate(valueNames[j]).createCompiledExpression());
@@ -1253,13 +1766,18 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
                 validateVariables(ex.getRootNode(), particleVariables);
             }
             else {
-                energyDerivExpressions[i].push_back(ex.differentiate(valueNames[j]+"1").createCompiledExpression());
-                energyDerivExpressions[i].push_back(ex.differentiate(valueNames[j]+"2").createCompiledExpression());
+                pairEnergyExpressions[i].push_back(ex.differentiate(valueNames[j]+"1").createCompiledVectorExpression(width));
+                pairEnergyExpressions[i].push_back(ex.differentiate(valueNames[j]+"2").createCompiledVectorExpression(width));
                 validateVariables(ex.getRootNode(), pairVariables);
             }
         }
-        for (int j = 0; j < force.getNumEnergyParameterDerivatives(); j++)
-            energyParamDerivExpressions[i].push_back(ex.differentiate(force.getEnergyParameterDerivativeName(j)).createCompiledExpression());
+        for (int j = 0; j < force.getNumEnergyParameterDerivatives(); j++) {
+            string param = force.getEnergyParameterDerivativeName(j);
+            if (type == CustomGBForce::SingleParticle)
+                energyParamDerivExpressions[i].push_back(ex.differentiate(param).createCompiledExpression());
+            else
+                pairEnergyParamDerivExpressions[i].push_back(ex.differentiate(param).createCompiledVectorExpression(width));
+        }
     }
 
     // Delete the custom functions.
@@ -1267,7 +1785,8 @@ void CpuCalcCustomGBForceKernel::createInteraction(const CustomGBForce& force) {
     for (auto& function : functions)
         delete function.second;
     ixn = new CpuCustomGBForce(numParticles, exclusions, valueExpressions, valueDerivExpressions, valueGradientExpressions, valueParamDerivExpressions,
-        valueNames, valueTypes, energyExpressions, energyDerivExpressions, energyGradientExpressions, energyParamDerivExpressions, energyTypes,
+        pairValueExpression, pairValueDerivExpression, pairValueParamDerivExpressions, valueNames, valueTypes, energyExpressions, energyDerivExpressions,
+        energyGradientExpressions, energyParamDerivExpressions, pairEnergyExpressions, pairEnergyParamDerivExpressions, energyTypes,
         particleParameterNames, data.threads);
 }
 
@@ -1278,7 +1797,7 @@ double CpuCalcCustomGBForceKernel::execute(ContextImpl& context, bool includeFor
     if (data.isPeriodic)
         ixn->setPeriodic(extractBoxSize(context));
     if (nonbondedMethod != NoCutoff) {
-        vector<set<int> > noExclusions(numParticles);
+        CpuExclusions noExclusions(numParticles, vector<pair<int, int> >());
         neighborList->computeNeighborList(numParticles, data.posq, noExclusions, boxVectors, data.isPeriodic, nonbondedCutoff, data.threads);
         ixn->setUseCutoff(nonbondedCutoff, *neighborList);
     }
@@ -1429,6 +1948,46 @@ void CpuCalcGayBerneForceKernel::copyParametersToContext(ContextImpl& context, c
     ixn = new CpuGayBerneForce(force);
 }
 
+CpuIntegrateVerletStepKernel::~CpuIntegrateVerletStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateVerletStepKernel::initialize(const System& system, const VerletIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+}
+
+void CpuIntegrateVerletStepKernel::execute(ContextImpl& context, const VerletIntegrator& integrator) {
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuVerletDynamics(context.getSystem().getNumParticles(), stepSize, data.threads);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevStepSize = stepSize;
+    }
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, integrator.getConstraintTolerance());
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateVerletStepKernel::computeKineticEnergy(ContextImpl& context, const VerletIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.5*integrator.getStepSize());
+}
+
+ReferenceNoseHooverDynamics* CpuIntegrateNoseHooverStepKernel::createDynamics(const System& system, double stepSize) {
+    return new CpuNoseHooverDynamics(system.getNumParticles(), stepSize, data.threads);
+}
+
 CpuIntegrateLangevinStepKernel::~CpuIntegrateLangevinStepKernel() {
     if (dynamics)
         delete dynamics;
@@ -1509,3 +2068,259 @@ void CpuIntegrateLangevinMiddleStepKernel::execute(ContextImpl& context, const L
 double CpuIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextImpl& context, const LangevinMiddleIntegrator& integrator) {
     return computeShiftedKineticEnergy(context, masses, 0.0);
 }
+
+CpuIntegrateMTSLangevinStepKernel::~CpuIntegrateMTSLangevinStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateMTSLangevinStepKernel::initialize(const System& system, const MTSLangevinIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+void CpuIntegrateMTSLangevinStepKernel::execute(ContextImpl& context, const MTSLangevinIntegrator& integrator, bool& forcesAreValid) {
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    if (dynamics == 0 || temperature != prevTemp || friction != prevFriction || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuMTSLangevinDynamics(context.getSystem().getNumParticles(), stepSize, friction, temperature, integrator.getGroups(), data.threads, data.random);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevStepSize = stepSize;
+        forcesAreValid = false;
+    }
+    dynamics->update(context, posData, velData, masses, integrator.getConstraintTolerance(), forcesAreValid);
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateMTSLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.0);
+}
+
+CpuIntegrateBrownianStepKernel::~CpuIntegrateBrownianStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateBrownianStepKernel::initialize(const System& system, const BrownianIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+void CpuIntegrateBrownianStepKernel::execute(ContextImpl& context, const BrownianIntegrator& integrator) {
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || temperature != prevTemp || friction != prevFriction || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuBrownianDynamics(context.getSystem().getNumParticles(), stepSize, friction, temperature, data.threads, data.random);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevStepSize = stepSize;
+    }
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, integrator.getConstraintTolerance());
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += stepSize;
+    refData->stepCount++;
+}
+
+double CpuIntegrateBrownianStepKernel::computeKineticEnergy(ContextImpl& context, const BrownianIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0);
+}
+
+CpuIntegrateVariableLangevinStepKernel::~CpuIntegrateVariableLangevinStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateVariableLangevinStepKernel::initialize(const System& system, const VariableLangevinIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+double CpuIntegrateVariableLangevinStepKernel::execute(ContextImpl& context, const VariableLangevinIntegrator& integrator, double maxTime) {
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    double errorTol = integrator.getErrorTolerance();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || temperature != prevTemp || friction != prevFriction || errorTol != prevErrorTol) {
+        // Recreate the computation objects with the new parameters.
+
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuVariableLangevinDynamics(context.getSystem().getNumParticles(), friction, temperature, errorTol, data.threads, data.random);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevErrorTol = errorTol;
+    }
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    double maxStepSize = maxTime-refData->time;
+    if (integrator.getMaximumStepSize() > 0)
+        maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, maxStepSize, integrator.getConstraintTolerance());
+    refData->time += dynamics->getDeltaT();
+    if (dynamics->getDeltaT() == maxStepSize)
+        refData->time = maxTime; // Avoid round-off error
+    refData->stepCount++;
+    return dynamics->getDeltaT();
+}
+
+double CpuIntegrateVariableLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const VariableLangevinIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.5*integrator.getStepSize());
+}
+
+CpuIntegrateVariableVerletStepKernel::~CpuIntegrateVariableVerletStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateVariableVerletStepKernel::initialize(const System& system, const VariableVerletIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+}
+
+double CpuIntegrateVariableVerletStepKernel::execute(ContextImpl& context, const VariableVerletIntegrator& integrator, double maxTime) {
+    double errorTol = integrator.getErrorTolerance();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    if (dynamics == 0 || errorTol != prevErrorTol) {
+        // Recreate the computation objects with the new parameters.
+
+        if (dynamics)
+            delete dynamics;
+        dynamics = new CpuVariableVerletDynamics(context.getSystem().getNumParticles(), errorTol, data.threads);
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevErrorTol = errorTol;
+    }
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    double maxStepSize = maxTime-refData->time;
+    if (integrator.getMaximumStepSize() > 0)
+        maxStepSize = min(integrator.getMaximumStepSize(), maxStepSize);
+    dynamics->update(context.getSystem(), posData, velData, forceData, masses, maxStepSize, integrator.getConstraintTolerance());
+    refData->time += dynamics->getDeltaT();
+    if (dynamics->getDeltaT() == maxStepSize)
+        refData->time = maxTime; // Avoid round-off error
+    refData->stepCount++;
+    return dynamics->getDeltaT();
+}
+
+double CpuIntegrateVariableVerletStepKernel::computeKineticEnergy(ContextImpl& context, const VariableVerletIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.5*integrator.getStepSize());
+}
+
+CpuIntegrateCustomStepKernel::~CpuIntegrateCustomStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void CpuIntegrateCustomStepKernel::initialize(const System& system, const CustomIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    perDofValues.resize(integrator.getNumPerDofVariables());
+    for (auto& values : perDofValues)
+        values.resize(numParticles);
+
+    // Create the computation objects.
+
+    dynamics = new CpuCustomDynamics(system.getNumParticles(), integrator, data.threads, data.random);
+    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+void CpuIntegrateCustomStepKernel::execute(ContextImpl& context, CustomIntegrator& integrator, bool& forcesAreValid) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    
+    // Record global variables.
+    
+    map<string, double> globals;
+    globals["dt"] = integrator.getStepSize();
+    for (int i = 0; i < integrator.getNumGlobalVariables(); i++)
+        globals[integrator.getGlobalVariableName(i)] = globalValues[i];
+    
+    // Execute the step.
+    
+    dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+    dynamics->update(context, context.getSystem().getNumParticles(), posData, velData, forceData, masses, globals, perDofValues, forcesAreValid, integrator.getConstraintTolerance());
+    
+    // Record changed global variables.
+    
+    integrator.setStepSize(globals["dt"]);
+    for (int i = 0; i < (int) globalValues.size(); i++)
+        globalValues[i] = globals[integrator.getGlobalVariableName(i)];
+    ReferencePlatform::PlatformData* refData = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    refData->time += dynamics->getDeltaT();
+    refData->stepCount++;
+}
+
+double CpuIntegrateCustomStepKernel::computeKineticEnergy(ContextImpl& context, CustomIntegrator& integrator, bool& forcesAreValid) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    vector<Vec3>& forceData = extractForces(context);
+    
+    // Record global variables.
+    
+    map<string, double> globals;
+    globals["dt"] = integrator.getStepSize();
+    for (int i = 0; i < integrator.getNumGlobalVariables(); i++)
+        globals[integrator.getGlobalVariableName(i)] = globalValues[i];
+    
+    // Compute the kinetic energy.
+    
+    return dynamics->computeKineticEnergy(context, context.getSystem().getNumParticles(), posData, velData, forceData, masses, globals, perDofValues, forcesAreValid);
+}
+
+void CpuIntegrateCustomStepKernel::getGlobalVariables(ContextImpl& context, vector<double>& values) const {
+    values = globalValues;
+}
+
+void CpuIntegrateCustomStepKernel::setGlobalVariables(ContextImpl& context, const vector<double>& values) {
+    globalValues = values;
+}
+
+void CpuIntegrateCustomStepKernel::getPerDofVariable(ContextImpl& context, int variable, vector<Vec3>& values) const {
+    values.resize(perDofValues[variable].size());
+    for (int i = 0; i < (int) values.size(); i++)
+        values[i] = perDofValues[variable][i];
+}
+
+void CpuIntegrateCustomStepKernel::setPerDofVariable(ContextImpl& context, int variable, const vector<Vec3>& values) {
+    perDofValues[variable].resize(values.size());
+    for (int i = 0; i < (int) values.size(); i++)
+        perDofValues[variable][i] = values[i];
+}
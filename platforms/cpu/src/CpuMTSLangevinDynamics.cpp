@@ -0,0 +1,59 @@
+
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuMTSLangevinDynamics.h"
+
+using namespace OpenMM;
+using namespace std;
+
+CpuMTSLangevinDynamics::CpuMTSLangevinDynamics(int numberOfAtoms, double deltaT, double friction, double temperature, const vector<pair<int, int> >& groups,
+                                               ThreadPool& threads, CpuRandom& random) :
+           ReferenceMTSLangevinDynamics(numberOfAtoms, deltaT, friction, temperature, groups), threads(threads),
+           innerDynamics(numberOfAtoms, getDeltaT(), friction, temperature, threads, random) {
+}
+
+CpuMTSLangevinDynamics::~CpuMTSLangevinDynamics() {
+}
+
+void CpuMTSLangevinDynamics::kick(int numberOfAtoms, vector<Vec3>& velocities, vector<Vec3>& forces, vector<double>& inverseMasses, double dt) {
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (inverseMasses[i] != 0.0)
+                velocities[i] += (dt*inverseMasses[i])*forces[i];
+    });
+    threads.waitForThreads();
+}
+
+void CpuMTSLangevinDynamics::updatePart2(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                         vector<double>& inverseMasses, vector<Vec3>& xPrime) {
+    innerDynamics.updatePart2(numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime);
+}
+
+void CpuMTSLangevinDynamics::updatePart3(ContextImpl& context, int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                         vector<double>& inverseMasses, vector<Vec3>& xPrime) {
+    innerDynamics.updatePart3(context, numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime);
+}
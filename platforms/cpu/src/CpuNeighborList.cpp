@@ -34,8 +34,6 @@
 #include "openmm/internal/vectorize.h"
 #include "hilbert.h"
 #include <algorithm>
-#include <set>
-#include <map>
 #include <cmath>
 
 using namespace std;
@@ -168,7 +166,7 @@ public:
         return VoxelIndex(y, z);
     }
         
-    void getNeighbors(vector<int>& neighbors, int blockIndex, const fvec4& blockCenter, const fvec4& blockWidth, const vector<int>& sortedAtoms, vector<CpuNeighborList::BlockExclusionMask>& exclusions, float maxDistance, const vector<int>& blockAtoms, const vector<float>& blockAtomX, const vector<float>& blockAtomY, const vector<float>& blockAtomZ, const vector<float>& sortedPositions, const vector<VoxelIndex>& atomVoxelIndex) const {
+    void getNeighbors(vector<int>& neighbors, int blockIndex, const fvec4& blockCenter, const fvec4& blockWidth, const vector<int>& sortedAtoms, vector<CpuNeighborList::BlockExclusionMask>& exclusions, float maxDistance, const vector<int>& blockAtoms, const vector<float>& blockAtomX, const vector<float>& blockAtomY, const vector<float>& blockAtomZ, const vector<float>& sortedPositions, const vector<VoxelIndex>& atomVoxelIndex, bool clusters) const {
         neighbors.resize(0);
         exclusions.resize(0);
         fvec4 boxSize(periodicBoxSize[0], periodicBoxSize[1], periodicBoxSize[2], 0);
@@ -336,6 +334,12 @@ public:
                         // Avoid duplicate entries.
                         if (sortedIndex >= lastSortedIndex)
                             continue;
+
+                        // When building cluster pairs, each block only needs to be found once.  The atoms of a
+                        // block are close together, so comparing to the last one added skips most duplicates.
+                        const int cluster = sortedIndex/blockSize;
+                        if (clusters && !neighbors.empty() && neighbors.back() == cluster)
+                            continue;
                         
                         fvec4 atomPos(&sortedPositions[4*sortedIndex]);
                         fvec4 delta = atomPos-blockCenter;
@@ -386,8 +390,12 @@ public:
                                 continue;
                         }
                         
-                        // Add this atom to the list of neighbors.
+                        // Add this atom (or when building cluster pairs, the block containing it) to the list of neighbors.
                         
+                        if (clusters) {
+                            neighbors.push_back(cluster);
+                            continue;
+                        }
                         neighbors.push_back(sortedAtoms[sortedIndex]);
                         if (sortedIndex < blockSize*blockIndex)
                             exclusions.push_back(0);
@@ -413,14 +421,25 @@ private:
     vector<vector<vector<pair<float, int> > > > bins;
 };
 
-CpuNeighborList::CpuNeighborList(int blockSize) : blockSize(blockSize) {
+CpuNeighborList::CpuNeighborList(int blockSize) : blockSize(blockSize), useClusterPairs(false) {
 }
 
-void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const vector<set<int> >& exclusions,
+void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float>& atomLocations, const CpuExclusions& exclusions,
             const Vec3* periodicBoxVectors, bool usePeriodic, float maxDistance, ThreadPool& threads) {
     int numBlocks = (numAtoms+blockSize-1)/blockSize;
-    blockNeighbors.resize(numBlocks);
-    blockExclusions.resize(numBlocks);
+    if (useClusterPairs) {
+        blockNeighbors.assign(numBlocks, vector<int>());
+        blockExclusions.assign(numBlocks, vector<BlockExclusionMask>());
+        blockClusters.resize(numBlocks);
+        blockClusterExclusions.resize(numBlocks);
+        atomSortedIndex.resize(numAtoms);
+    }
+    else {
+        blockNeighbors.resize(numBlocks);
+        blockExclusions.resize(numBlocks);
+        blockClusters.assign(numBlocks, vector<int>());
+        blockClusterExclusions.assign(numBlocks, vector<BlockExclusionMask>());
+    }
     sortedAtoms.resize(numAtoms);
     sortedPositions.resize(4*numAtoms);
     
@@ -471,6 +490,8 @@ void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float
     for (int i = 0; i < numAtoms; i++) {
         int atomIndex = atomBins[i].second;
         sortedAtoms[i] = atomIndex;
+        if (useClusterPairs)
+            atomSortedIndex[atomIndex] = i;
         fvec4 atomPos(&atomLocations[4*atomIndex]);
         atomPos.store(&sortedPositions[4*i]);
         voxels.insert(i, &atomLocations[4*atomIndex]);
@@ -484,7 +505,8 @@ void CpuNeighborList::computeNeighborList(int numAtoms, const AlignedArray<float
     threads.resumeThreads();
     threads.waitForThreads();
     
-    // Add padding atoms to fill up the last block.
+    // Add padding atoms to fill up the last block.  When building cluster pairs, the threads have already
+    // excluded them.
     
     int numPadding = numBlocks*blockSize-numAtoms;
     if (numPadding > 0) {
@@ -518,6 +540,22 @@ const std::vector<CpuNeighborList::BlockExclusionMask>& CpuNeighborList::getBloc
     
 }
 
+void CpuNeighborList::setUseClusterPairs(bool use) {
+    useClusterPairs = use;
+}
+
+bool CpuNeighborList::getUseClusterPairs() const {
+    return useClusterPairs;
+}
+
+const std::vector<int>& CpuNeighborList::getBlockClusters(int blockIndex) const {
+    return blockClusters[blockIndex];
+}
+
+const std::vector<CpuNeighborList::BlockExclusionMask>& CpuNeighborList::getBlockClusterExclusions(int blockIndex) const {
+    return blockClusterExclusions[blockIndex];
+}
+
 void CpuNeighborList::threadComputeNeighborList(ThreadPool& threads, int threadIndex) {
     // Compute the positions of atoms along the Hilbert curve.
 
@@ -541,6 +579,9 @@ void CpuNeighborList::threadComputeNeighborList(ThreadPool& threads, int threadI
     vector<int> blockAtoms;
     vector<float> blockAtomX(blockSize), blockAtomY(blockSize), blockAtomZ(blockSize);
     vector<VoxelIndex> atomVoxelIndex;
+    vector<pair<int, BlockExclusionMask> > blockFlags;
+    vector<int> clusterMaskIndex, orderedClusters;
+    vector<BlockExclusionMask> unusedExclusions;
     while (true) {
         int i = atomicCounter++;
         if (i >= numBlocks)
@@ -573,30 +614,112 @@ void CpuNeighborList::threadComputeNeighborList(ThreadPool& threads, int threadI
             blockAtomY[j] = 1e10;
             blockAtomZ[j] = 1e10;
         }
-        voxels->getNeighbors(blockNeighbors[i], i, (maxPos+minPos)*0.5f, (maxPos-minPos)*0.5f, sortedAtoms, blockExclusions[i], maxDistance, blockAtoms, blockAtomX, blockAtomY, blockAtomZ, sortedPositions, atomVoxelIndex);
+        if (useClusterPairs) {
+            voxels->getNeighbors(blockClusters[i], i, (maxPos+minPos)*0.5f, (maxPos-minPos)*0.5f, sortedAtoms, unusedExclusions, maxDistance, blockAtoms, blockAtomX, blockAtomY, blockAtomZ, sortedPositions, atomVoxelIndex, true);
+            computeClusterExclusions(i, atomsInBlock, clusterMaskIndex, orderedClusters);
+            continue;
+        }
+        voxels->getNeighbors(blockNeighbors[i], i, (maxPos+minPos)*0.5f, (maxPos-minPos)*0.5f, sortedAtoms, blockExclusions[i], maxDistance, blockAtoms, blockAtomX, blockAtomY, blockAtomZ, sortedPositions, atomVoxelIndex, false);
 
-        // Record the exclusions for this block.
+        // Record the exclusions for this block.  blockFlags lists every atom excluded by any atom in
+        // this block, together with the mask of block atoms that exclude it, sorted by atom index so
+        // each neighbor can be looked up with a binary search.  It only ever holds the exclusions of
+        // one block, so its size does not depend on the number of atoms in the system.
 
-        map<int, BlockExclusionMask> atomFlags;
+        blockFlags.clear();
         for (int j = 0; j < atomsInBlock; j++) {
-            const set<int>& atomExclusions = (*exclusions)[sortedAtoms[firstIndex+j]];
             const BlockExclusionMask mask = 1<<j;
-            for (int exclusion : atomExclusions) {
-                const auto thisAtomFlags = atomFlags.find(exclusion);
-                if (thisAtomFlags == atomFlags.end())
-                    atomFlags[exclusion] = mask;
-                else
-                    thisAtomFlags->second |= mask;
-            }
+            for (int exclusion : (*exclusions)[sortedAtoms[firstIndex+j]])
+                blockFlags.push_back(make_pair(exclusion, mask));
         }
+        if (blockFlags.size() == 0)
+            continue;
+        sort(blockFlags.begin(), blockFlags.end());
+        int numFlags = 0;
+        for (auto& flag : blockFlags) {
+            if (numFlags > 0 && blockFlags[numFlags-1].first == flag.first)
+                blockFlags[numFlags-1].second |= flag.second;
+            else
+                blockFlags[numFlags++] = flag;
+        }
+        blockFlags.resize(numFlags);
         int numNeighbors = blockNeighbors[i].size();
         for (int k = 0; k < numNeighbors; k++) {
-            int atomIndex = blockNeighbors[i][k];
-            auto thisAtomFlags = atomFlags.find(atomIndex);
-            if (thisAtomFlags != atomFlags.end())
-                blockExclusions[i][k] |= thisAtomFlags->second;
+            int neighbor = blockNeighbors[i][k];
+            auto flag = lower_bound(blockFlags.begin(), blockFlags.end(), neighbor,
+                    [] (const pair<int, BlockExclusionMask>& f, int atom) { return f.first < atom; });
+            if (flag != blockFlags.end() && flag->first == neighbor)
+                blockExclusions[i][k] |= flag->second;
+        }
+    }
+}
+
+void CpuNeighborList::computeClusterExclusions(int blockIndex, int atomsInBlock, vector<int>& clusterMaskIndex, vector<int>& orderedClusters) {
+    // A block was found once for every atom in it that is close enough, so remove the duplicates.
+
+    vector<int>& clusters = blockClusters[blockIndex];
+    sort(clusters.begin(), clusters.end());
+    clusters.erase(unique(clusters.begin(), clusters.end()), clusters.end());
+    int numClusters = clusters.size();
+
+    // clusterMaskIndex records, for each position in the list of clusters, which set of masks holds its
+    // exclusions, or -1 if it does not need any.
+
+    vector<BlockExclusionMask>& masks = blockClusterExclusions[blockIndex];
+    masks.clear();
+    clusterMaskIndex.assign(numClusters, -1);
+    auto getMasks = [&] (int position) {
+        if (clusterMaskIndex[position] == -1) {
+            clusterMaskIndex[position] = masks.size()/blockSize;
+            masks.resize(masks.size()+blockSize, 0);
         }
+        return &masks[blockSize*clusterMaskIndex[position]];
+    };
+
+    // Within the block itself, each pair must only be computed once, and no atom interacts with itself.
+    // Padding atoms, which only occur in the last block, must not interact with anything.
+
+    if (numClusters > 0 && clusters[numClusters-1] == blockIndex) {
+        const BlockExclusionMask paddingMask = (BlockExclusionMask) ~((1<<atomsInBlock)-1);
+        BlockExclusionMask* mask = getMasks(numClusters-1);
+        for (int j = 0; j < blockSize; j++)
+            mask[j] |= (BlockExclusionMask) ((2<<j)-1) | paddingMask;
+    }
+    if (atomsInBlock < blockSize)
+        for (int k = 0; k < numClusters; k++) {
+            BlockExclusionMask* mask = getMasks(k);
+            for (int j = atomsInBlock; j < blockSize; j++)
+                mask[j] = (BlockExclusionMask) ~0;
+        }
+
+    // Record the excluded pairs.
+
+    for (int j = 0; j < atomsInBlock; j++) {
+        for (int exclusion : (*exclusions)[sortedAtoms[blockSize*blockIndex+j]]) {
+            int sortedIndex = atomSortedIndex[exclusion];
+            int cluster = sortedIndex/blockSize;
+            if (cluster > blockIndex)
+                continue;
+            auto position = lower_bound(clusters.begin(), clusters.end(), cluster);
+            if (position == clusters.end() || *position != cluster)
+                continue;
+            getMasks(position-clusters.begin())[j] |= 1<<(sortedIndex-blockSize*cluster);
+        }
+    }
+
+    // Put the clusters with exclusions first, in the same order as their masks.
+
+    if (masks.size() == 0)
+        return;
+    orderedClusters.resize(numClusters);
+    int nextIndex = masks.size()/blockSize;
+    for (int k = 0; k < numClusters; k++) {
+        if (clusterMaskIndex[k] == -1)
+            orderedClusters[nextIndex++] = clusters[k];
+        else
+            orderedClusters[clusterMaskIndex[k]] = clusters[k];
     }
+    copy(orderedClusters.begin(), orderedClusters.end(), clusters.begin());
 }
 
 } // namespace OpenMM
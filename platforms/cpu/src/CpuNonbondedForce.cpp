@@ -244,7 +244,7 @@ void CpuNonbondedForce::tabulateExpTerms() {
 }
 
 void CpuNonbondedForce::calculateReciprocalIxn(int numberOfAtoms, float* posq, const vector<Vec3>& atomCoordinates,
-                                               const vector<pair<float, float> >& atomParameters, const vector<float> &C6params, const vector<set<int> >& exclusions,
+                                               const vector<pair<float, float> >& atomParameters, const vector<float> &C6params, const CpuExclusions& exclusions,
                                                vector<Vec3>& forces, double* totalEnergy) const {
     typedef std::complex<float> d_complex;
 
@@ -379,7 +379,7 @@ void CpuNonbondedForce::calculateReciprocalIxn(int numberOfAtoms, float* posq, c
 
 
 void CpuNonbondedForce::calculateDirectIxn(int numberOfAtoms, float* posq, const vector<Vec3>& atomCoordinates, const vector<pair<float, float> >& atomParameters,
-                                           const vector<float>& C6params, const vector<set<int> >& exclusions, vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads) {
+                                           const vector<float>& C6params, const CpuExclusions& exclusions, vector<AlignedArray<float> >& threadForce, double* totalEnergy, ThreadPool& threads) {
     // Record the parameters for the threads.
     
     this->numberOfAtoms = numberOfAtoms;
@@ -387,11 +387,34 @@ void CpuNonbondedForce::calculateDirectIxn(int numberOfAtoms, float* posq, const
     this->atomCoordinates = &atomCoordinates[0];
     this->atomParameters = &atomParameters[0];
     this->C6params = &C6params[0];
-    this->exclusions = &exclusions[0];
+    this->exclusions = &exclusions;
     this->threadForce = &threadForce;
     includeEnergy = (totalEnergy != NULL);
     threadEnergy.resize(threads.getNumThreads());
     atomicCounter = 0;
+
+    // When using cluster pairs, gather the positions and parameters of the atoms in sorted order so the
+    // kernel can load a whole cluster at once.
+
+    if (cutoff && neighborList->getUseClusterPairs()) {
+        const int blockSize = neighborList->getBlockSize();
+        const vector<int32_t>& sortedAtoms = neighborList->getSortedAtoms();
+        const int numBlocks = neighborList->getNumBlocks();
+        clusterData.resize(NUM_CLUSTER_VALUES*blockSize*numBlocks);
+        for (int block = 0; block < numBlocks; block++) {
+            float* data = &clusterData[NUM_CLUSTER_VALUES*blockSize*block];
+            for (int i = 0; i < blockSize; i++) {
+                int atom = sortedAtoms[blockSize*block+i];
+                data[i] = posq[4*atom];
+                data[blockSize+i] = posq[4*atom+1];
+                data[2*blockSize+i] = posq[4*atom+2];
+                data[3*blockSize+i] = posq[4*atom+3];
+                data[4*blockSize+i] = atomParameters[atom].first;
+                data[5*blockSize+i] = atomParameters[atom].second;
+                data[6*blockSize+i] = (ljpme ? C6params[atom] : 0.0f);
+            }
+        }
+    }
     
     // Signal the threads to start running and wait for them to finish.
     
@@ -428,11 +451,15 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
     fvec4 invBoxSize(recipBoxSize[0], recipBoxSize[1], recipBoxSize[2], 0);
     if (ewald || pme || ljpme) {
         // Compute the interactions from the neighbor list.
+        const bool useClusterPairs = neighborList->getUseClusterPairs();
         while (true) {
             int nextBlock = atomicCounter++;
             if (nextBlock >= neighborList->getNumBlocks())
                 break;
-            calculateBlockEwaldIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
+            if (useClusterPairs)
+                calculateBlockClusterEwaldIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
+            else
+                calculateBlockEwaldIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
         }
 
         // Now subtract off the exclusions, since they were implicitly included in the reciprocal space sum.
@@ -447,7 +474,7 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
             for (int i = start; i < end; i++) {
                 fvec4 posI((float) atomCoordinates[i][0], (float) atomCoordinates[i][1], (float) atomCoordinates[i][2], 0.0f);
                 float scaledChargeI = (float) (ONE_4PI_EPS0*posq[4*i+3]);
-                for (int excluded : exclusions[i]) {
+                for (int excluded : (*exclusions)[i]) {
                     if (excluded > i) {
                         int j = excluded;
                         fvec4 deltaR;
@@ -489,11 +516,15 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
     else if (cutoff) {
         // Compute the interactions from the neighbor list.
 
+        const bool useClusterPairs = neighborList->getUseClusterPairs();
         while (true) {
             int nextBlock = atomicCounter++;
             if (nextBlock >= neighborList->getNumBlocks())
                 break;
-            calculateBlockIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
+            if (useClusterPairs)
+                calculateBlockClusterIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
+            else
+                calculateBlockIxn(nextBlock, forces, energyPtr, boxSize, invBoxSize);
         }
     }
     else {
@@ -504,7 +535,7 @@ void CpuNonbondedForce::threadComputeDirect(ThreadPool& threads, int threadIndex
             if (i >= numberOfAtoms)
                 break;
             for (int j = i+1; j < numberOfAtoms; j++)
-                if (exclusions[j].find(i) == exclusions[j].end())
+                if (!exclusions->isExcluded(j, i))
                     calculateOneIxn(i, j, forces, energyPtr, boxSize, invBoxSize);
         }
     }
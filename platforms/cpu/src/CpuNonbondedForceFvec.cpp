@@ -27,14 +27,18 @@
 OpenMM::CpuNonbondedForce* createCpuNonbondedForceVec4();
 OpenMM::CpuNonbondedForce* createCpuNonbondedForceAvx();
 OpenMM::CpuNonbondedForce* createCpuNonbondedForceAvx2();
+OpenMM::CpuNonbondedForce* createCpuNonbondedForceAvx512();
 
 bool isAvxSupported();
 bool isAvx2Supported();
+bool isAvx512Supported();
 
 #include <iostream>
 
 OpenMM::CpuNonbondedForce* createCpuNonbondedForceVec() {
-    if (isAvx2Supported())
+    if (isAvx512Supported())
+        return createCpuNonbondedForceAvx512();
+    else if (isAvx2Supported())
         return createCpuNonbondedForceAvx2();
     else if (isAvxSupported())
         return createCpuNonbondedForceAvx();
@@ -43,7 +47,9 @@ OpenMM::CpuNonbondedForce* createCpuNonbondedForceVec() {
 }
 
 int getVecBlockSize() {
-    if (isAvx2Supported() || isAvxSupported())
+    if (isAvx512Supported())
+        return 16;
+    else if (isAvx2Supported() || isAvxSupported())
         return 8;
     else
         return 4;
@@ -0,0 +1,132 @@
+
+/* Portions copyright (c) 2024 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuNoseHooverDynamics.h"
+#include "ReferenceVirtualSites.h"
+#include "openmm/Integrator.h"
+#include "openmm/internal/ContextImpl.h"
+
+using namespace OpenMM;
+using namespace std;
+
+CpuNoseHooverDynamics::CpuNoseHooverDynamics(int numberOfAtoms, double deltaT, ThreadPool& threads) :
+           ReferenceNoseHooverDynamics(numberOfAtoms, deltaT), threads(threads) {
+}
+
+void CpuNoseHooverDynamics::step1(ContextImpl &context, const System& system, vector<Vec3>& atomCoordinates,
+                                  vector<Vec3>& velocities, vector<Vec3>& forces, vector<double>& masses, double tolerance, bool &forcesAreValid,
+                                  const vector<int> & atomList, const vector<tuple<int, int, double>> &pairList, double maxPairDistance) {
+    if (!forcesAreValid)
+        context.calcForcesAndEnergy(true, false, context.getIntegrator().getIntegrationForceGroups());
+    if (getTimeStep() == 0) {
+        for (int i = 0; i < numberOfAtoms; i++)
+            inverseMasses[i] = (masses[i] == 0.0 ? 0.0 : 1.0/masses[i]);
+    }
+
+    // Update the velocities of individual particles and Drude-like pairs.  A particle never
+    // appears in both lists, so each thread can safely process its own block of each one.
+
+    const double dt = getDeltaT();
+    const int numAtoms = atomList.size();
+    const int numPairs = pairList.size();
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int numThreads = threads.getNumThreads();
+        for (int i = threadIndex*numAtoms/numThreads; i < (threadIndex+1)*numAtoms/numThreads; i++) {
+            int atom = atomList[i];
+            if (masses[atom] != 0.0)
+                velocities[atom] += forces[atom]*(inverseMasses[atom]*dt);
+        }
+        for (int i = threadIndex*numPairs/numThreads; i < (threadIndex+1)*numPairs/numThreads; i++) {
+            int atom1 = get<0>(pairList[i]);
+            int atom2 = get<1>(pairList[i]);
+            double m1 = masses[atom1];
+            double m2 = masses[atom2];
+            double mass1fract = m1 / (m1 + m2);
+            double mass2fract = m2 / (m1 + m2);
+            double invRedMass = (m1 * m2 != 0.0) ? (m1 + m2)/(m1 * m2) : 0.0;
+            double invTotMass = (m1 + m2 != 0.0) ? 1.0 /(m1 + m2) : 0.0;
+            Vec3 comVel = velocities[atom1]*mass1fract + velocities[atom2]*mass2fract;
+            Vec3 relVel = velocities[atom2] - velocities[atom1];
+            Vec3 comForce = forces[atom1] + forces[atom2];
+            Vec3 relForce = mass1fract*forces[atom2] - mass2fract*forces[atom1];
+            comVel += comForce * dt * invTotMass;
+            relVel += relForce * dt * invRedMass;
+            if (m1 != 0.0)
+                velocities[atom1] = comVel - relVel*mass2fract;
+            if (m2 != 0.0)
+                velocities[atom2] = comVel + relVel*mass1fract;
+        }
+    });
+    threads.waitForThreads();
+    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
+    if (referenceConstraintAlgorithm)
+        referenceConstraintAlgorithm->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
+
+    // Advance the positions by half a step.
+
+    const double halfdt = 0.5*dt;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (masses[i] != 0.0)
+                xPrime[i] = atomCoordinates[i] + velocities[i]*halfdt;
+    });
+    threads.waitForThreads();
+}
+
+void CpuNoseHooverDynamics::step2(ContextImpl &context, const System& system, vector<Vec3>& atomCoordinates,
+                                  vector<Vec3>& velocities, vector<Vec3>& forces, vector<double>& masses, double tolerance, bool &forcesAreValid,
+                                  const vector<int> & atomList, const vector<tuple<int, int, double>> &pairList, double maxPairDistance) {
+    const double halfdt = 0.5*getDeltaT();
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (masses[i] != 0.0) {
+                xPrime[i] += velocities[i]*halfdt;
+                oldx[i] = xPrime[i];
+            }
+    });
+    threads.waitForThreads();
+    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
+    if (referenceConstraintAlgorithm)
+        referenceConstraintAlgorithm->apply(atomCoordinates, xPrime, inverseMasses, tolerance);
+    const double invStepSize = 1.0/getDeltaT();
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (inverseMasses[i] != 0.0) {
+                velocities[i] += (xPrime[i]-oldx[i])*invStepSize;
+                atomCoordinates[i] = xPrime[i];
+            }
+    });
+    threads.waitForThreads();
+    if (maxPairDistance > 0)
+        applyHardWallConstraints(atomCoordinates, velocities, masses, pairList, maxPairDistance);
+    ReferenceVirtualSites::computePositions(context.getSystem(), atomCoordinates);
+    incrementTimeStep();
+}
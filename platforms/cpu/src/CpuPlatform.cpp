@@ -30,9 +30,11 @@
  * -------------------------------------------------------------------------- */
 
 #include "CpuPlatform.h"
+#include "CpuCCMA.h"
 #include "CpuKernelFactory.h"
 #include "CpuKernels.h"
 #include "CpuSETTLE.h"
+#include "ReferenceCCMAAlgorithm.h"
 #include "ReferenceConstraints.h"
 #include "openmm/OpenMMException.h"
 #include "openmm/internal/hardware.h"
@@ -64,19 +66,34 @@ CpuPlatform::CpuPlatform() {
     deprecatedPropertyReplacements["CpuThreads"] = CpuThreads();
     CpuKernelFactory* factory = new CpuKernelFactory();
     registerKernelFactory(CalcForcesAndEnergyKernel::Name(), factory);
+    registerKernelFactory(MinimizeKernel::Name(), factory);
+    registerKernelFactory(CalcHarmonicBondForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomBondForceKernel::Name(), factory);
     registerKernelFactory(CalcHarmonicAngleForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomAngleForceKernel::Name(), factory);
     registerKernelFactory(CalcPeriodicTorsionForceKernel::Name(), factory);
     registerKernelFactory(CalcRBTorsionForceKernel::Name(), factory);
+    registerKernelFactory(CalcCustomTorsionForceKernel::Name(), factory);
     registerKernelFactory(CalcNonbondedForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomNonbondedForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomManyParticleForceKernel::Name(), factory);
     registerKernelFactory(CalcGBSAOBCForceKernel::Name(), factory);
     registerKernelFactory(CalcCustomGBForceKernel::Name(), factory);
     registerKernelFactory(CalcGayBerneForceKernel::Name(), factory);
+    registerKernelFactory(IntegrateVerletStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateNoseHooverStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinStepKernel::Name(), factory);
     registerKernelFactory(IntegrateLangevinMiddleStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateMTSLangevinStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateBrownianStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateVariableLangevinStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateVariableVerletStepKernel::Name(), factory);
+    registerKernelFactory(IntegrateCustomStepKernel::Name(), factory);
     platformProperties.push_back(CpuThreads());
     platformProperties.push_back(CpuDeterministicForces());
+    platformProperties.push_back(CpuPmeThreads());
+    platformProperties.push_back(CpuRpmdParallelCopies());
+    platformProperties.push_back(CpuClusterPairs());
     int threads = getNumProcessors();
     char* threadsEnv = getenv("OPENMM_CPU_THREADS");
     if (threadsEnv != NULL)
@@ -85,6 +102,9 @@ CpuPlatform::CpuPlatform() {
     defaultThreads << threads;
     setPropertyDefaultValue(CpuThreads(), defaultThreads.str());
     setPropertyDefaultValue(CpuDeterministicForces(), "false");
+    setPropertyDefaultValue(CpuPmeThreads(), "0");
+    setPropertyDefaultValue(CpuRpmdParallelCopies(), "1");
+    setPropertyDefaultValue(CpuClusterPairs(), "false");
 }
 
 const string& CpuPlatform::getPropertyValue(const Context& context, const string& property) const {
@@ -99,6 +119,37 @@ const string& CpuPlatform::getPropertyValue(const Context& context, const string
     return ReferencePlatform::getPropertyValue(context, property);
 }
 
+void CpuPlatform::getNeighborListStatistics(const Context& context, long long& numChecks, long long& numRebuilds) const {
+    const PlatformData& data = getPlatformData(getContextImpl(context));
+    numChecks = data.numNeighborListChecks;
+    numRebuilds = data.numNeighborListRebuilds;
+}
+
+void CpuPlatform::getTimingStatistics(ContextImpl& context, map<string, double>& statistics) const {
+    ReferencePlatform::getTimingStatistics(context, statistics);
+    const PlatformData& data = getPlatformData(context);
+    double taskTime, idleTime;
+    data.threads.getLoadBalanceStatistics(taskTime, idleTime);
+    statistics["Neighbor List Checks"] = data.numNeighborListChecks;
+    statistics["Neighbor List Builds"] = data.numNeighborListRebuilds;
+    statistics["Neighbor List Time"] = data.neighborListTime;
+    statistics["Thread Task Time"] = taskTime;
+    statistics["Thread Idle Time"] = idleTime;
+    if (data.numPmeEvaluations > 0) {
+        statistics["PME Direct Space Time"] = data.pmeDirectSpaceTime;
+        statistics["PME Reciprocal Space Time"] = data.pmeReciprocalSpaceTime;
+        statistics["PME Wait Time"] = data.pmeWaitTime;
+    }
+}
+
+void CpuPlatform::getPmeTimings(const Context& context, double& directSpaceTime, double& reciprocalSpaceTime, double& waitTime, long long& numEvaluations) const {
+    const PlatformData& data = getPlatformData(getContextImpl(context));
+    directSpaceTime = data.pmeDirectSpaceTime;
+    reciprocalSpaceTime = data.pmeReciprocalSpaceTime;
+    waitTime = data.pmeWaitTime;
+    numEvaluations = data.numPmeEvaluations;
+}
+
 double CpuPlatform::getSpeed() const {
     return 10;
 }
@@ -117,11 +168,25 @@ void CpuPlatform::contextCreated(ContextImpl& context, const map<string, string>
             getPropertyDefaultValue(CpuThreads()) : properties.find(CpuThreads())->second);
     string deterministicForcesValue = (properties.find(CpuDeterministicForces()) == properties.end() ?
             getPropertyDefaultValue(CpuDeterministicForces()) : properties.find(CpuDeterministicForces())->second);
-    int numThreads;
+    const string& pmeThreadsPropValue = (properties.find(CpuPmeThreads()) == properties.end() ?
+            getPropertyDefaultValue(CpuPmeThreads()) : properties.find(CpuPmeThreads())->second);
+    const string& rpmdParallelCopiesPropValue = (properties.find(CpuRpmdParallelCopies()) == properties.end() ?
+            getPropertyDefaultValue(CpuRpmdParallelCopies()) : properties.find(CpuRpmdParallelCopies())->second);
+    string clusterPairsValue = (properties.find(CpuClusterPairs()) == properties.end() ?
+            getPropertyDefaultValue(CpuClusterPairs()) : properties.find(CpuClusterPairs())->second);
+    int numThreads, pmeThreads, rpmdParallelCopies;
     stringstream(threadsPropValue) >> numThreads;
+    stringstream(pmeThreadsPropValue) >> pmeThreads;
+    stringstream(rpmdParallelCopiesPropValue) >> rpmdParallelCopies;
+    if (pmeThreads < 0 || (pmeThreads > 0 && pmeThreads >= numThreads))
+        throw OpenMMException("PmeThreads must be at least 0 and less than Threads");
+    if (rpmdParallelCopies < 1 || rpmdParallelCopies > numThreads)
+        throw OpenMMException("RpmdParallelCopies must be at least 1 and no greater than Threads");
     transform(deterministicForcesValue.begin(), deterministicForcesValue.end(), deterministicForcesValue.begin(), ::tolower);
     bool deterministicForces = (deterministicForcesValue == "true");
-    PlatformData* data = new PlatformData(context.getSystem().getNumParticles(), numThreads, deterministicForces);
+    transform(clusterPairsValue.begin(), clusterPairsValue.end(), clusterPairsValue.begin(), ::tolower);
+    bool useClusterPairs = (clusterPairsValue == "true");
+    PlatformData* data = new PlatformData(context.getSystem().getNumParticles(), numThreads, deterministicForces, pmeThreads, rpmdParallelCopies, useClusterPairs);
     contextData[&context] = data;
     ReferenceConstraints& constraints = *(ReferenceConstraints*) reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData())->constraints;
     if (constraints.settle != NULL) {
@@ -129,6 +194,11 @@ void CpuPlatform::contextCreated(ContextImpl& context, const map<string, string>
         delete constraints.settle;
         constraints.settle = parallelSettle;
     }
+    if (constraints.ccma != NULL) {
+        CpuCCMA* parallelCCMA = new CpuCCMA(context.getSystem(), *(ReferenceCCMAAlgorithm*) constraints.ccma, data->threads);
+        delete constraints.ccma;
+        constraints.ccma = parallelCCMA;
+    }
 }
 
 void CpuPlatform::contextDestroyed(ContextImpl& context) const {
@@ -147,17 +217,24 @@ const CpuPlatform::PlatformData& CpuPlatform::getPlatformData(const ContextImpl&
     return *contextData[&context];
 }
 
-CpuPlatform::PlatformData::PlatformData(int numParticles, int numThreads, bool deterministicForces) : posq(4*numParticles), threads(numThreads),
-        deterministicForces(deterministicForces), neighborList(NULL), cutoff(0.0), paddedCutoff(0.0), anyExclusions(false), currentPosqIndex(-1), nextPosqIndex(0) {
+CpuPlatform::PlatformData::PlatformData(int numParticles, int numThreads, bool deterministicForces, int pmeThreads, int rpmdParallelCopies, bool useClusterPairs) : posq(4*numParticles),
+        threads(numThreads-pmeThreads), deterministicForces(deterministicForces), useClusterPairs(useClusterPairs), neighborList(NULL), cutoff(0.0), paddedCutoff(0.0),
+        anyExclusions(false), currentPosqIndex(-1), nextPosqIndex(0), pmeThreads(pmeThreads), rpmdParallelCopies(rpmdParallelCopies), numNeighborListChecks(0), numNeighborListRebuilds(0),
+        numPmeEvaluations(0), neighborListTime(0.0), pmeDirectSpaceTime(0.0), pmeReciprocalSpaceTime(0.0), pmeWaitTime(0.0) {
     numThreads = threads.getNumThreads();
     threadForce.resize(numThreads);
     for (int i = 0; i < numThreads; i++)
         threadForce[i].resize(4*numParticles);
     isPeriodic = false;
-    stringstream threadsProperty;
-    threadsProperty << numThreads;
+    stringstream threadsProperty, pmeThreadsProperty, rpmdParallelCopiesProperty;
+    threadsProperty << numThreads+pmeThreads;
+    pmeThreadsProperty << pmeThreads;
+    rpmdParallelCopiesProperty << rpmdParallelCopies;
     propertyValues[CpuThreads()] = threadsProperty.str();
+    propertyValues[CpuPmeThreads()] = pmeThreadsProperty.str();
+    propertyValues[CpuRpmdParallelCopies()] = rpmdParallelCopiesProperty.str();
     propertyValues[CpuDeterministicForces()] = deterministicForces ? "true" : "false";
+    propertyValues[CpuClusterPairs()] = useClusterPairs ? "true" : "false";
 }
 
 CpuPlatform::PlatformData::~PlatformData() {
@@ -170,9 +247,13 @@ CpuPlatform::PlatformData::~PlatformData() {
  */
 int getVecBlockSize();
 
-void CpuPlatform::PlatformData::requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const vector<set<int> >& exclusionList) {
-    if (neighborList == NULL)
+void CpuPlatform::PlatformData::requestNeighborList(double cutoffDistance, double padding, bool useExclusions, const CpuExclusions& exclusionList, bool allowClusterPairs) {
+    if (neighborList == NULL) {
         neighborList = new CpuNeighborList(getVecBlockSize());
+        neighborList->setUseClusterPairs(useClusterPairs);
+    }
+    if (!allowClusterPairs)
+        neighborList->setUseClusterPairs(false);
     if (cutoffDistance > cutoff)
         cutoff = cutoffDistance;
     if (cutoffDistance+padding > paddedCutoff)
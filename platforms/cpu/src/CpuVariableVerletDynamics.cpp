@@ -0,0 +1,88 @@
+
+/* Portions copyright (c) 2024 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CpuVariableVerletDynamics.h"
+
+using namespace OpenMM;
+using namespace std;
+
+CpuVariableVerletDynamics::CpuVariableVerletDynamics(int numberOfAtoms, double accuracy, ThreadPool& threads) :
+           ReferenceVariableVerletDynamics(numberOfAtoms, accuracy), threads(threads) {
+    threadError.resize(threads.getNumThreads());
+}
+
+void CpuVariableVerletDynamics::updatePart1(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                            vector<Vec3>& forces, vector<double>& inverseMasses, vector<Vec3>& xPrime,
+                                            double maxStepSize) {
+    // Compute the error estimate in parallel.  Each thread sums its own block, then the
+    // partial sums are combined in a fixed order so the result is reproducible.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        double error = 0.0;
+        for (int i = start; i < end; i++) {
+            Vec3 xerror = forces[i]*inverseMasses[i];
+            error += xerror.dot(xerror);
+        }
+        threadError[threadIndex] = error;
+    });
+    threads.waitForThreads();
+    double error = 0.0;
+    for (double e : threadError)
+        error += e;
+    error = sqrt(error/(numberOfAtoms*3));
+    double newStepSize = selectStepSize(error, maxStepSize);
+    const double vstep = 0.5*(newStepSize+getDeltaT()); // The time interval by which to advance the velocities
+    setDeltaT(newStepSize);
+
+    // Compute the new positions.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (inverseMasses[i] != 0.0) {
+                Vec3 vPrime = velocities[i] + forces[i]*(inverseMasses[i]*vstep);
+                xPrime[i] = atomCoordinates[i] + vPrime*newStepSize;
+            }
+    });
+    threads.waitForThreads();
+}
+
+void CpuVariableVerletDynamics::updatePart2(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                            vector<double>& inverseMasses, vector<Vec3>& xPrime) {
+    const double velocityScale = 1.0/getDeltaT();
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numberOfAtoms/threads.getNumThreads();
+        int end = (threadIndex+1)*numberOfAtoms/threads.getNumThreads();
+        for (int i = start; i < end; i++)
+            if (inverseMasses[i] != 0.0) {
+                velocities[i] = (xPrime[i]-atomCoordinates[i])*velocityScale;
+                atomCoordinates[i] = xPrime[i];
+            }
+    });
+    threads.waitForThreads();
+}
@@ -0,0 +1,142 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2008-2021 Stanford University and the Authors.      *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the CPU implementation of CCMA.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/HarmonicAngleForce.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/LangevinIntegrator.h"
+#include "openmm/System.h"
+#include "CpuPlatform.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+void testConstraintClusters() {
+    // Create a set of independent chains, each of which forms one cluster of coupled constraints.
+    
+    const int numChains = 50;
+    const int chainLength = 6;
+    const int numParticles = numChains*chainLength;
+    const double temp = 300.0;
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    for (int i = 0; i < numChains; i++) {
+        for (int j = 0; j < chainLength; j++) {
+            system.addParticle(j%2 == 0 ? 12.0 : 1.0);
+            int index = i*chainLength+j;
+            if (j > 0)
+                system.addConstraint(index-1, index, 0.1+0.01*j);
+            if (j > 1)
+                angles->addAngle(index-2, index-1, index, 1.9, 100.0);
+        }
+        bonds->addBond(i*chainLength, i*chainLength+chainLength-1, 0.3, 10.0);
+    }
+    system.addForce(bonds);
+    system.addForce(angles);
+    vector<Vec3> positions(numParticles);
+    vector<Vec3> velocities(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numChains; i++) {
+        Vec3 pos((i%10)*1.5, (i/10)*1.5, 0);
+        for (int j = 0; j < chainLength; j++) {
+            int index = i*chainLength+j;
+            if (j > 0) {
+                double angle = (j%2 == 0 ? 0.5 : -0.5);
+                pos += Vec3(cos(angle), sin(angle), 0)*(0.1+0.01*j);
+            }
+            positions[index] = pos;
+            velocities[index] = Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+        }
+    }
+    LangevinIntegrator integrator(temp, 2.0, 0.002);
+    integrator.setConstraintTolerance(1e-5);
+    CpuPlatform platform;
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "4";
+    Context context(system, integrator, platform, properties);
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+    context.applyConstraints(1e-5);
+    context.applyVelocityConstraints(1e-5);
+
+    // Simulate it and see whether the constraints remain satisfied.
+
+    for (int i = 0; i < 200; i++) {
+        integrator.step(1);
+        State state = context.getState(State::Positions | State::Velocities);
+        for (int j = 0; j < system.getNumConstraints(); j++) {
+            int particle1, particle2;
+            double distance;
+            system.getConstraintParameters(j, particle1, particle2, distance);
+            Vec3 delta = state.getPositions()[particle1]-state.getPositions()[particle2];
+            ASSERT_EQUAL_TOL(distance, sqrt(delta.dot(delta)), 2e-5);
+        }
+    }
+    
+    // Check that velocity constraints are also applied correctly.
+    
+    context.applyVelocityConstraints(1e-6);
+    State state = context.getState(State::Positions | State::Velocities);
+    for (int j = 0; j < system.getNumConstraints(); j++) {
+        int particle1, particle2;
+        double distance;
+        system.getConstraintParameters(j, particle1, particle2, distance);
+        Vec3 delta = state.getPositions()[particle1]-state.getPositions()[particle2];
+        Vec3 deltaV = state.getVelocities()[particle1]-state.getVelocities()[particle2];
+        ASSERT_EQUAL_TOL(0.0, delta.dot(deltaV)/sqrt(deltaV.dot(deltaV)*delta.dot(delta)), 1e-4);
+    }
+}
+
+int main() {
+    try {
+        if (!CpuPlatform::isProcessorSupported()) {
+            cout << "CPU is not supported.  Exiting." << endl;
+            return 0;
+        }
+        testConstraintClusters();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
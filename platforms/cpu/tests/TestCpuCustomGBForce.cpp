@@ -32,5 +32,59 @@
 #include "CpuTests.h"
 #include "TestCustomGBForce.h"
 
+void testCompareToReference() {
+    const int numParticles = 300;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    CustomGBForce* custom = new CustomGBForce();
+    custom->setNonbondedMethod(CustomGBForce::CutoffPeriodic);
+    custom->setCutoffDistance(1.2);
+    custom->addPerParticleParameter("q");
+    custom->addPerParticleParameter("radius");
+    custom->addPerParticleParameter("scale");
+    custom->addGlobalParameter("solventDielectric", 78.3);
+    custom->addGlobalParameter("soluteDielectric", 1.0);
+    custom->addGlobalParameter("k", 0.5);
+    custom->addEnergyParameterDerivative("k");
+    custom->addComputedValue("I", "step(r+sr2-or1)*0.5*(1/L-1/U+0.25*(r-sr2^2/r)*(1/(U^2)-1/(L^2))+0.5*log(L/U)/r);"
+                             "U=r+sr2; L=max(or1, D); D=abs(r-sr2); sr2 = scale2*or2; or1 = radius1-0.009; or2 = radius2-0.009", CustomGBForce::ParticlePair);
+    custom->addComputedValue("B", "1/(1/or-tanh(psi-0.8*psi^2+4.85*psi^3)/radius); psi=I*or; or=radius-0.009", CustomGBForce::SingleParticle);
+    custom->addComputedValue("C", "B*(1+k*q^2)", CustomGBForce::SingleParticle);
+    custom->addEnergyTerm("28.3919551*(radius+0.14)^2*(radius/C)^6-0.5*138.935456*(1/soluteDielectric-1/solventDielectric)*q^2/B", CustomGBForce::SingleParticle);
+    custom->addEnergyTerm("-138.935456*(1/soluteDielectric-1/solventDielectric)*q1*q2/f; f=sqrt(r^2+C1*C2*exp(-r^2/(4*C1*C2)))", CustomGBForce::ParticlePair);
+    custom->addEnergyTerm("k*q1*q2*r^2", CustomGBForce::ParticlePairNoExclusions);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        double q = (i%2 == 0 ? 0.5 : -0.5);
+        custom->addParticle({q, 0.15+0.01*(i%5), 0.7+0.05*(i%3)});
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        if (i%3 != 0)
+            custom->addExclusion(i-1, i);
+    }
+    system.addForce(custom);
+
+    // The CPU platform evaluates pair expressions in single precision and in batches.  It should still
+    // match the Reference platform, which evaluates them one at a time in double precision.
+
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    ReferencePlatform reference;
+    Context context1(system, integrator1, reference);
+    Context context2(system, integrator2, platform);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    State state1 = context1.getState(State::Forces | State::Energy | State::ParameterDerivatives);
+    State state2 = context2.getState(State::Forces | State::Energy | State::ParameterDerivatives);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+    ASSERT_EQUAL_TOL(state1.getEnergyParameterDerivatives().at("k"), state2.getEnergyParameterDerivatives().at("k"), 1e-4);
+}
+
 void runPlatformTests() {
+    testCompareToReference();
 }
@@ -0,0 +1,82 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2008-2021 Stanford University and the Authors.      *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "TestCustomIntegrator.h"
+
+void testParallelComputation() {
+    // Run a velocity Verlet integrator with a per-DOF variable and a sum on the CPU platform with
+    // multiple threads, and compare the trajectory to the Reference platform.
+
+    System system;
+    const int numParticles = 500;
+    for (int i = 0; i < numParticles; i++)
+        system.addParticle(i%5 == 0 ? 0.0 : 1.0+0.1*(i%3));
+    CustomExternalForce* force = new CustomExternalForce("k*(x^2+y^2+z^2)");
+    force->addPerParticleParameter("k");
+    for (int i = 0; i < numParticles; i++)
+        force->addParticle(i, {1.0+0.01*i});
+    system.addForce(force);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(0.1*(i%7), 0.2*(i%3), 0.05*(i%11));
+    CustomIntegrator integrator1(0.01), integrator2(0.01);
+    for (CustomIntegrator* integrator : {&integrator1, &integrator2}) {
+        integrator->addPerDofVariable("a", 0.0);
+        integrator->addGlobalVariable("ke", 0.0);
+        integrator->addComputePerDof("a", "f/m");
+        integrator->addComputePerDof("v", "v+0.5*dt*a");
+        integrator->addComputePerDof("x", "x+dt*v");
+        integrator->addComputePerDof("a", "f/m");
+        integrator->addComputePerDof("v", "v+0.5*dt*a");
+        integrator->addComputeSum("ke", "0.5*m*v*v");
+    }
+    ReferencePlatform reference;
+    Context context1(system, integrator1, reference);
+    context1.setPositions(positions);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "4";
+    Context context2(system, integrator2, platform, properties);
+    context2.setPositions(positions);
+    integrator1.step(20);
+    integrator2.step(20);
+    State state1 = context1.getState(State::Positions | State::Velocities);
+    State state2 = context2.getState(State::Positions | State::Velocities);
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL_VEC(state1.getPositions()[i], state2.getPositions()[i], 1e-5);
+        ASSERT_EQUAL_VEC(state1.getVelocities()[i], state2.getVelocities()[i], 1e-5);
+    }
+    ASSERT_EQUAL_TOL(integrator1.getGlobalVariable(0), integrator2.getGlobalVariable(0), 1e-5);
+}
+
+void runPlatformTests() {
+    testParallelComputation();
+}
@@ -32,5 +32,60 @@
 #include "CpuTests.h"
 #include "TestCustomNonbondedForce.h"
 
+void testOverlappingInteractionGroups() {
+    const int numParticles = 400;
+    const double boxSize = 4.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    CustomNonbondedForce* nonbonded = new CustomNonbondedForce("4*eps*((sigma/r)^12-(sigma/r)^6); sigma=0.5*(sigma1+sigma2); eps=sqrt(eps1*eps2)");
+    nonbonded->addPerParticleParameter("sigma");
+    nonbonded->addPerParticleParameter("eps");
+    nonbonded->setNonbondedMethod(CustomNonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle({0.2+0.05*(i%3), 0.5+0.1*(i%4)});
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        if (i%2 == 1)
+            nonbonded->addExclusion(i-1, i);
+    }
+    system.addForce(nonbonded);
+
+    // Create groups that overlap, so some pairs appear in several of them and some appear
+    // in both directions within a single group.
+
+    set<int> ligand, solvent, all, shell;
+    for (int i = 0; i < 20; i++)
+        ligand.insert(i);
+    for (int i = 20; i < numParticles; i++)
+        solvent.insert(i);
+    for (int i = 0; i < numParticles; i++)
+        all.insert(i);
+    for (int i = 10; i < 100; i++)
+        shell.insert(i);
+    nonbonded->addInteractionGroup(ligand, solvent);
+    nonbonded->addInteractionGroup(ligand, all);
+    nonbonded->addInteractionGroup(shell, shell);
+
+    // The CPU platform should match the Reference platform, which uses an explicit list of pairs.
+
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    ReferencePlatform reference;
+    Context context1(system, integrator1, reference);
+    Context context2(system, integrator2, platform);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    State state1 = context1.getState(State::Forces | State::Energy);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-4);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+}
+
 void runPlatformTests() {
+    testOverlappingInteractionGroups();
 }
@@ -36,6 +36,7 @@
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/internal/ThreadPool.h"
 #include "AlignedArray.h"
+#include "CpuExclusions.h"
 #include "CpuNeighborList.h"
 #include "CpuPlatform.h"
 #include "sfmt/SFMT.h"
@@ -48,7 +49,7 @@
 using namespace OpenMM;
 using namespace std;
 
-void testNeighborList(bool periodic, bool triclinic) {
+void testNeighborList(bool periodic, bool triclinic, bool clusterPairs) {
     const int numParticles = 500;
     const float cutoff = 2.0f;
     Vec3 boxVectors[3];
@@ -70,21 +71,44 @@ void testNeighborList(bool periodic, bool triclinic) {
     for (int i = 0; i < 4*numParticles; i++)
         if (i%4 < 3)
             positions[i] = boxSize[i%4]*genrand_real2(sfmt);
-    vector<set<int> > exclusions(numParticles);
+    vector<pair<int, int> > excludedPairs;
     for (int i = 0; i < numParticles; i++) {
         int num = min(i+1, 10);
-        for (int j = 0; j < num; j++) {
-            exclusions[i].insert(i-j);
-            exclusions[i-j].insert(i);
-        }
+        for (int j = 0; j < num; j++)
+            excludedPairs.push_back(make_pair(i, i-j));
     }
+    CpuExclusions exclusions(numParticles, excludedPairs);
     ThreadPool threads;
     CpuNeighborList neighborList(blockSize);
+    neighborList.setUseClusterPairs(clusterPairs);
     neighborList.computeNeighborList(numParticles, positions, exclusions, boxVectors, periodic, cutoff, threads);
     
     // Convert the neighbor list to a set for faster lookup.
     
     set<pair<int, int> > neighbors;
+    const vector<int>& sortedAtoms = neighborList.getSortedAtoms();
+    for (int blockIndex = 0; blockIndex < neighborList.getNumBlocks(); blockIndex++) {
+        const vector<int>& clusters = neighborList.getBlockClusters(blockIndex);
+        const auto& clusterExclusions = neighborList.getBlockClusterExclusions(blockIndex);
+        ASSERT_EQUAL(clusterPairs, neighborList.getBlockNeighbors(blockIndex).empty());
+        ASSERT_EQUAL(!clusterPairs, clusters.empty());
+        for (int k = 0; k < (int) clusters.size(); k++) {
+            ASSERT(clusters[k] <= blockIndex);
+            for (int i = 0; i < blockSize; i++)
+                for (int j = 0; j < blockSize; j++) {
+                    if (blockSize*k < (int) clusterExclusions.size() && (clusterExclusions[blockSize*k+i] & (1<<j)) != 0)
+                        continue;
+                    int index1 = blockSize*blockIndex+i;
+                    int index2 = blockSize*clusters[k]+j;
+                    ASSERT(index1 < numParticles && index2 < numParticles); // Padding atoms must be excluded
+                    int atom1 = sortedAtoms[index1];
+                    int atom2 = sortedAtoms[index2];
+                    pair<int, int> entry = make_pair(min(atom1, atom2), max(atom1, atom2));
+                    ASSERT(neighbors.find(entry) == neighbors.end()); // No duplicates
+                    neighbors.insert(entry);
+                }
+        }
+    }
     for (int i = 0; i < (int) neighborList.getSortedAtoms().size(); i++) {
         int blockIndex = i/blockSize;
         int indexInBlock = i-blockIndex*blockSize;
@@ -104,7 +128,8 @@ void testNeighborList(bool periodic, bool triclinic) {
 
     for (int i = 0; i < numParticles; i++)
         for (int j = 0; j <= i; j++) {
-            bool shouldInclude = (exclusions[i].find(j) == exclusions[i].end());
+            bool isExcluded = exclusions.isExcluded(i, j);
+            bool shouldInclude = !isExcluded;
             Vec3 diff(positions[4*i]-positions[4*j], positions[4*i+1]-positions[4*j+1], positions[4*i+2]-positions[4*j+2]);
             if (periodic) {
                 diff -= boxVectors[2]*floor(diff[2]/boxSize[2]+0.5);
@@ -116,18 +141,57 @@ void testNeighborList(bool periodic, bool triclinic) {
             bool isIncluded = (neighbors.find(make_pair(i, j)) != neighbors.end() || neighbors.find(make_pair(j, i)) != neighbors.end());
             if (shouldInclude)
                 ASSERT(isIncluded);
+            if (isExcluded)
+                ASSERT(!isIncluded);
         }
 }
 
+void testExclusions() {
+    const int numParticles = 1000;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<set<int> > expected(numParticles);
+    vector<pair<int, int> > excludedPairs;
+    for (int i = 0; i < 5000; i++) {
+        int p1 = (int) (genrand_real2(sfmt)*numParticles);
+        int p2 = (int) (genrand_real2(sfmt)*numParticles);
+        excludedPairs.push_back(make_pair(p1, p2));
+        if (i%10 == 0)
+            excludedPairs.push_back(make_pair(p2, p1));
+        expected[p1].insert(p2);
+        expected[p2].insert(p1);
+    }
+    ThreadPool threads;
+    CpuExclusions serial(numParticles, excludedPairs);
+    CpuExclusions parallel;
+    parallel.setExclusions(numParticles, excludedPairs, &threads);
+    ASSERT(serial == parallel);
+    ASSERT_EQUAL(numParticles, serial.getNumParticles());
+    for (int i = 0; i < numParticles; i++) {
+        ASSERT_EQUAL(expected[i].size(), serial.getNumExclusions(i));
+        ASSERT(equal(expected[i].begin(), expected[i].end(), serial.begin(i)));
+        for (int j = 0; j < numParticles; j++)
+            ASSERT_EQUAL(expected[i].find(j) != expected[i].end(), serial.isExcluded(i, j));
+    }
+    CpuExclusions empty(numParticles, vector<pair<int, int> >());
+    ASSERT(empty != serial);
+    for (int i = 0; i < numParticles; i++)
+        ASSERT_EQUAL(0, empty.getNumExclusions(i));
+}
+
 int main() {
     try {
         if (!CpuPlatform::isProcessorSupported()) {
             cout << "CPU is not supported.  Exiting." << endl;
             return 0;
         }
-        testNeighborList(false, false);
-        testNeighborList(true, false);
-        testNeighborList(true, true);
+        testExclusions();
+        testNeighborList(false, false, false);
+        testNeighborList(true, false, false);
+        testNeighborList(true, true, false);
+        testNeighborList(false, false, true);
+        testNeighborList(true, false, true);
+        testNeighborList(true, true, true);
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
@@ -31,7 +31,206 @@
 
 #include "CpuTests.h"
 #include "TestNonbondedForce.h"
+#include "openmm/CustomNonbondedForce.h"
+
+void testNeighborListStatistics() {
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(3, 0, 0), Vec3(0, 3, 0), Vec3(0, 0, 3));
+    system.addParticle(1.0);
+    system.addParticle(1.0);
+    NonbondedForce* force = new NonbondedForce();
+    force->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    force->setCutoffDistance(1.0);
+    force->addParticle(1.0, 0.5, 1.0);
+    force->addParticle(-1.0, 0.5, 1.0);
+    system.addForce(force);
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions = {Vec3(0.01, 0, 0), Vec3(0.5, 0, 0)};
+    context.setPositions(positions);
+    long long numChecks, numRebuilds;
+    context.getState(State::Energy);
+    platform.getNeighborListStatistics(context, numChecks, numRebuilds);
+    ASSERT_EQUAL(1, numChecks);
+    ASSERT_EQUAL(1, numRebuilds);
+    
+    // Evaluating again at the same positions should not rebuild the neighbor list.
+    
+    double energy = context.getState(State::Energy).getPotentialEnergy();
+    platform.getNeighborListStatistics(context, numChecks, numRebuilds);
+    ASSERT_EQUAL(2, numChecks);
+    ASSERT_EQUAL(1, numRebuilds);
+    
+    // Moving a particle a tiny distance across the edge of the periodic box should not rebuild it either.
+    
+    positions[0] = Vec3(-0.01, 0, 0);
+    context.setPositions(positions);
+    context.getState(State::Energy);
+    platform.getNeighborListStatistics(context, numChecks, numRebuilds);
+    ASSERT_EQUAL(3, numChecks);
+    ASSERT_EQUAL(1, numRebuilds);
+    
+    // Moving it further than the padding should.
+    
+    positions[0] = Vec3(0.8, 0, 0);
+    context.setPositions(positions);
+    context.getState(State::Energy);
+    platform.getNeighborListStatistics(context, numChecks, numRebuilds);
+    ASSERT_EQUAL(4, numChecks);
+    ASSERT_EQUAL(2, numRebuilds);
+    positions[0] = Vec3(0.01, 0, 0);
+    context.setPositions(positions);
+    ASSERT_EQUAL_TOL(energy, context.getState(State::Energy).getPotentialEnergy(), 1e-5);
+
+    // The same statistics should appear in the timing report, along with thread load balance.
+
+    context.setTimingEnabled(true);
+    context.getState(State::Energy);
+    platform.getNeighborListStatistics(context, numChecks, numRebuilds);
+    map<string, double> report = context.getTimingReport();
+    ASSERT_EQUAL(numChecks, report["Neighbor List Checks"]);
+    ASSERT_EQUAL(numRebuilds, report["Neighbor List Builds"]);
+    ASSERT(report["Thread Task Time"] > 0.0);
+    ASSERT(report["Thread Idle Time"] >= 0.0);
+}
+
+void testPmeThreads() {
+    const int numMolecules = 300;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* force = new NonbondedForce();
+    force->setNonbondedMethod(NonbondedForce::PME);
+    force->setCutoffDistance(0.9);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        force->addParticle(-0.5, 0.2, 1.0);
+        force->addParticle(0.5, 0.1, 0.5);
+        force->addException(2*i, 2*i+1, -0.1, 0.15, 0.5);
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    system.addForce(force);
+
+    // Dedicating threads to reciprocal space should not change the result.
+
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "3";
+    properties[CpuPlatform::CpuPmeThreads()] = "1";
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, platform, properties);
+    ASSERT_EQUAL("0", platform.getPropertyValue(context1, CpuPlatform::CpuPmeThreads()));
+    ASSERT_EQUAL("1", platform.getPropertyValue(context2, CpuPlatform::CpuPmeThreads()));
+    ASSERT_EQUAL("3", platform.getPropertyValue(context2, CpuPlatform::CpuThreads()));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    for (int i = 0; i < 2; i++) {
+        State state1 = context1.getState(State::Forces | State::Energy);
+        State state2 = context2.getState(State::Forces | State::Energy);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+        for (int j = 0; j < system.getNumParticles(); j++)
+            ASSERT_EQUAL_VEC(state1.getForces()[j], state2.getForces()[j], 1e-5);
+    }
+
+    // Check the timing statistics.
+
+    double directSpaceTime, reciprocalSpaceTime, waitTime;
+    long long numEvaluations;
+    platform.getPmeTimings(context2, directSpaceTime, reciprocalSpaceTime, waitTime, numEvaluations);
+    ASSERT_EQUAL(2, numEvaluations);
+    ASSERT(directSpaceTime > 0.0);
+    ASSERT(reciprocalSpaceTime >= 0.0);
+    ASSERT(waitTime >= 0.0);
+
+    // Reserving all the threads for reciprocal space is an error.
+
+    properties[CpuPlatform::CpuPmeThreads()] = "3";
+    VerletIntegrator integrator3(0.001);
+    bool failed = false;
+    try {
+        Context context3(system, integrator3, platform, properties);
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+}
+
+void testClusterPairs(NonbondedForce::NonbondedMethod method, bool triclinic, bool useSwitch, bool addCustomForce) {
+    const int numMolecules = 301;
+    const double boxSize = 3.0;
+    System system;
+    if (triclinic)
+        system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0.6, boxSize, 0), Vec3(-0.5, 0.7, boxSize));
+    else
+        system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* force = new NonbondedForce();
+    force->setNonbondedMethod(method);
+    force->setCutoffDistance(0.9);
+    force->setUseSwitchingFunction(useSwitch);
+    force->setSwitchingDistance(0.7);
+    CustomNonbondedForce* custom = new CustomNonbondedForce("0.1/r");
+    custom->setNonbondedMethod(method == NonbondedForce::CutoffNonPeriodic ? CustomNonbondedForce::CutoffNonPeriodic : CustomNonbondedForce::CutoffPeriodic);
+    custom->setCutoffDistance(0.9);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        force->addParticle(-0.5, 0.2, 1.0);
+        force->addParticle(0.5, 0.1, (i%3 == 0 ? 0.0 : 0.5));
+        force->addException(2*i, 2*i+1, -0.1, 0.15, 0.5);
+        custom->addParticle();
+        custom->addParticle();
+        custom->addExclusion(2*i, 2*i+1);
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    system.addForce(force);
+    if (addCustomForce)
+        system.addForce(custom);
+    else
+        delete custom;
+
+    // Building the neighbor list as cluster pairs should not change the result.  When a CustomNonbondedForce
+    // shares the neighbor list, the standard list is used for both of them.
+
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuClusterPairs()] = "true";
+    Context context1(system, integrator1, platform);
+    Context context2(system, integrator2, platform, properties);
+    ASSERT_EQUAL("false", platform.getPropertyValue(context1, CpuPlatform::CpuClusterPairs()));
+    ASSERT_EQUAL("true", platform.getPropertyValue(context2, CpuPlatform::CpuClusterPairs()));
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    State state1 = context1.getState(State::Forces | State::Energy);
+    State state2 = context2.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(state1.getForces()[i], state2.getForces()[i], 1e-4);
+}
 
 void runPlatformTests() {
     testHugeSystem();
+    testNeighborListStatistics();
+    testPmeThreads();
+    testClusterPairs(NonbondedForce::CutoffNonPeriodic, false, false, false);
+    testClusterPairs(NonbondedForce::CutoffPeriodic, false, false, false);
+    testClusterPairs(NonbondedForce::CutoffPeriodic, true, true, false);
+    testClusterPairs(NonbondedForce::Ewald, false, false, false);
+    testClusterPairs(NonbondedForce::PME, false, true, false);
+    testClusterPairs(NonbondedForce::PME, true, false, false);
+    testClusterPairs(NonbondedForce::LJPME, false, false, false);
+    testClusterPairs(NonbondedForce::PME, false, false, true);
 }
@@ -301,8 +301,10 @@ void CudaUpdateStateDataKernel::getEnergyParameterDerivatives(ContextImpl& conte
     ContextSelector selector(cu);
     const vector<string>& paramDerivNames = cu.getEnergyParamDerivNames();
     int numDerivs = paramDerivNames.size();
-    if (numDerivs == 0)
+    if (numDerivs == 0) {
+        derivs.clear();
         return;
+    }
     derivs = cu.getEnergyParamDerivWorkspace();
     CudaArray& derivArray = cu.getEnergyParamDerivBuffer();
     if (cu.getUseDoublePrecision() || cu.getUseMixedPrecision()) {
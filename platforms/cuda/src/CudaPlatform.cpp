@@ -29,6 +29,7 @@
 #include "CudaPlatform.h"
 #include "CudaKernelFactory.h"
 #include "CudaKernels.h"
+#include "openmm/common/ContextSelector.h"
 #include "openmm/Context.h"
 #include "openmm/System.h"
 #include "openmm/internal/ContextImpl.h"
@@ -229,6 +230,16 @@ void CudaPlatform::contextDestroyed(ContextImpl& context) const {
     delete data;
 }
 
+void CudaPlatform::synchronizeContext(ContextImpl& context) const {
+    PlatformData* data = reinterpret_cast<PlatformData*>(context.getPlatformData());
+    for (auto cu : data->contexts) {
+        ContextSelector selector(*cu);
+        CUresult result = cuCtxSynchronize();
+        if (result != CUDA_SUCCESS)
+            throw OpenMMException("Error synchronizing CUDA context: "+cu->getErrorString(result));
+    }
+}
+
 CudaPlatform::PlatformData::PlatformData(ContextImpl* context, const System& system, const string& deviceIndexProperty, const string& blockingProperty, const string& precisionProperty,
             const string& cpuPmeProperty, const string& compilerProperty, const string& tempProperty, const string& hostCompilerProperty, const string& pmeStreamProperty,
             const string& deterministicForcesProperty, int numThreads, bool allowRuntimeCompiler, ContextImpl* originalContext) :
@@ -320,8 +320,10 @@ void OpenCLUpdateStateDataKernel::getForces(ContextImpl& context, vector<Vec3>&
 void OpenCLUpdateStateDataKernel::getEnergyParameterDerivatives(ContextImpl& context, map<string, double>& derivs) {
     const vector<string>& paramDerivNames = cl.getEnergyParamDerivNames();
     int numDerivs = paramDerivNames.size();
-    if (numDerivs == 0)
+    if (numDerivs == 0) {
+        derivs.clear();
         return;
+    }
     derivs = cl.getEnergyParamDerivWorkspace();
     OpenCLArray& derivArray = cl.getEnergyParamDerivBuffer();
     if (cl.getUseDoublePrecision() || cl.getUseMixedPrecision()) {
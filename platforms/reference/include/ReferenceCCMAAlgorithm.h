@@ -36,7 +36,7 @@ class OPENMM_EXPORT ReferenceCCMAAlgorithm : public ReferenceConstraintAlgorithm
 
 protected:
 
-    int _maximumNumberOfIterations;
+    int _maximumNumberOfIterations, _lastNumberOfIterations;
     double _elementCutoff;
 
     int _numberOfConstraints;
@@ -52,6 +52,8 @@ protected:
 
 private:
 
+    void allocateWorkArrays();
+
     void applyConstraints(std::vector<OpenMM::Vec3>& atomCoordinates,
                        std::vector<OpenMM::Vec3>& atomCoordinatesP, std::vector<double>& inverseMasses, bool constrainingVelocities, double tolerance);
           
@@ -71,6 +73,16 @@ public:
      */
     ReferenceCCMAAlgorithm(int numberOfAtoms, int numberOfConstraints, const std::vector<std::pair<int, int> >& atomIndices, const std::vector<double>& distance, std::vector<double>& masses, std::vector<AngleInfo>& angles, double elementCutoff);
 
+    /**
+     * Create a ReferenceCCMAAlgorithm object whose inverse constraint matrix has already been computed.
+     * 
+     * @param numberOfConstraints      the number of constraints
+     * @param atomIndices              atom indices for contraints
+     * @param distance                 distances for constraints
+     * @param matrix                   the inverse constraint matrix, in the format returned by getMatrix()
+     */
+    ReferenceCCMAAlgorithm(int numberOfConstraints, const std::vector<std::pair<int, int> >& atomIndices, const std::vector<double>& distance, const std::vector<std::vector<std::pair<int, double> > >& matrix);
+
     ~ReferenceCCMAAlgorithm();
 
     /**
@@ -78,6 +90,16 @@ public:
      */
     int getNumberOfConstraints() const;
 
+    /**
+     * Get the parameters describing one constraint.
+     * 
+     * @param index       the index of the constraint to get
+     * @param atom1       the index of the first atom in the constraint
+     * @param atom2       the index of the second atom in the constraint
+     * @param distance    the constrained distance between the atoms
+     */
+    void getConstraintParameters(int index, int& atom1, int& atom2, double& distance) const;
+
     /**
      * Get the maximum number of iterations to perform.
      */
@@ -88,6 +110,12 @@ public:
      */
     void setMaximumNumberOfIterations(int maximumNumberOfIterations);
 
+    /**
+     * Get the number of iterations that were needed to converge the last time apply() or applyToVelocities()
+     * was called.
+     */
+    int getLastNumberOfIterations() const;
+
     /**
      * Apply the constraint algorithm.
      * 
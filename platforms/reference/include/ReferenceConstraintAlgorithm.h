@@ -61,6 +61,15 @@ public:
      */
     virtual void applyToVelocities(std::vector<OpenMM::Vec3>& atomCoordinates,
                      std::vector<OpenMM::Vec3>& velocities, std::vector<double>& inverseMasses, double tolerance) = 0;
+
+    /**
+     * Get the number of iterations that were needed to converge the last time apply() or applyToVelocities()
+     * was called.  The default implementation returns 0, which is appropriate for algorithms that are not
+     * iterative.
+     */
+    virtual int getLastNumberOfIterations() const {
+        return 0;
+    }
 };
 
 } // namespace OpenMM
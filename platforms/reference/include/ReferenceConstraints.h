@@ -66,8 +66,25 @@ public:
      * @param tolerance        the constraint tolerance
      */
     void applyToVelocities(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities, std::vector<double>& inverseMasses, double tolerance);
+
+    /**
+     * Get the number of iterations that were needed to converge the last time apply() or applyToVelocities()
+     * was called.
+     */
+    int getLastNumberOfIterations() const;
+
+    /**
+     * Get statistics on how quickly the iterative constraint algorithm has converged.  Only calls that
+     * needed to apply CCMA are counted.
+     *
+     * @param numApplications  on exit, the total number of times constraints have been applied
+     * @param numIterations    on exit, the total number of iterations needed by all of them
+     */
+    void getConvergenceStatistics(long long& numApplications, long long& numIterations) const;
     ReferenceConstraintAlgorithm* ccma;
     ReferenceConstraintAlgorithm* settle;
+private:
+    long long numApplications, numIterations;
 };
 
 } // namespace OpenMM
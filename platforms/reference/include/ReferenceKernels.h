@@ -47,6 +47,7 @@ namespace OpenMM {
 class ReferenceObc;
 class ReferenceAndersenThermostat;
 class ReferenceLangevinMiddleDynamics;
+class ReferenceMTSLangevinDynamics;
 class ReferenceCustomBondIxn;
 class ReferenceCustomAngleIxn;
 class ReferenceCustomTorsionIxn;
@@ -284,6 +285,43 @@ public:
     void computePositions(ContextImpl& context);
 };
 
+/**
+ * This kernel is used by LocalEnergyMinimizer to evaluate the objective function.
+ */
+class ReferenceMinimizeKernel : public MinimizeKernel {
+public:
+    ReferenceMinimizeKernel(std::string name, const Platform& platform) : MinimizeKernel(name, platform) {
+    }
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     */
+    void initialize(const System& system);
+    /**
+     * Set the particle positions, then compute the potential energy and its gradient with respect to
+     * the positions, including harmonic restraints in place of constraints.
+     *
+     * @param context    the context in which to execute this kernel
+     * @param x          the particle positions, stored as 3*numParticles consecutive values
+     * @param gradient   on exit, this contains the gradient of the energy, stored in the same order as x
+     * @param k          the force constant for the harmonic restraints that replace constraints
+     * @param groups     a set of bit flags for which force groups to include
+     * @return the potential energy, including the restraint energy
+     */
+    double computeEnergyAndGradient(ContextImpl& context, const double* x, double* gradient, double k, int groups);
+    /**
+     * Get the largest amount by which any distance constraint is violated by the current positions.
+     *
+     * @param context    the context in which to execute this kernel
+     */
+    double getMaxConstraintError(ContextImpl& context);
+private:
+    std::vector<double> masses;
+    std::vector<std::pair<int, int> > constraintAtoms;
+    std::vector<double> constraintDistances;
+};
+
 /**
  * This kernel is invoked by HarmonicBondForce to calculate the forces acting on the system and the energy of the system.
  */
@@ -1170,7 +1208,7 @@ private:
 /**
  * This kernel is invoked by NoseHooverIntegrator to take one time step.
  */
-class ReferenceIntegrateNoseHooverStepKernel : public IntegrateNoseHooverStepKernel {
+class OPENMM_EXPORT ReferenceIntegrateNoseHooverStepKernel : public IntegrateNoseHooverStepKernel {
 public:
     ReferenceIntegrateNoseHooverStepKernel(std::string name, const Platform& platform, ReferencePlatform::PlatformData& data) : IntegrateNoseHooverStepKernel(name, platform),
         data(data), dynamics(0) {
@@ -1258,6 +1296,15 @@ public:
      * @param velocities    element [i][j] contains the velocity of bead j for chain i
      */
     void setChainStates(ContextImpl& context, const std::vector<std::vector<double> >& positions, const std::vector<std::vector<double> >& velocities);
+protected:
+    /**
+     * Create the object that integrates the particle positions and velocities.  Subclasses
+     * may override this to provide an optimized implementation.
+     *
+     * @param system     the System being integrated
+     * @param stepSize   the integration step size
+     */
+    virtual ReferenceNoseHooverDynamics* createDynamics(const System& system, double stepSize);
 private:
     ReferencePlatform::PlatformData& data;
     ReferenceNoseHooverChain* chainPropagator;
@@ -1342,6 +1389,44 @@ private:
     double prevTemp, prevFriction, prevStepSize;
 };
 
+/**
+ * This kernel is invoked by MTSLangevinIntegrator to take one time step.
+ */
+class ReferenceIntegrateMTSLangevinStepKernel : public IntegrateMTSLangevinStepKernel {
+public:
+    ReferenceIntegrateMTSLangevinStepKernel(std::string name, const Platform& platform, ReferencePlatform::PlatformData& data) : IntegrateMTSLangevinStepKernel(name, platform),
+        data(data), dynamics(0) {
+    }
+    ~ReferenceIntegrateMTSLangevinStepKernel();
+    /**
+     * Initialize the kernel, setting up the particle masses.
+     * 
+     * @param system     the System this kernel will be applied to
+     * @param integrator the MTSLangevinIntegrator this kernel will be used for
+     */
+    void initialize(const System& system, const MTSLangevinIntegrator& integrator);
+    /**
+     * Execute the kernel.
+     * 
+     * @param context        the context in which to execute this kernel
+     * @param integrator     the MTSLangevinIntegrator this kernel is being used for
+     * @param forcesAreValid whether the cached forces from the previous step may be reused
+     */
+    void execute(ContextImpl& context, const MTSLangevinIntegrator& integrator, bool& forcesAreValid);
+    /**
+     * Compute the kinetic energy.
+     * 
+     * @param context    the context in which to execute this kernel
+     * @param integrator the MTSLangevinIntegrator this kernel is being used for
+     */
+    double computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator);
+private:
+    ReferencePlatform::PlatformData& data;
+    ReferenceMTSLangevinDynamics* dynamics;
+    std::vector<double> masses;
+    double prevTemp, prevFriction, prevStepSize;
+};
+
 /**
  * This kernel is invoked by BrownianIntegrator to take one time step.
  */
@@ -0,0 +1,116 @@
+
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef __ReferenceMTSLangevinDynamics_H__
+#define __ReferenceMTSLangevinDynamics_H__
+
+#include "ReferenceLangevinMiddleDynamics.h"
+#include <utility>
+
+namespace OpenMM {
+
+/**
+ * This class implements the BAOAB-RESPA multiple time step algorithm used by MTSLangevinIntegrator.
+ * The innermost substep is a LangevinMiddle step, so the time step reported by getDeltaT() is the
+ * innermost step size.  Forces for each group are cached and only recomputed once positions have
+ * changed.
+ */
+class OPENMM_EXPORT ReferenceMTSLangevinDynamics : public ReferenceLangevinMiddleDynamics {
+
+   protected:
+
+      std::vector<std::pair<int, int> > groups;
+      std::vector<std::vector<OpenMM::Vec3> > groupForces;
+      std::vector<bool> groupForcesValid;
+      double outerDeltaT;
+
+   public:
+
+      /**---------------------------------------------------------------------------------------
+      
+         Constructor
+
+         @param numberOfAtoms  number of atoms
+         @param deltaT         outermost step size
+         @param friction       friction coefficient
+         @param temperature    temperature
+         @param groups         (force group, substeps) pairs, sorted by increasing number of substeps
+      
+         --------------------------------------------------------------------------------------- */
+
+       ReferenceMTSLangevinDynamics(int numberOfAtoms, double deltaT, double friction, double temperature,
+                                    const std::vector<std::pair<int, int> >& groups);
+
+      /**---------------------------------------------------------------------------------------
+      
+         Destructor
+      
+         --------------------------------------------------------------------------------------- */
+
+       ~ReferenceMTSLangevinDynamics();
+
+      /**---------------------------------------------------------------------------------------
+      
+         Update
+      
+         @param context             the context this integrator is updating
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param masses              atom masses
+         @param tolerance           the constraint tolerance
+         @param forcesAreValid      whether the cached forces from the previous step may be reused.
+                                    On exit it is set to true.
+      
+         --------------------------------------------------------------------------------------- */
+     
+      void update(OpenMM::ContextImpl& context, std::vector<OpenMM::Vec3>& atomCoordinates,
+                  std::vector<OpenMM::Vec3>& velocities, std::vector<double>& masses, double tolerance, bool& forcesAreValid);
+
+      /**---------------------------------------------------------------------------------------
+      
+         Apply the forces from one group to the velocities
+      
+         @param numberOfAtoms       number of atoms
+         @param velocities          velocities
+         @param forces              forces
+         @param inverseMasses       inverse atom masses
+         @param dt                  the time interval over which to apply the forces
+      
+         --------------------------------------------------------------------------------------- */
+      
+      virtual void kick(int numberOfAtoms, std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces,
+                        std::vector<double>& inverseMasses, double dt);
+
+   private:
+
+      void substeps(OpenMM::ContextImpl& context, int level, int parentSubsteps, std::vector<OpenMM::Vec3>& atomCoordinates,
+                    std::vector<OpenMM::Vec3>& velocities, double tolerance);
+
+      std::vector<OpenMM::Vec3>& getGroupForces(OpenMM::ContextImpl& context, int level);
+};
+
+} // namespace OpenMM
+
+#endif // __ReferenceMTSLangevinDynamics_H__
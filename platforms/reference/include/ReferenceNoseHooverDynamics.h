@@ -26,15 +26,16 @@
 #define __ReferenceNoseHooverDynamics_H__
 
 #include "ReferenceDynamics.h"
+#include "openmm/internal/windowsExport.h"
 #include <tuple>
 
 namespace OpenMM {
 
 class ContextImpl;
 
-class ReferenceNoseHooverDynamics : public ReferenceDynamics {
+class OPENMM_EXPORT ReferenceNoseHooverDynamics : public ReferenceDynamics {
 
-   private:
+   protected:
       std::vector<OpenMM::Vec3> xPrime;
       std::vector<OpenMM::Vec3> oldx;
       std::vector<double> inverseMasses;
@@ -80,7 +81,7 @@ class ReferenceNoseHooverDynamics : public ReferenceDynamics {
       
          --------------------------------------------------------------------------------------- */
      
-      void step1(OpenMM::ContextImpl &context, const OpenMM::System& system, std::vector<OpenMM::Vec3>& atomCoordinates,
+      virtual void step1(OpenMM::ContextImpl &context, const OpenMM::System& system, std::vector<OpenMM::Vec3>& atomCoordinates,
                  std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces, std::vector<double>& masses, double tolerance, bool &forcesAreValid,
                  const std::vector<int> & allAtoms, const std::vector<std::tuple<int, int, double>> & allPairs, double maxPairDistance);
       /**---------------------------------------------------------------------------------------
@@ -99,10 +100,23 @@ class ReferenceNoseHooverDynamics : public ReferenceDynamics {
          @param maxPairDistance     the maximum separation allowed for a Drude-like pair
       
          --------------------------------------------------------------------------------------- */
-      void step2(OpenMM::ContextImpl &context, const OpenMM::System& system, std::vector<OpenMM::Vec3>& atomCoordinates,
+      virtual void step2(OpenMM::ContextImpl &context, const OpenMM::System& system, std::vector<OpenMM::Vec3>& atomCoordinates,
                  std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces, std::vector<double>& masses, double tolerance, bool &forcesAreValid,
                  const std::vector<int> & allAtoms, const std::vector<std::tuple<int, int, double>> & allPairs, double maxPairDistance);
+
+      /**---------------------------------------------------------------------------------------
+      
+         Make any Drude-like pair whose separation exceeds the maximum distance bounce off a hard wall
+      
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param masses              atom masses
+         @param allPairs            a list of all Drude-like pairs, and their KT values, in the system
+         @param maxPairDistance     the maximum separation allowed for a Drude-like pair
       
+         --------------------------------------------------------------------------------------- */
+      void applyHardWallConstraints(std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities, std::vector<double>& masses,
+                                    const std::vector<std::tuple<int, int, double>> & allPairs, double maxPairDistance);
 };
 
 } // namespace OpenMM
@@ -57,6 +57,7 @@ public:
     bool supportsDoublePrecision() const;
     void contextCreated(ContextImpl& context, const std::map<std::string, std::string>& properties) const;
     void contextDestroyed(ContextImpl& context) const;
+    void getTimingStatistics(ContextImpl& context, std::map<std::string, double>& statistics) const;
 };
 
 class OPENMM_EXPORT ReferencePlatform::PlatformData {
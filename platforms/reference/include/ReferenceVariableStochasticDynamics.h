@@ -26,12 +26,13 @@
 #define __ReferenceVariableStochasticDynamics_H__
 
 #include "ReferenceDynamics.h"
+#include "openmm/internal/windowsExport.h"
 
 namespace OpenMM {
 
-class ReferenceVariableStochasticDynamics : public ReferenceDynamics {
+class OPENMM_EXPORT ReferenceVariableStochasticDynamics : public ReferenceDynamics {
 
-   private:
+   protected:
 
       std::vector<OpenMM::Vec3> xPrime;
       std::vector<double> inverseMasses;
@@ -118,7 +119,7 @@ class ReferenceVariableStochasticDynamics : public ReferenceDynamics {
 
          --------------------------------------------------------------------------------------- */
 
-      void updatePart1(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+      virtual void updatePart1(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
                        std::vector<OpenMM::Vec3>& forces, std::vector<double>& masses, std::vector<double>& inverseMasses,
                        std::vector<OpenMM::Vec3>& xPrime, double maxStepSize);
 
@@ -134,10 +135,37 @@ class ReferenceVariableStochasticDynamics : public ReferenceDynamics {
 
          --------------------------------------------------------------------------------------- */
 
-      void updatePart2(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+      virtual void updatePart2(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
                        std::vector<OpenMM::Vec3>& forces, std::vector<double>& inverseMasses,
                        std::vector<OpenMM::Vec3>& xPrime);
-      
+
+      /**---------------------------------------------------------------------------------------
+
+         Third update: compute the velocities from the constrained positions and store the positions
+
+         @param numberOfAtoms       number of atoms
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param inverseMasses       inverse atom masses
+         @param xPrime              the new positions after constraints are applied
+
+         --------------------------------------------------------------------------------------- */
+
+      virtual void updatePart3(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                               std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime);
+
+      /**---------------------------------------------------------------------------------------
+
+         Select the step size to use based on the error estimate
+
+         @param error               the RMS value of force/mass over all degrees of freedom
+         @param maxStepSize         maximum time step
+
+         @return the new step size
+
+         --------------------------------------------------------------------------------------- */
+
+      double selectStepSize(double error, double maxStepSize) const;
 };
 
 } // namespace OpenMM
@@ -26,12 +26,13 @@
 #define __ReferenceVariableVerletDynamics_H__
 
 #include "ReferenceDynamics.h"
+#include "openmm/internal/windowsExport.h"
 
 namespace OpenMM {
 
-class ReferenceVariableVerletDynamics : public ReferenceDynamics {
+class OPENMM_EXPORT ReferenceVariableVerletDynamics : public ReferenceDynamics {
 
-   private:
+   protected:
 
       std::vector<OpenMM::Vec3> xPrime;
       std::vector<double> inverseMasses;
@@ -93,6 +94,51 @@ class ReferenceVariableVerletDynamics : public ReferenceDynamics {
       void update(const OpenMM::System& system, std::vector<OpenMM::Vec3>& atomCoordinates,
                   std::vector<OpenMM::Vec3>& velocities, std::vector<OpenMM::Vec3>& forces, std::vector<double>& masses, double maxStepSize, double tolerance);
 
+      /**---------------------------------------------------------------------------------------
+
+         First update: select the step size and compute the unconstrained new positions
+
+         @param numberOfAtoms       number of atoms
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param forces              forces
+         @param inverseMasses       inverse atom masses
+         @param xPrime              on exit, the new positions before constraints are applied
+         @param maxStepSize         maximum time step
+
+         --------------------------------------------------------------------------------------- */
+
+      virtual void updatePart1(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                               std::vector<OpenMM::Vec3>& forces, std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime,
+                               double maxStepSize);
+
+      /**---------------------------------------------------------------------------------------
+
+         Second update: compute the velocities from the constrained positions and store the positions
+
+         @param numberOfAtoms       number of atoms
+         @param atomCoordinates     atom coordinates
+         @param velocities          velocities
+         @param inverseMasses       inverse atom masses
+         @param xPrime              the new positions after constraints are applied
+
+         --------------------------------------------------------------------------------------- */
+
+      virtual void updatePart2(int numberOfAtoms, std::vector<OpenMM::Vec3>& atomCoordinates, std::vector<OpenMM::Vec3>& velocities,
+                               std::vector<double>& inverseMasses, std::vector<OpenMM::Vec3>& xPrime);
+
+      /**---------------------------------------------------------------------------------------
+
+         Select the step size to use based on the error estimate
+
+         @param error               the RMS value of force/mass over all degrees of freedom
+         @param maxStepSize         maximum time step
+
+         @return the new step size
+
+         --------------------------------------------------------------------------------------- */
+
+      double selectStepSize(double error, double maxStepSize) const;
 };
 
 } // namespace OpenMM
@@ -53,6 +53,7 @@
 #include "ReferenceGayBerneForce.h"
 #include "ReferenceHarmonicBondIxn.h"
 #include "ReferenceLangevinMiddleDynamics.h"
+#include "ReferenceMTSLangevinDynamics.h"
 #include "ReferenceLJCoulomb14.h"
 #include "ReferenceLJCoulombIxn.h"
 #include "ReferenceMonteCarloBarostat.h"
@@ -359,6 +360,68 @@ void ReferenceVirtualSitesKernel::computePositions(ContextImpl& context) {
     ReferenceVirtualSites::computePositions(context.getSystem(), positions);
 }
 
+void ReferenceMinimizeKernel::initialize(const System& system) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        masses[i] = system.getParticleMass(i);
+    int numConstraints = system.getNumConstraints();
+    constraintAtoms.resize(numConstraints);
+    constraintDistances.resize(numConstraints);
+    for (int i = 0; i < numConstraints; i++)
+        system.getConstraintParameters(i, constraintAtoms[i].first, constraintAtoms[i].second, constraintDistances[i]);
+}
+
+double ReferenceMinimizeKernel::computeEnergyAndGradient(ContextImpl& context, const double* x, double* gradient, double k, int groups) {
+    vector<Vec3>& positions = extractPositions(context);
+    int numParticles = masses.size();
+    for (int i = 0; i < numParticles; i++)
+        positions[i] = Vec3(x[3*i], x[3*i+1], x[3*i+2]);
+    context.computeVirtualSites();
+    double energy = context.calcForcesAndEnergy(true, true, groups);
+    const vector<Vec3>& forces = extractForces(context);
+    for (int i = 0; i < numParticles; i++) {
+        if (masses[i] == 0.0) {
+            gradient[3*i] = 0.0;
+            gradient[3*i+1] = 0.0;
+            gradient[3*i+2] = 0.0;
+        }
+        else {
+            gradient[3*i] = -forces[i][0];
+            gradient[3*i+1] = -forces[i][1];
+            gradient[3*i+2] = -forces[i][2];
+        }
+    }
+
+    // Add harmonic forces for any constraints.
+
+    for (int i = 0; i < constraintAtoms.size(); i++) {
+        int particle1 = constraintAtoms[i].first;
+        int particle2 = constraintAtoms[i].second;
+        Vec3 delta = positions[particle2]-positions[particle1];
+        double r = sqrt(delta.dot(delta));
+        delta *= 1/r;
+        double dr = r-constraintDistances[i];
+        double kdr = k*dr;
+        energy += 0.5*kdr*dr;
+        for (int j = 0; j < 3; j++) {
+            gradient[3*particle1+j] -= kdr*delta[j];
+            gradient[3*particle2+j] += kdr*delta[j];
+        }
+    }
+    return energy;
+}
+
+double ReferenceMinimizeKernel::getMaxConstraintError(ContextImpl& context) {
+    const vector<Vec3>& positions = extractPositions(context);
+    double maxError = 0.0;
+    for (int i = 0; i < constraintAtoms.size(); i++) {
+        Vec3 delta = positions[constraintAtoms[i].second]-positions[constraintAtoms[i].first];
+        maxError = max(maxError, fabs(sqrt(delta.dot(delta))-constraintDistances[i]));
+    }
+    return maxError;
+}
+
 void ReferenceCalcHarmonicBondForceKernel::initialize(const System& system, const HarmonicBondForce& force) {
     numBonds = force.getNumBonds();
     bondIndexArray.resize(numBonds, vector<int>(2));
@@ -2326,7 +2389,7 @@ void ReferenceIntegrateNoseHooverStepKernel::execute(ContextImpl& context, const
         // Recreate the computation objects with the new parameters.
         if (dynamics)
             delete dynamics;
-        dynamics = new ReferenceNoseHooverDynamics(context.getSystem().getNumParticles(), stepSize);
+        dynamics = createDynamics(context.getSystem(), stepSize);
         dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
         prevStepSize = stepSize;
     }
@@ -2345,6 +2408,10 @@ void ReferenceIntegrateNoseHooverStepKernel::execute(ContextImpl& context, const
     data.stepCount++;
 }
 
+ReferenceNoseHooverDynamics* ReferenceIntegrateNoseHooverStepKernel::createDynamics(const System& system, double stepSize) {
+    return new ReferenceNoseHooverDynamics(system.getNumParticles(), stepSize);
+}
+
 double ReferenceIntegrateNoseHooverStepKernel::computeKineticEnergy(ContextImpl& context, const NoseHooverIntegrator& integrator) {
     return computeShiftedKineticEnergy(context, masses, 0);
 }
@@ -2456,11 +2523,6 @@ std::pair<double, double> ReferenceIntegrateNoseHooverStepKernel::computeMaskedK
     const std::vector<int>& atomsList = noseHooverChain.getThermostatedAtoms();
     const std::vector<std::pair<int,int>>& pairsList = noseHooverChain.getThermostatedPairs();
     std::vector<Vec3>& velocities = extractVelocities(context);
-    const System& system = context.getSystem();
-    int numParticles = system.getNumParticles();
-    std::vector<double> masses(numParticles);
-    for (int i = 0; i < numParticles; ++i)
-        masses[i] = system.getParticleMass(i);
 
     double comKE = 0;
     double relKE = 0;
@@ -2496,11 +2558,6 @@ void ReferenceIntegrateNoseHooverStepKernel::scaleVelocities(ContextImpl& contex
     double absScale = scaleFactors.first;
     double relScale = scaleFactors.second;
 
-    const System& system = context.getSystem();
-    int numParticles = system.getNumParticles();
-    std::vector<double> masses(numParticles);
-    for (int i = 0; i < numParticles; ++i)
-        masses[i] = system.getParticleMass(i);
     // scale absolute velocities
     for (const auto &a: atoms){
         velocities[a] *= absScale;
@@ -2651,6 +2708,51 @@ double ReferenceIntegrateLangevinMiddleStepKernel::computeKineticEnergy(ContextI
     return computeShiftedKineticEnergy(context, masses, 0.0);
 }
 
+ReferenceIntegrateMTSLangevinStepKernel::~ReferenceIntegrateMTSLangevinStepKernel() {
+    if (dynamics)
+        delete dynamics;
+}
+
+void ReferenceIntegrateMTSLangevinStepKernel::initialize(const System& system, const MTSLangevinIntegrator& integrator) {
+    int numParticles = system.getNumParticles();
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        masses[i] = system.getParticleMass(i);
+    SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
+}
+
+void ReferenceIntegrateMTSLangevinStepKernel::execute(ContextImpl& context, const MTSLangevinIntegrator& integrator, bool& forcesAreValid) {
+    double temperature = integrator.getTemperature();
+    double friction = integrator.getFriction();
+    double stepSize = integrator.getStepSize();
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& velData = extractVelocities(context);
+    if (dynamics == 0 || temperature != prevTemp || friction != prevFriction || stepSize != prevStepSize) {
+        // Recreate the computation objects with the new parameters.
+        
+        if (dynamics)
+            delete dynamics;
+        dynamics = new ReferenceMTSLangevinDynamics(
+                context.getSystem().getNumParticles(), 
+                stepSize, 
+                friction, 
+                temperature,
+                integrator.getGroups());
+        dynamics->setReferenceConstraintAlgorithm(&extractConstraints(context));
+        prevTemp = temperature;
+        prevFriction = friction;
+        prevStepSize = stepSize;
+        forcesAreValid = false;
+    }
+    dynamics->update(context, posData, velData, masses, integrator.getConstraintTolerance(), forcesAreValid);
+    data.time += stepSize;
+    data.stepCount++;
+}
+
+double ReferenceIntegrateMTSLangevinStepKernel::computeKineticEnergy(ContextImpl& context, const MTSLangevinIntegrator& integrator) {
+    return computeShiftedKineticEnergy(context, masses, 0.0);
+}
+
 ReferenceIntegrateBrownianStepKernel::~ReferenceIntegrateBrownianStepKernel() {
     if (dynamics)
         delete dynamics;
@@ -52,16 +52,10 @@ ReferenceCCMAAlgorithm::ReferenceCCMAAlgorithm(int numberOfAtoms,
     _distance = distance;
 
     _maximumNumberOfIterations = 150;
+    _lastNumberOfIterations = 0;
     _hasInitializedMasses = false;
 
-    // work arrays
-
-    if (_numberOfConstraints > 0) {
-        _r_ij.resize(numberOfConstraints);
-        _d_ij2 = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray(numberOfConstraints, NULL, 1, 0.0, "dij_2");
-        _distanceTolerance = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray(numberOfConstraints, NULL, 1, 0.0, "distanceTolerance");
-        _reducedMasses = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray(numberOfConstraints, NULL, 1, 0.0, "reducedMasses");
-    }
+    allocateWorkArrays();
     if (numberOfConstraints > 0)
     {
         // Compute the constraint coupling matrix
@@ -201,6 +195,30 @@ ReferenceCCMAAlgorithm::ReferenceCCMAAlgorithm(int numberOfAtoms,
     }
 }
 
+ReferenceCCMAAlgorithm::ReferenceCCMAAlgorithm(int numberOfConstraints,
+                                               const vector<pair<int, int> >& atomIndices,
+                                               const vector<double>& distance,
+                                               const vector<vector<pair<int, double> > >& matrix) {
+    _numberOfConstraints = numberOfConstraints;
+    _elementCutoff = 0.0;
+    _atomIndices = atomIndices;
+    _distance = distance;
+    _matrix = matrix;
+    _maximumNumberOfIterations = 150;
+    _lastNumberOfIterations = 0;
+    _hasInitializedMasses = false;
+    allocateWorkArrays();
+}
+
+void ReferenceCCMAAlgorithm::allocateWorkArrays() {
+    if (_numberOfConstraints > 0) {
+        _r_ij.resize(_numberOfConstraints);
+        _d_ij2 = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray(_numberOfConstraints, NULL, 1, 0.0, "dij_2");
+        _distanceTolerance = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray(_numberOfConstraints, NULL, 1, 0.0, "distanceTolerance");
+        _reducedMasses = SimTKOpenMMUtilities::allocateOneDRealOpenMMArray(_numberOfConstraints, NULL, 1, 0.0, "reducedMasses");
+    }
+}
+
 ReferenceCCMAAlgorithm::~ReferenceCCMAAlgorithm() {
     if (_numberOfConstraints > 0) {
         SimTKOpenMMUtilities::freeOneDRealOpenMMArray(_d_ij2, "d_ij2");
@@ -213,6 +231,12 @@ int ReferenceCCMAAlgorithm::getNumberOfConstraints() const {
     return _numberOfConstraints;
 }
 
+void ReferenceCCMAAlgorithm::getConstraintParameters(int index, int& atom1, int& atom2, double& distance) const {
+    atom1 = _atomIndices[index].first;
+    atom2 = _atomIndices[index].second;
+    distance = _distance[index];
+}
+
 int ReferenceCCMAAlgorithm::getMaximumNumberOfIterations() const {
     return _maximumNumberOfIterations;
 }
@@ -221,6 +245,10 @@ void ReferenceCCMAAlgorithm::setMaximumNumberOfIterations(int maximumNumberOfIte
     _maximumNumberOfIterations = maximumNumberOfIterations;
 }
 
+int ReferenceCCMAAlgorithm::getLastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
 void ReferenceCCMAAlgorithm::apply(vector<Vec3>& atomCoordinates,
                                          vector<Vec3>& atomCoordinatesP,
                                          vector<double>& inverseMasses, double tolerance) {
@@ -313,6 +341,7 @@ void ReferenceCCMAAlgorithm::applyConstraints(vector<Vec3>& atomCoordinates,
             atomCoordinatesP[atomJ] -= dr*inverseMasses[atomJ];
         }
     }
+    _lastNumberOfIterations = iterations;
 }
 
 const vector<vector<pair<int, double> > >& ReferenceCCMAAlgorithm::getMatrix() const {
@@ -41,7 +41,7 @@
 using namespace OpenMM;
 using namespace std;
 
-ReferenceConstraints::ReferenceConstraints(const System& system) : ccma(NULL), settle(NULL) {
+ReferenceConstraints::ReferenceConstraints(const System& system) : ccma(NULL), settle(NULL), numApplications(0), numIterations(0) {
     int numParticles = system.getNumParticles();
     vector<double> masses(numParticles);
     for (int i = 0; i < numParticles; ++i)
@@ -192,15 +192,30 @@ ReferenceConstraints::~ReferenceConstraints() {
 }
 
 void ReferenceConstraints::apply(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& atomCoordinatesP, vector<double>& inverseMasses, double tolerance) {
-    if (ccma != NULL)
+    if (ccma != NULL) {
         ccma->apply(atomCoordinates, atomCoordinatesP, inverseMasses, tolerance);
+        numApplications++;
+        numIterations += ccma->getLastNumberOfIterations();
+    }
     if (settle != NULL)
         settle->apply(atomCoordinates, atomCoordinatesP, inverseMasses, tolerance);
 }
 
 void ReferenceConstraints::applyToVelocities(vector<OpenMM::Vec3>& atomCoordinates, vector<OpenMM::Vec3>& velocities, vector<double>& inverseMasses, double tolerance) {
-    if (ccma != NULL)
+    if (ccma != NULL) {
         ccma->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
+        numApplications++;
+        numIterations += ccma->getLastNumberOfIterations();
+    }
     if (settle != NULL)
         settle->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
 }
+
+int ReferenceConstraints::getLastNumberOfIterations() const {
+    return (ccma == NULL ? 0 : ccma->getLastNumberOfIterations());
+}
+
+void ReferenceConstraints::getConvergenceStatistics(long long& numApplications, long long& numIterations) const {
+    numApplications = this->numApplications;
+    numIterations = this->numIterations;
+}
@@ -47,7 +47,8 @@ public:
         return 0;
     }
     double evaluate(const double* arguments) const {
-        return energyParamDerivs[param];
+        map<string, double>::const_iterator deriv = energyParamDerivs.find(param);
+        return (deriv == energyParamDerivs.end() ? 0.0 : deriv->second);
     }
     double evaluateDerivative(const double* arguments, const int* derivOrder) const {
         return 0;
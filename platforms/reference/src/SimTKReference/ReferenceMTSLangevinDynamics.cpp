@@ -0,0 +1,107 @@
+
+/* Portions copyright (c) 2026 Stanford University and Simbios.
+ * Authors: Peter Eastman
+ * Contributors: 
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject
+ * to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ReferenceMTSLangevinDynamics.h"
+#include "ReferencePlatform.h"
+#include "ReferenceVirtualSites.h"
+#include "openmm/internal/ContextImpl.h"
+
+using std::pair;
+using std::vector;
+using namespace OpenMM;
+
+ReferenceMTSLangevinDynamics::ReferenceMTSLangevinDynamics(int numberOfAtoms, double deltaT, double friction, double temperature,
+                                                           const vector<pair<int, int> >& groups) :
+           ReferenceLangevinMiddleDynamics(numberOfAtoms, deltaT/groups.back().second, friction, temperature),
+           groups(groups), groupForces(groups.size()), groupForcesValid(groups.size(), false), outerDeltaT(deltaT) {
+}
+
+ReferenceMTSLangevinDynamics::~ReferenceMTSLangevinDynamics() {
+}
+
+void ReferenceMTSLangevinDynamics::kick(int numberOfAtoms, vector<Vec3>& velocities, vector<Vec3>& forces, vector<double>& inverseMasses, double dt) {
+    for (int i = 0; i < numberOfAtoms; i++)
+        if (inverseMasses[i] != 0.0)
+            velocities[i] += (dt*inverseMasses[i])*forces[i];
+}
+
+vector<Vec3>& ReferenceMTSLangevinDynamics::getGroupForces(ContextImpl& context, int level) {
+    if (!groupForcesValid[level]) {
+        context.calcForcesAndEnergy(true, false, 1<<groups[level].first);
+        ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+        groupForces[level] = *data->forces;
+        groupForcesValid[level] = true;
+    }
+    return groupForces[level];
+}
+
+void ReferenceMTSLangevinDynamics::substeps(ContextImpl& context, int level, int parentSubsteps, vector<Vec3>& atomCoordinates,
+                                            vector<Vec3>& velocities, double tolerance) {
+    int numberOfAtoms = context.getSystem().getNumParticles();
+    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
+    int numSubsteps = groups[level].second;
+    double halfdt = 0.5*outerDeltaT/numSubsteps;
+    for (int step = 0; step < numSubsteps/parentSubsteps; step++) {
+        kick(numberOfAtoms, velocities, getGroupForces(context, level), inverseMasses, halfdt);
+        if (level == (int) groups.size()-1) {
+            // This is the innermost level, so take a LangevinMiddle step with no force kick.
+
+            updatePart2(numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime);
+            if (referenceConstraintAlgorithm)
+                referenceConstraintAlgorithm->apply(atomCoordinates, xPrime, inverseMasses, tolerance);
+            updatePart3(context, numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime);
+            if (referenceConstraintAlgorithm)
+                referenceConstraintAlgorithm->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
+            ReferenceVirtualSites::computePositions(context.getSystem(), atomCoordinates);
+            groupForcesValid.assign(groups.size(), false);
+        }
+        else
+            substeps(context, level+1, numSubsteps, atomCoordinates, velocities, tolerance);
+        kick(numberOfAtoms, velocities, getGroupForces(context, level), inverseMasses, halfdt);
+    }
+}
+
+void ReferenceMTSLangevinDynamics::update(ContextImpl& context, vector<Vec3>& atomCoordinates,
+                                          vector<Vec3>& velocities, vector<double>& masses, double tolerance, bool& forcesAreValid) {
+    int numberOfAtoms = context.getSystem().getNumParticles();
+    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
+    if (getTimeStep() == 0) {
+        // Invert masses
+
+        for (int ii = 0; ii < numberOfAtoms; ii++) {
+            if (masses[ii] == 0.0)
+                inverseMasses[ii] = 0.0;
+            else
+                inverseMasses[ii] = 1.0/masses[ii];
+        }
+    }
+    if (!forcesAreValid)
+        groupForcesValid.assign(groups.size(), false);
+    substeps(context, 0, 1, atomCoordinates, velocities, tolerance);
+    if (referenceConstraintAlgorithm)
+        referenceConstraintAlgorithm->applyToVelocities(atomCoordinates, velocities, inverseMasses, tolerance);
+    forcesAreValid = true;
+    incrementTimeStep();
+}
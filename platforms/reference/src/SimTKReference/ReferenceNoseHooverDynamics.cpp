@@ -138,71 +138,75 @@ void ReferenceNoseHooverDynamics::step2(OpenMM::ContextImpl &context, const Open
     }
 
     // Apply hard wall constraints.
-    if (maxPairDistance > 0) {
-        for (const auto & pair : pairList) {
-            const int atom1 = std::get<0>(pair);
-            const int atom2 = std::get<1>(pair);
-            const double hardWallScale = sqrt(std::get<2>(pair)*BOLTZ);
-            Vec3 delta = atomCoordinates[atom1]-atomCoordinates[atom2];
-            double r = sqrt(delta.dot(delta));
-            double rInv = 1/r;
-            if (rInv*maxPairDistance < 1.0) {
-                // The constraint has been violated, so make the inter-particle distance "bounce"
-                // off the hard wall.
-                Vec3 bondDir = delta*rInv;
-                Vec3 vel1 = velocities[atom1];
-                Vec3 vel2 = velocities[atom2];
-                double m1 = masses[atom1];
-                double m2 = masses[atom2];
-                double invTotMass = (m1 + m2 != 0.0) ? 1.0 /(m1 + m2) : 0.0;
-                double deltaR = r-maxPairDistance;
-                double deltaT = getDeltaT();
-                double dt = getDeltaT();
-
-                double dotvr1 = vel1.dot(bondDir);
-                Vec3 vb1 = bondDir*dotvr1;
-                Vec3 vp1 = vel1-vb1;
-                if (m2 == 0) {
-                    // The parent particle is massless, so move only the Drude particle.
-
-                    if (dotvr1 != 0.0)
-                        deltaT = deltaR/std::abs(dotvr1);
-                    if (deltaT > getDeltaT())
-                        deltaT = getDeltaT();
-                    dotvr1 = -dotvr1*hardWallScale/(std::abs(dotvr1)*sqrt(m1));
-                    double dr = -deltaR + deltaT*dotvr1;
-                    atomCoordinates[atom1] += bondDir*dr;
-                    velocities[atom1] = vp1 + bondDir*dotvr1;
-                }
-                else {
-                    // Move both particles.
-                    double dotvr2 = vel2.dot(bondDir);
-                    Vec3 vb2 = bondDir*dotvr2;
-                    Vec3 vp2 = vel2-vb2;
-                    double vbCMass = (m1*dotvr1 + m2*dotvr2)*invTotMass;
-                    dotvr1 -= vbCMass;
-                    dotvr2 -= vbCMass;
-                    if (dotvr1 != dotvr2)
-                        deltaT = deltaR/std::abs(dotvr1-dotvr2);
-                    if (deltaT > dt)
-                        deltaT = dt;
-                    double vBond = hardWallScale/sqrt(m1);
-                    dotvr1 = -dotvr1*vBond*m2*invTotMass/std::abs(dotvr1);
-                    dotvr2 = -dotvr2*vBond*m1*invTotMass/std::abs(dotvr2);
-                    double dr1 = -deltaR*m2*invTotMass + deltaT*dotvr1;
-                    double dr2 = deltaR*m1*invTotMass + deltaT*dotvr2;
-                    dotvr1 += vbCMass;
-                    dotvr2 += vbCMass;
-                    atomCoordinates[atom1] += bondDir*dr1;
-                    atomCoordinates[atom2] += bondDir*dr2;
-                    velocities[atom1] = vp1 + bondDir*dotvr1;
-                    velocities[atom2] = vp2 + bondDir*dotvr2;
-                }
-            }
-        }
-    } /* end of hard wall constraint part */
+    if (maxPairDistance > 0)
+        applyHardWallConstraints(atomCoordinates, velocities, masses, pairList, maxPairDistance);
 
     ReferenceVirtualSites::computePositions(context.getSystem(), atomCoordinates);
 
     incrementTimeStep();
 }
+
+void ReferenceNoseHooverDynamics::applyHardWallConstraints(vector<Vec3>& atomCoordinates, vector<Vec3>& velocities, vector<double>& masses,
+                                                           const std::vector<std::tuple<int, int, double>> &pairList, double maxPairDistance) {
+    for (const auto & pair : pairList) {
+        const int atom1 = std::get<0>(pair);
+        const int atom2 = std::get<1>(pair);
+        const double hardWallScale = sqrt(std::get<2>(pair)*BOLTZ);
+        Vec3 delta = atomCoordinates[atom1]-atomCoordinates[atom2];
+        double r = sqrt(delta.dot(delta));
+        double rInv = 1/r;
+        if (rInv*maxPairDistance < 1.0) {
+            // The constraint has been violated, so make the inter-particle distance "bounce"
+            // off the hard wall.
+            Vec3 bondDir = delta*rInv;
+            Vec3 vel1 = velocities[atom1];
+            Vec3 vel2 = velocities[atom2];
+            double m1 = masses[atom1];
+            double m2 = masses[atom2];
+            double invTotMass = (m1 + m2 != 0.0) ? 1.0 /(m1 + m2) : 0.0;
+            double deltaR = r-maxPairDistance;
+            double deltaT = getDeltaT();
+            double dt = getDeltaT();
+
+            double dotvr1 = vel1.dot(bondDir);
+            Vec3 vb1 = bondDir*dotvr1;
+            Vec3 vp1 = vel1-vb1;
+            if (m2 == 0) {
+                // The parent particle is massless, so move only the Drude particle.
+
+                if (dotvr1 != 0.0)
+                    deltaT = deltaR/std::abs(dotvr1);
+                if (deltaT > getDeltaT())
+                    deltaT = getDeltaT();
+                dotvr1 = -dotvr1*hardWallScale/(std::abs(dotvr1)*sqrt(m1));
+                double dr = -deltaR + deltaT*dotvr1;
+                atomCoordinates[atom1] += bondDir*dr;
+                velocities[atom1] = vp1 + bondDir*dotvr1;
+            }
+            else {
+                // Move both particles.
+                double dotvr2 = vel2.dot(bondDir);
+                Vec3 vb2 = bondDir*dotvr2;
+                Vec3 vp2 = vel2-vb2;
+                double vbCMass = (m1*dotvr1 + m2*dotvr2)*invTotMass;
+                dotvr1 -= vbCMass;
+                dotvr2 -= vbCMass;
+                if (dotvr1 != dotvr2)
+                    deltaT = deltaR/std::abs(dotvr1-dotvr2);
+                if (deltaT > dt)
+                    deltaT = dt;
+                double vBond = hardWallScale/sqrt(m1);
+                dotvr1 = -dotvr1*vBond*m2*invTotMass/std::abs(dotvr1);
+                dotvr2 = -dotvr2*vBond*m1*invTotMass/std::abs(dotvr2);
+                double dr1 = -deltaR*m2*invTotMass + deltaT*dotvr1;
+                double dr2 = deltaR*m1*invTotMass + deltaT*dotvr2;
+                dotvr1 += vbCMass;
+                dotvr2 += vbCMass;
+                atomCoordinates[atom1] += bondDir*dr1;
+                atomCoordinates[atom2] += bondDir*dr2;
+                velocities[atom1] = vp1 + bondDir*dotvr1;
+                velocities[atom2] = vp2 + bondDir*dotvr2;
+            }
+        }
+    }
+}
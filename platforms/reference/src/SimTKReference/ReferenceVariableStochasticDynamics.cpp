@@ -138,14 +138,7 @@ void ReferenceVariableStochasticDynamics::updatePart1(int numberOfAtoms, vector<
         }
     }
     error = sqrt(error/(numberOfAtoms*3));
-    double newStepSize = sqrt(getAccuracy()/error);
-    if (getDeltaT() > 0.0f)
-        newStepSize = std::min(newStepSize, getDeltaT()*2.0f); // For safety, limit how quickly dt can increase.
-    if (newStepSize > getDeltaT() && newStepSize < 1.2f*getDeltaT())
-        newStepSize = getDeltaT(); // Keeping dt constant between steps improves the behavior of the integrator.
-    if (newStepSize > maxStepSize)
-        newStepSize = maxStepSize;
-    setDeltaT(newStepSize);
+    setDeltaT(selectStepSize(error, maxStepSize));
  
     // perform first update
 
@@ -225,14 +218,52 @@ void ReferenceVariableStochasticDynamics::update(const OpenMM::System& system, v
 
    // copy xPrime -> atomCoordinates
 
+   updatePart3(numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime);
+   ReferenceVirtualSites::computePositions(system, atomCoordinates);
+   incrementTimeStep();
+}
+
+/**---------------------------------------------------------------------------------------
+
+   Third update: compute the velocities from the constrained positions and store the positions
+
+   @param numberOfAtoms       number of atoms
+   @param atomCoordinates     atom coordinates
+   @param velocities          velocities
+   @param inverseMasses       inverse atom masses
+   @param xPrime              the new positions after constraints are applied
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceVariableStochasticDynamics::updatePart3(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                                      vector<double>& inverseMasses, vector<Vec3>& xPrime) {
    double invStepSize = 1.0/getDeltaT();
    for (int ii = 0; ii < numberOfAtoms; ii++) {
-       if (masses[ii] != 0.0) {
+       if (inverseMasses[ii] != 0.0) {
            velocities[ii] = (xPrime[ii]-atomCoordinates[ii])*invStepSize;
            atomCoordinates[ii] = xPrime[ii];
        }
    }
+}
 
-   ReferenceVirtualSites::computePositions(system, atomCoordinates);
-   incrementTimeStep();
+/**---------------------------------------------------------------------------------------
+
+   Select the step size to use based on the error estimate
+
+   @param error               the RMS value of force/mass over all degrees of freedom
+   @param maxStepSize         maximum time step
+
+   @return the new step size
+
+   --------------------------------------------------------------------------------------- */
+
+double ReferenceVariableStochasticDynamics::selectStepSize(double error, double maxStepSize) const {
+    double newStepSize = sqrt(getAccuracy()/error);
+    if (getDeltaT() > 0.0f)
+        newStepSize = std::min(newStepSize, getDeltaT()*2.0f); // For safety, limit how quickly dt can increase.
+    if (newStepSize > getDeltaT() && newStepSize < 1.2f*getDeltaT())
+        newStepSize = getDeltaT(); // Keeping dt constant between steps improves the behavior of the integrator.
+    if (newStepSize > maxStepSize)
+        newStepSize = maxStepSize;
+    return newStepSize;
 }
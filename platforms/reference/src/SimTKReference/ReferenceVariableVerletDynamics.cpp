@@ -111,6 +111,56 @@ void ReferenceVariableVerletDynamics::update(const OpenMM::System& system, vecto
        }
     }
 
+    updatePart1(numberOfAtoms, atomCoordinates, velocities, forces, inverseMasses, xPrime, maxStepSize);
+    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
+    if (referenceConstraintAlgorithm)
+        referenceConstraintAlgorithm->apply(atomCoordinates, xPrime, inverseMasses, tolerance);
+
+   // Update the positions and velocities.
+
+   updatePart2(numberOfAtoms, atomCoordinates, velocities, inverseMasses, xPrime);
+   ReferenceVirtualSites::computePositions(system, atomCoordinates);
+   incrementTimeStep();
+}
+
+/**---------------------------------------------------------------------------------------
+
+   Select the step size to use based on the error estimate
+
+   @param error               the RMS value of force/mass over all degrees of freedom
+   @param maxStepSize         maximum time step
+
+   @return the new step size
+
+   --------------------------------------------------------------------------------------- */
+
+double ReferenceVariableVerletDynamics::selectStepSize(double error, double maxStepSize) const {
+    double newStepSize = sqrt(getAccuracy()/error);
+    if (getDeltaT() > 0.0f)
+        newStepSize = std::min(newStepSize, getDeltaT()*2.0f); // For safety, limit how quickly dt can increase.
+    if (newStepSize > getDeltaT() && newStepSize < 1.2f*getDeltaT())
+        newStepSize = getDeltaT(); // Keeping dt constant between steps improves the behavior of the integrator.
+    if (newStepSize > maxStepSize)
+        newStepSize = maxStepSize;
+    return newStepSize;
+}
+
+/**---------------------------------------------------------------------------------------
+
+   First update: select the step size and compute the unconstrained new positions
+
+   @param numberOfAtoms       number of atoms
+   @param atomCoordinates     atom coordinates
+   @param velocities          velocities
+   @param forces              forces
+   @param inverseMasses       inverse atom masses
+   @param xPrime              on exit, the new positions before constraints are applied
+   @param maxStepSize         maximum time step
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceVariableVerletDynamics::updatePart1(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                                  vector<Vec3>& forces, vector<double>& inverseMasses, vector<Vec3>& xPrime, double maxStepSize) {
     double error = 0.0;
     for (int i = 0; i < numberOfAtoms; ++i) {
         for (int j = 0; j < 3; ++j) {
@@ -119,38 +169,38 @@ void ReferenceVariableVerletDynamics::update(const OpenMM::System& system, vecto
         }
     }
     error = sqrt(error/(numberOfAtoms*3));
-    double newStepSize = sqrt(getAccuracy()/error);
-    if (getDeltaT() > 0.0f)
-        newStepSize = std::min(newStepSize, getDeltaT()*2.0f); // For safety, limit how quickly dt can increase.
-    if (newStepSize > getDeltaT() && newStepSize < 1.2f*getDeltaT())
-        newStepSize = getDeltaT(); // Keeping dt constant between steps improves the behavior of the integrator.
-    if (newStepSize > maxStepSize)
-        newStepSize = maxStepSize;
+    double newStepSize = selectStepSize(error, maxStepSize);
     double vstep = 0.5f*(newStepSize+getDeltaT()); // The time interval by which to advance the velocities
     setDeltaT(newStepSize);
     for (int i = 0; i < numberOfAtoms; ++i) {
-        if (masses[i] != 0.0)
+        if (inverseMasses[i] != 0.0)
             for (int j = 0; j < 3; ++j) {
                 double vPrime = velocities[i][j] + inverseMasses[i]*forces[i][j]*vstep;
                 xPrime[i][j] = atomCoordinates[i][j] + vPrime*getDeltaT();
             }
     }
-    ReferenceConstraintAlgorithm* referenceConstraintAlgorithm = getReferenceConstraintAlgorithm();
-    if (referenceConstraintAlgorithm)
-        referenceConstraintAlgorithm->apply(atomCoordinates, xPrime, inverseMasses, tolerance);
+}
 
-   // Update the positions and velocities.
+/**---------------------------------------------------------------------------------------
+
+   Second update: compute the velocities from the constrained positions and store the positions
 
+   @param numberOfAtoms       number of atoms
+   @param atomCoordinates     atom coordinates
+   @param velocities          velocities
+   @param inverseMasses       inverse atom masses
+   @param xPrime              the new positions after constraints are applied
+
+   --------------------------------------------------------------------------------------- */
+
+void ReferenceVariableVerletDynamics::updatePart2(int numberOfAtoms, vector<Vec3>& atomCoordinates, vector<Vec3>& velocities,
+                                                  vector<double>& inverseMasses, vector<Vec3>& xPrime) {
    double velocityScale = 1.0/getDeltaT();
    for (int i = 0; i < numberOfAtoms; ++i) {
-       if (masses[i] != 0.0)
+       if (inverseMasses[i] != 0.0)
            for (int j = 0; j < 3; ++j) {
                velocities[i][j] = velocityScale*(xPrime[i][j] - atomCoordinates[i][j]);
                atomCoordinates[i][j] = xPrime[i][j];
            }
    }
-   ReferenceVirtualSites::computePositions(system, atomCoordinates);
-   incrementTimeStep();
 }
-
-
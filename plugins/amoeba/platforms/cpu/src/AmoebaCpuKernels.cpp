@@ -0,0 +1,99 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaCpuKernels.h"
+#include "CpuAmoebaPmeMultipoleForce.h"
+#include "ReferencePlatform.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/internal/AmoebaVdwForceImpl.h"
+#include "openmm/internal/ContextImpl.h"
+
+using namespace OpenMM;
+using namespace std;
+
+static vector<Vec3>& extractPositions(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->positions;
+}
+
+static vector<Vec3>& extractForces(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return *data->forces;
+}
+
+static Vec3* extractBoxVectors(ContextImpl& context) {
+    ReferencePlatform::PlatformData* data = reinterpret_cast<ReferencePlatform::PlatformData*>(context.getPlatformData());
+    return data->periodicBoxVectors;
+}
+
+/* -------------------------------------------------------------------------- *
+ *                               AmoebaMultipole                              *
+ * -------------------------------------------------------------------------- */
+
+CpuCalcAmoebaMultipoleForceKernel::CpuCalcAmoebaMultipoleForceKernel(const string& name, const Platform& platform, const System& system, CpuPlatform::PlatformData& data) :
+        ReferenceCalcAmoebaMultipoleForceKernel(name, platform, system), data(data), neighborList(4) {
+}
+
+AmoebaReferencePmeMultipoleForce* CpuCalcAmoebaMultipoleForceKernel::createPmeMultipoleForce(ContextImpl& context) {
+    return new CpuAmoebaPmeMultipoleForce(data.threads, neighborList);
+}
+
+/* -------------------------------------------------------------------------- *
+ *                                 AmoebaVdw                                  *
+ * -------------------------------------------------------------------------- */
+
+CpuCalcAmoebaVdwForceKernel::CpuCalcAmoebaVdwForceKernel(const string& name, const Platform& platform, CpuPlatform::PlatformData& data) :
+        CalcAmoebaVdwForceKernel(name, platform), data(data), usePBC(false), cutoff(1.0e+10), dispersionCoefficient(0.0) {
+}
+
+void CpuCalcAmoebaVdwForceKernel::initialize(const System& system, const AmoebaVdwForce& force) {
+    numParticles = system.getNumParticles();
+    usePBC = (force.getNonbondedMethod() == AmoebaVdwForce::CutoffPeriodic);
+    cutoff = force.getCutoffDistance();
+    dispersionCoefficient = force.getUseDispersionCorrection() ?  AmoebaVdwForceImpl::calcDispersionCorrection(system, force) : 0.0;
+    vdwForce.initialize(force);
+}
+
+double CpuCalcAmoebaVdwForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
+    vector<Vec3>& posData = extractPositions(context);
+    vector<Vec3>& forceData = extractForces(context);
+    double lambda = context.getParameter(AmoebaVdwForce::Lambda());
+    if (!usePBC)
+        return vdwForce.calculateForceAndEnergy(numParticles, lambda, posData, data.threads, forceData);
+    Vec3* boxVectors = extractBoxVectors(context);
+    double minAllowedSize = 1.999999*cutoff;
+    if (boxVectors[0][0] < minAllowedSize || boxVectors[1][1] < minAllowedSize || boxVectors[2][2] < minAllowedSize)
+        throw OpenMMException("The periodic box size has decreased to less than twice the cutoff.");
+    vdwForce.setPeriodicBox(boxVectors);
+    double energy = vdwForce.calculateForceAndEnergy(numParticles, lambda, posData, data.threads, forceData);
+    return energy + dispersionCoefficient/(boxVectors[0][0]*boxVectors[1][1]*boxVectors[2][2]);
+}
+
+void CpuCalcAmoebaVdwForceKernel::copyParametersToContext(ContextImpl& context, const AmoebaVdwForce& force) {
+    if (numParticles != force.getNumParticles())
+        throw OpenMMException("updateParametersInContext: The number of particles has changed");
+    vdwForce.initialize(force);
+}
@@ -0,0 +1,275 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuAmoebaPmeMultipoleForce.h"
+#include "CpuExclusions.h"
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuAmoebaPmeMultipoleForce::CpuAmoebaPmeMultipoleForce(ThreadPool& threads, CpuNeighborList& neighborList) :
+        threads(threads), neighborList(neighborList), neighborListValid(false) {
+}
+
+void CpuAmoebaPmeMultipoleForce::computeNeighborList(const vector<MultipoleParticleData>& particleData) {
+    if (neighborListValid)
+        return;
+    posq.resize(4*_numParticles);
+    for (int i = 0; i < _numParticles; i++) {
+        Vec3 pos = particleData[i].position;
+        pos -= _periodicBoxVectors[2]*floor(pos[2]/_periodicBoxVectors[2][2]);
+        pos -= _periodicBoxVectors[1]*floor(pos[1]/_periodicBoxVectors[1][1]);
+        pos -= _periodicBoxVectors[0]*floor(pos[0]/_periodicBoxVectors[0][0]);
+        posq[4*i] = (float) pos[0];
+        posq[4*i+1] = (float) pos[1];
+        posq[4*i+2] = (float) pos[2];
+        posq[4*i+3] = 0.0f;
+    }
+
+    // Covalently related pairs are scaled rather than excluded, so every pair within the cutoff must be listed.
+    // The pair functions apply the exact cutoff themselves.
+
+    CpuExclusions noExclusions(_numParticles, vector<pair<int, int> >());
+    neighborList.computeNeighborList(_numParticles, posq, noExclusions, _periodicBoxVectors, true, (float) (1.001*_cutoffDistance), threads);
+    neighborListValid = true;
+}
+
+void CpuAmoebaPmeMultipoleForce::loopOverPairs(function<void (int, int, int)> pairFunction) {
+    atomicCounter = 0;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        while (true) {
+            int blockIndex = atomicCounter++;
+            if (blockIndex >= neighborList.getNumBlocks())
+                break;
+            const int blockSize = neighborList.getBlockSize();
+            const int32_t* blockAtom = &neighborList.getSortedAtoms()[blockSize*blockIndex];
+            const vector<int>& neighbors = neighborList.getBlockNeighbors(blockIndex);
+            const auto& blockExclusions = neighborList.getBlockExclusions(blockIndex);
+            for (int i = 0; i < (int) neighbors.size(); i++) {
+                int first = neighbors[i];
+                for (int k = 0; k < blockSize; k++) {
+                    if ((blockExclusions[i] & (1<<k)) == 0) {
+                        int second = blockAtom[k];
+                        pairFunction(threadIndex, min(first, second), max(first, second));
+                    }
+                }
+            }
+        }
+    });
+    threads.waitForThreads();
+}
+
+void CpuAmoebaPmeMultipoleForce::sumThreadArrays(const vector<vector<Vec3> >& threadArrays, vector<Vec3>& result) {
+    int numThreads = threads.getNumThreads();
+    int numParticles = _numParticles;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = (threadIndex*numParticles)/numThreads;
+        int end = ((threadIndex+1)*numParticles)/numThreads;
+        for (int j = 0; j < numThreads; j++)
+            for (int i = start; i < end; i++)
+                result[i] += threadArrays[j][i];
+    });
+    threads.waitForThreads();
+}
+
+void CpuAmoebaPmeMultipoleForce::calculateDirectFixedMultipoleField(const vector<MultipoleParticleData>& particleData) {
+    computeNeighborList(particleData);
+    int numThreads = threads.getNumThreads();
+    vector<vector<Vec3> > threadField(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadFieldPolar(numThreads, vector<Vec3>(_numParticles));
+    loopOverPairs([&] (int threadIndex, int ii, int jj) {
+        double dScale = 1.0, pScale = 1.0;
+        if (jj <= _maxScaleIndex[ii])
+            getDScaleAndPScale(ii, jj, dScale, pScale);
+        calculateFixedMultipoleFieldPairIxn(particleData[ii], particleData[jj], dScale, pScale, threadField[threadIndex], threadFieldPolar[threadIndex]);
+    });
+    sumThreadArrays(threadField, _fixedMultipoleField);
+    sumThreadArrays(threadFieldPolar, _fixedMultipoleFieldPolar);
+}
+
+void CpuAmoebaPmeMultipoleForce::calculateDirectInducedDipoleFields(const vector<MultipoleParticleData>& particleData,
+                                                                    vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields) {
+    computeNeighborList(particleData);
+    int numThreads = threads.getNumThreads();
+    int numFields = updateInducedDipoleFields.size();
+    vector<vector<UpdateInducedDipoleFieldStruct> > threadFields(numThreads, updateInducedDipoleFields);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        for (auto& field : threadFields[threadIndex]) {
+            fill(field.inducedDipoleField.begin(), field.inducedDipoleField.end(), Vec3());
+            for (auto& gradient : field.inducedDipoleFieldGradient)
+                fill(gradient.begin(), gradient.end(), 0.0);
+        }
+    });
+    threads.waitForThreads();
+    loopOverPairs([&] (int threadIndex, int ii, int jj) {
+        calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], threadFields[threadIndex]);
+    });
+
+    // Sum the contributions from the threads.
+
+    int numParticles = _numParticles;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = (threadIndex*numParticles)/numThreads;
+        int end = ((threadIndex+1)*numParticles)/numThreads;
+        for (int k = 0; k < numFields; k++) {
+            UpdateInducedDipoleFieldStruct& field = updateInducedDipoleFields[k];
+            bool hasGradient = (field.inducedDipoleFieldGradient.size() > 0);
+            for (int j = 0; j < numThreads; j++) {
+                const UpdateInducedDipoleFieldStruct& threadField = threadFields[j][k];
+                for (int i = start; i < end; i++) {
+                    field.inducedDipoleField[i] += threadField.inducedDipoleField[i];
+                    if (hasGradient)
+                        for (int m = 0; m < (int) field.inducedDipoleFieldGradient[i].size(); m++)
+                            field.inducedDipoleFieldGradient[i][m] += threadField.inducedDipoleFieldGradient[i][m];
+                }
+            }
+        }
+    });
+    threads.waitForThreads();
+}
+
+double CpuAmoebaPmeMultipoleForce::calculateDirectElectrostatic(const vector<MultipoleParticleData>& particleData,
+                                                                vector<Vec3>& torques, vector<Vec3>& forces) {
+    computeNeighborList(particleData);
+    int numThreads = threads.getNumThreads();
+    vector<vector<Vec3> > threadForces(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > threadTorques(numThreads, vector<Vec3>(_numParticles));
+    vector<vector<double> > threadScaleFactors(numThreads, vector<double>(LAST_SCALE_TYPE_INDEX, 1.0));
+    vector<double> threadEnergy(numThreads, 0.0);
+    loopOverPairs([&] (int threadIndex, int ii, int jj) {
+        vector<double>& scaleFactors = threadScaleFactors[threadIndex];
+        if (jj <= _maxScaleIndex[ii])
+            getMultipoleScaleFactors(ii, jj, scaleFactors);
+        threadEnergy[threadIndex] += calculatePmeDirectElectrostaticPairIxn(particleData[ii], particleData[jj], scaleFactors,
+                threadForces[threadIndex], threadTorques[threadIndex]);
+        if (jj <= _maxScaleIndex[ii])
+            for (auto& s : scaleFactors)
+                s = 1.0;
+    });
+    sumThreadArrays(threadForces, forces);
+    sumThreadArrays(threadTorques, torques);
+    double energy = 0.0;
+    for (int i = 0; i < numThreads; i++)
+        energy += threadEnergy[i];
+    return energy;
+}
+
+void CpuAmoebaPmeMultipoleForce::convergeMutualInducedDipoles(const vector<MultipoleParticleData>& particleData,
+                                                              vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields) {
+    // The induced dipoles satisfy (1/alpha - T)*mu = E, where T is the dipole-dipole interaction tensor and E is the
+    // field from the fixed multipoles.  This is a symmetric positive definite system, so it is solved with conjugate
+    // gradients, preconditioned by the polarizabilities.  The preconditioned residual alpha*r equals the change
+    // in the dipoles from one Jacobi iteration, so convergence is measured the same way as the DIIS solver.  The D and P
+    // dipoles are solved together, since each field evaluation handles both of them.  Particles with zero polarizability
+    // are left out of the system.
+
+    int numFields = updateInducedDipoleFields.size();
+    vector<vector<Vec3> > residual(numFields, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > precondResidual(numFields, vector<Vec3>(_numParticles));
+    vector<vector<Vec3> > direction(numFields, vector<Vec3>(_numParticles));
+    vector<double> residualDot(numFields);
+    vector<UpdateInducedDipoleFieldStruct> directionFields;
+    for (int k = 0; k < numFields; k++)
+        directionFields.push_back(UpdateInducedDipoleFieldStruct(*updateInducedDipoleFields[k].fixedMultipoleField, direction[k],
+                *updateInducedDipoleFields[k].extrapolatedDipoles, *updateInducedDipoleFields[k].extrapolatedDipoleFieldGradient));
+    setMutualInducedDipoleConverged(false);
+    double targetEpsilon = getMutualInducedDipoleTargetEpsilon();
+    int maxIterations = getMaximumMutualInducedDipoleIterations();
+    int iteration = 0;
+    while (true) {
+        // Compute the residual from the field of the current dipoles.  This is also done once the recurrence indicates
+        // convergence, so the final dipoles are checked directly and the fields match them.
+
+        calculateInducedDipoleFields(particleData, updateInducedDipoleFields);
+        double maxEpsilon = 0.0;
+        for (int k = 0; k < numFields; k++) {
+            UpdateInducedDipoleFieldStruct& field = updateInducedDipoleFields[k];
+            double epsilon = 0.0;
+            residualDot[k] = 0.0;
+            for (int i = 0; i < _numParticles; i++) {
+                double polarity = particleData[i].polarity;
+                if (polarity == 0.0) {
+                    residual[k][i] = Vec3();
+                    precondResidual[k][i] = Vec3();
+                }
+                else {
+                    residual[k][i] = ((*field.fixedMultipoleField)[i]-(*field.inducedDipoles)[i])/polarity + field.inducedDipoleField[i];
+                    precondResidual[k][i] = residual[k][i]*polarity;
+                }
+                direction[k][i] = precondResidual[k][i];
+                epsilon += precondResidual[k][i].dot(precondResidual[k][i]);
+                residualDot[k] += residual[k][i].dot(precondResidual[k][i]);
+            }
+            maxEpsilon = max(maxEpsilon, epsilon);
+        }
+        maxEpsilon = _debye*sqrt(maxEpsilon/_numParticles);
+        if (maxEpsilon < targetEpsilon)
+            setMutualInducedDipoleConverged(true);
+        if (maxEpsilon < targetEpsilon || iteration >= maxIterations) {
+            setMutualInducedDipoleEpsilon(maxEpsilon);
+            setMutualInducedDipoleIterations(iteration);
+            return;
+        }
+
+        // Perform conjugate gradient iterations until the recurrence for the residual indicates convergence.
+
+        while (true) {
+            calculateInducedDipoleFields(particleData, directionFields);
+            iteration++;
+            double recurrenceEpsilon = 0.0;
+            for (int k = 0; k < numFields; k++) {
+                UpdateInducedDipoleFieldStruct& field = updateInducedDipoleFields[k];
+                vector<Vec3>& dipoles = *field.inducedDipoles;
+                vector<Vec3>& product = directionFields[k].inducedDipoleField;
+                double directionDot = 0.0;
+                for (int i = 0; i < _numParticles; i++) {
+                    double polarity = particleData[i].polarity;
+                    product[i] = (polarity == 0.0 ? Vec3() : direction[k][i]/polarity - product[i]);
+                    directionDot += direction[k][i].dot(product[i]);
+                }
+                double alpha = (directionDot == 0.0 ? 0.0 : residualDot[k]/directionDot);
+                double epsilon = 0.0;
+                double newResidualDot = 0.0;
+                for (int i = 0; i < _numParticles; i++) {
+                    dipoles[i] += direction[k][i]*alpha;
+                    residual[k][i] -= product[i]*alpha;
+                    precondResidual[k][i] = residual[k][i]*particleData[i].polarity;
+                    epsilon += precondResidual[k][i].dot(precondResidual[k][i]);
+                    newResidualDot += residual[k][i].dot(precondResidual[k][i]);
+                }
+                double beta = (residualDot[k] == 0.0 ? 0.0 : newResidualDot/residualDot[k]);
+                residualDot[k] = newResidualDot;
+                for (int i = 0; i < _numParticles; i++)
+                    direction[k][i] = precondResidual[k][i] + direction[k][i]*beta;
+                recurrenceEpsilon = max(recurrenceEpsilon, epsilon);
+            }
+            recurrenceEpsilon = _debye*sqrt(recurrenceEpsilon/_numParticles);
+            if (recurrenceEpsilon < targetEpsilon || iteration >= maxIterations)
+                break;
+        }
+    }
+}
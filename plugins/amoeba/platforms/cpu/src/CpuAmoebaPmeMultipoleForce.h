@@ -0,0 +1,86 @@
+#ifndef __CpuAmoebaPmeMultipoleForce_H__
+#define __CpuAmoebaPmeMultipoleForce_H__
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaReferenceMultipoleForce.h"
+#include "AlignedArray.h"
+#include "CpuNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes the AMOEBA multipole interaction with PME, evaluating the direct space terms in parallel.
+ * Pairs within the cutoff are found with a CpuNeighborList, and each thread accumulates fields, forces, and torques
+ * into its own buffers.  Reciprocal space is computed by the reference implementation.  Mutual induced dipoles are
+ * converged with a preconditioned conjugate gradient solver.
+ */
+class CpuAmoebaPmeMultipoleForce : public AmoebaReferencePmeMultipoleForce {
+public:
+    /**
+     * Create a CpuAmoebaPmeMultipoleForce.
+     *
+     * @param threads       the thread pool to use
+     * @param neighborList  the neighbor list to store pairs of interacting particles in
+     */
+    CpuAmoebaPmeMultipoleForce(ThreadPool& threads, CpuNeighborList& neighborList);
+protected:
+    void calculateDirectFixedMultipoleField(const std::vector<MultipoleParticleData>& particleData);
+    void calculateDirectInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData,
+                                            std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
+    double calculateDirectElectrostatic(const std::vector<MultipoleParticleData>& particleData,
+                                        std::vector<OpenMM::Vec3>& torques, std::vector<OpenMM::Vec3>& forces);
+    void convergeMutualInducedDipoles(const std::vector<MultipoleParticleData>& particleData,
+                                      std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
+private:
+    /**
+     * Build the neighbor list if it has not already been built for the current positions.
+     */
+    void computeNeighborList(const std::vector<MultipoleParticleData>& particleData);
+    /**
+     * Call a function for every pair of particles in the neighbor list.  The function is invoked with the lower
+     * particle index first and is called in parallel from all threads.
+     */
+    void loopOverPairs(std::function<void (int threadIndex, int particleI, int particleJ)> pairFunction);
+    /**
+     * Sum per-thread arrays into an output array.
+     */
+    void sumThreadArrays(const std::vector<std::vector<Vec3> >& threadArrays, std::vector<Vec3>& result);
+    ThreadPool& threads;
+    CpuNeighborList& neighborList;
+    bool neighborListValid;
+    AlignedArray<float> posq;
+    std::atomic<int> atomicCounter;
+};
+
+} // namespace OpenMM
+
+#endif // __CpuAmoebaPmeMultipoleForce_H__
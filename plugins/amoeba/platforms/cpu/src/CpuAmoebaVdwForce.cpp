@@ -0,0 +1,205 @@
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuAmoebaVdwForce.h"
+#include "ReferenceForce.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuAmoebaVdwForce::CpuAmoebaVdwForce() : neighborList(4), neighborListCutoff(0.0) {
+}
+
+void CpuAmoebaVdwForce::initialize(const AmoebaVdwForce& force) {
+    AmoebaReferenceVdwForce::initialize(force);
+    int numParticles = force.getNumParticles();
+    vector<pair<int, int> > excludedPairs;
+    for (int i = 0; i < numParticles; i++)
+        for (int j : allExclusions[i])
+            if (j > i)
+                excludedPairs.push_back(make_pair(i, j));
+    exclusions.setExclusions(numParticles, excludedPairs);
+    neighborListPositions.clear();
+}
+
+bool CpuAmoebaVdwForce::needNeighborListRebuild(double paddedCutoff, ThreadPool& threads) {
+    if (neighborListPositions.size() != reducedPositions.size() || paddedCutoff != neighborListCutoff)
+        return true;
+    for (int i = 0; i < 3; i++)
+        if (_periodicBoxVectors[i] != neighborListBoxVectors[i])
+            return true;
+
+    // Look for a site that has moved more than half the padding since the list was built.  Together
+    // the two sites of a pair can then have closed the gap by at most the padding.
+
+    int numParticles = reducedPositions.size();
+    int numThreads = threads.getNumThreads();
+    double halfPadding = 0.5*(neighborListCutoff-_cutoff);
+    double maxDisplacement2 = halfPadding*halfPadding;
+    atomic<bool> moved(false);
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = (threadIndex*numParticles)/numThreads;
+        int end = ((threadIndex+1)*numParticles)/numThreads;
+        for (int i = start; i < end && !moved; i++) {
+            Vec3 delta = reducedPositions[i]-neighborListPositions[i];
+            if (delta.dot(delta) > maxDisplacement2)
+                moved = true;
+        }
+    });
+    threads.waitForThreads();
+    return moved;
+}
+
+double CpuAmoebaVdwForce::calculateForceAndEnergy(int numParticles, double lambda, const vector<Vec3>& particlePositions,
+                                                  ThreadPool& threads, vector<Vec3>& forces) {
+    // Interactions are computed between the reduced positions, so that is what the neighbor list is built from.
+
+    setReducedPositions(numParticles, particlePositions, indexIVs, reductions, reducedPositions);
+    if (_nonbondedMethod == AmoebaVdwForce::CutoffPeriodic) {
+        // Pad the cutoff so the neighbor list can be reused on later steps.  The padded cutoff may not exceed
+        // half the box size, since each pair is only recorded once.
+
+        double minBoxWidth = min(_periodicBoxVectors[0][0], min(_periodicBoxVectors[1][1], _periodicBoxVectors[2][2]));
+        double paddedCutoff = max(1.001*_cutoff, min(1.1*_cutoff, 0.5*minBoxWidth));
+        if (needNeighborListRebuild(paddedCutoff, threads)) {
+            posq.resize(4*numParticles);
+            for (int i = 0; i < numParticles; i++) {
+                Vec3 pos = reducedPositions[i];
+                pos -= _periodicBoxVectors[2]*floor(pos[2]/_periodicBoxVectors[2][2]);
+                pos -= _periodicBoxVectors[1]*floor(pos[1]/_periodicBoxVectors[1][1]);
+                pos -= _periodicBoxVectors[0]*floor(pos[0]/_periodicBoxVectors[0][0]);
+                posq[4*i] = (float) pos[0];
+                posq[4*i+1] = (float) pos[1];
+                posq[4*i+2] = (float) pos[2];
+                posq[4*i+3] = 0.0f;
+            }
+            neighborList.computeNeighborList(numParticles, posq, exclusions, _periodicBoxVectors, true, (float) paddedCutoff, threads);
+            neighborListPositions = reducedPositions;
+            for (int i = 0; i < 3; i++)
+                neighborListBoxVectors[i] = _periodicBoxVectors[i];
+            neighborListCutoff = paddedCutoff;
+        }
+    }
+
+    // Compute the interactions, with each thread accumulating forces into its own buffer.
+
+    int numThreads = threads.getNumThreads();
+    threadForce.resize(numThreads);
+    threadEnergy.resize(numThreads);
+    atomicCounter = 0;
+    threads.execute([&] (ThreadPool& threads, int threadIndex) { threadComputeForce(threads, threadIndex, lambda); });
+    threads.waitForThreads();
+
+    // Sum the contributions from the threads.
+
+    threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = (threadIndex*numParticles)/numThreads;
+        int end = ((threadIndex+1)*numParticles)/numThreads;
+        for (int j = 0; j < numThreads; j++)
+            for (int i = start; i < end; i++)
+                forces[i] += threadForce[j][i];
+    });
+    threads.waitForThreads();
+    double energy = 0.0;
+    for (int i = 0; i < numThreads; i++)
+        energy += threadEnergy[i];
+    return energy;
+}
+
+void CpuAmoebaVdwForce::threadComputeForce(ThreadPool& threads, int threadIndex, double lambda) {
+    int numParticles = reducedPositions.size();
+    vector<Vec3>& forces = threadForce[threadIndex];
+    forces.assign(numParticles, Vec3());
+    double lambdaScale = pow(lambda, _n);
+    double softcore = _alpha*pow(1.0-lambda, 2);
+    double energy = 0.0;
+    if (_nonbondedMethod == AmoebaVdwForce::CutoffPeriodic) {
+        // Loop over all pairs in the neighbor list.
+
+        while (true) {
+            int blockIndex = atomicCounter++;
+            if (blockIndex >= neighborList.getNumBlocks())
+                break;
+            const int blockSize = neighborList.getBlockSize();
+            const int32_t* blockAtom = &neighborList.getSortedAtoms()[blockSize*blockIndex];
+            const vector<int>& neighbors = neighborList.getBlockNeighbors(blockIndex);
+            const auto& blockExclusions = neighborList.getBlockExclusions(blockIndex);
+            for (int i = 0; i < (int) neighbors.size(); i++) {
+                int first = neighbors[i];
+                for (int k = 0; k < blockSize; k++) {
+                    if ((blockExclusions[i] & (1<<k)) == 0) {
+                        int second = blockAtom[k];
+                        energy += calculateOnePairIxn(min(first, second), max(first, second), lambdaScale, softcore, forces);
+                    }
+                }
+            }
+        }
+    }
+    else {
+        // Perform an O(N^2) loop over all particle pairs.
+
+        while (true) {
+            int ii = atomicCounter++;
+            if (ii >= numParticles)
+                break;
+            for (int jj = ii+1; jj < numParticles; jj++)
+                if (!exclusions.isExcluded(ii, jj))
+                    energy += calculateOnePairIxn(ii, jj, lambdaScale, softcore, forces);
+        }
+    }
+    threadEnergy[threadIndex] = energy;
+}
+
+double CpuAmoebaVdwForce::calculateOnePairIxn(int siteI, int siteJ, double lambdaScale, double softcore, vector<Vec3>& forces) const {
+    if (_nonbondedMethod == AmoebaVdwForce::CutoffPeriodic) {
+        double deltaR[ReferenceForce::LastDeltaRIndex];
+        ReferenceForce::getDeltaRPeriodic(reducedPositions[siteJ], reducedPositions[siteI], _periodicBoxVectors, deltaR);
+        if (deltaR[ReferenceForce::R2Index] > _cutoff*_cutoff)
+            return 0.0;
+    }
+    double combinedSigma = sigmaMatrix[particleType[siteI]][particleType[siteJ]];
+    double combinedEpsilon = epsilonMatrix[particleType[siteI]][particleType[siteJ]];
+    bool isAlchemicalI = isAlchemical[siteI];
+    bool isAlchemicalJ = isAlchemical[siteJ];
+    if ((_alchemicalMethod == AmoebaVdwForce::Decouple && isAlchemicalI != isAlchemicalJ) ||
+            (_alchemicalMethod == AmoebaVdwForce::Annihilate && (isAlchemicalI || isAlchemicalJ)))
+        combinedEpsilon *= lambdaScale;
+    else
+        softcore = 0.0;
+    Vec3 force;
+    double energy = calculatePairIxn(combinedSigma, combinedEpsilon, softcore, reducedPositions[siteI], reducedPositions[siteJ], force);
+    if (indexIVs[siteI] == siteI)
+        forces[siteI] -= force;
+    else
+        addReducedForce(siteI, indexIVs[siteI], reductions[siteI], -1.0, force, forces);
+    if (indexIVs[siteJ] == siteJ)
+        forces[siteJ] += force;
+    else
+        addReducedForce(siteJ, indexIVs[siteJ], reductions[siteJ], 1.0, force, forces);
+    return energy;
+}
@@ -0,0 +1,85 @@
+#ifndef __CpuAmoebaVdwForce_H__
+#define __CpuAmoebaVdwForce_H__
+
+/* -------------------------------------------------------------------------- *
+ *                              OpenMMAmoeba                                  *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * This program is free software: you can redistribute it and/or modify       *
+ * it under the terms of the GNU Lesser General Public License as published   *
+ * by the Free Software Foundation, either version 3 of the License, or       *
+ * (at your option) any later version.                                        *
+ *                                                                            *
+ * This program is distributed in the hope that it will be useful,            *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+ * GNU Lesser General Public License for more details.                        *
+ *                                                                            *
+ * You should have received a copy of the GNU Lesser General Public License   *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+ * -------------------------------------------------------------------------- */
+
+#include "AmoebaReferenceVdwForce.h"
+#include "AlignedArray.h"
+#include "CpuExclusions.h"
+#include "CpuNeighborList.h"
+#include "openmm/internal/ThreadPool.h"
+#include <atomic>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class computes the AMOEBA vdW interaction in parallel.  Interactions are identified with a CpuNeighborList
+ * built from the reduced (interaction site) positions, and each thread accumulates forces into its own buffer.
+ * The neighbor list is built with a padded cutoff and reused until some site has moved more than half the padding.
+ */
+class CpuAmoebaVdwForce : public AmoebaReferenceVdwForce {
+public:
+    CpuAmoebaVdwForce();
+    /**
+     * Set the force field parameters.
+     */
+    void initialize(const AmoebaVdwForce& force);
+    /**
+     * Calculate the vdW interactions.
+     *
+     * @param numParticles       number of particles
+     * @param lambda             lambda value
+     * @param particlePositions  Cartesian coordinates of particles
+     * @param threads            the thread pool to use
+     * @param forces             add forces to this vector
+     * @return the energy
+     */
+    double calculateForceAndEnergy(int numParticles, double lambda, const std::vector<Vec3>& particlePositions,
+                                   ThreadPool& threads, std::vector<Vec3>& forces);
+private:
+    /**
+     * Determine whether the neighbor list needs to be rebuilt for the current reduced positions.
+     */
+    bool needNeighborListRebuild(double paddedCutoff, ThreadPool& threads);
+    void threadComputeForce(ThreadPool& threads, int threadIndex, double lambda);
+    double calculateOnePairIxn(int siteI, int siteJ, double lambdaScale, double softcore, std::vector<Vec3>& forces) const;
+    CpuNeighborList neighborList;
+    CpuExclusions exclusions;
+    AlignedArray<float> posq;
+    std::vector<Vec3> reducedPositions;
+    std::vector<Vec3> neighborListPositions;
+    Vec3 neighborListBoxVectors[3];
+    double neighborListCutoff;
+    std::vector<std::vector<Vec3> > threadForce;
+    std::vector<double> threadEnergy;
+    std::atomic<int> atomicCounter;
+};
+
+} // namespace OpenMM
+
+#endif // __CpuAmoebaVdwForce_H__
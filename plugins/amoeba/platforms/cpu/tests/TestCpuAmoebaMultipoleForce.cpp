@@ -0,0 +1,99 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuAmoebaTests.h"
+#include "TestAmoebaMultipoleForce.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+
+// Build a periodic box of small polar molecules and check that the CPU platform matches the Reference platform.
+
+void testCompareToReference(AmoebaMultipoleForce::PolarizationType polarizationType) {
+    const int moleculesPerSide = 6;
+    const int numMolecules = moleculesPerSide*moleculesPerSide*moleculesPerSide;
+    const double boxSize = 2.5;
+    const double spacing = boxSize/moleculesPerSide;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    AmoebaMultipoleForce* force = new AmoebaMultipoleForce();
+    force->setNonbondedMethod(AmoebaMultipoleForce::PME);
+    force->setPolarizationType(polarizationType);
+    force->setCutoffDistance(0.8);
+    force->setMutualInducedTargetEpsilon(1e-8);
+    force->setMutualInducedMaxIterations(500);
+    force->setEwaldErrorTolerance(1e-4);
+    system.addForce(force);
+    vector<double> dipole = {0.0, 0.0, 0.01};
+    vector<double> quadrupole = {0.0005, 0.0, 0.0, 0.0, 0.0005, 0.0, 0.0, 0.0, -0.001};
+    double polarity = 0.001;
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        int first = 2*i;
+        system.addParticle(16.0);
+        system.addParticle(1.0);
+        force->addMultipole(-0.3, dipole, quadrupole, AmoebaMultipoleForce::ZOnly, first+1, -1, -1, 0.39, pow(polarity, 1.0/6.0), polarity);
+        force->addMultipole(0.3, dipole, quadrupole, AmoebaMultipoleForce::ZOnly, first, -1, -1, 0.39, pow(polarity, 1.0/6.0), polarity);
+        for (int j = 0; j < 2; j++) {
+            force->setCovalentMap(first+j, AmoebaMultipoleForce::Covalent12, {first+1-j});
+            force->setCovalentMap(first+j, AmoebaMultipoleForce::PolarizationCovalent11, {first+1-j});
+        }
+        Vec3 center = Vec3(i%moleculesPerSide, (i/moleculesPerSide)%moleculesPerSide, i/(moleculesPerSide*moleculesPerSide))*spacing;
+        center += Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5)*0.1;
+        Vec3 bond = Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5);
+        bond *= 0.1/sqrt(bond.dot(bond));
+        positions.push_back(center);
+        positions.push_back(center+bond);
+    }
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    Context referenceContext(system, integrator1, Platform::getPlatformByName("Reference"));
+    Context cpuContext(system, integrator2, platform);
+    referenceContext.setPositions(positions);
+    cpuContext.setPositions(positions);
+    State referenceState = referenceContext.getState(State::Forces | State::Energy);
+    State cpuState = cpuContext.getState(State::Forces | State::Energy);
+    ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), cpuState.getPotentialEnergy(), 1e-5);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceState.getForces()[i], cpuState.getForces()[i], 1e-4);
+    vector<Vec3> referenceDipoles, cpuDipoles;
+    force->getInducedDipoles(referenceContext, referenceDipoles);
+    force->getInducedDipoles(cpuContext, cpuDipoles);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(referenceDipoles[i], cpuDipoles[i], 1e-4);
+}
+
+void runPlatformTests() {
+    testCompareToReference(AmoebaMultipoleForce::Direct);
+    testCompareToReference(AmoebaMultipoleForce::Mutual);
+    testCompareToReference(AmoebaMultipoleForce::Extrapolated);
+}
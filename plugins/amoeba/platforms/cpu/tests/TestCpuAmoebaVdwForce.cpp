@@ -0,0 +1,86 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuAmoebaTests.h"
+#include "TestAmoebaVdwForce.h"
+#include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
+
+// Check that the CPU platform matches the Reference platform as particles move, both while the neighbor list
+// can be reused and after it must be rebuilt.
+
+void testCompareToReference() {
+    const int particlesPerSide = 8;
+    const int numParticles = particlesPerSide*particlesPerSide*particlesPerSide;
+    const double boxSize = 2.2;
+    const double spacing = boxSize/particlesPerSide;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    AmoebaVdwForce* force = new AmoebaVdwForce();
+    force->setNonbondedMethod(AmoebaVdwForce::CutoffPeriodic);
+    force->setCutoffDistance(0.9);
+    system.addForce(force);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        force->addParticle(i, 0.3+0.05*(i%3), 0.2+0.1*(i%2), 1.0);
+        Vec3 pos = Vec3(i%particlesPerSide, (i/particlesPerSide)%particlesPerSide, i/(particlesPerSide*particlesPerSide))*spacing;
+        positions.push_back(pos+Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5)*0.1);
+    }
+    for (int i = 0; i < numParticles; i += 2) {
+        force->setParticleExclusions(i, {i, i+1});
+        force->setParticleExclusions(i+1, {i, i+1});
+    }
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    Context referenceContext(system, integrator1, Platform::getPlatformByName("Reference"));
+    Context cpuContext(system, integrator2, platform);
+    for (int step = 0; step < 8; step++) {
+        // Take several small steps, then one large enough to require rebuilding the neighbor list.
+
+        double displacement = (step == 5 ? 0.2 : 0.005);
+        for (Vec3& pos : positions)
+            pos += Vec3(genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5, genrand_real2(sfmt)-0.5)*displacement;
+        referenceContext.setPositions(positions);
+        cpuContext.setPositions(positions);
+        State referenceState = referenceContext.getState(State::Forces | State::Energy);
+        State cpuState = cpuContext.getState(State::Forces | State::Energy);
+        ASSERT_EQUAL_TOL(referenceState.getPotentialEnergy(), cpuState.getPotentialEnergy(), 1e-5);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(referenceState.getForces()[i], cpuState.getForces()[i], 1e-5);
+    }
+}
+
+void runPlatformTests() {
+    testCompareToReference();
+}
@@ -31,6 +31,7 @@
 #include "openmm/OpenMMException.h"
 
 using namespace OpenMM;
+using namespace std;
 
 #ifdef OPENMM_BUILDING_STATIC_LIBRARY
 static void registerPlatforms() {
@@ -39,27 +40,41 @@ extern "C" OPENMM_EXPORT void registerPlatforms() {
 #endif
 }
 
-#ifdef OPENMM_BUILDING_STATIC_LIBRARY
-static void registerKernelFactories() {
-#else
-extern "C" OPENMM_EXPORT void registerKernelFactories() {
-#endif
+static void registerAmoebaReferenceKernels() {
     for (int i = 0; i < Platform::getNumPlatforms(); i++) {
         Platform& platform = Platform::getPlatform(i);
         if (dynamic_cast<ReferencePlatform*>(&platform) != NULL) {
-             AmoebaReferenceKernelFactory* factory = new AmoebaReferenceKernelFactory();
-             platform.registerKernelFactory(CalcAmoebaTorsionTorsionForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaVdwForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaMultipoleForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaGeneralizedKirkwoodForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcAmoebaWcaDispersionForceKernel::Name(), factory);
-             platform.registerKernelFactory(CalcHippoNonbondedForceKernel::Name(), factory);
+             // Platforms derived from ReferencePlatform (such as the CPU platform) may already have faster
+             // versions of some kernels registered by another plugin.  Only fill in the ones that are missing.
+
+             AmoebaReferenceKernelFactory* factory = NULL;
+             vector<string> kernelNames = {CalcAmoebaTorsionTorsionForceKernel::Name(), CalcAmoebaVdwForceKernel::Name(),
+                     CalcAmoebaMultipoleForceKernel::Name(), CalcAmoebaGeneralizedKirkwoodForceKernel::Name(),
+                     CalcAmoebaWcaDispersionForceKernel::Name(), CalcHippoNonbondedForceKernel::Name()};
+             for (const string& name : kernelNames) {
+                 if (!platform.supportsKernels(vector<string>(1, name))) {
+                     if (factory == NULL)
+                         factory = new AmoebaReferenceKernelFactory();
+                     platform.registerKernelFactory(name, factory);
+                 }
+             }
         }
     }
 }
 
+#ifdef OPENMM_BUILDING_STATIC_LIBRARY
+static void registerKernelFactories() {
+#else
+extern "C" OPENMM_EXPORT void registerKernelFactories() {
+#endif
+    registerAmoebaReferenceKernels();
+}
+
 extern "C" OPENMM_EXPORT void registerAmoebaReferenceKernelFactories() {
-    registerKernelFactories();
+    // Other plugins also export registerKernelFactories(), so call the local function directly
+    // to avoid the call being resolved to a different library.
+
+    registerAmoebaReferenceKernels();
 }
 
 KernelImpl* AmoebaReferenceKernelFactory::createKernelImpl(std::string name, const Platform& platform, ContextImpl& context) const {
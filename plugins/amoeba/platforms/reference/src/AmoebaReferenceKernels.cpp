@@ -314,7 +314,7 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
 
     } else if (usePme) {
 
-        AmoebaReferencePmeMultipoleForce* amoebaReferencePmeMultipoleForce = new AmoebaReferencePmeMultipoleForce();
+        AmoebaReferencePmeMultipoleForce* amoebaReferencePmeMultipoleForce = createPmeMultipoleForce(context);
         amoebaReferencePmeMultipoleForce->setAlphaEwald(alphaEwald);
         amoebaReferencePmeMultipoleForce->setCutoffDistance(cutoffDistance);
         amoebaReferencePmeMultipoleForce->setPmeGridDimensions(pmeGridDimension);
@@ -349,6 +349,10 @@ AmoebaReferenceMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::setupAmo
 
 }
 
+AmoebaReferencePmeMultipoleForce* ReferenceCalcAmoebaMultipoleForceKernel::createPmeMultipoleForce(ContextImpl& context) {
+    return new AmoebaReferencePmeMultipoleForce();
+}
+
 double ReferenceCalcAmoebaMultipoleForceKernel::execute(ContextImpl& context, bool includeForces, bool includeEnergy) {
 
     AmoebaReferenceMultipoleForce* amoebaReferenceMultipoleForce = setupAmoebaReferenceMultipoleForce(context);
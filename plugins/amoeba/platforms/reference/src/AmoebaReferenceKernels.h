@@ -170,6 +170,15 @@ public:
      */
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
 
+protected:
+    /**
+     * Create the object that computes the multipole interactions when PME is used.  Subclasses may
+     * override this to supply an optimized implementation.
+     *
+     * @param context        the current context
+     */
+    virtual AmoebaReferencePmeMultipoleForce* createPmeMultipoleForce(ContextImpl& context);
+
 private:
 
     int numMultipoles;
@@ -243,7 +243,7 @@ void AmoebaReferenceMultipoleForce::setupScaleMaps(const vector< vector< vector<
 double AmoebaReferenceMultipoleForce::getMultipoleScaleFactor(unsigned int particleI, unsigned int particleJ, ScaleType scaleType) const
 {
 
-    MapIntRealOpenMM  scaleMap   = _scaleMaps[particleI][scaleType];
+    const MapIntRealOpenMM& scaleMap = _scaleMaps[particleI][scaleType];
     MapIntRealOpenMMCI isPresent = scaleMap.find(particleJ);
     if (isPresent != scaleMap.end()) {
         return isPresent->second;
@@ -1004,6 +1004,10 @@ void AmoebaReferenceMultipoleForce::convergeInduceDipolesByDIIS(const vector<Mul
 
 }
 
+void AmoebaReferenceMultipoleForce::convergeMutualInducedDipoles(const vector<MultipoleParticleData>& particleData, vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleField) {
+    convergeInduceDipolesByDIIS(particleData, updateInducedDipoleField);
+}
+
 void AmoebaReferenceMultipoleForce::computeDIISCoefficients(const vector<vector<Vec3> >& prevErrors, vector<double>& coefficients) const {
     int steps = coefficients.size();
     if (steps == 1) {
@@ -1076,7 +1080,7 @@ void AmoebaReferenceMultipoleForce::calculateInducedDipoles(const vector<Multipo
     // UpdateInducedDipoleFieldStruct contains induced dipole, fixed multipole fields and fields
     // due to other induced dipoles at each site
     if (getPolarizationType() == AmoebaReferenceMultipoleForce::Mutual)
-        convergeInduceDipolesByDIIS(particleData, updateInducedDipoleField);
+        convergeMutualInducedDipoles(particleData, updateInducedDipoleField);
     else if (getPolarizationType() == AmoebaReferenceMultipoleForce::Extrapolated)
         convergeInduceDipolesByExtrapolation(particleData, updateInducedDipoleField);
 }
@@ -5080,6 +5084,14 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const
                                                                            const MultipoleParticleData& particleJ,
                                                                            double dscale, double pscale)
 {
+    calculateFixedMultipoleFieldPairIxn(particleI, particleJ, dscale, pscale, _fixedMultipoleField, _fixedMultipoleFieldPolar);
+}
+
+void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI,
+                                                                           const MultipoleParticleData& particleJ,
+                                                                           double dscale, double pscale,
+                                                                           vector<Vec3>& field, vector<Vec3>& fieldPolar) const
+{
 
     unsigned int iIndex    = particleI.particleIndex;
     unsigned int jIndex    = particleJ.particleIndex;
@@ -5159,11 +5171,11 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleFieldPairIxn(const
     // increment the field at each site due to this interaction
 
 
-    _fixedMultipoleField[iIndex]      += fim - fid;
-    _fixedMultipoleField[jIndex]      += fjm - fjd;
+    field[iIndex]      += fim - fid;
+    field[jIndex]      += fjm - fjd;
 
-    _fixedMultipoleFieldPolar[iIndex] += fim - fip;
-    _fixedMultipoleFieldPolar[jIndex] += fjm - fjp;
+    fieldPolar[iIndex] += fim - fip;
+    fieldPolar[jIndex] += fjm - fjp;
 }
 
 void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleField(const vector<MultipoleParticleData>& particleData)
@@ -5193,6 +5205,11 @@ void AmoebaReferencePmeMultipoleForce::calculateFixedMultipoleField(const vector
 
     // include direct space fixed multipole fields
 
+    calculateDirectFixedMultipoleField(particleData);
+}
+
+void AmoebaReferencePmeMultipoleForce::calculateDirectFixedMultipoleField(const vector<MultipoleParticleData>& particleData)
+{
     this->AmoebaReferenceMultipoleForce::calculateFixedMultipoleField(particleData);
 }
 
@@ -6067,11 +6084,7 @@ void AmoebaReferencePmeMultipoleForce::calculateInducedDipoleFields(const vector
 
     // Add fields from direct space interactions.
 
-    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
-        for (unsigned int jj = ii + 1; jj < particleData.size(); jj++) {
-            calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], updateInducedDipoleFields);
-        }
-    }
+    calculateDirectInducedDipoleFields(particleData, updateInducedDipoleFields);
 
     // reciprocal space ixns
 
@@ -6151,6 +6164,16 @@ void AmoebaReferencePmeMultipoleForce::calculateInducedDipoleFields(const vector
     }
 }
 
+void AmoebaReferencePmeMultipoleForce::calculateDirectInducedDipoleFields(const vector<MultipoleParticleData>& particleData,
+                                                                           vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields)
+{
+    for (unsigned int ii = 0; ii < particleData.size(); ii++) {
+        for (unsigned int jj = ii + 1; jj < particleData.size(); jj++) {
+            calculateDirectInducedDipolePairIxns(particleData[ii], particleData[jj], updateInducedDipoleFields);
+        }
+    }
+}
+
 void AmoebaReferencePmeMultipoleForce::calculateDirectInducedDipolePairIxn(unsigned int iIndex, unsigned int jIndex,
                                                                            double preFactor1, double preFactor2,
                                                                            const Vec3& delta,
@@ -6171,7 +6194,7 @@ void AmoebaReferencePmeMultipoleForce::calculateDirectInducedDipolePairIxn(unsig
 
 void AmoebaReferencePmeMultipoleForce::calculateDirectInducedDipolePairIxns(const MultipoleParticleData& particleI,
                                                                             const MultipoleParticleData& particleJ,
-                                                                            vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields)
+                                                                            vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields) const
 {
 
     // compute the real space portion of the Ewald summation
@@ -6750,8 +6773,8 @@ double AmoebaReferencePmeMultipoleForce::calculatePmeDirectElectrostaticPairIxn(
 
 }
 
-double AmoebaReferencePmeMultipoleForce::calculateElectrostatic(const vector<MultipoleParticleData>& particleData,
-                                                                vector<Vec3>& torques, vector<Vec3>& forces)
+double AmoebaReferencePmeMultipoleForce::calculateDirectElectrostatic(const vector<MultipoleParticleData>& particleData,
+                                                                      vector<Vec3>& torques, vector<Vec3>& forces)
 {
     double energy = 0.0;
     vector<double> scaleFactors(LAST_SCALE_TYPE_INDEX);
@@ -6775,6 +6798,15 @@ double AmoebaReferencePmeMultipoleForce::calculateElectrostatic(const vector<Mul
             }
         }
     }
+    return energy;
+}
+
+double AmoebaReferencePmeMultipoleForce::calculateElectrostatic(const vector<MultipoleParticleData>& particleData,
+                                                                vector<Vec3>& torques, vector<Vec3>& forces)
+{
+    // loop over particle pairs for direct space interactions
+
+    double energy = calculateDirectElectrostatic(particleData, torques, forces);
 
     // The polarization energy
     calculatePmeSelfTorque(particleData, torques);
@@ -1028,6 +1028,15 @@ protected:
      */
     void convergeInduceDipolesByDIIS(const std::vector<MultipoleParticleData>& particleData,
                                      std::vector<UpdateInducedDipoleFieldStruct>& calculateInducedDipoleField);
+
+    /**
+     * Converge mutual induced dipoles.  The default implementation uses DIIS.
+     *
+     * @param particleData              vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     */
+    virtual void convergeMutualInducedDipoles(const std::vector<MultipoleParticleData>& particleData,
+                                              std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
     
     /**
      * Use DIIS to compute the weighting coefficients for the new induced dipoles.
@@ -1459,7 +1468,7 @@ public:
      */
      void setPeriodicBoxSize(OpenMM::Vec3* vectors);
 
-private:
+protected:
 
     static const int AMOEBA_PME_ORDER;
     static const double SQRT_PI;
@@ -1538,6 +1547,21 @@ private:
      */
     void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
                                              double dscale, double pscale);
+
+    /**
+     * Calculate direct-space field at site I due fixed multipoles at site J and vice versa, accumulating
+     * the result into the supplied arrays rather than the member fields.
+     * 
+     * @param particleI               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle I
+     * @param particleJ               positions and parameters (charge, labFrame dipoles, quadrupoles, ...) for particle J
+     * @param dScale                  d-scale value for i-j interaction
+     * @param pScale                  p-scale value for i-j interaction
+     * @param field                   fixed multipole field to be updated
+     * @param fieldPolar              fixed multipole polar field to be updated
+     */
+    void calculateFixedMultipoleFieldPairIxn(const MultipoleParticleData& particleI, const MultipoleParticleData& particleJ,
+                                             double dscale, double pscale,
+                                             std::vector<Vec3>& field, std::vector<Vec3>& fieldPolar) const;
     
     /**
      * Calculate fixed multipole fields.
@@ -1547,6 +1571,14 @@ private:
      */
     void calculateFixedMultipoleField(const vector<MultipoleParticleData>& particleData);
 
+    /**
+     * Calculate the direct space contribution to the fixed multipole fields.  This is called from
+     * calculateFixedMultipoleField() after the reciprocal space and self terms have been recorded.
+     *
+     * @param particleData vector particle data
+     */
+    virtual void calculateDirectFixedMultipoleField(const vector<MultipoleParticleData>& particleData);
+
     /**
      * This is called from computeAmoebaBsplines().  It calculates the spline coefficients for a single atom along a single axis.
      * 
@@ -1648,7 +1680,17 @@ private:
      */
     void calculateDirectInducedDipolePairIxns(const MultipoleParticleData& particleI,
                                               const MultipoleParticleData& particleJ,
-                                              std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
+                                              std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields) const;
+
+    /**
+     * Add the direct space contribution to the induced dipole fields.  This is called from
+     * calculateInducedDipoleFields() after the fields have been zeroed.
+     *
+     * @param particleData              vector of particle positions and parameters (charge, labFrame dipoles, quadrupoles, ...)
+     * @param updateInducedDipoleFields vector of UpdateInducedDipoleFieldStruct containing input induced dipoles and output fields
+     */
+    virtual void calculateDirectInducedDipoleFields(const std::vector<MultipoleParticleData>& particleData,
+                                                    std::vector<UpdateInducedDipoleFieldStruct>& updateInducedDipoleFields);
 
     /**
      * Initialize induced dipoles
@@ -1712,6 +1754,19 @@ private:
                                                   const std::vector<double>& scalingFactors,
                                                   std::vector<Vec3>& forces, std::vector<Vec3>& torques) const;
 
+    /**
+     * Calculate the direct space electrostatic energy, forces, and torques.
+     * 
+     * @param particleData            vector of parameters (charge, labFrame dipoles, quadrupoles, ...) for particles
+     * @param torques                 output torques
+     * @param forces                  output forces 
+     *
+     * @return energy
+     */
+    virtual double calculateDirectElectrostatic(const std::vector<MultipoleParticleData>& particleData,
+                                                std::vector<OpenMM::Vec3>& torques,
+                                                std::vector<OpenMM::Vec3>& forces);
+
     /**
      * Calculate reciprocal space energy/force/torque for dipole interaction.
      * 
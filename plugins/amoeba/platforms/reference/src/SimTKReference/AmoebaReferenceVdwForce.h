@@ -115,7 +115,7 @@ public:
     double calculateForceAndEnergy(int numParticles, double lambda, const std::vector<OpenMM::Vec3>& particlePositions, 
                                    const NeighborList& neighborList, std::vector<OpenMM::Vec3>& forces) const;
          
-private:
+protected:
     // taper coefficient indices
     static const int C3=0;
     static const int C4=1;
@@ -35,6 +35,7 @@
 #include "CpuPmeKernels.h"
 #include "SimTKOpenMMRealType.h"
 #include "openmm/internal/hardware.h"
+#include "openmm/internal/timer.h"
 #include "openmm/internal/vectorize.h"
 #include "openmm/OpenMMException.h"
 #include <cmath>
@@ -49,11 +50,13 @@ using namespace std;
 static const int PME_ORDER = 5;
 
 bool CpuCalcDispersionPmeReciprocalForceKernel::hasInitializedThreads = false;
-int CpuCalcDispersionPmeReciprocalForceKernel::numThreads = 0;
+int CpuCalcDispersionPmeReciprocalForceKernel::defaultNumThreads = 0;
 
-static void spreadCharge(float* posq, float* grid, int gridx, int gridy, int gridz, int numParticles, Vec3* periodicBoxVectors, Vec3* recipBoxVectors,
-        atomic<int>& atomicCounter, const float epsilonFactor, int threadIndex, int numThreads, bool deterministic) {
-    float temp[4];
+/**
+ * Find the grid point each atom is nearest to, and its fractional offset from that point.
+ */
+static void computeGridIndices(float* posq, int* gridIndex, float* gridOffset, int gridx, int gridy, int gridz, int start, int end,
+        Vec3* periodicBoxVectors, Vec3* recipBoxVectors) {
     fvec4 boxSize((float) periodicBoxVectors[0][0], (float) periodicBoxVectors[1][1], (float) periodicBoxVectors[2][2], 0);
     fvec4 invBoxSize((float) recipBoxVectors[0][0], (float) recipBoxVectors[1][1], (float) recipBoxVectors[2][2], 0);
     fvec4 recipBoxVec0((float) recipBoxVectors[0][0], (float) recipBoxVectors[0][1], (float) recipBoxVectors[0][2], 0);
@@ -61,107 +64,154 @@ static void spreadCharge(float* posq, float* grid, int gridx, int gridy, int gri
     fvec4 recipBoxVec2((float) recipBoxVectors[2][0], (float) recipBoxVectors[2][1], (float) recipBoxVectors[2][2], 0);
     fvec4 gridSize(gridx, gridy, gridz, 0);
     ivec4 gridSizeInt(gridx, gridy, gridz, 0);
-    fvec4 one(1);
-    fvec4 scale(1.0f/(PME_ORDER-1));
     float posInBox[4] = {0,0,0,0};
-    memset(grid, 0, sizeof(float)*gridx*gridy*gridz);
-
-    const int groupSize = max(1, numParticles / (10 * numThreads));
-    int start = groupSize * threadIndex;
-    while (true) {
-        if (!deterministic)
-            start = atomicCounter.fetch_add(groupSize);
-
-        if (start >= numParticles)
-            break;
-
-        int end = min(start + groupSize, numParticles);
-        for (int i = start; i < end; ++i) {
-            // Find the position relative to the nearest grid point.
-
-            fvec4 pos(&posq[4*i]);
-            (pos-boxSize*floor(pos*invBoxSize)).store(posInBox);
-            fvec4 t = posInBox[0]*recipBoxVec0 + posInBox[1]*recipBoxVec1 + posInBox[2]*recipBoxVec2;
-            t = (t-floor(t))*gridSize;
-            ivec4 ti = t;
-            fvec4 dr = t-ti;
-            ivec4 gridIndex = ti-(gridSizeInt&ti==gridSizeInt);
-
-            // Compute the B-spline coefficients.
-
-            fvec4 data[PME_ORDER];
-            data[PME_ORDER-1] = 0.0f;
-            data[1] = dr;
-            data[0] = one-dr;
-            for (int j = 3; j < PME_ORDER; j++) {
-                fvec4 div(1.0f/(j-1));
-                data[j-1] = div*dr*data[j-2];
-                for (int k = 1; k < j-1; k++)
-                    data[j-k-1] = div*((dr+k)*data[j-k-2]+(fvec4(j-k)-dr)*data[j-k-1]);
-                data[0] = div*(one-dr)*data[0];
-            }
-            data[PME_ORDER-1] = scale*dr*data[PME_ORDER-2];
-            for (int j = 1; j < (PME_ORDER-1); j++)
-                data[PME_ORDER-j-1] = scale*((dr+j)*data[PME_ORDER-j-2]+(fvec4(PME_ORDER-j)-dr)*data[PME_ORDER-j-1]);
-            data[0] = scale*(one-dr)*data[0];
-
-            // Spread the charges.
+    for (int i = start; i < end; ++i) {
+        fvec4 pos(&posq[4*i]);
+        (pos-boxSize*floor(pos*invBoxSize)).store(posInBox);
+        fvec4 t = posInBox[0]*recipBoxVec0 + posInBox[1]*recipBoxVec1 + posInBox[2]*recipBoxVec2;
+        t = (t-floor(t))*gridSize;
+        ivec4 ti = t;
+        (t-ti).store(&gridOffset[4*i]);
+        (ti-(gridSizeInt&ti==gridSizeInt)).store(&gridIndex[4*i]);
+    }
+}
 
-            int gridIndexX = gridIndex[0];
-            int gridIndexY = gridIndex[1];
-            int gridIndexZ = gridIndex[2];
-            if (gridIndexX < 0)
-                return; // This happens when a simulation blows up and coordinates become NaN.
-            int zindex[PME_ORDER];
-            for (int j = 0; j < PME_ORDER; j++) {
-                zindex[j] = gridIndexZ+j;
-                zindex[j] -= (zindex[j] >= gridz ? gridz : 0);
-            }
-            float charge = epsilonFactor*posq[4*i+3];
-            fvec4 zdata0to3(data[0][2], data[1][2], data[2][2], data[3][2]);
-            float zdata4 = data[4][2];
-            if (gridIndexZ+4 < gridz) {
-                for (int ix = 0; ix < PME_ORDER; ix++) {
-                    int xbase = gridIndexX+ix;
-                    xbase -= (xbase >= gridx ? gridx : 0);
-                    xbase = xbase*gridy*gridz;
-                    float xdata = charge*data[ix][0];
-                    for (int iy = 0; iy < PME_ORDER; iy++) {
-                        int ybase = gridIndexY+iy;
-                        ybase -= (ybase >= gridy ? gridy : 0);
-                        ybase = xbase + ybase*gridz;
-                        float multiplier = xdata*data[iy][1];
-                        fvec4 add0to3 = zdata0to3*multiplier;
-                        (fvec4(&grid[ybase+gridIndexZ])+add0to3).store(&grid[ybase+gridIndexZ]);
-                        grid[ybase+zindex[4]] += multiplier*zdata4;
-                    }
+/**
+ * Spread the charges of a set of atoms onto a slab of the grid.  The slab begins at X index slabStart
+ * and must include room for the PME_ORDER-1 planes beyond the last X index of any atom.
+ */
+static void spreadCharge(float* posq, float* grid, const int* gridIndex, const float* gridOffset, const vector<int>& atoms,
+        int slabStart, int gridy, int gridz, const float epsilonFactor) {
+    float temp[4];
+    fvec4 one(1);
+    fvec4 scale(1.0f/(PME_ORDER-1));
+    for (int i : atoms) {
+        fvec4 dr(&gridOffset[4*i]);
+
+        // Compute the B-spline coefficients.
+
+        fvec4 data[PME_ORDER];
+        data[PME_ORDER-1] = 0.0f;
+        data[1] = dr;
+        data[0] = one-dr;
+        for (int j = 3; j < PME_ORDER; j++) {
+            fvec4 div(1.0f/(j-1));
+            data[j-1] = div*dr*data[j-2];
+            for (int k = 1; k < j-1; k++)
+                data[j-k-1] = div*((dr+k)*data[j-k-2]+(fvec4(j-k)-dr)*data[j-k-1]);
+            data[0] = div*(one-dr)*data[0];
+        }
+        data[PME_ORDER-1] = scale*dr*data[PME_ORDER-2];
+        for (int j = 1; j < (PME_ORDER-1); j++)
+            data[PME_ORDER-j-1] = scale*((dr+j)*data[PME_ORDER-j-2]+(fvec4(PME_ORDER-j)-dr)*data[PME_ORDER-j-1]);
+        data[0] = scale*(one-dr)*data[0];
+
+        // Spread the charges.  X indices are relative to the start of the slab, so they never wrap.
+
+        int gridIndexX = gridIndex[4*i]-slabStart;
+        int gridIndexY = gridIndex[4*i+1];
+        int gridIndexZ = gridIndex[4*i+2];
+        int zindex[PME_ORDER];
+        for (int j = 0; j < PME_ORDER; j++) {
+            zindex[j] = gridIndexZ+j;
+            zindex[j] -= (zindex[j] >= gridz ? gridz : 0);
+        }
+        float charge = epsilonFactor*posq[4*i+3];
+        fvec4 zdata0to3(data[0][2], data[1][2], data[2][2], data[3][2]);
+        float zdata4 = data[4][2];
+        if (gridIndexZ+4 < gridz) {
+            for (int ix = 0; ix < PME_ORDER; ix++) {
+                int xbase = (gridIndexX+ix)*gridy*gridz;
+                float xdata = charge*data[ix][0];
+                for (int iy = 0; iy < PME_ORDER; iy++) {
+                    int ybase = gridIndexY+iy;
+                    ybase -= (ybase >= gridy ? gridy : 0);
+                    ybase = xbase + ybase*gridz;
+                    float multiplier = xdata*data[iy][1];
+                    fvec4 add0to3 = zdata0to3*multiplier;
+                    (fvec4(&grid[ybase+gridIndexZ])+add0to3).store(&grid[ybase+gridIndexZ]);
+                    grid[ybase+zindex[4]] += multiplier*zdata4;
                 }
             }
-            else {
-                for (int ix = 0; ix < PME_ORDER; ix++) {
-                    int xbase = gridIndexX+ix;
-                    xbase -= (xbase >= gridx ? gridx : 0);
-                    xbase = xbase*gridy*gridz;
-                    float xdata = charge*data[ix][0];
-                    for (int iy = 0; iy < PME_ORDER; iy++) {
-                        int ybase = gridIndexY+iy;
-                        ybase -= (ybase >= gridy ? gridy : 0);
-                        ybase = xbase + ybase*gridz;
-                        float multiplier = xdata*data[iy][1];
-                        fvec4 add0to3 = zdata0to3*multiplier;
-                        add0to3.store(temp);
-                        grid[ybase+zindex[0]] += temp[0];
-                        grid[ybase+zindex[1]] += temp[1];
-                        grid[ybase+zindex[2]] += temp[2];
-                        grid[ybase+zindex[3]] += temp[3];
-                        grid[ybase+zindex[4]] += multiplier*zdata4;
-                    }
+        }
+        else {
+            for (int ix = 0; ix < PME_ORDER; ix++) {
+                int xbase = (gridIndexX+ix)*gridy*gridz;
+                float xdata = charge*data[ix][0];
+                for (int iy = 0; iy < PME_ORDER; iy++) {
+                    int ybase = gridIndexY+iy;
+                    ybase -= (ybase >= gridy ? gridy : 0);
+                    ybase = xbase + ybase*gridz;
+                    float multiplier = xdata*data[iy][1];
+                    fvec4 add0to3 = zdata0to3*multiplier;
+                    add0to3.store(temp);
+                    grid[ybase+zindex[0]] += temp[0];
+                    grid[ybase+zindex[1]] += temp[1];
+                    grid[ybase+zindex[2]] += temp[2];
+                    grid[ybase+zindex[3]] += temp[3];
+                    grid[ybase+zindex[4]] += multiplier*zdata4;
                 }
             }
         }
+    }
+}
+
+/**
+ * Spread charges using a decomposition of the grid into slabs along the X axis.  Each thread owns
+ * one slab, spreads the atoms whose grid index falls inside it into a private buffer that also covers
+ * the PME_ORDER-1 planes past its end, and then sums the planes it owns from every buffer that overlaps
+ * them.  Every grid point is summed in a fixed order, so the result does not depend on thread timing.
+ *
+ * This contains two barriers, so the main thread must resume the workers once to begin spreading and
+ * once to begin summing.  slabAtoms holds numThreads*numThreads lists: element t*numThreads+s holds the
+ * atoms from thread t's range that fall inside slab s.
+ */
+static void spreadChargeBySlab(ThreadPool& threads, int index, int numThreads, float* posq, float* realGrid, vector<vector<float> >& slabGrid,
+        vector<vector<int> >& slabAtoms, vector<int>& gridIndex, vector<float>& gridOffset, int gridx, int gridy, int gridz,
+        int numParticles, Vec3* periodicBoxVectors, Vec3* recipBoxVectors, const float epsilonFactor) {
+    // Find the grid index of each atom in this thread's range, and sort them into slabs.  Atoms with
+    // invalid indices (which happens when a simulation blows up and coordinates become NaN) are skipped.
+
+    int atomStart = (index*numParticles)/numThreads;
+    int atomEnd = ((index+1)*numParticles)/numThreads;
+    computeGridIndices(posq, &gridIndex[0], &gridOffset[0], gridx, gridy, gridz, atomStart, atomEnd, periodicBoxVectors, recipBoxVectors);
+    for (int slab = 0; slab < numThreads; slab++)
+        slabAtoms[index*numThreads+slab].clear();
+    for (int i = atomStart; i < atomEnd; i++) {
+        int x = gridIndex[4*i];
+        if (x >= 0 && x < gridx)
+            slabAtoms[index*numThreads+((x+1)*numThreads-1)/gridx].push_back(i);
+    }
+    threads.syncThreads();
+
+    // Spread the atoms that fall inside this thread's slab.
 
-        if (deterministic)
-            start += groupSize * numThreads;
+    int slabStart = (index*gridx)/numThreads;
+    int slabEnd = ((index+1)*gridx)/numThreads;
+    int slabPlanes = slabEnd-slabStart+PME_ORDER-1;
+    memset(&slabGrid[index][0], 0, sizeof(float)*slabPlanes*gridy*gridz);
+    for (int t = 0; t < numThreads; t++)
+        spreadCharge(posq, &slabGrid[index][0], &gridIndex[0], &gridOffset[0], slabAtoms[t*numThreads+index], slabStart, gridy, gridz, epsilonFactor);
+    threads.syncThreads();
+
+    // Sum the planes owned by this thread.
+
+    int planeSize = gridy*gridz;
+    int vecSize = 4*(planeSize/4);
+    for (int x = slabStart; x < slabEnd; x++) {
+        float* plane = &realGrid[x*planeSize];
+        memset(plane, 0, sizeof(float)*planeSize);
+        for (int t = 0; t < numThreads; t++) {
+            int start = (t*gridx)/numThreads;
+            int planes = ((t+1)*gridx)/numThreads-start+PME_ORDER-1;
+            for (int local = (x-start+gridx)%gridx; local < planes; local += gridx) {
+                const float* source = &slabGrid[t][local*planeSize];
+                for (int i = 0; i < vecSize; i += 4)
+                    (fvec4(&plane[i])+fvec4(&source[i])).store(&plane[i]);
+                for (int i = vecSize; i < planeSize; i++)
+                    plane[i] += source[i];
+            }
+        }
     }
 }
 
@@ -425,22 +475,30 @@ static void* threadBody(void* args) {
 
 void CpuCalcPmeReciprocalForceKernel::initialize(int xsize, int ysize, int zsize, int numParticles, double alpha, bool deterministic) {
     if (!hasInitializedThreads) {
-        numThreads = getNumProcessors();
+        defaultNumThreads = getNumProcessors();
         char* threadsEnv = getenv("OPENMM_CPU_THREADS");
         if (threadsEnv != NULL)
-            stringstream(threadsEnv) >> numThreads;
+            stringstream(threadsEnv) >> defaultNumThreads;
         fftwf_init_threads();
         hasInitializedThreads = true;
     }
+    if (numThreads <= 0)
+        numThreads = defaultNumThreads;
     threadEnergy.resize(numThreads);
     gridx = findFFTDimension(xsize, false);
     gridy = findFFTDimension(ysize, false);
     gridz = findFFTDimension(zsize, true);
     this->numParticles = numParticles;
     this->alpha = alpha;
-    this->deterministic = deterministic;
     force.resize(4*numParticles);
     recipEterm.resize(gridx*gridy*gridz);
+    gridIndex.resize(4*numParticles);
+    gridOffset.resize(4*numParticles);
+    slabAtoms.resize(numThreads*numThreads);
+    for (int i = 0; i < numThreads; i++) {
+        int slabPlanes = ((i+1)*gridx)/numThreads-(i*gridx)/numThreads+PME_ORDER-1;
+        slabGrid.push_back(vector<float>(slabPlanes*gridy*gridz+3));
+    }
     
     // Initialize threads.
     
@@ -459,9 +517,7 @@ void CpuCalcPmeReciprocalForceKernel::initialize(int xsize, int ysize, int zsize
     
     // Initialize FFTW.
     
-    for (int i = 0; i < numThreads; i++)
-        tempGrid.push_back((float*) fftwf_malloc(sizeof(float)*(gridx*gridy*gridz+3)));
-    realGrid = tempGrid[0];
+    realGrid = (float*) fftwf_malloc(sizeof(float)*(gridx*gridy*gridz+3));
     complexGrid = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex)*gridx*gridy*(gridz/2+1));
     fftwf_plan_with_nthreads(numThreads);
     forwardFFT = fftwf_plan_dft_r2c_3d(gridx, gridy, gridz, realGrid, complexGrid, FFTW_MEASURE);
@@ -533,8 +589,8 @@ CpuCalcPmeReciprocalForceKernel::~CpuCalcPmeReciprocalForceKernel() {
     pthread_mutex_destroy(&lock);
     pthread_cond_destroy(&startCondition);
     pthread_cond_destroy(&endCondition);
-    for (auto grid : tempGrid)
-        fftwf_free(grid);
+    if (realGrid != NULL)
+        fftwf_free(realGrid);
     if (complexGrid != NULL)
         fftwf_free(complexGrid);
     if (hasCreatedPlan) {
@@ -556,9 +612,11 @@ void CpuCalcPmeReciprocalForceKernel::runMainThread() {
         pthread_cond_wait(&startCondition, &lock);
         if (isDeleted)
             break;
+        double startTime = getCurrentTime();
         posq = io->getPosq();
-        atomicCounter = 0;
-        threads.execute([&] (ThreadPool& threads, int threadIndex) { runWorkerThread(threads, threadIndex); }); // Signal threads to perform charge spreading.
+        threads.execute([&] (ThreadPool& threads, int threadIndex) { runWorkerThread(threads, threadIndex); }); // Signal threads to bin the atoms by slab.
+        threads.waitForThreads();
+        threads.resumeThreads(); // Signal threads to spread the charges within their slabs.
         threads.waitForThreads();
         threads.resumeThreads(); // Signal threads to sum the charge grids.
         threads.waitForThreads();
@@ -579,6 +637,7 @@ void CpuCalcPmeReciprocalForceKernel::runMainThread() {
         atomicCounter = 0;
         threads.resumeThreads(); // Signal threads to interpolate forces.
         threads.waitForThreads();
+        lastComputationTime = getCurrentTime()-startTime;
         isFinished = true;
         lastBoxVectors[0] = periodicBoxVectors[0];
         lastBoxVectors[1] = periodicBoxVectors[1];
@@ -591,22 +650,12 @@ void CpuCalcPmeReciprocalForceKernel::runMainThread() {
 void CpuCalcPmeReciprocalForceKernel::runWorkerThread(ThreadPool& threads, int index) {
     int gridxStart = (index*gridx)/numThreads;
     int gridxEnd = ((index+1)*gridx)/numThreads;
-    int gridSize = (gridx*gridy*gridz+3)/4;
-    int gridStart = 4*((index*gridSize)/numThreads);
-    int gridEnd = 4*(((index+1)*gridSize)/numThreads);
     int complexSize = gridx*gridy*(gridz/2+1);
     int complexStart = std::max(1, ((index*complexSize)/numThreads));
     int complexEnd = (((index+1)*complexSize)/numThreads);
     const float epsilonFactor = sqrt(ONE_4PI_EPS0);
-    spreadCharge(posq, tempGrid[index], gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor, index, numThreads, deterministic);
-    threads.syncThreads();
-    int numGrids = tempGrid.size();
-    for (int i = gridStart; i < gridEnd; i += 4) {
-        fvec4 sum(&realGrid[i]);
-        for (int j = 1; j < numGrids; j++)
-            sum += fvec4(&tempGrid[j][i]);
-        sum.store(&realGrid[i]);
-    }
+    spreadChargeBySlab(threads, index, numThreads, posq, realGrid, slabGrid, slabAtoms, gridIndex, gridOffset, gridx, gridy, gridz,
+            numParticles, periodicBoxVectors, recipBoxVectors, epsilonFactor);
     threads.syncThreads();
     if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
         computeReciprocalEterm(gridxStart, gridxEnd, gridx, gridy, gridz, recipEterm, alpha, bsplineModuli, periodicBoxVectors, recipBoxVectors);
@@ -666,6 +715,10 @@ void CpuCalcPmeReciprocalForceKernel::getPMEParameters(double& alpha, int& nx, i
     nz = gridz;
 }
 
+double CpuCalcPmeReciprocalForceKernel::getLastComputationTime() const {
+    return lastComputationTime;
+}
+
 int CpuCalcPmeReciprocalForceKernel::findFFTDimension(int minimum, bool isZ) {
     if (minimum < 1)
         return 1;
@@ -695,7 +748,7 @@ int CpuCalcPmeReciprocalForceKernel::findFFTDimension(int minimum, bool isZ) {
  */
 
 bool CpuCalcPmeReciprocalForceKernel::hasInitializedThreads = false;
-int CpuCalcPmeReciprocalForceKernel::numThreads = 0;
+int CpuCalcPmeReciprocalForceKernel::defaultNumThreads = 0;
 
 
 class CpuCalcDispersionPmeReciprocalForceKernel::ComputeTask : public ThreadPool::Task {
@@ -716,22 +769,30 @@ static void* dispersionThreadBody(void* args) {
 
 void CpuCalcDispersionPmeReciprocalForceKernel::initialize(int xsize, int ysize, int zsize, int numParticles, double alpha, bool deterministic) {
     if (!hasInitializedThreads) {
-        numThreads = getNumProcessors();
+        defaultNumThreads = getNumProcessors();
         char* threadsEnv = getenv("OPENMM_CPU_THREADS");
         if (threadsEnv != NULL)
-            stringstream(threadsEnv) >> numThreads;
+            stringstream(threadsEnv) >> defaultNumThreads;
         fftwf_init_threads();
         hasInitializedThreads = true;
     }
+    if (numThreads <= 0)
+        numThreads = defaultNumThreads;
     threadEnergy.resize(numThreads);
     gridx = findFFTDimension(xsize, false);
     gridy = findFFTDimension(ysize, false);
     gridz = findFFTDimension(zsize, true);
     this->numParticles = numParticles;
     this->alpha = alpha;
-    this->deterministic = deterministic;
     force.resize(4*numParticles);
     recipEterm.resize(gridx*gridy*gridz);
+    gridIndex.resize(4*numParticles);
+    gridOffset.resize(4*numParticles);
+    slabAtoms.resize(numThreads*numThreads);
+    for (int i = 0; i < numThreads; i++) {
+        int slabPlanes = ((i+1)*gridx)/numThreads-(i*gridx)/numThreads+PME_ORDER-1;
+        slabGrid.push_back(vector<float>(slabPlanes*gridy*gridz+3));
+    }
     
     // Initialize threads.
     
@@ -750,9 +811,7 @@ void CpuCalcDispersionPmeReciprocalForceKernel::initialize(int xsize, int ysize,
     
     // Initialize FFTW.
     
-    for (int i = 0; i < numThreads; i++)
-        tempGrid.push_back((float*) fftwf_malloc(sizeof(float)*(gridx*gridy*gridz+3)));
-    realGrid = tempGrid[0];
+    realGrid = (float*) fftwf_malloc(sizeof(float)*(gridx*gridy*gridz+3));
     complexGrid = (fftwf_complex*) fftwf_malloc(sizeof(fftwf_complex)*gridx*gridy*(gridz/2+1));
     fftwf_plan_with_nthreads(numThreads);
     forwardFFT = fftwf_plan_dft_r2c_3d(gridx, gridy, gridz, realGrid, complexGrid, FFTW_MEASURE);
@@ -824,8 +883,8 @@ CpuCalcDispersionPmeReciprocalForceKernel::~CpuCalcDispersionPmeReciprocalForceK
     pthread_mutex_destroy(&lock);
     pthread_cond_destroy(&startCondition);
     pthread_cond_destroy(&endCondition);
-    for (auto grid : tempGrid)
-        fftwf_free(grid);
+    if (realGrid != NULL)
+        fftwf_free(realGrid);
     if (complexGrid != NULL)
         fftwf_free(complexGrid);
     if (hasCreatedPlan) {
@@ -847,10 +906,12 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runMainThread() {
         pthread_cond_wait(&startCondition, &lock);
         if (isDeleted)
             break;
+        double startTime = getCurrentTime();
         posq = io->getPosq();
         ComputeTask task(*this);
-        atomicCounter = 0;
-        threads.execute(task); // Signal threads to perform charge spreading.
+        threads.execute(task); // Signal threads to bin the atoms by slab.
+        threads.waitForThreads();
+        threads.resumeThreads(); // Signal threads to spread the charges within their slabs.
         threads.waitForThreads();
         threads.resumeThreads(); // Signal threads to sum the charge grids.
         threads.waitForThreads();
@@ -871,6 +932,7 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runMainThread() {
         atomicCounter = 0;
         threads.resumeThreads(); // Signal threads to interpolate forces.
         threads.waitForThreads();
+        lastComputationTime = getCurrentTime()-startTime;
         isFinished = true;
         lastBoxVectors[0] = periodicBoxVectors[0];
         lastBoxVectors[1] = periodicBoxVectors[1];
@@ -883,22 +945,12 @@ void CpuCalcDispersionPmeReciprocalForceKernel::runMainThread() {
 void CpuCalcDispersionPmeReciprocalForceKernel::runWorkerThread(ThreadPool& threads, int index) {
     int gridxStart = (index*gridx)/numThreads;
     int gridxEnd = ((index+1)*gridx)/numThreads;
-    int gridSize = (gridx*gridy*gridz+3)/4;
-    int gridStart = 4*((index*gridSize)/numThreads);
-    int gridEnd = 4*(((index+1)*gridSize)/numThreads);
     int complexSize = gridx*gridy*(gridz/2+1);
     int complexStart = std::max(1, ((index*complexSize)/numThreads));
     int complexEnd = (((index+1)*complexSize)/numThreads);
     const float epsilonFactor = 1.0f;
-    spreadCharge(posq, tempGrid[index], gridx, gridy, gridz, numParticles, periodicBoxVectors, recipBoxVectors, atomicCounter, epsilonFactor, index, numThreads, deterministic);
-    threads.syncThreads();
-    int numGrids = tempGrid.size();
-    for (int i = gridStart; i < gridEnd; i += 4) {
-        fvec4 sum(&realGrid[i]);
-        for (int j = 1; j < numGrids; j++)
-            sum += fvec4(&tempGrid[j][i]);
-        sum.store(&realGrid[i]);
-    }
+    spreadChargeBySlab(threads, index, numThreads, posq, realGrid, slabGrid, slabAtoms, gridIndex, gridOffset, gridx, gridy, gridz,
+            numParticles, periodicBoxVectors, recipBoxVectors, epsilonFactor);
     threads.syncThreads();
     if (lastBoxVectors[0] != periodicBoxVectors[0] || lastBoxVectors[1] != periodicBoxVectors[1] || lastBoxVectors[2] != periodicBoxVectors[2]) {
         computeReciprocalDispersionEterm(gridxStart, gridxEnd, gridx, gridy, gridz, recipEterm, alpha, bsplineModuli, periodicBoxVectors, recipBoxVectors);
@@ -960,6 +1012,10 @@ void CpuCalcDispersionPmeReciprocalForceKernel::getPMEParameters(double& alpha,
     nz = gridz;
 }
 
+double CpuCalcDispersionPmeReciprocalForceKernel::getLastComputationTime() const {
+    return lastComputationTime;
+}
+
 int CpuCalcDispersionPmeReciprocalForceKernel::findFFTDimension(int minimum, bool isZ) {
     if (minimum < 1)
         return 1;
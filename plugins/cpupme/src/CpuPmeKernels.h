@@ -51,8 +51,16 @@ namespace OpenMM {
 
 class OPENMM_EXPORT_PME CpuCalcPmeReciprocalForceKernel : public CalcPmeReciprocalForceKernel {
 public:
-    CpuCalcPmeReciprocalForceKernel(const std::string& name, const Platform& platform) : CalcPmeReciprocalForceKernel(name, platform),
-            hasCreatedPlan(false), isDeleted(false), realGrid(NULL), complexGrid(NULL) {
+    /**
+     * Create a kernel.
+     *
+     * @param name        the name of the kernel
+     * @param platform    the Platform that created it
+     * @param numThreads  the number of threads to use.  If this is 0, the number of processors (or the value
+     *                    of the OPENMM_CPU_THREADS environment variable) is used.
+     */
+    CpuCalcPmeReciprocalForceKernel(const std::string& name, const Platform& platform, int numThreads=0) : CalcPmeReciprocalForceKernel(name, platform),
+            numThreads(numThreads), lastComputationTime(0.0), hasCreatedPlan(false), isDeleted(false), realGrid(NULL), complexGrid(NULL) {
     }
     /**
      * Initialize the kernel.
@@ -62,7 +70,8 @@ public:
      * @param gridz        the z size of the PME grid
      * @param numParticles the number of particles in the system
      * @param alpha        the Ewald blending parameter
-     * @param deterministic whether it should attempt to make the resulting forces deterministic
+     * @param deterministic whether it should attempt to make the resulting forces deterministic.  This is
+     *                     ignored, since charges are always spread in a fixed order.
      */
     void initialize(int xsize, int ysize, int zsize, int numParticles, double alpha, bool deterministic);
     ~CpuCalcPmeReciprocalForceKernel();
@@ -102,23 +111,29 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
+    /**
+     * Get the wall clock time (in seconds) spent on the most recent computation.
+     */
+    double getLastComputationTime() const;
 private:
     /**
      * Select a size for one grid dimension that FFTW can handle efficiently.
      */
     int findFFTDimension(int minimum, bool isZ);
     static bool hasInitializedThreads;
-    static int numThreads;
-    int gridx, gridy, gridz, numParticles;
-    double alpha;
-    bool deterministic;
+    static int defaultNumThreads;
+    int numThreads, gridx, gridy, gridz, numParticles;
+    double alpha, lastComputationTime;
     bool hasCreatedPlan, isFinished, isDeleted;
     std::vector<float> force;
     std::vector<float> bsplineModuli[3];
     std::vector<float> recipEterm;
     Vec3 lastBoxVectors[3];
     std::vector<float> threadEnergy;
-    std::vector<float*> tempGrid;
+    std::vector<std::vector<float> > slabGrid;
+    std::vector<std::vector<int> > slabAtoms;
+    std::vector<int> gridIndex;
+    std::vector<float> gridOffset;
     float* realGrid;
     fftwf_complex* complexGrid;
     fftwf_plan forwardFFT, backwardFFT;
@@ -144,8 +159,16 @@ private:
 
 class OPENMM_EXPORT_PME CpuCalcDispersionPmeReciprocalForceKernel : public CalcDispersionPmeReciprocalForceKernel {
 public:
-    CpuCalcDispersionPmeReciprocalForceKernel(const std::string& name, const Platform& platform) : CalcDispersionPmeReciprocalForceKernel(name, platform),
-            hasCreatedPlan(false), isDeleted(false), realGrid(NULL), complexGrid(NULL)  {
+    /**
+     * Create a kernel.
+     *
+     * @param name        the name of the kernel
+     * @param platform    the Platform that created it
+     * @param numThreads  the number of threads to use.  If this is 0, the number of processors (or the value
+     *                    of the OPENMM_CPU_THREADS environment variable) is used.
+     */
+    CpuCalcDispersionPmeReciprocalForceKernel(const std::string& name, const Platform& platform, int numThreads=0) : CalcDispersionPmeReciprocalForceKernel(name, platform),
+            numThreads(numThreads), lastComputationTime(0.0), hasCreatedPlan(false), isDeleted(false), realGrid(NULL), complexGrid(NULL)  {
     }
     /**
      * Initialize the kernel.
@@ -155,7 +178,8 @@ public:
      * @param gridz        the z size of the PME grid
      * @param numParticles the number of particles in the system
      * @param alpha        the Ewald blending parameter
-     * @param deterministic whether it should attempt to make the resulting forces deterministic
+     * @param deterministic whether it should attempt to make the resulting forces deterministic.  This is
+     *                     ignored, since charges are always spread in a fixed order.
      */
     void initialize(int xsize, int ysize, int zsize, int numParticles, double alpha, bool deterministic);
     ~CpuCalcDispersionPmeReciprocalForceKernel();
@@ -195,6 +219,10 @@ public:
      * @param nz      the number of grid points along the Z axis
      */
     void getPMEParameters(double& alpha, int& nx, int& ny, int& nz) const;
+    /**
+     * Get the wall clock time (in seconds) spent on the most recent computation.
+     */
+    double getLastComputationTime() const;
 private:
     class ComputeTask;
     /**
@@ -202,17 +230,19 @@ private:
      */
     int findFFTDimension(int minimum, bool isZ);
     static bool hasInitializedThreads;
-    static int numThreads;
-    int gridx, gridy, gridz, numParticles;
-    double alpha;
-    bool deterministic;
+    static int defaultNumThreads;
+    int numThreads, gridx, gridy, gridz, numParticles;
+    double alpha, lastComputationTime;
     bool hasCreatedPlan, isFinished, isDeleted;
     std::vector<float> force;
     std::vector<float> bsplineModuli[3];
     std::vector<float> recipEterm;
     Vec3 lastBoxVectors[3];
     std::vector<float> threadEnergy;
-    std::vector<float*> tempGrid;
+    std::vector<std::vector<float> > slabGrid;
+    std::vector<std::vector<int> > slabAtoms;
+    std::vector<int> gridIndex;
+    std::vector<float> gridOffset;
     float* realGrid;
     fftwf_complex* complexGrid;
     fftwf_plan forwardFFT, backwardFFT;
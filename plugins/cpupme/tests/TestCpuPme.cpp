@@ -565,7 +565,7 @@ void test_water2_dpme_energies_forces_no_exclusions() {
 }
 
 
-void testPME(bool triclinic) {
+void testPME(bool triclinic, int numThreads) {
     // Create a cloud of random point charges.
 
     const int numParticles = 51;
@@ -613,7 +613,7 @@ void testPME(bool triclinic) {
     double alpha;
     int gridx, gridy, gridz;
     NonbondedForceImpl::calcPMEParameters(system, *force, alpha, gridx, gridy, gridz, false);
-    CpuCalcPmeReciprocalForceKernel pme(CalcPmeReciprocalForceKernel::Name(), platform);
+    CpuCalcPmeReciprocalForceKernel pme(CalcPmeReciprocalForceKernel::Name(), platform, numThreads);
     IO io;
     double sumSquaredCharges = 0;
     for (int i = 0; i < numParticles; i++) {
@@ -627,17 +627,19 @@ void testPME(bool triclinic) {
     }
     double ewaldSelfEnergy = -ONE_4PI_EPS0*alpha*sumSquaredCharges/sqrt(M_PI);
     pme.initialize(gridx, gridy, gridz, numParticles, alpha, true);
-    pme.beginComputation(io, boxVectors, true);
-    double energy = pme.finishComputation(io);
 
-    // See if they match.
-    
-    ASSERT_EQUAL_TOL(refState.getPotentialEnergy(), energy+ewaldSelfEnergy, 1e-3);
-    for (int i = 0; i < numParticles; i++)
-        ASSERT_EQUAL_VEC(refState.getForces()[i], Vec3(io.force[4*i], io.force[4*i+1], io.force[4*i+2]), 1e-3);
+    // See if they match.  Do it twice, since the second computation skips recomputing the scale factors.
+
+    for (int repeat = 0; repeat < 2; repeat++) {
+        pme.beginComputation(io, boxVectors, true);
+        double energy = pme.finishComputation(io);
+        ASSERT_EQUAL_TOL(refState.getPotentialEnergy(), energy+ewaldSelfEnergy, 1e-3);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(refState.getForces()[i], Vec3(io.force[4*i], io.force[4*i+1], io.force[4*i+2]), 1e-3);
+    }
 }
 
-void testLJPME(bool triclinic) {
+void testLJPME(bool triclinic, int numThreads) {
     // Create a cloud of random LJ particles.
 
     const int numParticles = 51;
@@ -683,7 +685,7 @@ void testLJPME(bool triclinic) {
     
     // Now compute them with the optimized kernel.
     
-    CpuCalcDispersionPmeReciprocalForceKernel pme(CalcDispersionPmeReciprocalForceKernel::Name(), platform);
+    CpuCalcDispersionPmeReciprocalForceKernel pme(CalcDispersionPmeReciprocalForceKernel::Name(), platform, numThreads);
     IO io;
     double ewaldSelfEnergy = 0;
     for (int i = 0; i < numParticles; i++) {
@@ -696,14 +698,16 @@ void testLJPME(bool triclinic) {
         ewaldSelfEnergy += pow(alpha*sigma, 6.0) * epsilon / 3.0;
     }
     pme.initialize(64, 64, 64, numParticles, alpha, true);
-    pme.beginComputation(io, boxVectors, true);
-    double energy = pme.finishComputation(io);
 
-    // See if they match.
-    
-    ASSERT_EQUAL_TOL(refState.getPotentialEnergy(), energy+ewaldSelfEnergy, 1e-3);
-    for (int i = 0; i < numParticles; i++)
-        ASSERT_EQUAL_VEC(refState.getForces()[i], Vec3(io.force[4*i], io.force[4*i+1], io.force[4*i+2]), 1e-3);
+    // See if they match.  Do it twice, since the second computation skips recomputing the scale factors.
+
+    for (int repeat = 0; repeat < 2; repeat++) {
+        pme.beginComputation(io, boxVectors, true);
+        double energy = pme.finishComputation(io);
+        ASSERT_EQUAL_TOL(refState.getPotentialEnergy(), energy+ewaldSelfEnergy, 1e-3);
+        for (int i = 0; i < numParticles; i++)
+            ASSERT_EQUAL_VEC(refState.getForces()[i], Vec3(io.force[4*i], io.force[4*i+1], io.force[4*i+2]), 1e-3);
+    }
 }
 
 int main(int argc, char* argv[]) {
@@ -712,10 +716,15 @@ int main(int argc, char* argv[]) {
             cout << "CPU is not supported.  Exiting." << endl;
             return 0;
         }
-        testPME(false);
-        testPME(true);
-        testLJPME(false);
-        testLJPME(true);
+        // Use several thread counts, so the slab decomposition is exercised regardless of the
+        // number of cores.
+
+        for (int numThreads : {1, 3, 8}) {
+            testPME(false, numThreads);
+            testPME(true, numThreads);
+            testLJPME(false, numThreads);
+            testLJPME(true, numThreads);
+        }
         test_water2_dpme_energies_forces_no_exclusions();
     }
     catch(const exception& e) {
@@ -0,0 +1,142 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+/**
+ * This tests the CPU PME plugin running inside the CPU platform, with and without dedicated
+ * reciprocal space threads.
+ */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/VerletIntegrator.h"
+#include "CpuPlatform.h"
+#include "../src/CpuPmeKernelFactory.h"
+#include "../src/CpuPmeKernels.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <map>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+CpuPlatform platform;
+
+void testPmeThreads(NonbondedForce::NonbondedMethod method) {
+    const int numMolecules = 300;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* force = new NonbondedForce();
+    force->setNonbondedMethod(method);
+    force->setCutoffDistance(0.9);
+    vector<Vec3> positions;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(1.0);
+        force->addParticle(-0.5, 0.2, 1.0);
+        force->addParticle(0.5, 0.1, 0.5);
+        force->addException(2*i, 2*i+1, -0.1, 0.15, 0.5);
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+    }
+    system.addForce(force);
+
+    // Compute the forces with the Reference platform, and with the CPU platform both with and
+    // without dedicated reciprocal space threads.  Scale the box on each iteration so the kernels
+    // must recompute their scale factors.
+
+    VerletIntegrator integrator1(0.001);
+    VerletIntegrator integrator2(0.001);
+    VerletIntegrator integrator3(0.001);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "3";
+    Context context1(system, integrator1, platform, properties);
+    properties[CpuPlatform::CpuPmeThreads()] = "1";
+    Context context2(system, integrator2, platform, properties);
+    Context reference(system, integrator3, Platform::getPlatformByName("Reference"));
+    ASSERT_EQUAL("1", platform.getPropertyValue(context2, CpuPlatform::CpuPmeThreads()));
+    const int numIterations = 3;
+    for (int i = 0; i < numIterations; i++) {
+        double scale = 1.0+0.02*i;
+        vector<Vec3> scaledPositions;
+        for (const Vec3& pos : positions)
+            scaledPositions.push_back(pos*scale);
+        for (Context* context : {&context1, &context2, &reference}) {
+            context->setPeriodicBoxVectors(Vec3(boxSize*scale, 0, 0), Vec3(0, boxSize*scale, 0), Vec3(0, 0, boxSize*scale));
+            context->setPositions(scaledPositions);
+        }
+        State refState = reference.getState(State::Forces | State::Energy);
+        State state1 = context1.getState(State::Forces | State::Energy);
+        State state2 = context2.getState(State::Forces | State::Energy);
+        ASSERT_EQUAL_TOL(refState.getPotentialEnergy(), state1.getPotentialEnergy(), 1e-3);
+        ASSERT_EQUAL_TOL(state1.getPotentialEnergy(), state2.getPotentialEnergy(), 1e-5);
+        for (int j = 0; j < system.getNumParticles(); j++) {
+            ASSERT_EQUAL_VEC(refState.getForces()[j], state1.getForces()[j], 5e-3);
+            ASSERT_EQUAL_VEC(state1.getForces()[j], state2.getForces()[j], 1e-5);
+        }
+    }
+
+    // The timing statistics should include the time reported by the optimized reciprocal space kernel.
+
+    double directSpaceTime, reciprocalSpaceTime, waitTime;
+    long long numEvaluations;
+    platform.getPmeTimings(context2, directSpaceTime, reciprocalSpaceTime, waitTime, numEvaluations);
+    ASSERT_EQUAL(numIterations, numEvaluations);
+    ASSERT(directSpaceTime > 0.0);
+    ASSERT(reciprocalSpaceTime > 0.0);
+    ASSERT(waitTime >= 0.0);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        if (!CpuPlatform::isProcessorSupported() || !CpuCalcPmeReciprocalForceKernel::isProcessorSupported()) {
+            cout << "CPU is not supported.  Exiting." << endl;
+            return 0;
+        }
+        CpuPmeKernelFactory* factory = new CpuPmeKernelFactory();
+        platform.registerKernelFactory(CalcPmeReciprocalForceKernel::Name(), factory);
+        platform.registerKernelFactory(CalcDispersionPmeReciprocalForceKernel::Name(), factory);
+        testPmeThreads(NonbondedForce::PME);
+        testPmeThreads(NonbondedForce::LJPME);
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
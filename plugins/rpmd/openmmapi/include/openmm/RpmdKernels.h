@@ -84,6 +84,15 @@ public:
      * Compute the kinetic energy.
      */
     virtual double computeKineticEnergy(ContextImpl& context, const RPMDIntegrator& integrator) = 0;
+    /**
+     * This is called whenever the state of the Context is changed from outside the integrator.  A value
+     * of State::Energy indicates that the System itself may have changed, for example because
+     * updateParametersInContext() was called on one of its Forces.  The default implementation does nothing.
+     *
+     * @param changed    the type of data that was changed
+     */
+    virtual void stateChanged(State::DataType changed) {
+    }
 };
 
 } // namespace OpenMM
@@ -77,6 +77,8 @@ void RPMDIntegrator::cleanup() {
 
 void RPMDIntegrator::stateChanged(State::DataType changed) {
     forcesAreValid = false;
+    if (context != NULL)
+        kernel.getAs<IntegrateRPMDStepKernel>().stateChanged(changed);
 }
 
 vector<string> RPMDIntegrator::getKernelNames() {
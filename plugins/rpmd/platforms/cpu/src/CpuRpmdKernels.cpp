@@ -0,0 +1,207 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuRpmdKernels.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/RPMDIntegrator.h"
+#include "openmm/internal/ContextImpl.h"
+#include <algorithm>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * This describes one force evaluation to be done by a copy Context.
+ */
+struct CpuRpmdForceTask {
+    const vector<Vec3>* positions;
+    vector<Vec3>* forces;
+    int groups;
+    bool computeVirtualSites;
+};
+
+CpuIntegrateRPMDStepKernel::~CpuIntegrateRPMDStepKernel() {
+    deleteCopyContexts();
+}
+
+void CpuIntegrateRPMDStepKernel::initialize(const System& system, const RPMDIntegrator& integrator) {
+    ReferenceIntegrateRPMDStepKernel::initialize(system, integrator);
+    createThreadData(data.threads.getNumThreads());
+    data.random.initialize(integrator.getRandomNumberSeed(), data.threads.getNumThreads());
+}
+
+void CpuIntegrateRPMDStepKernel::stateChanged(State::DataType changed) {
+    // The copy Contexts have their own copies of all force field parameters, so if the System
+    // may have changed, they need to be recreated.
+
+    if (changed == State::Energy)
+        deleteCopyContexts();
+}
+
+void CpuIntegrateRPMDStepKernel::forEachParticleBlock(const function<void(int, int, int)>& task) {
+    const int numParticles = positions[0].size();
+    data.threads.execute([&] (ThreadPool& threads, int threadIndex) {
+        int start = threadIndex*numParticles/threads.getNumThreads();
+        int end = (threadIndex+1)*numParticles/threads.getNumThreads();
+        task(start, end, threadIndex);
+    });
+    data.threads.waitForThreads();
+}
+
+double CpuIntegrateRPMDStepKernel::getGaussianRandom(int threadIndex) {
+    return data.random.getGaussianRandom(threadIndex);
+}
+
+void CpuIntegrateRPMDStepKernel::createCopyContexts(ContextImpl& context, const RPMDIntegrator& integrator) {
+    // Divide the threads between the copy Contexts.  Each one also gets its share of the threads
+    // reserved for PME, as long as that leaves it at least one thread for everything else.
+
+    int numContexts = min(data.rpmdParallelCopies, (int) positions.size());
+    int totalThreads = data.threads.getNumThreads()+data.pmeThreads;
+    int threadsPerContext = max(1, totalThreads/numContexts);
+    int pmeThreadsPerContext = data.pmeThreads/numContexts;
+    if (pmeThreadsPerContext >= threadsPerContext)
+        pmeThreadsPerContext = 0;
+    Platform& platform = context.getPlatform();
+    map<string, string> properties;
+    for (const string& name : platform.getPropertyNames())
+        properties[name] = platform.getPropertyValue(context.getOwner(), name);
+    stringstream threadsProperty, pmeThreadsProperty;
+    threadsProperty << threadsPerContext;
+    pmeThreadsProperty << pmeThreadsPerContext;
+    properties[CpuPlatform::CpuThreads()] = threadsProperty.str();
+    properties[CpuPlatform::CpuPmeThreads()] = pmeThreadsProperty.str();
+    properties[CpuPlatform::CpuRpmdParallelCopies()] = "1";
+    for (int i = 0; i < numContexts; i++) {
+        // The copy Contexts are never used to take steps, but some Forces (such as RPMDMonteCarloBarostat)
+        // can only be created in a Context that uses an RPMDIntegrator.
+
+        RPMDIntegrator* copyIntegrator = new RPMDIntegrator(1, integrator.getTemperature(), integrator.getFriction(), integrator.getStepSize());
+        copyIntegrator->setApplyThermostat(integrator.getApplyThermostat());
+        copyIntegrators.push_back(copyIntegrator);
+        copyContexts.push_back(new Context(context.getSystem(), *copyIntegrator, platform, properties));
+    }
+    copyThreads = new ThreadPool(numContexts);
+    for (int i = 0; i < 3; i++)
+        copyBoxVectors[i] = Vec3();
+}
+
+void CpuIntegrateRPMDStepKernel::deleteCopyContexts() {
+    for (Context* copyContext : copyContexts)
+        delete copyContext;
+    for (Integrator* copyIntegrator : copyIntegrators)
+        delete copyIntegrator;
+    copyContexts.clear();
+    copyIntegrators.clear();
+    if (copyThreads != NULL)
+        delete copyThreads;
+    copyThreads = NULL;
+}
+
+void CpuIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const RPMDIntegrator& integrator) {
+    if (data.rpmdParallelCopies == 1) {
+        ReferenceIntegrateRPMDStepKernel::computeForces(context, integrator);
+        return;
+    }
+    if (copyContexts.size() == 0)
+        createCopyContexts(context, integrator);
+    const int totalCopies = positions.size();
+
+    // Let the main Context update its state for every copy, and find the contracted positions.
+
+    for (int i = 0; i < totalCopies; i++)
+        updateCopyState(context, i);
+    for (auto& g : groupsByCopies) {
+        int copies = g.first;
+        forEachParticleBlock([&] (int start, int end, int threadIndex) {
+            contractPositions(copies, start, end, threadIndex);
+        });
+    }
+
+    // Make the copy Contexts match the main one.
+
+    Vec3 box[3];
+    context.getPeriodicBoxVectors(box[0], box[1], box[2]);
+    bool boxChanged = (box[0] != copyBoxVectors[0] || box[1] != copyBoxVectors[1] || box[2] != copyBoxVectors[2]);
+    for (Context* copyContext : copyContexts) {
+        if (boxChanged)
+            copyContext->setPeriodicBoxVectors(box[0], box[1], box[2]);
+        for (auto& param : context.getParameters())
+            if (copyContext->getParameter(param.first) != param.second)
+                copyContext->setParameter(param.first, param.second);
+    }
+    for (int i = 0; i < 3; i++)
+        copyBoxVectors[i] = box[i];
+
+    // Build a list of every force evaluation, including the ones for contracted copies, and divide
+    // them between the copy Contexts.  Each Context always evaluates the same copies, which lets it
+    // reuse its neighbor list as much as possible.
+
+    vector<CpuRpmdForceTask> tasks;
+    for (int i = 0; i < totalCopies; i++)
+        tasks.push_back({&positions[i], &forces[i], groupsNotContracted, false});
+    for (auto& g : groupsByCopies) {
+        int copies = g.first;
+        for (int i = 0; i < copies; i++)
+            tasks.push_back({&contractedPositions[copies][i], &contractedForces[copies][i], g.second, true});
+    }
+    vector<string> errors(copyContexts.size());
+    copyThreads->execute([&] (ThreadPool& threads, int threadIndex) {
+        Context& copyContext = *copyContexts[threadIndex];
+        State state;
+        try {
+            for (int i = threadIndex; i < (int) tasks.size(); i += threads.getNumThreads()) {
+                copyContext.setPositions(*tasks[i].positions);
+                if (tasks[i].computeVirtualSites)
+                    copyContext.computeVirtualSites();
+                copyContext.getState(state, State::Forces, false, tasks[i].groups);
+                *tasks[i].forces = state.getForces();
+            }
+        }
+        catch (exception& ex) {
+            errors[threadIndex] = ex.what();
+        }
+    });
+    copyThreads->waitForThreads();
+    for (const string& error : errors)
+        if (error.size() > 0)
+            throw OpenMMException(error);
+
+    // Apply the forces from the contracted copies to the original ones.
+
+    for (auto& g : groupsByCopies) {
+        int copies = g.first;
+        forEachParticleBlock([&] (int start, int end, int threadIndex) {
+            addContractedForces(copies, start, end, threadIndex);
+        });
+    }
+}
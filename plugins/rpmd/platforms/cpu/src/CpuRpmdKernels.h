@@ -0,0 +1,83 @@
+#ifndef CPU_RPMD_KERNELS_H_
+#define CPU_RPMD_KERNELS_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "ReferenceRpmdKernels.h"
+#include "CpuPlatform.h"
+#include "openmm/Context.h"
+#include "openmm/internal/ThreadPool.h"
+
+namespace OpenMM {
+
+/**
+ * This kernel is invoked by RPMDIntegrator to take one time step, and to get and
+ * set the state of system copies.  The normal mode transforms are divided between
+ * threads.  If the RpmdParallelCopies property of the CpuPlatform is greater than 1,
+ * forces on different copies are also computed concurrently, each in its own Context.
+ */
+class CpuIntegrateRPMDStepKernel : public ReferenceIntegrateRPMDStepKernel {
+public:
+    CpuIntegrateRPMDStepKernel(const std::string& name, const Platform& platform, CpuPlatform::PlatformData& data) :
+            ReferenceIntegrateRPMDStepKernel(name, platform), data(data), copyThreads(NULL) {
+    }
+    ~CpuIntegrateRPMDStepKernel();
+    /**
+     * Initialize the kernel.
+     *
+     * @param system     the System this kernel will be applied to
+     * @param integrator the RPMDIntegrator this kernel will be used for
+     */
+    void initialize(const System& system, const RPMDIntegrator& integrator);
+    /**
+     * This is called whenever the state of the Context is changed from outside the integrator.
+     *
+     * @param changed    the type of data that was changed
+     */
+    void stateChanged(State::DataType changed);
+protected:
+    void computeForces(ContextImpl& context, const RPMDIntegrator& integrator);
+    void forEachParticleBlock(const std::function<void(int, int, int)>& task);
+    double getGaussianRandom(int threadIndex);
+private:
+    void createCopyContexts(ContextImpl& context, const RPMDIntegrator& integrator);
+    void deleteCopyContexts();
+    CpuPlatform::PlatformData& data;
+    std::vector<Context*> copyContexts;
+    std::vector<Integrator*> copyIntegrators;
+    ThreadPool* copyThreads;
+    Vec3 copyBoxVectors[3];
+};
+
+} // namespace OpenMM
+
+#endif /*CPU_RPMD_KERNELS_H_*/
@@ -0,0 +1,167 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CpuTests.h"
+#include "TestRpmd.h"
+#include "openmm/CustomExternalForce.h"
+
+extern "C" void registerRpmdReferenceKernelFactories();
+extern "C" void registerRpmdCpuKernelFactories();
+
+using namespace OpenMM;
+
+void testParallelCopies() {
+    const int gridSize = 3;
+    const int numMolecules = gridSize*gridSize*gridSize;
+    const int numParticles = numMolecules*3;
+    const int numCopies = 10;
+    const double spacing = 0.8;
+    const double cutoff = 1.0;
+    const double boxSize = spacing*(gridSize+1);
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setCutoffDistance(cutoff);
+    nonbonded->setNonbondedMethod(NonbondedForce::PME);
+    nonbonded->setForceGroup(1);
+    nonbonded->setReciprocalSpaceForceGroup(2);
+    system.addForce(nonbonded);
+    CustomExternalForce* external = new CustomExternalForce("k*(x^2+y^2+z^2)");
+    external->addGlobalParameter("k", 0.5);
+    system.addForce(external);
+
+    // Create a cloud of molecules, each with a virtual site.
+
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<vector<Vec3> > positions(numCopies, vector<Vec3>(numParticles));
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(1.0);
+        system.addParticle(2.0);
+        system.addParticle(0.0);
+        nonbonded->addParticle(-0.2, 0.2, 0.5);
+        nonbonded->addParticle(0.1, 0.2, 0.5);
+        nonbonded->addParticle(0.1, 0.1, 0.1);
+        nonbonded->addException(3*i, 3*i+1, 0, 1, 0);
+        nonbonded->addException(3*i, 3*i+2, 0, 1, 0);
+        nonbonded->addException(3*i+1, 3*i+2, 0, 1, 0);
+        bonds->addBond(3*i, 3*i+1, 0.2, 10000.0);
+        system.setVirtualSite(3*i+2, new TwoParticleAverageSite(3*i, 3*i+1, 0.5, 0.5));
+        for (int j = 0; j < 3; j++)
+            external->addParticle(3*i+j);
+    }
+    for (int copy = 0; copy < numCopies; copy++)
+        for (int i = 0; i < numMolecules; i++) {
+            Vec3 pos = Vec3(spacing*(i%gridSize+0.02*genrand_real2(sfmt)), spacing*((i/gridSize)%gridSize+0.02*genrand_real2(sfmt)), spacing*(i/(gridSize*gridSize)+0.02*genrand_real2(sfmt)));
+            positions[copy][3*i] = pos;
+            positions[copy][3*i+1] = Vec3(pos[0]+0.2, pos[1], pos[2]);
+        }
+
+    // Simulate it with copies evaluated one at a time, and with several copies evaluated at once.
+    // The trajectories should match.
+
+    map<int, int> contractions;
+    contractions[1] = 3;
+    contractions[2] = 1;
+    RPMDIntegrator integ1(numCopies, 300.0, 10.0, 0.0005, contractions);
+    RPMDIntegrator integ2(numCopies, 300.0, 10.0, 0.0005, contractions);
+    integ1.setApplyThermostat(false);
+    integ2.setApplyThermostat(false);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "4";
+    Context context1(system, integ1, platform, properties);
+    properties[CpuPlatform::CpuRpmdParallelCopies()] = "3";
+    Context context2(system, integ2, platform, properties);
+    ASSERT_EQUAL("1", platform.getPropertyValue(context1, CpuPlatform::CpuRpmdParallelCopies()));
+    ASSERT_EQUAL("3", platform.getPropertyValue(context2, CpuPlatform::CpuRpmdParallelCopies()));
+    for (int copy = 0; copy < numCopies; copy++) {
+        integ1.setPositions(copy, positions[copy]);
+        integ2.setPositions(copy, positions[copy]);
+    }
+    for (int iteration = 0; iteration < 3; iteration++) {
+        integ1.step(10);
+        integ2.step(10);
+        for (int copy = 0; copy < numCopies; copy++) {
+            State state1 = integ1.getState(copy, State::Positions | State::Velocities);
+            State state2 = integ2.getState(copy, State::Positions | State::Velocities);
+            for (int i = 0; i < numParticles; i++) {
+                ASSERT_EQUAL_VEC(state1.getPositions()[i], state2.getPositions()[i], 1e-4);
+                ASSERT_EQUAL_VEC(state1.getVelocities()[i], state2.getVelocities()[i], 1e-3);
+            }
+        }
+
+        // Change a global parameter and a force field parameter, and make sure the changes are seen
+        // by all copies.
+
+        if (iteration == 0) {
+            context1.setParameter("k", 2.0);
+            context2.setParameter("k", 2.0);
+        }
+        if (iteration == 1) {
+            for (int i = 0; i < numMolecules; i++)
+                nonbonded->setParticleParameters(3*i+2, 0.3, 0.1, 0.1);
+            nonbonded->updateParametersInContext(context1);
+            nonbonded->updateParametersInContext(context2);
+        }
+    }
+}
+
+void testParallelCopiesProperty() {
+    System system;
+    system.addParticle(1.0);
+    RPMDIntegrator integ(4, 300.0, 1.0, 0.001);
+    map<string, string> properties;
+    properties[CpuPlatform::CpuThreads()] = "2";
+    properties[CpuPlatform::CpuRpmdParallelCopies()] = "3";
+    ASSERT_EQUAL("1", platform.getPropertyDefaultValue(CpuPlatform::CpuRpmdParallelCopies()));
+    bool threw = false;
+    try {
+        Context context(system, integ, platform, properties);
+    }
+    catch (OpenMMException& ex) {
+        threw = true;
+    }
+    ASSERT(threw);
+}
+
+void runPlatformTests() {
+    testParallelCopies();
+    testParallelCopiesProperty();
+}
+
+void setupKernels(int argc, char* argv[]) {
+    initializeTests(argc, argv);
+    Platform::registerPlatform(&platform);
+    registerRpmdReferenceKernelFactories();
+    registerRpmdCpuKernelFactories();
+}
@@ -33,6 +33,7 @@
 #include "openmm/OpenMMException.h"
 #include "openmm/internal/ContextImpl.h"
 #include "SimTKOpenMMUtilities.h"
+#include <algorithm>
 
 using namespace OpenMM;
 using namespace std;
@@ -52,12 +53,49 @@ static vector<Vec3>& extractForces(ContextImpl& context) {
     return *data->forces;
 }
 
+/**
+ * The normal mode transforms are applied to blocks of this many particles at a time.  All three
+ * components of every particle in a block are transformed together.
+ */
+static const int ParticleBlockSize = 16;
+
+/**
+ * Copy the values for a list of particles from every copy into consecutive rows of a workspace, one
+ * row for each component of each particle.
+ */
+static void loadRows(const vector<vector<Vec3> >& values, const int* particles, int numParticles, double scale, t_complex* rows) {
+    const int numCopies = values.size();
+    for (int i = 0; i < numParticles; i++)
+        for (int component = 0; component < 3; component++) {
+            t_complex* row = &rows[(3*i+component)*numCopies];
+            for (int k = 0; k < numCopies; k++)
+                row[k] = t_complex(scale*values[k][particles[i]][component], 0.0);
+        }
+}
+
+/**
+ * Copy the real parts of rows created by loadRows() back to the original values.
+ */
+static void storeRows(vector<vector<Vec3> >& values, const int* particles, int numParticles, double scale, const t_complex* rows) {
+    const int numCopies = values.size();
+    for (int i = 0; i < numParticles; i++)
+        for (int component = 0; component < 3; component++) {
+            const t_complex* row = &rows[(3*i+component)*numCopies];
+            for (int k = 0; k < numCopies; k++)
+                values[k][particles[i]][component] = scale*row[k].re;
+        }
+}
+
+/**
+ * Perform the same FFT on every row of a workspace.
+ */
+static void transformRows(fftpack* fft, fftpack_direction direction, t_complex* rows, int numRows, int rowLength) {
+    for (int i = 0; i < numRows; i++)
+        fftpack_exec_1d(fft, direction, &rows[i*rowLength], &rows[i*rowLength]);
+}
+
 ReferenceIntegrateRPMDStepKernel::~ReferenceIntegrateRPMDStepKernel() {
-    if (fft != NULL)
-        fftpack_destroy(fft);
-    for (auto& c : contractionFFT)
-        if (c.second != NULL)
-            fftpack_destroy(c.second);
+    destroyThreadData();
 }
 
 void ReferenceIntegrateRPMDStepKernel::initialize(const System& system, const RPMDIntegrator& integrator) {
@@ -71,14 +109,15 @@ void ReferenceIntegrateRPMDStepKernel::initialize(const System& system, const RP
         velocities[i].resize(numParticles);
         forces[i].resize(numParticles);
     }
-    fftpack_init_1d(&fft, numCopies);
+    masses.resize(numParticles);
+    for (int i = 0; i < numParticles; i++)
+        masses[i] = system.getParticleMass(i);
     SimTKOpenMMUtilities::setRandomNumberSeed((unsigned int) integrator.getRandomNumberSeed());
     
     // Build a list of contractions.
     
     groupsNotContracted = -1;
     const map<int, int>& contractions = integrator.getContractions();
-    int maxContractedCopies = 0;
     for (auto& c : contractions) {
         int group = c.first;
         int copies = c.second;
@@ -87,13 +126,8 @@ void ReferenceIntegrateRPMDStepKernel::initialize(const System& system, const RP
         if (copies < 0 || copies > numCopies)
             throw OpenMMException("RPMDIntegrator: Number of copies for contraction cannot be greater than the total number of copies being simulated");
         if (copies != numCopies) {
-            if (groupsByCopies.find(copies) == groupsByCopies.end()) {
+            if (groupsByCopies.find(copies) == groupsByCopies.end())
                 groupsByCopies[copies] = 1<<group;
-                contractionFFT[copies] = NULL;
-                fftpack_init_1d(&contractionFFT[copies], copies);
-                if (copies > maxContractedCopies)
-                    maxContractedCopies = copies;
-            }
             else
                 groupsByCopies[copies] |= 1<<group;
             groupsNotContracted -= 1<<group;
@@ -103,188 +137,237 @@ void ReferenceIntegrateRPMDStepKernel::initialize(const System& system, const RP
     
     // Create workspace for doing contractions.
     
-    contractedPositions.resize(maxContractedCopies);
-    contractedForces.resize(maxContractedCopies);
-    for (int i = 0; i < maxContractedCopies; i++) {
-        contractedPositions[i].resize(numParticles);
-        contractedForces[i].resize(numParticles);
+    for (auto& g : groupsByCopies) {
+        int copies = g.first;
+        contractedPositions[copies].resize(copies, vector<Vec3>(numParticles));
+        contractedForces[copies].resize(copies, vector<Vec3>(numParticles));
+    }
+    createThreadData(1);
+}
+
+void ReferenceIntegrateRPMDStepKernel::createThreadData(int numThreads) {
+    destroyThreadData();
+    int numCopies = positions.size();
+    fft.resize(numThreads, NULL);
+    contractionFFT.resize(numThreads);
+    qWorkspace.resize(numThreads);
+    vWorkspace.resize(numThreads);
+    for (int i = 0; i < numThreads; i++) {
+        fftpack_init_1d(&fft[i], numCopies);
+        for (auto& g : groupsByCopies) {
+            int copies = g.first;
+            contractionFFT[i][copies] = NULL;
+            fftpack_init_1d(&contractionFFT[i][copies], copies);
+        }
+        qWorkspace[i].resize(ParticleBlockSize*3*numCopies);
+        vWorkspace[i].resize(ParticleBlockSize*3*numCopies);
     }
 }
 
+void ReferenceIntegrateRPMDStepKernel::destroyThreadData() {
+    for (fftpack* f : fft)
+        if (f != NULL)
+            fftpack_destroy(f);
+    for (auto& threadFFT : contractionFFT)
+        for (auto& c : threadFFT)
+            if (c.second != NULL)
+                fftpack_destroy(c.second);
+    fft.clear();
+    contractionFFT.clear();
+}
+
+void ReferenceIntegrateRPMDStepKernel::forEachParticleBlock(const function<void(int, int, int)>& task) {
+    task(0, masses.size(), 0);
+}
+
+double ReferenceIntegrateRPMDStepKernel::getGaussianRandom(int threadIndex) {
+    return SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
+}
+
 void ReferenceIntegrateRPMDStepKernel::execute(ContextImpl& context, const RPMDIntegrator& integrator, bool forcesAreValid) {
-    const int numCopies = positions.size();
-    const int numParticles = positions[0].size();
     const double dt = integrator.getStepSize();
     const double halfdt = 0.5*dt;
-    const System& system = context.getSystem();
-    vector<Vec3>& pos = extractPositions(context);
-    vector<Vec3>& vel = extractVelocities(context);
-    vector<Vec3>& f = extractForces(context);
+    const bool useThermostat = integrator.getApplyThermostat();
     
     // Loop over copies and compute the force on each one.
     
     if (!forcesAreValid)
         computeForces(context, integrator);
 
-    // Apply the PILE-L thermostat.
+    // Apply the PILE-L thermostat, update velocities, and evolve the free ring polymer.
+
+    computeModeCoefficients(integrator);
+    forEachParticleBlock([&] (int start, int end, int threadIndex) {
+        if (useThermostat)
+            applyThermostat(start, end, threadIndex);
+        advanceVelocities(start, end, halfdt);
+        propagateFreeRingPolymer(start, end, threadIndex);
+    });
+    
+    // Calculate forces based on the updated positions.
+    
+    computeForces(context, integrator);
+
+    // Update velocities and apply the PILE-L thermostat again.
+    
+    forEachParticleBlock([&] (int start, int end, int threadIndex) {
+        advanceVelocities(start, end, halfdt);
+        if (useThermostat)
+            applyThermostat(start, end, threadIndex);
+    });
     
-    vector<t_complex> v(numCopies);
-    vector<t_complex> q(numCopies);
+    // Update the time.
+    
+    context.setTime(context.getTime()+dt);
+}
+
+void ReferenceIntegrateRPMDStepKernel::computeModeCoefficients(const RPMDIntegrator& integrator) {
+    const int numCopies = positions.size();
     const double hbar = 1.054571628e-34*AVOGADRO/(1000*1e-12);
-    const double scale = 1.0/sqrt((double) numCopies);
-    const double nkT = numCopies*BOLTZ*integrator.getTemperature();
+    stepSize = integrator.getStepSize();
+    const double halfdt = 0.5*stepSize;
+    nkT = numCopies*BOLTZ*integrator.getTemperature();
     const double twown = 2.0*nkT/hbar;
-    const double c1_0 = exp(-halfdt*integrator.getFriction());
-    const double c2_0 = sqrt(1.0-c1_0*c1_0);
-    if (integrator.getApplyThermostat()) {
-        for (int particle = 0; particle < numParticles; particle++) {
-            if (system.getParticleMass(particle) == 0.0)
-                continue;
-            const double c3_0 = c2_0*sqrt(nkT/system.getParticleMass(particle));
+    centroidFriction = exp(-halfdt*integrator.getFriction());
+    centroidNoise = sqrt(1.0-centroidFriction*centroidFriction);
+    modeFrequency.resize(numCopies);
+    modeCos.resize(numCopies);
+    modeSin.resize(numCopies);
+    modeFriction.resize(numCopies);
+    modeNoise.resize(numCopies);
+    for (int k = 1; k < numCopies; k++) {
+        const double wk = twown*sin(k*M_PI/numCopies);
+        const double wt = wk*stepSize;
+        modeFrequency[k] = wk;
+        modeCos[k] = cos(wt);
+        modeSin[k] = sin(wt);
+    }
+
+    // The thermostat uses critical damping for all modes other than the centroid.
+
+    for (int k = 1; k <= numCopies/2; k++) {
+        const bool isCenter = (numCopies%2 == 0 && k == numCopies/2);
+        const double c1 = exp(-2.0*modeFrequency[k]*halfdt);
+        modeFriction[k] = c1;
+        modeNoise[k] = sqrt((1.0-c1*c1)/2) * (isCenter ? sqrt(2.0) : 1.0);
+    }
+}
+
+int ReferenceIntegrateRPMDStepKernel::findMassiveParticles(int start, int end, int* particles) const {
+    int numFound = 0;
+    for (int i = start; i < end; i++)
+        if (masses[i] != 0.0)
+            particles[numFound++] = i;
+    return numFound;
+}
+
+void ReferenceIntegrateRPMDStepKernel::applyThermostat(int start, int end, int threadIndex) {
+    const int numCopies = positions.size();
+    const double scale = 1.0/sqrt((double) numCopies);
+    t_complex* v = &vWorkspace[threadIndex][0];
+    int particles[ParticleBlockSize];
+    for (int blockStart = start; blockStart < end; blockStart += ParticleBlockSize) {
+        int numInBlock = findMassiveParticles(blockStart, min(end, blockStart+ParticleBlockSize), particles);
+        loadRows(velocities, particles, numInBlock, scale, v);
+        transformRows(fft[threadIndex], FFTPACK_FORWARD, v, 3*numInBlock, numCopies);
+        for (int i = 0; i < numInBlock; i++) {
+            const double noiseScale = sqrt(nkT/masses[particles[i]]);
+            const double c3_0 = centroidNoise*noiseScale;
             for (int component = 0; component < 3; component++) {
-                for (int k = 0; k < numCopies; k++)
-                    v[k] = t_complex(scale*velocities[k][particle][component], 0.0);
-                fftpack_exec_1d(fft, FFTPACK_FORWARD, &v[0], &v[0]);
+                t_complex* row = &v[(3*i+component)*numCopies];
 
                 // Apply a local Langevin thermostat to the centroid mode.
 
-                v[0].re = v[0].re*c1_0 + c3_0*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
+                row[0].re = row[0].re*centroidFriction + c3_0*getGaussianRandom(threadIndex);
 
                 // Use critical damping white noise for the remaining modes.
 
                 for (int k = 1; k <= numCopies/2; k++) {
                     const bool isCenter = (numCopies%2 == 0 && k == numCopies/2);
-                    const double wk = twown*sin(k*M_PI/numCopies);
-                    const double c1 = exp(-2.0*wk*halfdt);
-                    const double c2 = sqrt((1.0-c1*c1)/2) * (isCenter ? sqrt(2.0) : 1.0);
-                    const double c3 = c2*sqrt(nkT/system.getParticleMass(particle));
-                    double rand1 = c3*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-                    double rand2 = (isCenter ? 0.0 : c3*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
-                    v[k] = v[k]*c1 + t_complex(rand1, rand2);
+                    const double c1 = modeFriction[k];
+                    const double c3 = modeNoise[k]*noiseScale;
+                    double rand1 = c3*getGaussianRandom(threadIndex);
+                    double rand2 = (isCenter ? 0.0 : c3*getGaussianRandom(threadIndex));
+                    row[k] = row[k]*c1 + t_complex(rand1, rand2);
                     if (k < numCopies-k)
-                        v[numCopies-k] = v[numCopies-k]*c1 + t_complex(rand1, -rand2);
+                        row[numCopies-k] = row[numCopies-k]*c1 + t_complex(rand1, -rand2);
                 }
-                fftpack_exec_1d(fft, FFTPACK_BACKWARD, &v[0], &v[0]);
-                for (int k = 0; k < numCopies; k++)
-                    velocities[k][particle][component] = scale*v[k].re;
             }
         }
+        transformRows(fft[threadIndex], FFTPACK_BACKWARD, v, 3*numInBlock, numCopies);
+        storeRows(velocities, particles, numInBlock, scale, v);
     }
+}
 
-    // Update velocities.
-    
+void ReferenceIntegrateRPMDStepKernel::advanceVelocities(int start, int end, double dt) {
+    const int numCopies = positions.size();
     for (int i = 0; i < numCopies; i++)
-        for (int j = 0; j < numParticles; j++)
-            if (system.getParticleMass(j) != 0.0)
-                velocities[i][j] += forces[i][j]*(halfdt/system.getParticleMass(j));
-    
+        for (int j = start; j < end; j++)
+            if (masses[j] != 0.0)
+                velocities[i][j] += forces[i][j]*(dt/masses[j]);
+}
+
+void ReferenceIntegrateRPMDStepKernel::propagateFreeRingPolymer(int start, int end, int threadIndex) {
     // Evolve the free ring polymer by transforming to the frequency domain.
 
-    for (int particle = 0; particle < numParticles; particle++) {
-        if (system.getParticleMass(particle) == 0.0)
-            continue;
-        for (int component = 0; component < 3; component++) {
-            for (int k = 0; k < numCopies; k++) {
-                q[k] = t_complex(scale*positions[k][particle][component], 0.0);
-                v[k] = t_complex(scale*velocities[k][particle][component], 0.0);
-            }
-            fftpack_exec_1d(fft, FFTPACK_FORWARD, &q[0], &q[0]);
-            fftpack_exec_1d(fft, FFTPACK_FORWARD, &v[0], &v[0]);
-            q[0] += v[0]*dt;
+    const int numCopies = positions.size();
+    const double scale = 1.0/sqrt((double) numCopies);
+    t_complex* q = &qWorkspace[threadIndex][0];
+    t_complex* v = &vWorkspace[threadIndex][0];
+    int particles[ParticleBlockSize];
+    for (int blockStart = start; blockStart < end; blockStart += ParticleBlockSize) {
+        int numInBlock = findMassiveParticles(blockStart, min(end, blockStart+ParticleBlockSize), particles);
+        int numRows = 3*numInBlock;
+        loadRows(positions, particles, numInBlock, scale, q);
+        loadRows(velocities, particles, numInBlock, scale, v);
+        transformRows(fft[threadIndex], FFTPACK_FORWARD, q, numRows, numCopies);
+        transformRows(fft[threadIndex], FFTPACK_FORWARD, v, numRows, numCopies);
+        for (int row = 0; row < numRows; row++) {
+            t_complex* qrow = &q[row*numCopies];
+            t_complex* vrow = &v[row*numCopies];
+            qrow[0] += vrow[0]*stepSize;
             for (int k = 1; k < numCopies; k++) {
-                const double wk = twown*sin(k*M_PI/numCopies);
-                const double wt = wk*dt;
-                const double coswt = cos(wt);
-                const double sinwt = sin(wt);
-                const double wm = wk*system.getParticleMass(particle);
-                const t_complex vprime = v[k]*coswt - q[k]*(wk*sinwt); // Advance velocity from t to t+dt
-                q[k] = v[k]*(sinwt/wk) + q[k]*coswt; // Advance position from t to t+dt
-                v[k] = vprime;
-            }
-            fftpack_exec_1d(fft, FFTPACK_BACKWARD, &q[0], &q[0]);
-            fftpack_exec_1d(fft, FFTPACK_BACKWARD, &v[0], &v[0]);
-            for (int k = 0; k < numCopies; k++) {
-                positions[k][particle][component] = scale*q[k].re;
-                velocities[k][particle][component] = scale*v[k].re;
+                const double wk = modeFrequency[k];
+                const double coswt = modeCos[k];
+                const double sinwt = modeSin[k];
+                const t_complex vprime = vrow[k]*coswt - qrow[k]*(wk*sinwt); // Advance velocity from t to t+dt
+                qrow[k] = vrow[k]*(sinwt/wk) + qrow[k]*coswt; // Advance position from t to t+dt
+                vrow[k] = vprime;
             }
         }
+        transformRows(fft[threadIndex], FFTPACK_BACKWARD, q, numRows, numCopies);
+        transformRows(fft[threadIndex], FFTPACK_BACKWARD, v, numRows, numCopies);
+        storeRows(positions, particles, numInBlock, scale, q);
+        storeRows(velocities, particles, numInBlock, scale, v);
     }
-    
-    // Calculate forces based on the updated positions.
-    
-    computeForces(context, integrator);
-
-    // Update velocities.
-    
-    for (int i = 0; i < numCopies; i++)
-        for (int j = 0; j < numParticles; j++)
-            if (system.getParticleMass(j) != 0.0)
-                velocities[i][j] += forces[i][j]*(halfdt/system.getParticleMass(j));
-
-    // Apply the PILE-L thermostat again.
-    
-    if (integrator.getApplyThermostat()) {
-        for (int particle = 0; particle < numParticles; particle++) {
-            if (system.getParticleMass(particle) == 0.0)
-                continue;
-            const double c3_0 = c2_0*sqrt(nkT/system.getParticleMass(particle));
-            for (int component = 0; component < 3; component++) {
-                for (int k = 0; k < numCopies; k++)
-                    v[k] = t_complex(scale*velocities[k][particle][component], 0.0);
-                fftpack_exec_1d(fft, FFTPACK_FORWARD, &v[0], &v[0]);
-
-                // Apply a local Langevin thermostat to the centroid mode.
-
-                v[0].re = v[0].re*c1_0 + c3_0*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-
-                // Use critical damping white noise for the remaining modes.
+}
 
-                for (int k = 1; k <= numCopies/2; k++) {
-                    const bool isCenter = (numCopies%2 == 0 && k == numCopies/2);
-                    const double wk = twown*sin(k*M_PI/numCopies);
-                    const double c1 = exp(-2.0*wk*halfdt);
-                    const double c2 = sqrt((1.0-c1*c1)/2) * (isCenter ? sqrt(2.0) : 1.0);
-                    const double c3 = c2*sqrt(nkT/system.getParticleMass(particle));
-                    double rand1 = c3*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber();
-                    double rand2 = (isCenter ? 0.0 : c3*SimTKOpenMMUtilities::getNormallyDistributedRandomNumber());
-                    v[k] = v[k]*c1 + t_complex(rand1, rand2);
-                    if (k < numCopies-k)
-                        v[numCopies-k] = v[numCopies-k]*c1 + t_complex(rand1, -rand2);
-                }
-                fftpack_exec_1d(fft, FFTPACK_BACKWARD, &v[0], &v[0]);
-                for (int k = 0; k < numCopies; k++)
-                    velocities[k][particle][component] = scale*v[k].re;
-            }
-        }
-    }
-    
-    // Update the time.
-    
-    context.setTime(context.getTime()+dt);
+void ReferenceIntegrateRPMDStepKernel::updateCopyState(ContextImpl& context, int copy) {
+    vector<Vec3>& pos = extractPositions(context);
+    vector<Vec3>& vel = extractVelocities(context);
+    pos = positions[copy];
+    vel = velocities[copy];
+    context.computeVirtualSites();
+    Vec3 initialBox[3];
+    context.getPeriodicBoxVectors(initialBox[0], initialBox[1], initialBox[2]);
+    context.updateContextState();
+    Vec3 finalBox[3];
+    context.getPeriodicBoxVectors(finalBox[0], finalBox[1], finalBox[2]);
+    if (initialBox[0] != finalBox[0] || initialBox[1] != finalBox[1] || initialBox[2] != finalBox[2])
+        throw OpenMMException("Standard barostats cannot be used with RPMDIntegrator.  Use RPMDMonteCarloBarostat instead.");
+    positions[copy] = pos;
+    velocities[copy] = vel;
 }
 
 void ReferenceIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const RPMDIntegrator& integrator) {
     const int totalCopies = positions.size();
-    const int numParticles = positions[0].size();
     vector<Vec3>& pos = extractPositions(context);
-    vector<Vec3>& vel = extractVelocities(context);
     vector<Vec3>& f = extractForces(context);
     
     // Compute forces from all groups that didn't have a specified contraction.
     
     for (int i = 0; i < totalCopies; i++) {
-        pos = positions[i];
-        vel = velocities[i];
-        context.computeVirtualSites();
-        Vec3 initialBox[3];
-        context.getPeriodicBoxVectors(initialBox[0], initialBox[1], initialBox[2]);
-        context.updateContextState();
-        Vec3 finalBox[3];
-        context.getPeriodicBoxVectors(finalBox[0], finalBox[1], finalBox[2]);
-        if (initialBox[0] != finalBox[0] || initialBox[1] != finalBox[1] || initialBox[2] != finalBox[2])
-            throw OpenMMException("Standard barostats cannot be used with RPMDIntegrator.  Use RPMDMonteCarloBarostat instead.");
-        positions[i] = pos;
-        velocities[i] = vel;
+        updateCopyState(context, i);
         context.calcForcesAndEnergy(true, false, groupsNotContracted);
         forces[i] = f;
     }
@@ -294,62 +377,91 @@ void ReferenceIntegrateRPMDStepKernel::computeForces(ContextImpl& context, const
     for (auto& g : groupsByCopies) {
         int copies = g.first;
         int groupFlags = g.second;
-        fftpack* shortFFT = contractionFFT[copies];
-        
-        // Find the contracted positions.
-        
-        vector<t_complex> q(totalCopies);
-        const double scale1 = 1.0/totalCopies;
-        for (int particle = 0; particle < numParticles; particle++) {
-            for (int component = 0; component < 3; component++) {
-                // Transform to the frequency domain, set high frequency components to zero, and transform back.
-                
-                for (int k = 0; k < totalCopies; k++)
-                    q[k] = t_complex(positions[k][particle][component], 0.0);
-                fftpack_exec_1d(fft, FFTPACK_FORWARD, &q[0], &q[0]);
-                if (copies > 1) {
-                    int start = (copies+1)/2;
-                    int end = totalCopies-copies+start;
-                    for (int k = end; k < totalCopies; k++)
-                        q[k-(totalCopies-copies)] = q[k];
-                    fftpack_exec_1d(shortFFT, FFTPACK_BACKWARD, &q[0], &q[0]);
-                }
-                for (int k = 0; k < copies; k++)
-                    contractedPositions[k][particle][component] = scale1*q[k].re;
-            }
-        }
-        
-        // Compute forces.
-
+        forEachParticleBlock([&] (int start, int end, int threadIndex) {
+            contractPositions(copies, start, end, threadIndex);
+        });
         for (int i = 0; i < copies; i++) {
-            pos = contractedPositions[i];
+            pos = contractedPositions[copies][i];
             context.computeVirtualSites();
             context.calcForcesAndEnergy(true, false, groupFlags);
-            contractedForces[i] = f;
+            contractedForces[copies][i] = f;
         }
-        
-        // Apply the forces to the original copies.
-        
-        const double scale2 = 1.0/copies;
-        for (int particle = 0; particle < numParticles; particle++) {
+        forEachParticleBlock([&] (int start, int end, int threadIndex) {
+            addContractedForces(copies, start, end, threadIndex);
+        });
+    }
+}
+
+void ReferenceIntegrateRPMDStepKernel::contractPositions(int copies, int start, int end, int threadIndex) {
+    // Transform to the frequency domain, set high frequency components to zero, and transform back.
+
+    const int totalCopies = positions.size();
+    const double scale = 1.0/totalCopies;
+    vector<vector<Vec3> >& contracted = contractedPositions[copies];
+    fftpack* shortFFT = contractionFFT[threadIndex][copies];
+    t_complex* q = &qWorkspace[threadIndex][0];
+    int particles[ParticleBlockSize];
+    for (int blockStart = start; blockStart < end; blockStart += ParticleBlockSize) {
+        int numInBlock = min(end, blockStart+ParticleBlockSize)-blockStart;
+        int numRows = 3*numInBlock;
+        for (int i = 0; i < numInBlock; i++)
+            particles[i] = blockStart+i;
+        loadRows(positions, particles, numInBlock, 1.0, q);
+        transformRows(fft[threadIndex], FFTPACK_FORWARD, q, numRows, totalCopies);
+        if (copies > 1) {
+            int highStart = (copies+1)/2;
+            int highEnd = totalCopies-copies+highStart;
+            for (int row = 0; row < numRows; row++) {
+                t_complex* qrow = &q[row*totalCopies];
+                for (int k = highEnd; k < totalCopies; k++)
+                    qrow[k-(totalCopies-copies)] = qrow[k];
+                fftpack_exec_1d(shortFFT, FFTPACK_BACKWARD, qrow, qrow);
+            }
+        }
+        for (int i = 0; i < numInBlock; i++)
             for (int component = 0; component < 3; component++) {
-                // Transform to the frequency domain, pad with zeros, and transform back.
-                
+                const t_complex* qrow = &q[(3*i+component)*totalCopies];
                 for (int k = 0; k < copies; k++)
-                    q[k] = t_complex(contractedForces[k][particle][component], 0.0);
+                    contracted[k][particles[i]][component] = scale*qrow[k].re;
+            }
+    }
+}
+
+void ReferenceIntegrateRPMDStepKernel::addContractedForces(int copies, int start, int end, int threadIndex) {
+    // Transform to the frequency domain, pad with zeros, and transform back.
+
+    const int totalCopies = positions.size();
+    const double scale = 1.0/copies;
+    const vector<vector<Vec3> >& contracted = contractedForces[copies];
+    fftpack* shortFFT = contractionFFT[threadIndex][copies];
+    t_complex* q = &qWorkspace[threadIndex][0];
+    for (int blockStart = start; blockStart < end; blockStart += ParticleBlockSize) {
+        int numInBlock = min(end, blockStart+ParticleBlockSize)-blockStart;
+        for (int i = 0; i < numInBlock; i++)
+            for (int component = 0; component < 3; component++) {
+                t_complex* qrow = &q[(3*i+component)*totalCopies];
+                for (int k = 0; k < copies; k++)
+                    qrow[k] = t_complex(contracted[k][blockStart+i][component], 0.0);
                 if (copies > 1)
-                    fftpack_exec_1d(shortFFT, FFTPACK_FORWARD, &q[0], &q[0]);
-                int start = (copies+1)/2;
-                int end = totalCopies-copies+start;
-                for (int k = end; k < totalCopies; k++)
-                    q[k] = q[k-(totalCopies-copies)];
-                for (int k = start; k < end; k++)
-                    q[k] = t_complex(0, 0);
-                fftpack_exec_1d(fft, FFTPACK_BACKWARD, &q[0], &q[0]);
+                    fftpack_exec_1d(shortFFT, FFTPACK_FORWARD, qrow, qrow);
+
+                // Move the negative frequencies to the end.  Go from high to low so no value is
+                // overwritten before it has been moved.
+
+                int highStart = (copies+1)/2;
+                int highEnd = totalCopies-copies+highStart;
+                for (int k = totalCopies-1; k >= highEnd; k--)
+                    qrow[k] = qrow[k-(totalCopies-copies)];
+                for (int k = highStart; k < highEnd; k++)
+                    qrow[k] = t_complex(0, 0);
+            }
+        transformRows(fft[threadIndex], FFTPACK_BACKWARD, q, 3*numInBlock, totalCopies);
+        for (int i = 0; i < numInBlock; i++)
+            for (int component = 0; component < 3; component++) {
+                const t_complex* qrow = &q[(3*i+component)*totalCopies];
                 for (int k = 0; k < totalCopies; k++)
-                    forces[k][particle][component] += scale2*q[k].re;
+                    forces[k][blockStart+i][component] += scale*qrow[k].re;
             }
-        }
     }
 }
 
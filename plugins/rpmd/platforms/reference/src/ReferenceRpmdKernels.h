@@ -36,6 +36,7 @@
 #include "openmm/RpmdKernels.h"
 #include "openmm/Vec3.h"
 #include "fftpack.h"
+#include <functional>
 
 namespace OpenMM {
 
@@ -46,7 +47,7 @@ namespace OpenMM {
 class ReferenceIntegrateRPMDStepKernel : public IntegrateRPMDStepKernel {
 public:
     ReferenceIntegrateRPMDStepKernel(const std::string& name, const Platform& platform) :
-            IntegrateRPMDStepKernel(name, platform), fft(NULL) {
+            IntegrateRPMDStepKernel(name, platform) {
     }
     ~ReferenceIntegrateRPMDStepKernel();
     /**
@@ -84,17 +85,67 @@ public:
      * Copy positions and velocities for one copy into the context.
      */
     void copyToContext(int copy, ContextImpl& context);
-private:
-    void computeForces(ContextImpl& context, const RPMDIntegrator& integrator);
+protected:
+    /**
+     * Compute the forces on every copy, including the ones from contracted force groups.
+     */
+    virtual void computeForces(ContextImpl& context, const RPMDIntegrator& integrator);
+    /**
+     * Invoke a function on blocks of particles that together cover the whole system.  The function is
+     * passed the first particle in the block, one past the last particle in the block, and the index of
+     * the thread processing it.  The default implementation processes every particle in a single call
+     * with thread index 0.  Subclasses may override this to process blocks concurrently.
+     */
+    virtual void forEachParticleBlock(const std::function<void(int, int, int)>& task);
+    /**
+     * Get a Gaussian distributed random number for the thermostat.
+     *
+     * @param threadIndex    the index of the thread requesting it, as passed to forEachParticleBlock()
+     */
+    virtual double getGaussianRandom(int threadIndex);
+    /**
+     * Create the FFTs and workspace used by each thread in forEachParticleBlock().
+     */
+    void createThreadData(int numThreads);
+    /**
+     * Load one copy into the context and update the context's state for it: virtual sites are computed,
+     * and updateContextState() is called.  Any changes are stored back into the copy.  On exit, the
+     * context contains the positions and velocities of the copy.
+     */
+    void updateCopyState(ContextImpl& context, int copy);
+    /**
+     * Compute the contracted positions for a block of particles.
+     *
+     * @param copies    the number of copies in the contraction
+     */
+    void contractPositions(int copies, int start, int end, int threadIndex);
+    /**
+     * Transform the forces on the contracted copies back to the full set of copies, and add them
+     * to the forces on a block of particles.
+     *
+     * @param copies    the number of copies in the contraction
+     */
+    void addContractedForces(int copies, int start, int end, int threadIndex);
     std::vector<std::vector<Vec3> > positions;
     std::vector<std::vector<Vec3> > velocities;
     std::vector<std::vector<Vec3> > forces;
-    std::vector<std::vector<Vec3> > contractedPositions;
-    std::vector<std::vector<Vec3> > contractedForces;
+    std::map<int, std::vector<std::vector<Vec3> > > contractedPositions;
+    std::map<int, std::vector<std::vector<Vec3> > > contractedForces;
     std::map<int, int> groupsByCopies;
     int groupsNotContracted;
-    fftpack* fft;
-    std::map<int, fftpack*> contractionFFT;
+private:
+    void destroyThreadData();
+    void computeModeCoefficients(const RPMDIntegrator& integrator);
+    void applyThermostat(int start, int end, int threadIndex);
+    void advanceVelocities(int start, int end, double dt);
+    void propagateFreeRingPolymer(int start, int end, int threadIndex);
+    int findMassiveParticles(int start, int end, int* particles) const;
+    std::vector<double> masses;
+    std::vector<fftpack*> fft;
+    std::vector<std::map<int, fftpack*> > contractionFFT;
+    std::vector<std::vector<t_complex> > qWorkspace, vWorkspace;
+    double stepSize, nkT, centroidFriction, centroidNoise;
+    std::vector<double> modeFrequency, modeCos, modeSin, modeFriction, modeNoise;
 };
 
 } // namespace OpenMM
@@ -36,6 +36,7 @@
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/CMMotionRemover.h"
 #include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
 #include "openmm/CustomNonbondedForce.h"
 #include "openmm/HarmonicBondForce.h"
 #include "openmm/NonbondedForce.h"
@@ -425,6 +426,61 @@ void testContractions() {
     ASSERT_USUALLY_EQUAL_TOL(expectedKE, meanKE, 1e-2);
 }
 
+void testContractionToMostCopies() {
+    // Contract a force group to more than half the copies.  The force is linear and the copies
+    // only contain the normal modes that are kept, so the contracted force is exact and the
+    // trajectory should match the one without contraction.
+
+    const int numParticles = 5;
+    const int numCopies = 8;
+    const double temperature = 300.0;
+    System system;
+    CustomExternalForce* force = new CustomExternalForce("0.5*(100*x^2+200*y^2+300*z^2)");
+    force->setForceGroup(1);
+    system.addForce(force);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0+i);
+        force->addParticle(i);
+    }
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> center(numParticles), mode1(numParticles), mode2(numParticles), mode3(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        center[i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt));
+        mode1[i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.1;
+        mode2[i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.1;
+        mode3[i] = Vec3(genrand_real2(sfmt), genrand_real2(sfmt), genrand_real2(sfmt))*0.1;
+    }
+    for (int contractedCopies : {5, 7}) {
+        map<int, int> contractions;
+        contractions[1] = contractedCopies;
+        RPMDIntegrator integ1(numCopies, temperature, 1.0, 0.001, contractions);
+        RPMDIntegrator integ2(numCopies, temperature, 1.0, 0.001);
+        integ1.setApplyThermostat(false);
+        integ2.setApplyThermostat(false);
+        Context context1(system, integ1, platform);
+        Context context2(system, integ2, platform);
+        vector<Vec3> positions(numParticles);
+        for (int copy = 0; copy < numCopies; copy++) {
+            double phase = 2*M_PI*copy/numCopies;
+            for (int i = 0; i < numParticles; i++)
+                positions[i] = center[i] + mode1[i]*cos(phase) + mode2[i]*sin(phase) + mode3[i]*cos(2*phase);
+            integ1.setPositions(copy, positions);
+            integ2.setPositions(copy, positions);
+        }
+        for (int step = 0; step < 10; step++) {
+            integ1.step(1);
+            integ2.step(1);
+            for (int copy = 0; copy < numCopies; copy++) {
+                State state1 = integ1.getState(copy, State::Positions);
+                State state2 = integ2.getState(copy, State::Positions);
+                for (int i = 0; i < numParticles; i++)
+                    ASSERT_EQUAL_VEC(state2.getPositions()[i], state1.getPositions()[i], 1e-5);
+            }
+        }
+    }
+}
+
 void testWithoutThermostat() {
     const int numParticles = 20;
     const int numCopies = 10;
@@ -551,6 +607,7 @@ int main(int argc, char* argv[]) {
         testCMMotionRemoval();
         testVirtualSites();
         testContractions();
+        testContractionToMostCopies();
         testWithoutThermostat();
         testWithBarostat();
         runPlatformTests();
@@ -0,0 +1,112 @@
+#ifndef OPENMM_BINARY_SERIALIZER_H_
+#define OPENMM_BINARY_SERIALIZER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/serialization/SerializationNode.h"
+#include "openmm/State.h"
+#include "openmm/internal/windowsExport.h"
+#include <iosfwd>
+#include <string>
+#include <typeinfo>
+
+namespace OpenMM {
+
+class Force;
+class System;
+
+/**
+ * BinarySerializer writes objects to a compact binary format, and reconstructs them again.
+ * Compared to XmlSerializer it is much faster and produces much smaller output, at the cost
+ * of not being human readable.  Values are written in the byte order of the machine that
+ * created them, and reading a stream with a different byte order throws an exception.
+ */
+
+class OPENMM_EXPORT BinarySerializer {
+public:
+    /**
+     * Write a State to a stream.  Positions, velocities, and forces are written as contiguous
+     * blocks of double precision values.
+     *
+     * @param state     the State to serialize
+     * @param stream    an output stream to write the data to.  It should be opened in binary mode.
+     */
+    static void serialize(const State& state, std::ostream& stream);
+    /**
+     * Reconstruct a State that has been written with serialize().  Any data previously stored in the
+     * State is discarded.  The State's existing memory is reused, so when the same State is used to
+     * read a series of snapshots for the same System, no memory is allocated after the first one.
+     *
+     * @param stream    an input stream to read the data from.  It should be opened in binary mode.
+     * @param state     the data that was read is stored into this
+     */
+    static void deserialize(std::istream& stream, State& state);
+    /**
+     * Write an object to a stream.  This works for any object that can be serialized with
+     * XmlSerializer, and stores the same information, but is faster to write and read.  Like
+     * XmlSerializer, it processes a System one particle, constraint, and Force at a time, and the
+     * element lists of Forces one element at a time.
+     *
+     * @param object    the object to serialize
+     * @param rootName  the name to use for the root node
+     * @param stream    an output stream to write the data to.  It should be opened in binary mode.
+     */
+    template <class T>
+    static void serialize(const T* object, const std::string& rootName, std::ostream& stream) {
+        serializeObject(object, typeid(*object), rootName, stream);
+    }
+    /**
+     * Reconstruct an object that has been written with serialize(const T*, const std::string&, std::ostream&).
+     *
+     * @param stream    an input stream to read the data from.  It should be opened in binary mode.
+     * @return a pointer to the newly created object.  The caller assumes ownership of the object.
+     */
+    template <class T>
+    static T* deserialize(std::istream& stream) {
+        return reinterpret_cast<T*>(deserializeStream(stream));
+    }
+private:
+    static void serializeObject(const void* object, const std::type_info& type, const std::string& rootName, std::ostream& stream);
+    static void serializeSystem(const System& system, const std::string& rootName, std::ostream& stream);
+    static void* deserializeStream(std::istream& stream);
+    static System* deserializeSystem(const SerializationNode& root, int numChildren, std::istream& stream);
+    static void writeObject(const void* object, const std::type_info& type, const std::string& name, std::ostream& stream);
+    static Force* readForce(std::istream& stream);
+    static void writeNode(const SerializationNode& node, std::ostream& stream);
+    static void writeNodeStart(const SerializationNode& node, int numChildren, std::ostream& stream);
+    static void readNode(SerializationNode& node, std::istream& stream);
+    static int readNodeStart(SerializationNode& node, std::istream& stream);
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_BINARY_SERIALIZER_H_*/
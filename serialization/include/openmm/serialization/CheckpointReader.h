@@ -0,0 +1,90 @@
+#ifndef OPENMM_CHECKPOINT_READER_H_
+#define OPENMM_CHECKPOINT_READER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/Context.h"
+#include "openmm/State.h"
+#include "openmm/internal/windowsExport.h"
+#include <iosfwd>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * CheckpointReader loads checkpoints that were written by CheckpointWriter.  See the CheckpointWriter
+ * documentation for a description of the format.
+ *
+ * A checkpoint that was stored as a delta can only be read after reading all the previous checkpoints
+ * back to the last full checkpoint, so a CheckpointReader should be used to read the checkpoints in a
+ * stream in order.
+ */
+
+class OPENMM_EXPORT CheckpointReader {
+public:
+    CheckpointReader();
+    /**
+     * Read the next checkpoint from a stream.
+     *
+     * @param stream    an input stream to read the checkpoint from.  It should be opened in binary mode.
+     * @param state     the information in the checkpoint is stored into this.  Its existing memory is
+     *                  reused, so reading a series of checkpoints into the same State allocates no memory
+     *                  after the first one.
+     * @return true if a checkpoint was read, or false if the stream was already at its end.  If the
+     * checkpoint is damaged or incomplete, an exception is thrown.
+     */
+    bool readCheckpoint(std::istream& stream, State& state);
+    /**
+     * Read all the checkpoints in a stream and load the last one into a Context.  If the final
+     * checkpoint in the stream is damaged or incomplete, as happens when a process is killed while
+     * writing it, it is ignored and the last complete checkpoint is loaded instead.  If the stream
+     * does not contain any complete checkpoint, an exception is thrown.
+     *
+     * @param stream    an input stream to read the checkpoints from.  It should be opened in binary mode.
+     * @param context   the Context to load the checkpoint into
+     */
+    void loadCheckpoint(std::istream& stream, Context& context);
+private:
+    bool hasPrevious;
+    unsigned int previousChecksum;
+    State state;
+    std::stringstream serialized;
+    std::string data, previousData;
+    std::vector<char> encoded, workspace;
+    std::vector<unsigned int> chunkChecksums;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CHECKPOINT_READER_H_*/
@@ -0,0 +1,130 @@
+#ifndef OPENMM_CHECKPOINT_WRITER_H_
+#define OPENMM_CHECKPOINT_WRITER_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/Context.h"
+#include "openmm/State.h"
+#include "openmm/internal/windowsExport.h"
+#include <iosfwd>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * CheckpointWriter writes checkpoints in a portable format that can be loaded with CheckpointReader.
+ * Unlike Context::createCheckpoint(), the checkpoint records only the information contained in a
+ * State: positions, velocities, periodic box vectors, time, step count, parameters, and integrator
+ * parameters.  It does not depend on the Platform it was created with, and can be loaded into a
+ * Context that uses any Platform.  Internal data such as the states of random number generators
+ * is not saved, so continuing from it will not reproduce the original trajectory exactly.
+ *
+ * The data is divided into chunks, and every chunk is stored with a checksum so that damaged or
+ * partially written checkpoints can be detected.  Chunks are optionally compressed.
+ *
+ * A CheckpointWriter can write a series of checkpoints to the same stream, for example by repeatedly
+ * appending to one file.  Most of them are stored as deltas relative to the previous checkpoint,
+ * which makes them much smaller.  Every few checkpoints a full one (a "keyframe") is written instead.
+ * To load a delta checkpoint, a CheckpointReader must first have read all the checkpoints back to
+ * the preceding keyframe.  If you instead write each checkpoint to a separate file, call
+ * setKeyframeInterval(1) so every checkpoint is self contained.
+ */
+
+class OPENMM_EXPORT CheckpointWriter {
+public:
+    /**
+     * Create a CheckpointWriter.
+     *
+     * @param compress           whether to compress the data
+     * @param keyframeInterval   a full checkpoint is written every keyframeInterval checkpoints.  The
+     *                           others are written as deltas relative to the previous one.
+     */
+    CheckpointWriter(bool compress=true, int keyframeInterval=10);
+    /**
+     * Get whether the data is compressed.
+     */
+    bool getCompress() const;
+    /**
+     * Set whether the data is compressed.
+     */
+    void setCompress(bool compress);
+    /**
+     * Get the number of checkpoints between successive full checkpoints.
+     */
+    int getKeyframeInterval() const;
+    /**
+     * Set the number of checkpoints between successive full checkpoints.  If this is 1, every
+     * checkpoint is a full checkpoint.
+     */
+    void setKeyframeInterval(int interval);
+    /**
+     * Get the size in bytes of the chunks the data is divided into.
+     */
+    int getChunkSize() const;
+    /**
+     * Set the size in bytes of the chunks the data is divided into.
+     */
+    void setChunkSize(int size);
+    /**
+     * Write a checkpoint recording the current state of a Context.
+     *
+     * @param context   the Context to write a checkpoint for
+     * @param stream    an output stream to write the checkpoint to.  It should be opened in binary mode.
+     */
+    void writeCheckpoint(const Context& context, std::ostream& stream);
+    /**
+     * Write a checkpoint containing the information in a State.
+     *
+     * @param state     the State to write a checkpoint for
+     * @param stream    an output stream to write the checkpoint to.  It should be opened in binary mode.
+     */
+    void writeCheckpoint(const State& state, std::ostream& stream);
+    /**
+     * Make the next checkpoint a full checkpoint.  Call this if you start writing to a new stream.
+     */
+    void reset();
+private:
+    bool compress;
+    int keyframeInterval, chunkSize, checkpointsSinceKeyframe;
+    unsigned int previousChecksum;
+    State state;
+    std::stringstream serialized;
+    std::string data, previousData;
+    std::vector<char> chunk, encoded, workspace;
+    std::vector<unsigned int> chunkChecksums;
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CHECKPOINT_WRITER_H_*/
@@ -46,6 +46,13 @@ public:
     HarmonicAngleForceProxy();
     void serialize(const void* object, SerializationNode& node) const;
     void* deserialize(const SerializationNode& node) const;
+    int getNumElementLists() const;
+    void getElementListNames(int list, std::string& listName, std::string& elementName) const;
+    int getNumElements(const void* object, int list) const;
+    void serializeHeader(const void* object, SerializationNode& node) const;
+    void serializeElement(const void* object, int list, int index, SerializationNode& element) const;
+    void* deserializeHeader(const SerializationNode& node) const;
+    void deserializeElement(const SerializationNode& element, int list, void* object) const;
 };
 
 } // namespace OpenMM
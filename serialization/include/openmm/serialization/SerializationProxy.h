@@ -84,6 +84,67 @@ public:
      * of the object.
      */
     virtual void* deserialize(const SerializationNode& node) const = 0;
+    /**
+     * Some objects contain long lists of similar elements, such as the particles, exceptions, or bonds
+     * of a Force.  Serializers that process a System incrementally use the element list methods to create
+     * a SerializationNode for only one element at a time, rather than calling serialize() or deserialize()
+     * to build the nodes for the whole object at once.
+     *
+     * This returns the number of element lists the proxy supports.  The default implementation returns 0,
+     * in which case the other element list methods are never called.  A subclass that returns a nonzero
+     * value must override all of them.  In the node created by serialize(), each list must be a child node
+     * whose children are the elements, and the lists must follow all other children in order.
+     */
+    virtual int getNumElementLists() const;
+    /**
+     * Get the names of the nodes used for an element list.
+     *
+     * @param list          the index of the element list
+     * @param listName      on exit, the name of the child node that contains the list
+     * @param elementName   on exit, the name of the node for each element
+     */
+    virtual void getElementListNames(int list, std::string& listName, std::string& elementName) const;
+    /**
+     * Get the number of elements in one of an object's element lists.
+     *
+     * @param object    a pointer to the object being serialized
+     * @param list      the index of the element list
+     */
+    virtual int getNumElements(const void* object, int list) const;
+    /**
+     * Record information about an object being serialized, except for its element lists.
+     *
+     * @param object    a pointer to the object being serialized
+     * @param node      the data should be stored into this node, exactly as serialize() would
+     *                  but without creating the element lists
+     */
+    virtual void serializeHeader(const void* object, SerializationNode& node) const;
+    /**
+     * Record information about one element of an object being serialized.
+     *
+     * @param object    a pointer to the object being serialized
+     * @param list      the index of the element list
+     * @param index     the index of the element within the list
+     * @param element   the element's data should be stored into this node
+     */
+    virtual void serializeElement(const void* object, int list, int index, SerializationNode& element) const;
+    /**
+     * Create an object from a node that was created by serializeHeader().  Its element lists are
+     * initially empty.
+     *
+     * @param node    a SerializationNode containing everything except the element lists
+     * @return a pointer to a new object created from the data.  The caller assumes ownership
+     * of the object.
+     */
+    virtual void* deserializeHeader(const SerializationNode& node) const;
+    /**
+     * Add one element to an object that was created by deserializeHeader().
+     *
+     * @param element   a SerializationNode containing the element's description
+     * @param list      the index of the element list to add it to
+     * @param object    a pointer to the object to add the element to
+     */
+    virtual void deserializeElement(const SerializationNode& element, int list, void* object) const;
     /**
      * Register a SerializationProxy to be used for objects of a particular type.
      *
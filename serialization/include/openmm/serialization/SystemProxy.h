@@ -34,6 +34,7 @@
 
 #include "openmm/internal/windowsExport.h"
 #include "openmm/serialization/SerializationProxy.h"
+#include "openmm/System.h"
 
 namespace OpenMM {
 
@@ -46,6 +47,19 @@ public:
     SystemProxy();
     void serialize(const void* object, SerializationNode& node) const;
     void* deserialize(const SerializationNode& node) const;
+    /**
+     * The following methods each serialize or deserialize one part of a System.  They are used by
+     * serializers that process a System incrementally instead of building the full tree of
+     * SerializationNodes.
+     */
+    static void serializeHeader(const System& system, SerializationNode& node);
+    static void serializeBoxVectors(const System& system, SerializationNode& box);
+    static void serializeParticle(const System& system, int index, SerializationNode& particle);
+    static void serializeConstraint(const System& system, int index, SerializationNode& constraint);
+    static void checkVersion(const SerializationNode& node);
+    static void deserializeBoxVectors(const SerializationNode& box, System& system);
+    static void deserializeParticle(const SerializationNode& particle, System& system);
+    static void deserializeConstraint(const SerializationNode& constraint, System& system);
 };
 
 } // namespace OpenMM
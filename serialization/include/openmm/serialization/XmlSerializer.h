@@ -37,11 +37,19 @@
 #include "openmm/OpenMMException.h"
 #include "openmm/internal/windowsExport.h"
 #include <iosfwd>
+#include <typeinfo>
 
 namespace OpenMM {
 
+class System;
+
 /**
  * XmlSerializer is used for serializing objects as XML, and for reconstructing them again.
+ *
+ * Most objects are first converted to a tree of SerializationNodes, which is then written out.
+ * Systems are an exception: they are written and read one particle, constraint, and Force at a
+ * time.  Forces whose proxies support element lists are in turn processed one particle, bond, or
+ * exception at a time, so the memory needed does not grow with the size of the System.
  */
 
 class OPENMM_EXPORT XmlSerializer {
@@ -55,14 +63,7 @@ public:
      */
     template <class T>
     static void serialize(const T* object, const std::string& rootName, std::ostream& stream) {
-        const SerializationProxy& proxy = SerializationProxy::getProxy(typeid(*object));
-        SerializationNode node;
-        node.setName(rootName);
-        proxy.serialize(object, node);
-        if (node.hasProperty("type"))
-            throw OpenMMException(proxy.getTypeName()+" created node with reserved property 'type'");
-        node.setStringProperty("type", proxy.getTypeName());
-        serialize(node, stream);
+        serializeObject(object, typeid(*object), rootName, stream);
     }
     /**
      * Reconstruct an object that has been serialized as XML.
@@ -88,9 +89,12 @@ public:
     }
 private:
     class StreamReader;
+    static void serializeObject(const void* object, const std::type_info& type, const std::string& rootName, std::ostream& stream);
+    static void serializeSystem(const System& system, const std::string& rootName, std::ostream& stream);
     static void serialize(const SerializationNode& node, std::ostream& stream);
     static void* deserializeStream(std::istream& stream);
     static void encodeNode(const SerializationNode& node, std::ostream& stream, int depth);
+    static void encodeObject(const void* object, const std::type_info& type, const std::string& name, std::ostream& stream, int depth);
 };
 
 } // namespace OpenMM
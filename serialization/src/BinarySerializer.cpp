@@ -0,0 +1,492 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/serialization/BinarySerializer.h"
+#include "openmm/serialization/SystemProxy.h"
+#include "openmm/Force.h"
+#include "openmm/OpenMMException.h"
+#include "openmm/System.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+using namespace OpenMM;
+using namespace std;
+
+const static char STATE_MAGIC_BYTES[] = "OpenMM Binary State\n";
+const static int STATE_VERSION = 1;
+const static int BYTE_ORDER_MARK = 0x01020304;
+const static char OBJECT_MAGIC_BYTES[] = "OpenMM Binary Object\n";
+const static int OBJECT_VERSION = 1;
+const static long long MAX_UNCHECKED_BYTES = 1<<20;
+
+template <class T>
+static void writeValue(ostream& stream, const T& value) {
+    stream.write((char*) &value, sizeof(T));
+}
+
+template <class T>
+static void readValue(istream& stream, T& value) {
+    stream.read((char*) &value, sizeof(T));
+}
+
+static int readLength(istream& stream) {
+    int length;
+    readValue(stream, length);
+    if (stream.fail() || length < 0)
+        throw OpenMMException("BinarySerializer: Unexpected end of stream or corrupted data");
+    return length;
+}
+
+/**
+ * Before allocating memory for a large block of data, check that the stream really contains that
+ * much data, so a corrupted length cannot cause a huge allocation.  Returns false if the stream does
+ * not support seeking, in which case the data must be read in pieces.
+ */
+static bool checkAvailable(istream& stream, long long bytes) {
+    if (bytes <= MAX_UNCHECKED_BYTES)
+        return true;
+    streampos current = stream.tellg();
+    if (current == streampos(-1))
+        return false;
+    stream.seekg(0, ios::end);
+    streampos end = stream.tellg();
+    if (stream.fail() || end == streampos(-1)) {
+        stream.clear();
+        stream.seekg(current);
+        return false;
+    }
+    stream.seekg(current);
+    if (end-current < bytes)
+        throw OpenMMException("BinarySerializer: Unexpected end of stream or corrupted data");
+    return true;
+}
+
+/**
+ * Read a block of data into a string or vector, resizing it to hold the specified number of elements.
+ */
+template <class T>
+static void readArray(istream& stream, T& values, int length, int elementSize) {
+    long long bytes = (long long) length*elementSize;
+    if (checkAvailable(stream, bytes)) {
+        values.resize(length);
+        if (length > 0)
+            stream.read((char*) &values[0], bytes);
+    }
+    else {
+        // Grow the array as the data is read, so it never gets much bigger than the data really present.
+
+        int piece = MAX_UNCHECKED_BYTES/elementSize;
+        for (int start = 0; start < length && !stream.fail(); start += piece) {
+            int count = min(piece, length-start);
+            values.resize(start+count);
+            stream.read((char*) &values[start], (streamsize) count*elementSize);
+        }
+    }
+    if (stream.fail())
+        throw OpenMMException("BinarySerializer: Unexpected end of stream or corrupted data");
+}
+
+static void writeString(ostream& stream, const string& str) {
+    writeValue<int>(stream, str.size());
+    stream.write(str.c_str(), str.size());
+}
+
+static void readString(istream& stream, string& str) {
+    readArray(stream, str, readLength(stream), 1);
+}
+
+static void writeVectors(ostream& stream, const vector<Vec3>& values) {
+    writeValue<int>(stream, values.size());
+    if (values.size() > 0)
+        stream.write((char*) &values[0], values.size()*sizeof(Vec3));
+}
+
+static void readVectors(istream& stream, vector<Vec3>& values) {
+    readArray(stream, values, readLength(stream), sizeof(Vec3));
+}
+
+static void writeMap(ostream& stream, const map<string, double>& values) {
+    writeValue<int>(stream, values.size());
+    for (auto& value : values) {
+        writeString(stream, value.first);
+        writeValue(stream, value.second);
+    }
+}
+
+static void readMap(istream& stream, map<string, double>& values) {
+    int length = readLength(stream);
+    values.clear();
+    string key;
+    for (int i = 0; i < length; i++) {
+        readString(stream, key);
+        readValue(stream, values[key]);
+    }
+}
+
+void BinarySerializer::writeNode(const SerializationNode& node, ostream& stream) {
+    writeNodeStart(node, node.getChildren().size(), stream);
+    for (auto& child : node.getChildren())
+        writeNode(child, stream);
+}
+
+void BinarySerializer::writeNodeStart(const SerializationNode& node, int numChildren, ostream& stream) {
+    writeString(stream, node.getName());
+    writeValue<int>(stream, node.getProperties().size());
+    for (auto& prop : node.getProperties()) {
+        writeString(stream, prop.first);
+        writeString(stream, prop.second);
+    }
+    writeValue(stream, numChildren);
+}
+
+void BinarySerializer::readNode(SerializationNode& node, istream& stream) {
+    int numChildren = readNodeStart(node, stream);
+    for (int i = 0; i < numChildren; i++)
+        readNode(node.createChildNode(""), stream);
+}
+
+int BinarySerializer::readNodeStart(SerializationNode& node, istream& stream) {
+    string name, key, value;
+    readString(stream, name);
+    node.setName(name);
+    int numProperties = readLength(stream);
+    for (int i = 0; i < numProperties; i++) {
+        readString(stream, key);
+        readString(stream, value);
+        node.setStringProperty(key, value);
+    }
+    return readLength(stream);
+}
+
+void BinarySerializer::serialize(const State& state, ostream& stream) {
+    stream.write(STATE_MAGIC_BYTES, sizeof(STATE_MAGIC_BYTES));
+    writeValue(stream, STATE_VERSION);
+    writeValue(stream, BYTE_ORDER_MARK);
+    int types = state.getDataTypes();
+    writeValue(stream, types);
+    writeValue(stream, state.getTime());
+    writeValue(stream, state.getStepCount());
+    Vec3 box[3];
+    state.getPeriodicBoxVectors(box[0], box[1], box[2]);
+    stream.write((char*) box, sizeof(box));
+    if ((types&State::Energy) != 0) {
+        writeValue(stream, state.getKineticEnergy());
+        writeValue(stream, state.getPotentialEnergy());
+    }
+    if ((types&State::Positions) != 0)
+        writeVectors(stream, state.getPositions());
+    if ((types&State::Velocities) != 0)
+        writeVectors(stream, state.getVelocities());
+    if ((types&State::Forces) != 0)
+        writeVectors(stream, state.getForces());
+    if ((types&State::Parameters) != 0)
+        writeMap(stream, state.getParameters());
+    if ((types&State::ParameterDerivatives) != 0)
+        writeMap(stream, state.getEnergyParameterDerivatives());
+    if ((types&State::IntegratorParameters) != 0)
+        writeNode(state.getIntegratorParameters(), stream);
+    if (stream.fail())
+        throw OpenMMException("BinarySerializer: Failed to write State");
+}
+
+void BinarySerializer::deserialize(istream& stream, State& state) {
+    char magicBytes[sizeof(STATE_MAGIC_BYTES)];
+    stream.read(magicBytes, sizeof(STATE_MAGIC_BYTES));
+    if (stream.fail() || memcmp(magicBytes, STATE_MAGIC_BYTES, sizeof(STATE_MAGIC_BYTES)) != 0)
+        throw OpenMMException("BinarySerializer: The stream does not contain a binary State");
+    int version, byteOrder, types;
+    readValue(stream, version);
+    if (version != STATE_VERSION)
+        throw OpenMMException("BinarySerializer: Unsupported version number");
+    readValue(stream, byteOrder);
+    if (byteOrder != BYTE_ORDER_MARK)
+        throw OpenMMException("BinarySerializer: The State was written on a machine with a different byte order");
+    readValue(stream, types);
+    double time;
+    long long stepCount;
+    readValue(stream, time);
+    readValue(stream, stepCount);
+    state.reset(time, stepCount);
+    Vec3 box[3];
+    stream.read((char*) box, sizeof(box));
+    state.setPeriodicBoxVectors(box[0], box[1], box[2]);
+    if ((types&State::Energy) != 0) {
+        double ke, pe;
+        readValue(stream, ke);
+        readValue(stream, pe);
+        state.setEnergy(ke, pe);
+    }
+    if ((types&State::Positions) != 0)
+        readVectors(stream, state.updatePositions());
+    if ((types&State::Velocities) != 0)
+        readVectors(stream, state.updateVelocities());
+    if ((types&State::Forces) != 0)
+        readVectors(stream, state.updateForces());
+    if ((types&State::Parameters) != 0)
+        readMap(stream, state.updateParameters());
+    if ((types&State::ParameterDerivatives) != 0)
+        readMap(stream, state.updateEnergyParameterDerivatives());
+    if ((types&State::IntegratorParameters) != 0)
+        readNode(state.updateIntegratorParameters(), stream);
+    if (stream.fail())
+        throw OpenMMException("BinarySerializer: Unexpected end of stream while reading State");
+}
+
+void BinarySerializer::serializeObject(const void* object, const type_info& type, const string& rootName, ostream& stream) {
+    stream.write(OBJECT_MAGIC_BYTES, sizeof(OBJECT_MAGIC_BYTES));
+    writeValue(stream, OBJECT_VERSION);
+    writeValue(stream, BYTE_ORDER_MARK);
+    if (type == typeid(System))
+        serializeSystem(*reinterpret_cast<const System*>(object), rootName, stream);
+    else {
+        const SerializationProxy& proxy = SerializationProxy::getProxy(type);
+        SerializationNode node;
+        node.setName(rootName);
+        proxy.serialize(object, node);
+        if (node.hasProperty("type"))
+            throw OpenMMException(proxy.getTypeName()+" created node with reserved property 'type'");
+        node.setStringProperty("type", proxy.getTypeName());
+        writeNode(node, stream);
+    }
+    if (stream.fail())
+        throw OpenMMException("BinarySerializer: Failed to write object");
+}
+
+void BinarySerializer::serializeSystem(const System& system, const string& rootName, ostream& stream) {
+    // Write the same tree SystemProxy would create, but only create the SerializationNodes
+    // for one particle, constraint, or Force at a time.
+
+    SerializationNode root;
+    root.setName(rootName);
+    SystemProxy::serializeHeader(system, root);
+    root.setStringProperty("type", SerializationProxy::getProxy(typeid(System)).getTypeName());
+    writeNodeStart(root, 4, stream);
+    SerializationNode box;
+    box.setName("PeriodicBoxVectors");
+    SystemProxy::serializeBoxVectors(system, box);
+    writeNode(box, stream);
+    SerializationNode section;
+    section.setName("Particles");
+    writeNodeStart(section, system.getNumParticles(), stream);
+    for (int i = 0; i < system.getNumParticles(); i++) {
+        SerializationNode particle;
+        particle.setName("Particle");
+        SystemProxy::serializeParticle(system, i, particle);
+        writeNode(particle, stream);
+    }
+    section.setName("Constraints");
+    writeNodeStart(section, system.getNumConstraints(), stream);
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        SerializationNode constraint;
+        constraint.setName("Constraint");
+        SystemProxy::serializeConstraint(system, i, constraint);
+        writeNode(constraint, stream);
+    }
+    section.setName("Forces");
+    writeNodeStart(section, system.getNumForces(), stream);
+    for (int i = 0; i < system.getNumForces(); i++)
+        writeObject(&system.getForce(i), typeid(system.getForce(i)), "Force", stream);
+}
+
+void BinarySerializer::writeObject(const void* object, const type_info& type, const string& name, ostream& stream) {
+    // If the proxy supports element lists, create the SerializationNode for each element only
+    // while it is being written.
+
+    const SerializationProxy& proxy = SerializationProxy::getProxy(type);
+    int numLists = proxy.getNumElementLists();
+    SerializationNode node;
+    node.setName(name);
+    if (numLists == 0)
+        proxy.serialize(object, node);
+    else
+        proxy.serializeHeader(object, node);
+    if (node.hasProperty("type"))
+        throw OpenMMException(proxy.getTypeName()+" created node with reserved property 'type'");
+    node.setStringProperty("type", proxy.getTypeName());
+    if (numLists == 0) {
+        writeNode(node, stream);
+        return;
+    }
+    writeNodeStart(node, node.getChildren().size()+numLists, stream);
+    for (auto& child : node.getChildren())
+        writeNode(child, stream);
+    string listName, elementName;
+    for (int list = 0; list < numLists; list++) {
+        proxy.getElementListNames(list, listName, elementName);
+        int numElements = proxy.getNumElements(object, list);
+        SerializationNode listNode;
+        listNode.setName(listName);
+        writeNodeStart(listNode, numElements, stream);
+        for (int i = 0; i < numElements; i++) {
+            SerializationNode element;
+            element.setName(elementName);
+            proxy.serializeElement(object, list, i, element);
+            writeNode(element, stream);
+        }
+    }
+}
+
+void* BinarySerializer::deserializeStream(istream& stream) {
+    char magicBytes[sizeof(OBJECT_MAGIC_BYTES)];
+    stream.read(magicBytes, sizeof(OBJECT_MAGIC_BYTES));
+    if (stream.fail() || memcmp(magicBytes, OBJECT_MAGIC_BYTES, sizeof(OBJECT_MAGIC_BYTES)) != 0)
+        throw OpenMMException("BinarySerializer: The stream does not contain a binary object");
+    int version, byteOrder;
+    readValue(stream, version);
+    if (version != OBJECT_VERSION)
+        throw OpenMMException("BinarySerializer: Unsupported version number");
+    readValue(stream, byteOrder);
+    if (byteOrder != BYTE_ORDER_MARK)
+        throw OpenMMException("BinarySerializer: The object was written on a machine with a different byte order");
+    SerializationNode root;
+    int numChildren = readNodeStart(root, stream);
+    const SerializationProxy& proxy = SerializationProxy::getProxy(root.getStringProperty("type"));
+    if (&proxy == &SerializationProxy::getProxy(typeid(System)))
+        return deserializeSystem(root, numChildren, stream);
+    for (int i = 0; i < numChildren; i++)
+        readNode(root.createChildNode(""), stream);
+    return proxy.deserialize(root);
+}
+
+System* BinarySerializer::deserializeSystem(const SerializationNode& root, int numChildren, istream& stream) {
+    SystemProxy::checkVersion(root);
+    System* system = new System();
+    try {
+        for (int i = 0; i < numChildren; i++) {
+            SerializationNode section;
+            int numItems = readNodeStart(section, stream);
+            const string& name = section.getName();
+            if (name == "Particles" || name == "Constraints") {
+                for (int j = 0; j < numItems; j++) {
+                    SerializationNode item;
+                    readNode(item, stream);
+                    if (name == "Particles")
+                        SystemProxy::deserializeParticle(item, *system);
+                    else
+                        SystemProxy::deserializeConstraint(item, *system);
+                }
+            }
+            else if (name == "Forces") {
+                for (int j = 0; j < numItems; j++)
+                    system->addForce(readForce(stream));
+            }
+            else {
+                for (int j = 0; j < numItems; j++)
+                    readNode(section.createChildNode(""), stream);
+                if (name == "PeriodicBoxVectors")
+                    SystemProxy::deserializeBoxVectors(section, *system);
+            }
+        }
+    }
+    catch (...) {
+        delete system;
+        throw;
+    }
+    return system;
+}
+
+Force* BinarySerializer::readForce(istream& stream) {
+    // If the proxy supports element lists, add each element to the Force as soon as it has been read.
+    // If another child comes after the element lists, convert the elements read so far (if any) back to
+    // SerializationNodes and read the rest of the Force into SerializationNodes too.
+
+    SerializationNode node;
+    int numChildren = readNodeStart(node, stream);
+    const SerializationProxy& proxy = SerializationProxy::getProxy(node.getStringProperty("type"));
+    int numLists = proxy.getNumElementLists();
+    if (numLists == 0) {
+        for (int i = 0; i < numChildren; i++)
+            readNode(node.createChildNode(""), stream);
+        return reinterpret_cast<Force*>(proxy.deserialize(node));
+    }
+    vector<string> listNames(numLists), elementNames(numLists);
+    vector<bool> listRead(numLists, false);
+    for (int i = 0; i < numLists; i++)
+        proxy.getElementListNames(i, listNames[i], elementNames[i]);
+    Force* force = NULL;
+    bool readAll = false;
+    try {
+        for (int i = 0; i < numChildren; i++) {
+            SerializationNode child;
+            int numItems = readNodeStart(child, stream);
+            int list = find(listNames.begin(), listNames.end(), child.getName())-listNames.begin();
+            if (list == numLists && force != NULL) {
+                for (int j = 0; j < numLists; j++)
+                    if (listRead[j]) {
+                        SerializationNode& listNode = node.createChildNode(listNames[j]);
+                        for (int k = 0; k < proxy.getNumElements(force, j); k++)
+                            proxy.serializeElement(force, j, k, listNode.createChildNode(elementNames[j]));
+                    }
+                delete force;
+                force = NULL;
+                readAll = true;
+            }
+            if (list == numLists || readAll) {
+                for (int j = 0; j < numItems; j++)
+                    readNode(child.createChildNode(""), stream);
+                node.getChildren().push_back(child);
+            }
+            else {
+                if (force == NULL) {
+                    // If the header cannot be created yet, some of the children it needs come after
+                    // the element lists.
+
+                    try {
+                        force = reinterpret_cast<Force*>(proxy.deserializeHeader(node));
+                    }
+                    catch (OpenMMException&) {
+                        readAll = true;
+                        for (int j = 0; j < numItems; j++)
+                            readNode(child.createChildNode(""), stream);
+                        node.getChildren().push_back(child);
+                        continue;
+                    }
+                }
+                listRead[list] = true;
+                for (int j = 0; j < numItems; j++) {
+                    SerializationNode element;
+                    readNode(element, stream);
+                    proxy.deserializeElement(element, list, force);
+                }
+            }
+        }
+        if (readAll)
+            return reinterpret_cast<Force*>(proxy.deserialize(node));
+        if (force == NULL)
+            force = reinterpret_cast<Force*>(proxy.deserializeHeader(node));
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
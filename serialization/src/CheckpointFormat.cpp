@@ -0,0 +1,157 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "CheckpointFormat.h"
+
+using namespace OpenMM;
+using namespace std;
+
+const char CheckpointFormat::MAGIC_BYTES[] = "OpenMM Portable Checkpoint\n";
+const int CheckpointFormat::MAGIC_LENGTH = sizeof(CheckpointFormat::MAGIC_BYTES);
+const int CheckpointFormat::VERSION;
+const int CheckpointFormat::BYTE_ORDER_MARK;
+const int CheckpointFormat::MAX_CHUNK_SIZE;
+
+static const int WORD_SIZE = 8;
+static const int MIN_ZERO_RUN = 4;
+
+static void writeCount(vector<char>& output, unsigned int count) {
+    while (count >= 0x80) {
+        output.push_back((char) ((count&0x7F)|0x80));
+        count >>= 7;
+    }
+    output.push_back((char) count);
+}
+
+static bool readCount(const char* data, int length, int& pos, unsigned int& count) {
+    count = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= length)
+            return false;
+        unsigned char byte = (unsigned char) data[pos++];
+        count |= (unsigned int) (byte&0x7F) << shift;
+        if ((byte&0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static vector<unsigned int> createChecksumTable() {
+    vector<unsigned int> table(256);
+    for (unsigned int i = 0; i < 256; i++) {
+        unsigned int c = i;
+        for (int j = 0; j < 8; j++)
+            c = (c&1 ? 0xEDB88320u^(c>>1) : c>>1);
+        table[i] = c;
+    }
+    return table;
+}
+
+unsigned int CheckpointFormat::computeChecksum(const char* data, int length) {
+    static const vector<unsigned int> table = createChecksumTable();
+    unsigned int crc = 0xFFFFFFFFu;
+    for (int i = 0; i < length; i++)
+        crc = table[(crc^(unsigned char) data[i])&0xFF]^(crc>>8);
+    return crc^0xFFFFFFFFu;
+}
+
+void CheckpointFormat::applyDelta(char* data, const char* base, int length) {
+    for (int i = 0; i < length; i++)
+        data[i] ^= base[i];
+}
+
+void CheckpointFormat::compress(const char* data, int length, vector<char>& output, vector<char>& workspace) {
+    // Shuffle the bytes so that equivalent bytes of consecutive words are next to each other.
+
+    int numWords = length/WORD_SIZE;
+    vector<char>& shuffled = workspace;
+    shuffled.resize(length);
+    for (int word = 0; word < numWords; word++)
+        for (int byte = 0; byte < WORD_SIZE; byte++)
+            shuffled[byte*numWords+word] = data[word*WORD_SIZE+byte];
+    for (int i = numWords*WORD_SIZE; i < length; i++)
+        shuffled[i] = data[i];
+
+    // Encode it as alternating blocks of literal bytes and runs of zeros.
+
+    output.clear();
+    int pos = 0;
+    while (pos < length) {
+        int literalStart = pos;
+        int zeroStart = pos, zeroEnd = pos;
+        while (pos < length) {
+            if (shuffled[pos] != 0) {
+                pos++;
+                continue;
+            }
+            int end = pos;
+            while (end < length && shuffled[end] == 0)
+                end++;
+            if (end-pos >= MIN_ZERO_RUN || end == length) {
+                zeroStart = pos;
+                zeroEnd = end;
+                break;
+            }
+            pos = end;
+        }
+        if (pos == length)
+            zeroStart = zeroEnd = length;
+        writeCount(output, zeroStart-literalStart);
+        output.insert(output.end(), shuffled.begin()+literalStart, shuffled.begin()+zeroStart);
+        writeCount(output, zeroEnd-zeroStart);
+        pos = zeroEnd;
+    }
+}
+
+bool CheckpointFormat::decompress(const char* data, int length, char* output, int outputLength, vector<char>& workspace) {
+    workspace.resize(outputLength);
+    int inPos = 0, outPos = 0;
+    while (inPos < length) {
+        unsigned int literals, zeros;
+        if (!readCount(data, length, inPos, literals) || literals > (unsigned int) (length-inPos) || literals > (unsigned int) (outputLength-outPos))
+            return false;
+        for (unsigned int i = 0; i < literals; i++)
+            workspace[outPos++] = data[inPos++];
+        if (!readCount(data, length, inPos, zeros) || zeros > (unsigned int) (outputLength-outPos))
+            return false;
+        for (unsigned int i = 0; i < zeros; i++)
+            workspace[outPos++] = 0;
+    }
+    if (outPos != outputLength)
+        return false;
+    int numWords = outputLength/WORD_SIZE;
+    for (int word = 0; word < numWords; word++)
+        for (int byte = 0; byte < WORD_SIZE; byte++)
+            output[word*WORD_SIZE+byte] = workspace[byte*numWords+word];
+    for (int i = numWords*WORD_SIZE; i < outputLength; i++)
+        output[i] = workspace[i];
+    return true;
+}
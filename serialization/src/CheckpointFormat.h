@@ -0,0 +1,92 @@
+#ifndef OPENMM_CHECKPOINT_FORMAT_H_
+#define OPENMM_CHECKPOINT_FORMAT_H_
+
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include <string>
+#include <vector>
+
+namespace OpenMM {
+
+/**
+ * This class contains the definitions and encoding functions shared by CheckpointWriter and
+ * CheckpointReader.
+ *
+ * A checkpoint stream is a sequence of records.  Each record holds one State, serialized with
+ * BinarySerializer.  The serialized bytes are divided into fixed size chunks, and each chunk is
+ * stored with its own checksum.  A delta record stores the XOR of its bytes with the bytes of the
+ * previous record, which leaves most high order bytes of slowly changing values equal to zero.
+ * Compressed chunks are byte shuffled (all first bytes of each 8 byte word, then all second bytes,
+ * etc.) and then run length encoded, so those runs of zeros take almost no space.
+ */
+
+class CheckpointFormat {
+public:
+    static const char MAGIC_BYTES[];
+    static const int MAGIC_LENGTH;
+    static const int VERSION = 1;
+    static const int BYTE_ORDER_MARK = 0x01020304;
+    static const int MAX_CHUNK_SIZE = 1<<30;
+    /**
+     * Flags that describe a record.
+     */
+    enum RecordFlags {
+        DeltaRecord = 1
+    };
+    /**
+     * Flags that describe how a chunk is stored.
+     */
+    enum ChunkFlags {
+        CompressedChunk = 1
+    };
+    /**
+     * Compute the CRC-32 checksum of a block of data.
+     */
+    static unsigned int computeChecksum(const char* data, int length);
+    /**
+     * XOR a block of data with another one.
+     */
+    static void applyDelta(char* data, const char* base, int length);
+    /**
+     * Compress a block of data.  The result is stored in output, replacing any previous content.
+     */
+    static void compress(const char* data, int length, std::vector<char>& output, std::vector<char>& workspace);
+    /**
+     * Decompress a block of data that was compressed with compress().  The output must already
+     * have the size of the uncompressed data.  Returns false if the data is invalid.
+     */
+    static bool decompress(const char* data, int length, char* output, int outputLength, std::vector<char>& workspace);
+};
+
+} // namespace OpenMM
+
+#endif /*OPENMM_CHECKPOINT_FORMAT_H_*/
@@ -0,0 +1,158 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/serialization/CheckpointReader.h"
+#include "openmm/serialization/BinarySerializer.h"
+#include "openmm/OpenMMException.h"
+#include "CheckpointFormat.h"
+#include <cstring>
+#include <iostream>
+
+using namespace OpenMM;
+using namespace std;
+
+template <class T>
+static void readValue(istream& stream, T& value) {
+    stream.read((char*) &value, sizeof(T));
+    if (stream.fail())
+        throw OpenMMException("CheckpointReader: The checkpoint is incomplete");
+}
+
+CheckpointReader::CheckpointReader() : hasPrevious(false), previousChecksum(0) {
+}
+
+bool CheckpointReader::readCheckpoint(istream& stream, State& state) {
+    // Read and validate the header.
+
+    vector<char> magicBytes(CheckpointFormat::MAGIC_LENGTH);
+    stream.read(&magicBytes[0], CheckpointFormat::MAGIC_LENGTH);
+    if (stream.gcount() == 0 && stream.eof())
+        return false;
+    if (stream.fail())
+        throw OpenMMException("CheckpointReader: The checkpoint is incomplete");
+    if (memcmp(&magicBytes[0], CheckpointFormat::MAGIC_BYTES, CheckpointFormat::MAGIC_LENGTH) != 0)
+        throw OpenMMException("CheckpointReader: The stream does not contain a checkpoint");
+    int version, byteOrder, flags, chunkSize;
+    long long dataSize;
+    unsigned int dataChecksum, baseChecksum, headerChecksum;
+    const int headerSize = 4*sizeof(int)+sizeof(long long)+2*sizeof(unsigned int);
+    char header[headerSize];
+    stream.read(header, headerSize);
+    readValue(stream, headerChecksum);
+    if (headerChecksum != CheckpointFormat::computeChecksum(header, headerSize))
+        throw OpenMMException("CheckpointReader: The checkpoint header is damaged");
+    stringstream headerStream(string(header, headerSize));
+    readValue(headerStream, version);
+    readValue(headerStream, byteOrder);
+    readValue(headerStream, flags);
+    readValue(headerStream, dataSize);
+    readValue(headerStream, chunkSize);
+    readValue(headerStream, dataChecksum);
+    readValue(headerStream, baseChecksum);
+    if (version != CheckpointFormat::VERSION)
+        throw OpenMMException("CheckpointReader: Unsupported version number");
+    if (byteOrder != CheckpointFormat::BYTE_ORDER_MARK)
+        throw OpenMMException("CheckpointReader: The checkpoint was written on a machine with a different byte order");
+    if (chunkSize < 1 || chunkSize > CheckpointFormat::MAX_CHUNK_SIZE || dataSize < 0)
+        throw OpenMMException("CheckpointReader: The checkpoint header is damaged");
+    bool delta = ((flags&CheckpointFormat::DeltaRecord) != 0);
+    if (delta && (!hasPrevious || (long long) previousData.size() != dataSize || previousChecksum != baseChecksum))
+        throw OpenMMException("CheckpointReader: The checkpoint is stored as a delta, and the checkpoint it is relative to has not been read");
+
+    // Read the chunks.
+
+    data.resize(dataSize);
+    chunkChecksums.clear();
+    for (long long start = 0; start < dataSize; start += chunkSize) {
+        int length = (int) min((long long) chunkSize, dataSize-start);
+        unsigned char chunkFlags;
+        int storedLength;
+        unsigned int checksum;
+        readValue(stream, chunkFlags);
+        readValue(stream, storedLength);
+        readValue(stream, checksum);
+        if (storedLength < 0 || storedLength > length)
+            throw OpenMMException("CheckpointReader: The checkpoint is damaged");
+        char* output = &data[start];
+        if ((chunkFlags&CheckpointFormat::CompressedChunk) != 0) {
+            encoded.resize(storedLength);
+            if (storedLength > 0)
+                stream.read(&encoded[0], storedLength);
+            if (stream.fail())
+                throw OpenMMException("CheckpointReader: The checkpoint is incomplete");
+            if (!CheckpointFormat::decompress(&encoded[0], storedLength, output, length, workspace))
+                throw OpenMMException("CheckpointReader: The checkpoint is damaged");
+        }
+        else {
+            if (storedLength != length)
+                throw OpenMMException("CheckpointReader: The checkpoint is damaged");
+            stream.read(output, length);
+            if (stream.fail())
+                throw OpenMMException("CheckpointReader: The checkpoint is incomplete");
+        }
+        if (delta)
+            CheckpointFormat::applyDelta(output, &previousData[start], length);
+        if (checksum != CheckpointFormat::computeChecksum(output, length))
+            throw OpenMMException("CheckpointReader: The checkpoint is damaged");
+        chunkChecksums.push_back(checksum);
+    }
+    if (dataChecksum != CheckpointFormat::computeChecksum((char*) &chunkChecksums[0], chunkChecksums.size()*sizeof(unsigned int)))
+        throw OpenMMException("CheckpointReader: The checkpoint is damaged");
+
+    // Reconstruct the State.
+
+    serialized.str(data);
+    serialized.clear();
+    BinarySerializer::deserialize(serialized, state);
+    previousData.swap(data);
+    previousChecksum = dataChecksum;
+    hasPrevious = true;
+    return true;
+}
+
+void CheckpointReader::loadCheckpoint(istream& stream, Context& context) {
+    bool found = false;
+    while (true) {
+        try {
+            if (!readCheckpoint(stream, state))
+                break;
+            found = true;
+        }
+        catch (OpenMMException& ex) {
+            if (!found)
+                throw;
+            break;
+        }
+    }
+    if (!found)
+        throw OpenMMException("CheckpointReader: The stream does not contain a checkpoint");
+    context.setState(state);
+}
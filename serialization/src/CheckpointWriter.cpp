@@ -0,0 +1,152 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/serialization/CheckpointWriter.h"
+#include "openmm/serialization/BinarySerializer.h"
+#include "openmm/OpenMMException.h"
+#include "CheckpointFormat.h"
+#include <algorithm>
+#include <iostream>
+
+using namespace OpenMM;
+using namespace std;
+
+template <class T>
+static void writeValue(ostream& stream, const T& value) {
+    stream.write((char*) &value, sizeof(T));
+}
+
+CheckpointWriter::CheckpointWriter(bool compress, int keyframeInterval) : compress(compress), chunkSize(1<<22), checkpointsSinceKeyframe(0), previousChecksum(0) {
+    setKeyframeInterval(keyframeInterval);
+}
+
+bool CheckpointWriter::getCompress() const {
+    return compress;
+}
+
+void CheckpointWriter::setCompress(bool compress) {
+    this->compress = compress;
+}
+
+int CheckpointWriter::getKeyframeInterval() const {
+    return keyframeInterval;
+}
+
+void CheckpointWriter::setKeyframeInterval(int interval) {
+    if (interval < 1)
+        throw OpenMMException("CheckpointWriter: The keyframe interval must be at least 1");
+    keyframeInterval = interval;
+}
+
+int CheckpointWriter::getChunkSize() const {
+    return chunkSize;
+}
+
+void CheckpointWriter::setChunkSize(int size) {
+    if (size < 1 || size > CheckpointFormat::MAX_CHUNK_SIZE)
+        throw OpenMMException("CheckpointWriter: Illegal chunk size");
+    chunkSize = size;
+}
+
+void CheckpointWriter::reset() {
+    checkpointsSinceKeyframe = 0;
+}
+
+void CheckpointWriter::writeCheckpoint(const Context& context, ostream& stream) {
+    context.getState(state, State::Positions | State::Velocities | State::Parameters | State::IntegratorParameters);
+    writeCheckpoint(state, stream);
+}
+
+void CheckpointWriter::writeCheckpoint(const State& state, ostream& stream) {
+    serialized.str("");
+    serialized.clear();
+    BinarySerializer::serialize(state, serialized);
+    data = serialized.str();
+    bool delta = (checkpointsSinceKeyframe > 0 && checkpointsSinceKeyframe < keyframeInterval && data.size() == previousData.size());
+    if (!delta)
+        checkpointsSinceKeyframe = 0;
+
+    // Write the header.
+
+    int flags = (delta ? CheckpointFormat::DeltaRecord : 0);
+    long long dataSize = data.size();
+    chunkChecksums.clear();
+    for (long long start = 0; start < dataSize; start += chunkSize) {
+        int length = (int) min((long long) chunkSize, dataSize-start);
+        chunkChecksums.push_back(CheckpointFormat::computeChecksum(&data[start], length));
+    }
+    unsigned int dataChecksum = CheckpointFormat::computeChecksum((char*) &chunkChecksums[0], chunkChecksums.size()*sizeof(unsigned int));
+    unsigned int baseChecksum = (delta ? previousChecksum : 0);
+    stringstream header;
+    writeValue(header, CheckpointFormat::VERSION);
+    writeValue(header, CheckpointFormat::BYTE_ORDER_MARK);
+    writeValue(header, flags);
+    writeValue(header, dataSize);
+    writeValue(header, chunkSize);
+    writeValue(header, dataChecksum);
+    writeValue(header, baseChecksum);
+    string headerData = header.str();
+    stream.write(CheckpointFormat::MAGIC_BYTES, CheckpointFormat::MAGIC_LENGTH);
+    stream.write(headerData.c_str(), headerData.size());
+    writeValue(stream, CheckpointFormat::computeChecksum(headerData.c_str(), headerData.size()));
+
+    // Write the chunks.
+
+    for (int i = 0; i < chunkChecksums.size(); i++) {
+        long long start = i*(long long) chunkSize;
+        int length = (int) min((long long) chunkSize, dataSize-start);
+        unsigned int checksum = chunkChecksums[i];
+        chunk.assign(data.begin()+start, data.begin()+start+length);
+        if (delta)
+            CheckpointFormat::applyDelta(&chunk[0], &previousData[start], length);
+        const char* stored = &chunk[0];
+        int storedLength = length;
+        unsigned char chunkFlags = 0;
+        if (compress) {
+            CheckpointFormat::compress(&chunk[0], length, encoded, workspace);
+            if (encoded.size() < (size_t) length) {
+                stored = &encoded[0];
+                storedLength = encoded.size();
+                chunkFlags = CheckpointFormat::CompressedChunk;
+            }
+        }
+        writeValue(stream, chunkFlags);
+        writeValue(stream, storedLength);
+        writeValue(stream, checksum);
+        stream.write(stored, storedLength);
+    }
+    stream.flush();
+    if (stream.fail())
+        throw OpenMMException("CheckpointWriter: Failed to write checkpoint");
+    previousData.swap(data);
+    previousChecksum = dataChecksum;
+    checkpointsSinceKeyframe++;
+}
@@ -42,21 +42,56 @@ HarmonicAngleForceProxy::HarmonicAngleForceProxy() : SerializationProxy("Harmoni
 }
 
 void HarmonicAngleForceProxy::serialize(const void* object, SerializationNode& node) const {
+    serializeHeader(object, node);
+    SerializationNode& angles = node.createChildNode("Angles");
+    for (int i = 0; i < getNumElements(object, 0); i++)
+        serializeElement(object, 0, i, angles.createChildNode("Angle"));
+}
+
+void* HarmonicAngleForceProxy::deserialize(const SerializationNode& node) const {
+    HarmonicAngleForce* force = reinterpret_cast<HarmonicAngleForce*>(deserializeHeader(node));
+    try {
+        const SerializationNode& angles = node.getChildNode("Angles");
+        for (auto& angle : angles.getChildren())
+            deserializeElement(angle, 0, force);
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
+
+int HarmonicAngleForceProxy::getNumElementLists() const {
+    return 1;
+}
+
+void HarmonicAngleForceProxy::getElementListNames(int list, string& listName, string& elementName) const {
+    listName = "Angles";
+    elementName = "Angle";
+}
+
+int HarmonicAngleForceProxy::getNumElements(const void* object, int list) const {
+    return reinterpret_cast<const HarmonicAngleForce*>(object)->getNumAngles();
+}
+
+void HarmonicAngleForceProxy::serializeHeader(const void* object, SerializationNode& node) const {
     node.setIntProperty("version", 2);
     const HarmonicAngleForce& force = *reinterpret_cast<const HarmonicAngleForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
     node.setBoolProperty("usesPeriodic", force.usesPeriodicBoundaryConditions());
-    SerializationNode& bonds = node.createChildNode("Angles");
-    for (int i = 0; i < force.getNumAngles(); i++) {
-        int particle1, particle2, particle3;
-        double angle, k;
-        force.getAngleParameters(i, particle1, particle2, particle3, angle, k);
-        bonds.createChildNode("Angle").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setIntProperty("p3", particle3).setDoubleProperty("a", angle).setDoubleProperty("k", k);
-    }
 }
 
-void* HarmonicAngleForceProxy::deserialize(const SerializationNode& node) const {
+void HarmonicAngleForceProxy::serializeElement(const void* object, int list, int index, SerializationNode& element) const {
+    const HarmonicAngleForce& force = *reinterpret_cast<const HarmonicAngleForce*>(object);
+    int particle1, particle2, particle3;
+    double angle, k;
+    force.getAngleParameters(index, particle1, particle2, particle3, angle, k);
+    element.setIntProperty("p1", particle1).setIntProperty("p2", particle2).setIntProperty("p3", particle3).setDoubleProperty("a", angle).setDoubleProperty("k", k);
+}
+
+void* HarmonicAngleForceProxy::deserializeHeader(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
     if (version < 1 || version > 2)
         throw OpenMMException("Unsupported version number");
@@ -66,9 +101,6 @@ void* HarmonicAngleForceProxy::deserialize(const SerializationNode& node) const
         force->setName(node.getStringProperty("name", force->getName()));
         if (version > 1)
             force->setUsesPeriodicBoundaryConditions(node.getBoolProperty("usesPeriodic"));
-        const SerializationNode& angles = node.getChildNode("Angles");
-        for (auto& angle : angles.getChildren())
-            force->addAngle(angle.getIntProperty("p1"), angle.getIntProperty("p2"), angle.getIntProperty("p3"), angle.getDoubleProperty("a"), angle.getDoubleProperty("k"));
     }
     catch (...) {
         delete force;
@@ -77,3 +109,6 @@ void* HarmonicAngleForceProxy::deserialize(const SerializationNode& node) const
     return force;
 }
 
+void HarmonicAngleForceProxy::deserializeElement(const SerializationNode& element, int list, void* object) const {
+    reinterpret_cast<HarmonicAngleForce*>(object)->addAngle(element.getIntProperty("p1"), element.getIntProperty("p2"), element.getIntProperty("p3"), element.getDoubleProperty("a"), element.getDoubleProperty("k"));
+}
@@ -42,21 +42,56 @@ HarmonicBondForceProxy::HarmonicBondForceProxy() : SerializationProxy("HarmonicB
 }
 
 void HarmonicBondForceProxy::serialize(const void* object, SerializationNode& node) const {
+    serializeHeader(object, node);
+    SerializationNode& bonds = node.createChildNode("Bonds");
+    for (int i = 0; i < getNumElements(object, 0); i++)
+        serializeElement(object, 0, i, bonds.createChildNode("Bond"));
+}
+
+void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
+    HarmonicBondForce* force = reinterpret_cast<HarmonicBondForce*>(deserializeHeader(node));
+    try {
+        const SerializationNode& bonds = node.getChildNode("Bonds");
+        for (auto& bond : bonds.getChildren())
+            deserializeElement(bond, 0, force);
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
+
+int HarmonicBondForceProxy::getNumElementLists() const {
+    return 1;
+}
+
+void HarmonicBondForceProxy::getElementListNames(int list, string& listName, string& elementName) const {
+    listName = "Bonds";
+    elementName = "Bond";
+}
+
+int HarmonicBondForceProxy::getNumElements(const void* object, int list) const {
+    return reinterpret_cast<const HarmonicBondForce*>(object)->getNumBonds();
+}
+
+void HarmonicBondForceProxy::serializeHeader(const void* object, SerializationNode& node) const {
     node.setIntProperty("version", 2);
     const HarmonicBondForce& force = *reinterpret_cast<const HarmonicBondForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
     node.setBoolProperty("usesPeriodic", force.usesPeriodicBoundaryConditions());
-    SerializationNode& bonds = node.createChildNode("Bonds");
-    for (int i = 0; i < force.getNumBonds(); i++) {
-        int particle1, particle2;
-        double distance, k;
-        force.getBondParameters(i, particle1, particle2, distance, k);
-        bonds.createChildNode("Bond").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setDoubleProperty("d", distance).setDoubleProperty("k", k);
-    }
 }
 
-void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
+void HarmonicBondForceProxy::serializeElement(const void* object, int list, int index, SerializationNode& element) const {
+    const HarmonicBondForce& force = *reinterpret_cast<const HarmonicBondForce*>(object);
+    int particle1, particle2;
+    double distance, k;
+    force.getBondParameters(index, particle1, particle2, distance, k);
+    element.setIntProperty("p1", particle1).setIntProperty("p2", particle2).setDoubleProperty("d", distance).setDoubleProperty("k", k);
+}
+
+void* HarmonicBondForceProxy::deserializeHeader(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
     if (version < 1 || version > 2)
         throw OpenMMException("Unsupported version number");
@@ -66,9 +101,6 @@ void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
         force->setName(node.getStringProperty("name", force->getName()));
         if (version > 1)
             force->setUsesPeriodicBoundaryConditions(node.getBoolProperty("usesPeriodic"));
-        const SerializationNode& bonds = node.getChildNode("Bonds");
-        for (auto& bond : bonds.getChildren())
-            force->addBond(bond.getIntProperty("p1"), bond.getIntProperty("p2"), bond.getDoubleProperty("d"), bond.getDoubleProperty("k"));
     }
     catch (...) {
         delete force;
@@ -76,3 +108,7 @@ void* HarmonicBondForceProxy::deserialize(const SerializationNode& node) const {
     }
     return force;
 }
+
+void HarmonicBondForceProxy::deserializeElement(const SerializationNode& element, int list, void* object) const {
+    reinterpret_cast<HarmonicBondForce*>(object)->addBond(element.getIntProperty("p1"), element.getIntProperty("p2"), element.getDoubleProperty("d"), element.getDoubleProperty("k"));
+}
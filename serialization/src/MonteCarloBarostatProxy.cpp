@@ -42,7 +42,7 @@ MonteCarloBarostatProxy::MonteCarloBarostatProxy() : SerializationProxy("MonteCa
 }
 
 void MonteCarloBarostatProxy::serialize(const void* object, SerializationNode& node) const {
-    node.setIntProperty("version", 1);
+    node.setIntProperty("version", 2);
     const MonteCarloBarostat& force = *reinterpret_cast<const MonteCarloBarostat*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
@@ -50,10 +50,12 @@ void MonteCarloBarostatProxy::serialize(const void* object, SerializationNode& n
     node.setDoubleProperty("temperature", force.getDefaultTemperature());
     node.setIntProperty("frequency", force.getFrequency());
     node.setIntProperty("randomSeed", force.getRandomNumberSeed());
+    node.setBoolProperty("incrementalEnergy", force.getUseIncrementalEnergy());
 }
 
 void* MonteCarloBarostatProxy::deserialize(const SerializationNode& node) const {
-    if (node.getIntProperty("version") != 1)
+    int version = node.getIntProperty("version");
+    if (version < 1 || version > 2)
         throw OpenMMException("Unsupported version number");
     MonteCarloBarostat* force = NULL;
     try {
@@ -61,6 +63,8 @@ void* MonteCarloBarostatProxy::deserialize(const SerializationNode& node) const
         force->setForceGroup(node.getIntProperty("forceGroup", 0));
         force->setName(node.getStringProperty("name", force->getName()));
         force->setRandomNumberSeed(node.getIntProperty("randomSeed"));
+        if (version > 1)
+            force->setUseIncrementalEnergy(node.getBoolProperty("incrementalEnergy"));
         return force;
     }
     catch (...) {
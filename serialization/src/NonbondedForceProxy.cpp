@@ -42,6 +42,47 @@ NonbondedForceProxy::NonbondedForceProxy() : SerializationProxy("NonbondedForce"
 }
 
 void NonbondedForceProxy::serialize(const void* object, SerializationNode& node) const {
+    serializeHeader(object, node);
+    SerializationNode& particles = node.createChildNode("Particles");
+    for (int i = 0; i < getNumElements(object, 0); i++)
+        serializeElement(object, 0, i, particles.createChildNode("Particle"));
+    SerializationNode& exceptions = node.createChildNode("Exceptions");
+    for (int i = 0; i < getNumElements(object, 1); i++)
+        serializeElement(object, 1, i, exceptions.createChildNode("Exception"));
+}
+
+void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
+    NonbondedForce* force = reinterpret_cast<NonbondedForce*>(deserializeHeader(node));
+    try {
+        const SerializationNode& particles = node.getChildNode("Particles");
+        for (auto& particle : particles.getChildren())
+            deserializeElement(particle, 0, force);
+        const SerializationNode& exceptions = node.getChildNode("Exceptions");
+        for (auto& exception : exceptions.getChildren())
+            deserializeElement(exception, 1, force);
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
+
+int NonbondedForceProxy::getNumElementLists() const {
+    return 2;
+}
+
+void NonbondedForceProxy::getElementListNames(int list, string& listName, string& elementName) const {
+    listName = (list == 0 ? "Particles" : "Exceptions");
+    elementName = (list == 0 ? "Particle" : "Exception");
+}
+
+int NonbondedForceProxy::getNumElements(const void* object, int list) const {
+    const NonbondedForce& force = *reinterpret_cast<const NonbondedForce*>(object);
+    return (list == 0 ? force.getNumParticles() : force.getNumExceptions());
+}
+
+void NonbondedForceProxy::serializeHeader(const void* object, SerializationNode& node) const {
     node.setIntProperty("version", 4);
     const NonbondedForce& force = *reinterpret_cast<const NonbondedForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
@@ -87,22 +128,24 @@ void NonbondedForceProxy::serialize(const void* object, SerializationNode& node)
         force.getExceptionParameterOffset(i, parameter, exception, chargeProdScale, sigmaScale, epsilonScale);
         exceptionOffsets.createChildNode("Offset").setStringProperty("parameter", parameter).setIntProperty("exception", exception).setDoubleProperty("q", chargeProdScale).setDoubleProperty("sig", sigmaScale).setDoubleProperty("eps", epsilonScale);
     }
-    SerializationNode& particles = node.createChildNode("Particles");
-    for (int i = 0; i < force.getNumParticles(); i++) {
+}
+
+void NonbondedForceProxy::serializeElement(const void* object, int list, int index, SerializationNode& element) const {
+    const NonbondedForce& force = *reinterpret_cast<const NonbondedForce*>(object);
+    if (list == 0) {
         double charge, sigma, epsilon;
-        force.getParticleParameters(i, charge, sigma, epsilon);
-        particles.createChildNode("Particle").setDoubleProperty("q", charge).setDoubleProperty("sig", sigma).setDoubleProperty("eps", epsilon);
+        force.getParticleParameters(index, charge, sigma, epsilon);
+        element.setDoubleProperty("q", charge).setDoubleProperty("sig", sigma).setDoubleProperty("eps", epsilon);
     }
-    SerializationNode& exceptions = node.createChildNode("Exceptions");
-    for (int i = 0; i < force.getNumExceptions(); i++) {
+    else {
         int particle1, particle2;
         double chargeProd, sigma, epsilon;
-        force.getExceptionParameters(i, particle1, particle2, chargeProd, sigma, epsilon);
-        exceptions.createChildNode("Exception").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setDoubleProperty("q", chargeProd).setDoubleProperty("sig", sigma).setDoubleProperty("eps", epsilon);
+        force.getExceptionParameters(index, particle1, particle2, chargeProd, sigma, epsilon);
+        element.setIntProperty("p1", particle1).setIntProperty("p2", particle2).setDoubleProperty("q", chargeProd).setDoubleProperty("sig", sigma).setDoubleProperty("eps", epsilon);
     }
 }
 
-void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
+void* NonbondedForceProxy::deserializeHeader(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
     if (version < 1 || version > 4)
         throw OpenMMException("Unsupported version number");
@@ -145,12 +188,6 @@ void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
         }
         if (version >= 4)
             force->setExceptionsUsePeriodicBoundaryConditions(node.getIntProperty("exceptionsUsePeriodic"));
-        const SerializationNode& particles = node.getChildNode("Particles");
-        for (auto& particle : particles.getChildren())
-            force->addParticle(particle.getDoubleProperty("q"), particle.getDoubleProperty("sig"), particle.getDoubleProperty("eps"));
-        const SerializationNode& exceptions = node.getChildNode("Exceptions");
-        for (auto& exception : exceptions.getChildren())
-            force->addException(exception.getIntProperty("p1"), exception.getIntProperty("p2"), exception.getDoubleProperty("q"), exception.getDoubleProperty("sig"), exception.getDoubleProperty("eps"));
     }
     catch (...) {
         delete force;
@@ -158,3 +195,11 @@ void* NonbondedForceProxy::deserialize(const SerializationNode& node) const {
     }
     return force;
 }
+
+void NonbondedForceProxy::deserializeElement(const SerializationNode& element, int list, void* object) const {
+    NonbondedForce& force = *reinterpret_cast<NonbondedForce*>(object);
+    if (list == 0)
+        force.addParticle(element.getDoubleProperty("q"), element.getDoubleProperty("sig"), element.getDoubleProperty("eps"));
+    else
+        force.addException(element.getIntProperty("p1"), element.getIntProperty("p2"), element.getDoubleProperty("q"), element.getDoubleProperty("sig"), element.getDoubleProperty("eps"));
+}
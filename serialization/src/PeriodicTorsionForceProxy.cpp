@@ -42,21 +42,56 @@ PeriodicTorsionForceProxy::PeriodicTorsionForceProxy() : SerializationProxy("Per
 }
 
 void PeriodicTorsionForceProxy::serialize(const void* object, SerializationNode& node) const {
+    serializeHeader(object, node);
+    SerializationNode& torsions = node.createChildNode("Torsions");
+    for (int i = 0; i < getNumElements(object, 0); i++)
+        serializeElement(object, 0, i, torsions.createChildNode("Torsion"));
+}
+
+void* PeriodicTorsionForceProxy::deserialize(const SerializationNode& node) const {
+    PeriodicTorsionForce* force = reinterpret_cast<PeriodicTorsionForce*>(deserializeHeader(node));
+    try {
+        const SerializationNode& torsions = node.getChildNode("Torsions");
+        for (auto& torsion : torsions.getChildren())
+            deserializeElement(torsion, 0, force);
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
+
+int PeriodicTorsionForceProxy::getNumElementLists() const {
+    return 1;
+}
+
+void PeriodicTorsionForceProxy::getElementListNames(int list, string& listName, string& elementName) const {
+    listName = "Torsions";
+    elementName = "Torsion";
+}
+
+int PeriodicTorsionForceProxy::getNumElements(const void* object, int list) const {
+    return reinterpret_cast<const PeriodicTorsionForce*>(object)->getNumTorsions();
+}
+
+void PeriodicTorsionForceProxy::serializeHeader(const void* object, SerializationNode& node) const {
     node.setIntProperty("version", 2);
     const PeriodicTorsionForce& force = *reinterpret_cast<const PeriodicTorsionForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
     node.setBoolProperty("usesPeriodic", force.usesPeriodicBoundaryConditions());
-    SerializationNode& torsions = node.createChildNode("Torsions");
-    for (int i = 0; i < force.getNumTorsions(); i++) {
-        int particle1, particle2, particle3, particle4, periodicity;
-        double phase, k;
-        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, periodicity, phase, k);
-        torsions.createChildNode("Torsion").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setIntProperty("p3", particle3).setIntProperty("p4", particle4).setIntProperty("periodicity", periodicity).setDoubleProperty("phase", phase).setDoubleProperty("k", k);
-    }
 }
 
-void* PeriodicTorsionForceProxy::deserialize(const SerializationNode& node) const {
+void PeriodicTorsionForceProxy::serializeElement(const void* object, int list, int index, SerializationNode& element) const {
+    const PeriodicTorsionForce& force = *reinterpret_cast<const PeriodicTorsionForce*>(object);
+    int particle1, particle2, particle3, particle4, periodicity;
+    double phase, k;
+    force.getTorsionParameters(index, particle1, particle2, particle3, particle4, periodicity, phase, k);
+    element.setIntProperty("p1", particle1).setIntProperty("p2", particle2).setIntProperty("p3", particle3).setIntProperty("p4", particle4).setIntProperty("periodicity", periodicity).setDoubleProperty("phase", phase).setDoubleProperty("k", k);
+}
+
+void* PeriodicTorsionForceProxy::deserializeHeader(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
     if (version < 1 || version > 2)
         throw OpenMMException("Unsupported version number");
@@ -66,10 +101,6 @@ void* PeriodicTorsionForceProxy::deserialize(const SerializationNode& node) cons
         force->setName(node.getStringProperty("name", force->getName()));
         if (version > 1)
             force->setUsesPeriodicBoundaryConditions(node.getBoolProperty("usesPeriodic"));
-        const SerializationNode& torsions = node.getChildNode("Torsions");
-        for (auto& torsion : torsions.getChildren())
-            force->addTorsion(torsion.getIntProperty("p1"), torsion.getIntProperty("p2"), torsion.getIntProperty("p3"), torsion.getIntProperty("p4"),
-                    torsion.getIntProperty("periodicity"), torsion.getDoubleProperty("phase"), torsion.getDoubleProperty("k"));
     }
     catch (...) {
         delete force;
@@ -77,3 +108,8 @@ void* PeriodicTorsionForceProxy::deserialize(const SerializationNode& node) cons
     }
     return force;
 }
+
+void PeriodicTorsionForceProxy::deserializeElement(const SerializationNode& element, int list, void* object) const {
+    reinterpret_cast<PeriodicTorsionForce*>(object)->addTorsion(element.getIntProperty("p1"), element.getIntProperty("p2"), element.getIntProperty("p3"), element.getIntProperty("p4"),
+            element.getIntProperty("periodicity"), element.getDoubleProperty("phase"), element.getDoubleProperty("k"));
+}
@@ -42,21 +42,56 @@ RBTorsionForceProxy::RBTorsionForceProxy() : SerializationProxy("RBTorsionForce"
 }
 
 void RBTorsionForceProxy::serialize(const void* object, SerializationNode& node) const {
+    serializeHeader(object, node);
+    SerializationNode& torsions = node.createChildNode("Torsions");
+    for (int i = 0; i < getNumElements(object, 0); i++)
+        serializeElement(object, 0, i, torsions.createChildNode("Torsion"));
+}
+
+void* RBTorsionForceProxy::deserialize(const SerializationNode& node) const {
+    RBTorsionForce* force = reinterpret_cast<RBTorsionForce*>(deserializeHeader(node));
+    try {
+        const SerializationNode& torsions = node.getChildNode("Torsions");
+        for (auto& torsion : torsions.getChildren())
+            deserializeElement(torsion, 0, force);
+    }
+    catch (...) {
+        delete force;
+        throw;
+    }
+    return force;
+}
+
+int RBTorsionForceProxy::getNumElementLists() const {
+    return 1;
+}
+
+void RBTorsionForceProxy::getElementListNames(int list, string& listName, string& elementName) const {
+    listName = "Torsions";
+    elementName = "Torsion";
+}
+
+int RBTorsionForceProxy::getNumElements(const void* object, int list) const {
+    return reinterpret_cast<const RBTorsionForce*>(object)->getNumTorsions();
+}
+
+void RBTorsionForceProxy::serializeHeader(const void* object, SerializationNode& node) const {
     node.setIntProperty("version", 2);
     const RBTorsionForce& force = *reinterpret_cast<const RBTorsionForce*>(object);
     node.setIntProperty("forceGroup", force.getForceGroup());
     node.setStringProperty("name", force.getName());
     node.setBoolProperty("usesPeriodic", force.usesPeriodicBoundaryConditions());
-    SerializationNode& torsions = node.createChildNode("Torsions");
-    for (int i = 0; i < force.getNumTorsions(); i++) {
-        int particle1, particle2, particle3, particle4;
-        double c0, c1, c2, c3, c4, c5;
-        force.getTorsionParameters(i, particle1, particle2, particle3, particle4, c0, c1, c2, c3, c4, c5);
-        torsions.createChildNode("Torsion").setIntProperty("p1", particle1).setIntProperty("p2", particle2).setIntProperty("p3", particle3).setIntProperty("p4", particle4).setDoubleProperty("c0", c0).setDoubleProperty("c1", c1).setDoubleProperty("c2", c2).setDoubleProperty("c3", c3).setDoubleProperty("c4", c4).setDoubleProperty("c5", c5);
-    }
 }
 
-void* RBTorsionForceProxy::deserialize(const SerializationNode& node) const {
+void RBTorsionForceProxy::serializeElement(const void* object, int list, int index, SerializationNode& element) const {
+    const RBTorsionForce& force = *reinterpret_cast<const RBTorsionForce*>(object);
+    int particle1, particle2, particle3, particle4;
+    double c0, c1, c2, c3, c4, c5;
+    force.getTorsionParameters(index, particle1, particle2, particle3, particle4, c0, c1, c2, c3, c4, c5);
+    element.setIntProperty("p1", particle1).setIntProperty("p2", particle2).setIntProperty("p3", particle3).setIntProperty("p4", particle4).setDoubleProperty("c0", c0).setDoubleProperty("c1", c1).setDoubleProperty("c2", c2).setDoubleProperty("c3", c3).setDoubleProperty("c4", c4).setDoubleProperty("c5", c5);
+}
+
+void* RBTorsionForceProxy::deserializeHeader(const SerializationNode& node) const {
     int version = node.getIntProperty("version");
     if (version < 1 || version > 2)
         throw OpenMMException("Unsupported version number");
@@ -66,11 +101,6 @@ void* RBTorsionForceProxy::deserialize(const SerializationNode& node) const {
         force->setName(node.getStringProperty("name", force->getName()));
         if (version > 1)
             force->setUsesPeriodicBoundaryConditions(node.getBoolProperty("usesPeriodic"));
-        const SerializationNode& torsions = node.getChildNode("Torsions");
-        for (auto& torsion : torsions.getChildren())
-            force->addTorsion(torsion.getIntProperty("p1"), torsion.getIntProperty("p2"), torsion.getIntProperty("p3"), torsion.getIntProperty("p4"),
-                    torsion.getDoubleProperty("c0"), torsion.getDoubleProperty("c1"), torsion.getDoubleProperty("c2"),
-                    torsion.getDoubleProperty("c3"), torsion.getDoubleProperty("c4"), torsion.getDoubleProperty("c5"));
     }
     catch (...) {
         delete force;
@@ -79,3 +109,8 @@ void* RBTorsionForceProxy::deserialize(const SerializationNode& node) const {
     return force;
 }
 
+void RBTorsionForceProxy::deserializeElement(const SerializationNode& element, int list, void* object) const {
+    reinterpret_cast<RBTorsionForce*>(object)->addTorsion(element.getIntProperty("p1"), element.getIntProperty("p2"), element.getIntProperty("p3"), element.getIntProperty("p4"),
+            element.getDoubleProperty("c0"), element.getDoubleProperty("c1"), element.getDoubleProperty("c2"),
+            element.getDoubleProperty("c3"), element.getDoubleProperty("c4"), element.getDoubleProperty("c5"));
+}
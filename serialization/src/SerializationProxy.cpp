@@ -53,6 +53,34 @@ const string& SerializationProxy::getTypeName() const {
     return typeName;
 }
 
+int SerializationProxy::getNumElementLists() const {
+    return 0;
+}
+
+void SerializationProxy::getElementListNames(int list, string& listName, string& elementName) const {
+    throw OpenMMException(typeName+" does not support element lists");
+}
+
+int SerializationProxy::getNumElements(const void* object, int list) const {
+    throw OpenMMException(typeName+" does not support element lists");
+}
+
+void SerializationProxy::serializeHeader(const void* object, SerializationNode& node) const {
+    throw OpenMMException(typeName+" does not support element lists");
+}
+
+void SerializationProxy::serializeElement(const void* object, int list, int index, SerializationNode& element) const {
+    throw OpenMMException(typeName+" does not support element lists");
+}
+
+void* SerializationProxy::deserializeHeader(const SerializationNode& node) const {
+    throw OpenMMException(typeName+" does not support element lists");
+}
+
+void SerializationProxy::deserializeElement(const SerializationNode& element, int list, void* object) const {
+    throw OpenMMException(typeName+" does not support element lists");
+}
+
 void SerializationProxy::registerProxy(const type_info& type, const SerializationProxy* proxy) {
     getProxiesByType()[type.name()] = proxy;
     getProxiesByName()[proxy->getTypeName()] = proxy;
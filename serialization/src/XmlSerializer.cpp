@@ -30,10 +30,13 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/serialization/XmlSerializer.h"
+#include "openmm/serialization/SystemProxy.h"
+#include "openmm/Force.h"
+#include "openmm/System.h"
 #include "irrXML.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
-#include <map>
 
 using namespace OpenMM;
 using namespace std;
@@ -44,15 +47,17 @@ using namespace io;
  * Apply XML encoding to a string.  This is adapted from TinyXML (written by Lee Thomason).
  */
 static void encodeString(const string& str, string* outString) {
-    static map<char, string> entities;
-    static bool hasInitialized = false;
-    if (!hasInitialized) {
-        hasInitialized = true;
-	entities['&'] = "&amp;";
-	entities['<'] = "&lt;";
-	entities['>'] = "&gt;";
-	entities['\"'] = "&quot;";
-	entities['\''] = "&apos;";
+    // Most strings contain no characters that need encoding, so check for that case first.
+
+    bool needsEncoding = false;
+    for (char c : str)
+        if (c == '&' || c == '<' || c == '>' || c == '\"' || c == '\'' || (unsigned char) c < 32) {
+            needsEncoding = true;
+            break;
+        }
+    if (!needsEncoding) {
+        *outString = str;
+        return;
     }
 
     int i=0;
@@ -81,8 +86,24 @@ static void encodeString(const string& str, string* outString) {
                     break;
             }
         }
-        else if (entities.find(c) != entities.end()) {
-            outString->append(entities[c]);
+        else if (c == '&') {
+            outString->append("&amp;");
+            ++i;
+        }
+        else if (c == '<') {
+            outString->append("&lt;");
+            ++i;
+        }
+        else if (c == '>') {
+            outString->append("&gt;");
+            ++i;
+        }
+        else if (c == '\"') {
+            outString->append("&quot;");
+            ++i;
+        }
+        else if (c == '\'') {
+            outString->append("&apos;");
             ++i;
         }
         else if (c < 32) {
@@ -106,32 +127,146 @@ static void encodeString(const string& str, string* outString) {
     }
 }
 
-void XmlSerializer::serialize(const SerializationNode& node, std::ostream& stream) {
-    stream << "<?xml version=\"1.0\" ?>\n";
-    encodeNode(node, stream, 0);
-}
-
-void XmlSerializer::encodeNode(const SerializationNode& node, std::ostream& stream, int depth) {
+/**
+ * Write the start tag for a node, including its properties.
+ */
+static void encodeStartTag(const SerializationNode& node, ostream& stream, int depth, bool hasChildren) {
+    string name, value;
     for (int i = 0; i < depth; i++)
         stream << '\t';
     stream << '<' << node.getName();
     for (auto& prop : node.getProperties()) {
-        string name, value;
+        name.clear();
+        value.clear();
         encodeString(prop.first, &name);
         encodeString(prop.second, &value);
         stream << ' ' << name << "=\"" << value << '\"';
     }
+    stream << (hasChildren ? ">\n" : "/>\n");
+}
+
+/**
+ * Write the end tag for a node.
+ */
+static void encodeEndTag(const string& name, ostream& stream, int depth) {
+    for (int i = 0; i < depth; i++)
+        stream << '\t';
+    stream << "</" << name << ">\n";
+}
+
+void XmlSerializer::serialize(const SerializationNode& node, std::ostream& stream) {
+    stream << "<?xml version=\"1.0\" ?>\n";
+    encodeNode(node, stream, 0);
+}
+
+void XmlSerializer::encodeNode(const SerializationNode& node, std::ostream& stream, int depth) {
     const vector<SerializationNode>& children = node.getChildren();
-    if (children.size() == 0)
-        stream << "/>\n";
-    else {
-        stream << ">\n";
+    encodeStartTag(node, stream, depth, children.size() > 0);
+    if (children.size() > 0) {
         for (auto& child : children)
             encodeNode(child, stream, depth+1);
-        for (int i = 0; i < depth; i++)
-            stream << '\t';
-        stream << "</" << node.getName() << ">\n";
+        encodeEndTag(node.getName(), stream, depth);
+    }
+}
+
+void XmlSerializer::serializeObject(const void* object, const type_info& type, const string& rootName, ostream& stream) {
+    if (type == typeid(System)) {
+        serializeSystem(*reinterpret_cast<const System*>(object), rootName, stream);
+        return;
+    }
+    const SerializationProxy& proxy = SerializationProxy::getProxy(type);
+    SerializationNode node;
+    node.setName(rootName);
+    proxy.serialize(object, node);
+    if (node.hasProperty("type"))
+        throw OpenMMException(proxy.getTypeName()+" created node with reserved property 'type'");
+    node.setStringProperty("type", proxy.getTypeName());
+    serialize(node, stream);
+}
+
+void XmlSerializer::serializeSystem(const System& system, const string& rootName, ostream& stream) {
+    // This produces exactly the same output as SystemProxy, but only creates the
+    // SerializationNodes for one particle, constraint, or Force at a time.
+
+    stream << "<?xml version=\"1.0\" ?>\n";
+    SerializationNode root;
+    root.setName(rootName);
+    SystemProxy::serializeHeader(system, root);
+    root.setStringProperty("type", SerializationProxy::getProxy(typeid(System)).getTypeName());
+    encodeStartTag(root, stream, 0, true);
+    SerializationNode box;
+    box.setName("PeriodicBoxVectors");
+    SystemProxy::serializeBoxVectors(system, box);
+    encodeNode(box, stream, 1);
+    SerializationNode section;
+    section.setName("Particles");
+    encodeStartTag(section, stream, 1, system.getNumParticles() > 0);
+    for (int i = 0; i < system.getNumParticles(); i++) {
+        SerializationNode particle;
+        particle.setName("Particle");
+        SystemProxy::serializeParticle(system, i, particle);
+        encodeNode(particle, stream, 2);
+    }
+    if (system.getNumParticles() > 0)
+        encodeEndTag(section.getName(), stream, 1);
+    section.setName("Constraints");
+    encodeStartTag(section, stream, 1, system.getNumConstraints() > 0);
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        SerializationNode constraint;
+        constraint.setName("Constraint");
+        SystemProxy::serializeConstraint(system, i, constraint);
+        encodeNode(constraint, stream, 2);
     }
+    if (system.getNumConstraints() > 0)
+        encodeEndTag(section.getName(), stream, 1);
+    section.setName("Forces");
+    encodeStartTag(section, stream, 1, system.getNumForces() > 0);
+    for (int i = 0; i < system.getNumForces(); i++)
+        encodeObject(&system.getForce(i), typeid(system.getForce(i)), "Force", stream, 2);
+    if (system.getNumForces() > 0)
+        encodeEndTag(section.getName(), stream, 1);
+    encodeEndTag(rootName, stream, 0);
+}
+
+void XmlSerializer::encodeObject(const void* object, const type_info& type, const string& name, ostream& stream, int depth) {
+    // If the proxy supports element lists, create the SerializationNode for each element only
+    // while it is being written.
+
+    const SerializationProxy& proxy = SerializationProxy::getProxy(type);
+    int numLists = proxy.getNumElementLists();
+    SerializationNode node;
+    node.setName(name);
+    if (numLists == 0)
+        proxy.serialize(object, node);
+    else
+        proxy.serializeHeader(object, node);
+    if (node.hasProperty("type"))
+        throw OpenMMException(proxy.getTypeName()+" created node with reserved property 'type'");
+    node.setStringProperty("type", proxy.getTypeName());
+    if (numLists == 0) {
+        encodeNode(node, stream, depth);
+        return;
+    }
+    encodeStartTag(node, stream, depth, true);
+    for (auto& child : node.getChildren())
+        encodeNode(child, stream, depth+1);
+    string listName, elementName;
+    for (int list = 0; list < numLists; list++) {
+        proxy.getElementListNames(list, listName, elementName);
+        int numElements = proxy.getNumElements(object, list);
+        SerializationNode listNode;
+        listNode.setName(listName);
+        encodeStartTag(listNode, stream, depth+1, numElements > 0);
+        for (int i = 0; i < numElements; i++) {
+            SerializationNode element;
+            element.setName(elementName);
+            proxy.serializeElement(object, list, i, element);
+            encodeNode(element, stream, depth+2);
+        }
+        if (numElements > 0)
+            encodeEndTag(listName, stream, depth+1);
+    }
+    encodeEndTag(name, stream, depth);
 }
 
 /**
@@ -178,6 +313,157 @@ static void decodeNode(SerializationNode& node, IrrXMLReader& xml) {
     }
 }
 
+/**
+ * Process the children of an XML node that lists particles, constraints, or Forces.  Each one is
+ * decoded into a SerializationNode and passed to a function, after which it is discarded.
+ */
+template <class F>
+static void decodeChildren(IrrXMLReader& xml, F process) {
+    if (xml.isEmptyElement())
+        return;
+    while (xml.read()) {
+        switch (xml.getNodeType()) {
+            case EXN_ELEMENT:
+            {
+                SerializationNode child;
+                child.setName(xml.getNodeName());
+                decodeNode(child, xml);
+                process(child);
+                break;
+            }
+            case EXN_ELEMENT_END:
+                return;
+        }
+    }
+}
+
+/**
+ * Create an object from XML.  If its proxy supports element lists, each element is added to the
+ * object as soon as it has been read, rather than first decoding the whole object into SerializationNodes.
+ * That requires all other children to come before the element lists.  If one comes after them, the
+ * elements read so far (if any) are converted back to SerializationNodes and the rest of the object is
+ * decoded into SerializationNodes too.
+ */
+template <class T>
+static T* decodeObject(IrrXMLReader& xml) {
+    SerializationNode node;
+    node.setName(xml.getNodeName());
+    for (int i = 0; i < xml.getAttributeCount(); i++)
+        node.setStringProperty(xml.getAttributeName(i), xml.getAttributeValue(i));
+    const SerializationProxy& proxy = SerializationProxy::getProxy(node.getStringProperty("type"));
+    int numLists = proxy.getNumElementLists();
+    if (numLists == 0) {
+        decodeNode(node, xml);
+        return reinterpret_cast<T*>(proxy.deserialize(node));
+    }
+    vector<string> listNames(numLists), elementNames(numLists);
+    vector<bool> listRead(numLists, false);
+    for (int i = 0; i < numLists; i++)
+        proxy.getElementListNames(i, listNames[i], elementNames[i]);
+    T* object = NULL;
+    bool decodeAll = false;
+    try {
+        if (!xml.isEmptyElement()) {
+            while (xml.read()) {
+                if (xml.getNodeType() == EXN_ELEMENT_END)
+                    break;
+                if (xml.getNodeType() != EXN_ELEMENT)
+                    continue;
+                string name = xml.getNodeName();
+                int list = find(listNames.begin(), listNames.end(), name)-listNames.begin();
+                if (list == numLists && object != NULL) {
+                    for (int i = 0; i < numLists; i++)
+                        if (listRead[i]) {
+                            SerializationNode& listNode = node.createChildNode(listNames[i]);
+                            for (int j = 0; j < proxy.getNumElements(object, i); j++)
+                                proxy.serializeElement(object, i, j, listNode.createChildNode(elementNames[i]));
+                        }
+                    delete object;
+                    object = NULL;
+                    decodeAll = true;
+                }
+                if (list == numLists || decodeAll)
+                    decodeNode(node.createChildNode(name), xml);
+                else {
+                    if (object == NULL) {
+                        // If the header cannot be created yet, some of the children it needs come after
+                        // the element lists.
+
+                        try {
+                            object = reinterpret_cast<T*>(proxy.deserializeHeader(node));
+                        }
+                        catch (OpenMMException&) {
+                            decodeAll = true;
+                            decodeNode(node.createChildNode(name), xml);
+                            continue;
+                        }
+                    }
+                    listRead[list] = true;
+                    decodeChildren(xml, [&] (const SerializationNode& element) {
+                        proxy.deserializeElement(element, list, object);
+                    });
+                }
+            }
+        }
+        if (decodeAll)
+            return reinterpret_cast<T*>(proxy.deserialize(node));
+        if (object == NULL)
+            object = reinterpret_cast<T*>(proxy.deserializeHeader(node));
+    }
+    catch (...) {
+        delete object;
+        throw;
+    }
+    return object;
+}
+
+/**
+ * Create a System from XML, processing one particle, constraint, or Force at a time.
+ */
+static System* decodeSystem(IrrXMLReader& xml) {
+    SerializationNode root;
+    for (int i = 0; i < xml.getAttributeCount(); i++)
+        root.setStringProperty(xml.getAttributeName(i), xml.getAttributeValue(i));
+    SystemProxy::checkVersion(root);
+    System* system = new System();
+    try {
+        bool isEmpty = xml.isEmptyElement();
+        while (!isEmpty && xml.read()) {
+            if (xml.getNodeType() == EXN_ELEMENT_END)
+                break;
+            if (xml.getNodeType() != EXN_ELEMENT)
+                continue;
+            string name = xml.getNodeName();
+            if (name == "Particles")
+                decodeChildren(xml, [&] (const SerializationNode& particle) {
+                    SystemProxy::deserializeParticle(particle, *system);
+                });
+            else if (name == "Constraints")
+                decodeChildren(xml, [&] (const SerializationNode& constraint) {
+                    SystemProxy::deserializeConstraint(constraint, *system);
+                });
+            else if (name == "Forces") {
+                bool noForces = xml.isEmptyElement();
+                while (!noForces && xml.read() && xml.getNodeType() != EXN_ELEMENT_END)
+                    if (xml.getNodeType() == EXN_ELEMENT)
+                        system->addForce(decodeObject<Force>(xml));
+            }
+            else {
+                SerializationNode child;
+                child.setName(name);
+                decodeNode(child, xml);
+                if (name == "PeriodicBoxVectors")
+                    SystemProxy::deserializeBoxVectors(child, *system);
+            }
+        }
+    }
+    catch (...) {
+        delete system;
+        throw;
+    }
+    return system;
+}
+
 void* XmlSerializer::deserializeStream(std::istream& stream) {
     SerializationNode root;
     StreamReader reader(stream);
@@ -187,6 +473,19 @@ void* XmlSerializer::deserializeStream(std::istream& stream) {
     
     while (xml->read() && xml->getNodeType() != EXN_ELEMENT)
         ;
+    const char* type = xml->getAttributeValue("type");
+    if (type != NULL && string(type) == SerializationProxy::getProxy(typeid(System)).getTypeName()) {
+        System* system;
+        try {
+            system = decodeSystem(*xml);
+        }
+        catch (...) {
+            delete xml;
+            throw;
+        }
+        delete xml;
+        return system;
+    }
     decodeNode(root, *xml);
     delete xml;
     
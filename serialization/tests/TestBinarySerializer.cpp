@@ -0,0 +1,211 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomBondForce.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/serialization/BinarySerializer.h"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+
+void compareVectors(const vector<Vec3>& v1, const vector<Vec3>& v2) {
+    ASSERT_EQUAL(v1.size(), v2.size());
+    for (int i = 0; i < v1.size(); i++)
+        ASSERT_EQUAL_VEC(v1[i], v2[i], 0);
+}
+
+void testSerializeState() {
+    const int numParticles = 20;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    CustomBondForce* bonds = new CustomBondForce("lambda*r^2");
+    bonds->addGlobalParameter("lambda", 0.5);
+    bonds->addEnergyParameterDerivative("lambda");
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.5 : -0.5, 0.2, 0.5);
+        if (i > 0)
+            bonds->addBond(i-1, i);
+        positions.push_back(Vec3(boxSize*(i%5)/5, boxSize*(i/5)/4, 0.1*i));
+    }
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    CustomIntegrator integrator(0.001);
+    integrator.addGlobalVariable("a", 1.5);
+    integrator.addPerDofVariable("b", 2.0);
+    integrator.addComputePerDof("v", "v+dt*f/m");
+    integrator.addComputePerDof("x", "x+dt*v");
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    context.setVelocitiesToTemperature(300.0);
+    context.setTime(2.5);
+    context.setStepCount(100);
+    integrator.step(5);
+
+    // Serialize and deserialize a State, and make sure it is reproduced exactly.
+
+    int allTypes = State::Positions | State::Velocities | State::Forces | State::Energy | State::Parameters |
+            State::ParameterDerivatives | State::IntegratorParameters;
+    State s1 = context.getState(allTypes);
+    stringstream buffer(ios_base::in | ios_base::out | ios_base::binary);
+    BinarySerializer::serialize(s1, buffer);
+    State s2;
+    BinarySerializer::deserialize(buffer, s2);
+    ASSERT_EQUAL(s1.getDataTypes(), s2.getDataTypes());
+    ASSERT_EQUAL(s1.getTime(), s2.getTime());
+    ASSERT_EQUAL(s1.getStepCount(), s2.getStepCount());
+    ASSERT_EQUAL(s1.getKineticEnergy(), s2.getKineticEnergy());
+    ASSERT_EQUAL(s1.getPotentialEnergy(), s2.getPotentialEnergy());
+    Vec3 a1, b1, c1, a2, b2, c2;
+    s1.getPeriodicBoxVectors(a1, b1, c1);
+    s2.getPeriodicBoxVectors(a2, b2, c2);
+    ASSERT_EQUAL_VEC(a1, a2, 0);
+    ASSERT_EQUAL_VEC(b1, b2, 0);
+    ASSERT_EQUAL_VEC(c1, c2, 0);
+    compareVectors(s1.getPositions(), s2.getPositions());
+    compareVectors(s1.getVelocities(), s2.getVelocities());
+    compareVectors(s1.getForces(), s2.getForces());
+    ASSERT(s1.getParameters() == s2.getParameters());
+    ASSERT(s1.getEnergyParameterDerivatives() == s2.getEnergyParameterDerivatives());
+
+    // Loading it into a Context should restore the integrator parameters.
+
+    integrator.setGlobalVariable(0, 0.0);
+    context.setState(s2);
+    ASSERT_EQUAL(1.5, integrator.getGlobalVariable(0));
+
+    // Now serialize a series of States that include only one type of information, reading
+    // them all into the same State.
+
+    for (int types = 1; types <= State::IntegratorParameters; types *= 2) {
+        stringstream buffer2(ios_base::in | ios_base::out | ios_base::binary);
+        BinarySerializer::serialize(context.getState(types), buffer2);
+        BinarySerializer::deserialize(buffer2, s2);
+        ASSERT_EQUAL(types, s2.getDataTypes());
+    }
+}
+
+void testInvalidStream() {
+    stringstream buffer(ios_base::in | ios_base::out | ios_base::binary);
+    buffer << "This is not a State";
+    State state;
+    bool failed = false;
+    try {
+        BinarySerializer::deserialize(buffer, state);
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+}
+
+/**
+ * A stream buffer that does not support seeking.
+ */
+class UnseekableBuffer : public streambuf {
+public:
+    UnseekableBuffer(string& data) {
+        setg(&data[0], &data[0], &data[0]+data.size());
+    }
+};
+
+void checkDeserializeFails(istream& stream) {
+    State state;
+    bool failed = false;
+    try {
+        BinarySerializer::deserialize(stream, state);
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+}
+
+void testCorruptedLength() {
+    // Create a State containing only positions, so the length of the positions is just before them
+    // at the end of the data.
+
+    const int numParticles = 10;
+    System system;
+    vector<Vec3> positions;
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        positions.push_back(Vec3(i, 0, 0));
+    }
+    CustomIntegrator integrator(0.001);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    context.setPositions(positions);
+    stringstream buffer(ios_base::in | ios_base::out | ios_base::binary);
+    BinarySerializer::serialize(context.getState(State::Positions), buffer);
+    string data = buffer.str();
+
+    // Replace the length with a huge value.  Deserializing should fail without trying to allocate
+    // memory for all of it, whether or not the stream supports seeking.
+
+    int length = 100000000;
+    memcpy(&data[data.size()-numParticles*sizeof(Vec3)-sizeof(int)], &length, sizeof(int));
+    stringstream corrupted(data, ios_base::in | ios_base::binary);
+    checkDeserializeFails(corrupted);
+    UnseekableBuffer unseekable(data);
+    istream unseekableStream(&unseekable);
+    checkDeserializeFails(unseekableStream);
+
+    // A stream that ends in the middle of the positions should also fail.
+
+    stringstream truncated(buffer.str().substr(0, data.size()-10), ios_base::in | ios_base::binary);
+    checkDeserializeFails(truncated);
+}
+
+int main() {
+    try {
+        testSerializeState();
+        testInvalidStream();
+        testCorruptedLength();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
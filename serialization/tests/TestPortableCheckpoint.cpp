@@ -0,0 +1,208 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/Platform.h"
+#include "openmm/System.h"
+#include "openmm/serialization/CheckpointReader.h"
+#include "openmm/serialization/CheckpointWriter.h"
+#include <iostream>
+#include <sstream>
+
+using namespace OpenMM;
+using namespace std;
+
+void compareStates(const State& s1, const State& s2) {
+    ASSERT_EQUAL(s1.getTime(), s2.getTime());
+    ASSERT_EQUAL(s1.getStepCount(), s2.getStepCount());
+    ASSERT_EQUAL(s1.getPositions().size(), s2.getPositions().size());
+    for (int i = 0; i < s1.getPositions().size(); i++) {
+        ASSERT_EQUAL_VEC(s1.getPositions()[i], s2.getPositions()[i], 0);
+        ASSERT_EQUAL_VEC(s1.getVelocities()[i], s2.getVelocities()[i], 0);
+    }
+    ASSERT(s1.getParameters() == s2.getParameters());
+}
+
+Context* createContext(System& system, LangevinMiddleIntegrator& integrator) {
+    const int gridSize = 6;
+    const double spacing = 0.4;
+    const double boxSize = gridSize*spacing;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    vector<Vec3> positions;
+    for (int i = 0; i < gridSize; i++)
+        for (int j = 0; j < gridSize; j++)
+            for (int k = 0; k < gridSize; k++) {
+                system.addParticle(10.0);
+                nonbonded->addParticle((i+j+k)%2 == 0 ? 0.2 : -0.2, 0.3, 0.5);
+                positions.push_back(Vec3(i*spacing, j*spacing, k*spacing));
+            }
+    system.addForce(nonbonded);
+    Context* context = new Context(system, integrator, Platform::getPlatformByName("Reference"));
+    context->setPositions(positions);
+    context->setVelocitiesToTemperature(300.0);
+    return context;
+}
+
+void testSeriesOfCheckpoints(bool compress) {
+    System system;
+    LangevinMiddleIntegrator integrator(300.0, 1.0, 0.002);
+    Context* context = createContext(system, integrator);
+    stringstream stream(ios_base::in | ios_base::out | ios_base::binary);
+    CheckpointWriter writer(compress, 4);
+    vector<State> states;
+    vector<int> sizes;
+    for (int i = 0; i < 10; i++) {
+        integrator.step(5);
+        int start = stream.tellp();
+        writer.writeCheckpoint(*context, stream);
+        sizes.push_back((int) stream.tellp()-start);
+        states.push_back(context->getState(State::Positions | State::Velocities | State::Parameters));
+    }
+
+    // Read them back and make sure they match.
+
+    CheckpointReader reader;
+    State state;
+    for (int i = 0; i < 10; i++) {
+        ASSERT(reader.readCheckpoint(stream, state));
+        compareStates(states[i], state);
+    }
+    ASSERT(!reader.readCheckpoint(stream, state));
+
+    // With compression, the delta checkpoints should be smaller than the keyframes.  If nothing has
+    // changed, a delta checkpoint should take almost no space.
+
+    if (compress) {
+        for (int i = 0; i < 10; i++)
+            if (i%4 != 0)
+                ASSERT(sizes[i] < sizes[0]);
+        stream.clear();
+        int start = stream.tellp();
+        writer.writeCheckpoint(*context, stream);
+        int size = (int) stream.tellp()-start;
+        ASSERT(size < 0.05*sizes[0]);
+        ASSERT(reader.readCheckpoint(stream, state));
+        compareStates(states[9], state);
+    }
+    delete context;
+}
+
+void testLoadIntoContext() {
+    System system;
+    LangevinMiddleIntegrator integrator(300.0, 1.0, 0.002);
+    Context* context = createContext(system, integrator);
+    stringstream stream(ios_base::in | ios_base::out | ios_base::binary);
+    CheckpointWriter writer;
+    writer.setChunkSize(1000);
+    for (int i = 0; i < 3; i++) {
+        integrator.step(5);
+        writer.writeCheckpoint(*context, stream);
+    }
+    State expected = context->getState(State::Positions | State::Velocities | State::Parameters);
+
+    // Simulate being interrupted while writing a checkpoint.
+
+    integrator.step(5);
+    stringstream partial(ios_base::in | ios_base::out | ios_base::binary);
+    writer.writeCheckpoint(*context, partial);
+    string partialData = partial.str();
+    stream.write(partialData.c_str(), partialData.size()/2);
+
+    // Load it into a different Context.  It should get the last complete checkpoint.
+
+    System system2;
+    LangevinMiddleIntegrator integrator2(300.0, 1.0, 0.002);
+    Context* context2 = createContext(system2, integrator2);
+    CheckpointReader reader;
+    reader.loadCheckpoint(stream, *context2);
+    compareStates(expected, context2->getState(State::Positions | State::Velocities | State::Parameters));
+    delete context;
+    delete context2;
+}
+
+void testDamagedCheckpoint() {
+    System system;
+    LangevinMiddleIntegrator integrator(300.0, 1.0, 0.002);
+    Context* context = createContext(system, integrator);
+    CheckpointWriter writer;
+    stringstream stream(ios_base::in | ios_base::out | ios_base::binary);
+    writer.writeCheckpoint(*context, stream);
+    string data = stream.str();
+    data[data.size()/2] ^= 1;
+    stringstream damaged(data, ios_base::in | ios_base::binary);
+    CheckpointReader reader;
+    State state;
+    bool failed = false;
+    try {
+        reader.readCheckpoint(damaged, state);
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+
+    // A delta checkpoint cannot be read without the one before it.
+
+    integrator.step(1);
+    stringstream delta(ios_base::in | ios_base::out | ios_base::binary);
+    writer.writeCheckpoint(*context, delta);
+    CheckpointReader reader2;
+    failed = false;
+    try {
+        reader2.readCheckpoint(delta, state);
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+    delete context;
+}
+
+int main() {
+    try {
+        testSeriesOfCheckpoints(true);
+        testSeriesOfCheckpoints(false);
+        testLoadIntoContext();
+        testDamagedCheckpoint();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
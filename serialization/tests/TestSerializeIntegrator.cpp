@@ -36,6 +36,7 @@
 #include "openmm/CustomIntegrator.h"
 #include "openmm/LangevinIntegrator.h"
 #include "openmm/LangevinMiddleIntegrator.h"
+#include "openmm/MTSLangevinIntegrator.h"
 #include "openmm/VariableLangevinIntegrator.h"
 #include "openmm/VariableVerletIntegrator.h"
 #include "openmm/VerletIntegrator.h"
@@ -89,6 +90,27 @@ void testSerializeLangevinMiddleIntegrator() {
     delete intg2;
 }
 
+void testSerializeMTSLangevinIntegrator() {
+    vector<pair<int, int> > groups = {{2, 4}, {0, 1}, {1, 2}};
+    MTSLangevinIntegrator *intg = new MTSLangevinIntegrator(301.5, 2.345, 0.004, groups);
+    intg->setRandomNumberSeed(17);
+    stringstream ss;
+    XmlSerializer::serialize<Integrator>(intg, "MTSLangevinIntegrator", ss);
+    MTSLangevinIntegrator *intg2 = dynamic_cast<MTSLangevinIntegrator*>(XmlSerializer::deserialize<Integrator>(ss));
+    ASSERT_EQUAL(intg->getConstraintTolerance(), intg2->getConstraintTolerance());
+    ASSERT_EQUAL(intg->getStepSize(), intg2->getStepSize());
+    ASSERT_EQUAL(intg->getTemperature(), intg2->getTemperature());
+    ASSERT_EQUAL(intg->getFriction(), intg2->getFriction());
+    ASSERT_EQUAL(intg->getRandomNumberSeed(), intg2->getRandomNumberSeed());
+    ASSERT_EQUAL(intg->getGroups().size(), intg2->getGroups().size());
+    for (int i = 0; i < intg->getGroups().size(); i++) {
+        ASSERT_EQUAL(intg->getGroups()[i].first, intg2->getGroups()[i].first);
+        ASSERT_EQUAL(intg->getGroups()[i].second, intg2->getGroups()[i].second);
+    }
+    delete intg;
+    delete intg2;
+}
+
 void testSerializeBrownianIntegrator() {
     BrownianIntegrator *intg = new BrownianIntegrator(243.1, 3.234, 0.0021);
     stringstream ss;
@@ -260,6 +282,7 @@ int main() {
         testSerializeVariableVerletIntegrator();
         testSerializeLangevinIntegrator();
         testSerializeLangevinMiddleIntegrator();
+        testSerializeMTSLangevinIntegrator();
         testSerializeCompoundIntegrator();
     }
     catch(const exception& e) {
@@ -45,6 +45,7 @@ void testSerialization() {
     force.setForceGroup(3);
     force.setName("custom name");
     force.setRandomNumberSeed(3);
+    force.setUseIncrementalEnergy(true);
 
     // Serialize and then deserialize it.
 
@@ -61,6 +62,7 @@ void testSerialization() {
     ASSERT_EQUAL(force.getDefaultTemperature(), force2.getDefaultTemperature());
     ASSERT_EQUAL(force.getFrequency(), force2.getFrequency());
     ASSERT_EQUAL(force.getRandomNumberSeed(), force2.getRandomNumberSeed());
+    ASSERT_EQUAL(force.getUseIncrementalEnergy(), force2.getUseIncrementalEnergy());
 }
 
 int main() {
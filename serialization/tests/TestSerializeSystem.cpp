@@ -30,10 +30,16 @@
  * -------------------------------------------------------------------------- */
 
 #include "openmm/internal/AssertionUtilities.h"
+#include "openmm/HarmonicAngleForce.h"
 #include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/PeriodicTorsionForce.h"
+#include "openmm/RBTorsionForce.h"
 #include "openmm/System.h"
 #include "openmm/VirtualSite.h"
+#include "openmm/serialization/BinarySerializer.h"
 #include "openmm/serialization/XmlSerializer.h"
+#include <cstring>
 #include <iostream>
 #include <sstream>
 
@@ -104,10 +110,7 @@ void compareSystems(System& system, System& system2) {
         ASSERT(typeid(system.getForce(i)) == typeid(system2.getForce(i)))
 }
 
-void testSerialization() {
-    // Create a System.
-
-    System system;
+void createSystem(System& system) {
     for (int i = 0; i < 5; i++)
         system.addParticle(0.1*i+1);
     for (int i = 0; i < 5; i++)
@@ -121,6 +124,11 @@ void testSerialization() {
     system.setVirtualSite(7, new OutOfPlaneSite(0, 3, 1, 0.1, 0.2, 0.5));
     system.setVirtualSite(8, new LocalCoordinatesSite({4, 3, 2, 1}, {0.1, 0.2, 0.3, 0.4}, {-1.0, 0.4, 0.4, 0.2}, {0.3, 0.7, 0.0, -1.0}, Vec3(-0.5, 1.0, 1.5)));
     system.addForce(new HarmonicBondForce());
+}
+
+void testSerialization() {
+    System system;
+    createSystem(system);
 
     // Serialize and then deserialize it, then make sure the systems are identical.
 
@@ -128,6 +136,12 @@ void testSerialization() {
     XmlSerializer::serialize<System>(&system, "System", buffer);
     System* copy = XmlSerializer::deserialize<System>(buffer);
     compareSystems(system, *copy);
+
+    // Serializing the copy should produce identical XML.
+
+    stringstream buffer2;
+    XmlSerializer::serialize<System>(copy, "System", buffer2);
+    ASSERT_EQUAL(buffer.str(), buffer2.str());
     delete copy;
 
     // Now do the same thing but by calling clone().
@@ -137,9 +151,258 @@ void testSerialization() {
     delete copy;
 }
 
+void testBinarySerialization() {
+    System system;
+    createSystem(system);
+    stringstream buffer(ios_base::in | ios_base::out | ios_base::binary);
+    BinarySerializer::serialize<System>(&system, "System", buffer);
+    System* copy = BinarySerializer::deserialize<System>(buffer);
+    compareSystems(system, *copy);
+    delete copy;
+
+    // Objects other than Systems should also work.
+
+    HarmonicBondForce bonds;
+    bonds.addBond(0, 1, 1.5, 2.0);
+    stringstream buffer2(ios_base::in | ios_base::out | ios_base::binary);
+    BinarySerializer::serialize<Force>(&bonds, "Force", buffer2);
+    HarmonicBondForce* bonds2 = dynamic_cast<HarmonicBondForce*>(BinarySerializer::deserialize<Force>(buffer2));
+    ASSERT(bonds2 != NULL);
+    ASSERT_EQUAL(1, bonds2->getNumBonds());
+    int p1, p2;
+    double length, k;
+    bonds2->getBondParameters(0, p1, p2, length, k);
+    ASSERT_EQUAL(1.5, length);
+    ASSERT_EQUAL(2.0, k);
+    delete bonds2;
+}
+
+void testEmptySystem() {
+    System system;
+    stringstream buffer;
+    XmlSerializer::serialize<System>(&system, "System", buffer);
+    System* copy = XmlSerializer::deserialize<System>(buffer);
+    ASSERT_EQUAL(0, copy->getNumParticles());
+    ASSERT_EQUAL(0, copy->getNumForces());
+    delete copy;
+    stringstream buffer2(ios_base::in | ios_base::out | ios_base::binary);
+    BinarySerializer::serialize<System>(&system, "System", buffer2);
+    copy = BinarySerializer::deserialize<System>(buffer2);
+    ASSERT_EQUAL(0, copy->getNumParticles());
+    ASSERT_EQUAL(0, copy->getNumForces());
+    delete copy;
+
+    // Empty sections written as separate start and end tags should also be accepted.
+
+    stringstream xml;
+    xml << "<?xml version=\"1.0\" ?>\n<System type=\"System\" version=\"1\">\n<!-- comment -->\n";
+    xml << "<PeriodicBoxVectors><A x=\"2\" y=\"0\" z=\"0\"/><B x=\"0\" y=\"2\" z=\"0\"/><C x=\"0\" y=\"0\" z=\"2\"/></PeriodicBoxVectors>\n";
+    xml << "<Particles><Particle mass=\"1.5\"></Particle></Particles><Constraints></Constraints><Forces></Forces>\n</System>\n";
+    copy = XmlSerializer::deserialize<System>(xml);
+    ASSERT_EQUAL(1, copy->getNumParticles());
+    ASSERT_EQUAL(1.5, copy->getParticleMass(0));
+    Vec3 a, b, c;
+    copy->getDefaultPeriodicBoxVectors(a, b, c);
+    ASSERT_EQUAL_VEC(Vec3(0, 0, 2), c, 0);
+    delete copy;
+}
+
+void compareStreamedForces(System& system, System& system2) {
+    ASSERT_EQUAL(0, system2.getNumConstraints());
+    ASSERT_EQUAL(system.getNumForces(), system2.getNumForces());
+    NonbondedForce& nb = dynamic_cast<NonbondedForce&>(system.getForce(0));
+    NonbondedForce& nb2 = dynamic_cast<NonbondedForce&>(system2.getForce(0));
+    ASSERT_EQUAL(nb.getNonbondedMethod(), nb2.getNonbondedMethod());
+    ASSERT_EQUAL(nb.getCutoffDistance(), nb2.getCutoffDistance());
+    ASSERT_EQUAL(1, nb2.getNumGlobalParameters());
+    ASSERT_EQUAL(1, nb2.getNumParticleParameterOffsets());
+    ASSERT_EQUAL(nb.getNumParticles(), nb2.getNumParticles());
+    for (int i = 0; i < nb.getNumParticles(); i++) {
+        double charge, sigma, epsilon, charge2, sigma2, epsilon2;
+        nb.getParticleParameters(i, charge, sigma, epsilon);
+        nb2.getParticleParameters(i, charge2, sigma2, epsilon2);
+        ASSERT_EQUAL(charge, charge2);
+        ASSERT_EQUAL(sigma, sigma2);
+        ASSERT_EQUAL(epsilon, epsilon2);
+    }
+    ASSERT_EQUAL(nb.getNumExceptions(), nb2.getNumExceptions());
+    for (int i = 0; i < nb.getNumExceptions(); i++) {
+        int p1, p2, p3, p4;
+        double chargeProd, sigma, epsilon, chargeProd2, sigma2, epsilon2;
+        nb.getExceptionParameters(i, p1, p2, chargeProd, sigma, epsilon);
+        nb2.getExceptionParameters(i, p3, p4, chargeProd2, sigma2, epsilon2);
+        ASSERT_EQUAL(p1, p3);
+        ASSERT_EQUAL(p2, p4);
+        ASSERT_EQUAL(chargeProd, chargeProd2);
+        ASSERT_EQUAL(sigma, sigma2);
+        ASSERT_EQUAL(epsilon, epsilon2);
+    }
+    HarmonicBondForce& bonds = dynamic_cast<HarmonicBondForce&>(system2.getForce(1));
+    ASSERT_EQUAL(2, bonds.getNumBonds());
+    int p1, p2, p3, p4, periodicity;
+    double length, k;
+    bonds.getBondParameters(1, p1, p2, length, k);
+    ASSERT_EQUAL(2, p1);
+    ASSERT_EQUAL(3, p2);
+    ASSERT_EQUAL(0.15, length);
+    ASSERT_EQUAL(1000.0, k);
+    ASSERT_EQUAL("bonds", bonds.getName());
+    HarmonicAngleForce& angles = dynamic_cast<HarmonicAngleForce&>(system2.getForce(2));
+    ASSERT_EQUAL(1, angles.getNumAngles());
+    double angle;
+    angles.getAngleParameters(0, p1, p2, p3, angle, k);
+    ASSERT_EQUAL(1.9, angle);
+    PeriodicTorsionForce& periodic = dynamic_cast<PeriodicTorsionForce&>(system2.getForce(3));
+    ASSERT_EQUAL(1, periodic.getNumTorsions());
+    double phase;
+    periodic.getTorsionParameters(0, p1, p2, p3, p4, periodicity, phase, k);
+    ASSERT_EQUAL(3, p4);
+    ASSERT_EQUAL(2, periodicity);
+    ASSERT_EQUAL(0.5, phase);
+    RBTorsionForce& rb = dynamic_cast<RBTorsionForce&>(system2.getForce(4));
+    ASSERT_EQUAL(1, rb.getNumTorsions());
+    double c[6];
+    rb.getTorsionParameters(0, p1, p2, p3, p4, c[0], c[1], c[2], c[3], c[4], c[5]);
+    ASSERT_EQUAL(-0.5, c[5]);
+    ASSERT_EQUAL(0, dynamic_cast<NonbondedForce&>(system2.getForce(5)).getNumParticles());
+}
+
+/**
+ * Find the children of a node in data written by BinarySerializer.  The offset of each child is
+ * added to a vector, and the offset of the end of the node is returned.
+ */
+size_t findBinaryChildren(const string& data, size_t pos, vector<size_t>& children) {
+    auto readInt = [&] () {
+        int value;
+        memcpy(&value, &data[pos], sizeof(int));
+        pos += sizeof(int);
+        return value;
+    };
+    pos += readInt();
+    int numProperties = readInt();
+    for (int i = 0; i < 2*numProperties; i++)
+        pos += readInt();
+    int numChildren = readInt();
+    vector<size_t> grandchildren;
+    for (int i = 0; i < numChildren; i++) {
+        children.push_back(pos);
+        pos = findBinaryChildren(data, pos, grandchildren);
+    }
+    return pos;
+}
+
+string getBinaryNodeName(const string& data, size_t pos) {
+    int length;
+    memcpy(&length, &data[pos], sizeof(int));
+    return data.substr(pos+sizeof(int), length);
+}
+
+void testStreamedForces() {
+    // Forces whose proxies support element lists are written and read one element at a time.
+    // A System with no constraints makes sure the Forces after the empty Constraints section are read.
+
+    System system;
+    NonbondedForce* nb = new NonbondedForce();
+    nb->setNonbondedMethod(NonbondedForce::PME);
+    nb->setCutoffDistance(0.8);
+    nb->addGlobalParameter("scale", 0.5);
+    nb->addParticleParameterOffset("scale", 1, 0.1, 0.0, 0.0);
+    for (int i = 0; i < 4; i++) {
+        system.addParticle(1.0+i);
+        nb->addParticle(0.1*i-0.15, 0.3+0.01*i, 0.5+i);
+    }
+    nb->addException(0, 1, 0.0, 1.0, 0.0);
+    nb->addException(1, 3, 0.25, 0.3, 0.4);
+    system.addForce(nb);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->setName("bonds");
+    bonds->addBond(0, 1, 0.1, 500.0);
+    bonds->addBond(2, 3, 0.15, 1000.0);
+    system.addForce(bonds);
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    angles->addAngle(0, 1, 2, 1.9, 300.0);
+    system.addForce(angles);
+    PeriodicTorsionForce* periodic = new PeriodicTorsionForce();
+    periodic->addTorsion(0, 1, 2, 3, 2, 0.5, 10.0);
+    system.addForce(periodic);
+    RBTorsionForce* rb = new RBTorsionForce();
+    rb->addTorsion(0, 1, 2, 3, 1.0, 0.5, 0.25, 0.0, 0.1, -0.5);
+    system.addForce(rb);
+    system.addForce(new NonbondedForce());
+    stringstream buffer;
+    XmlSerializer::serialize<System>(&system, "System", buffer);
+    System* copy = XmlSerializer::deserialize<System>(buffer);
+    compareStreamedForces(system, *copy);
+    stringstream buffer2;
+    XmlSerializer::serialize<System>(copy, "System", buffer2);
+    ASSERT_EQUAL(buffer.str(), buffer2.str());
+    delete copy;
+
+    // The streamed XML should be identical to what the Force proxies write for each Force on its own.
+
+    for (int i = 0; i < system.getNumForces(); i++) {
+        stringstream forceBuffer;
+        XmlSerializer::serialize<Force>(&system.getForce(i), "Force", forceBuffer);
+        string forceXml = forceBuffer.str();
+        forceXml = forceXml.substr(forceXml.find('\n')+1);
+        stringstream indented;
+        size_t start = 0;
+        while (start < forceXml.size()) {
+            size_t end = forceXml.find('\n', start);
+            indented << "\t\t" << forceXml.substr(start, end-start+1);
+            start = end+1;
+        }
+        ASSERT(buffer.str().find(indented.str()) != string::npos);
+    }
+    stringstream binary(ios_base::in | ios_base::out | ios_base::binary);
+    BinarySerializer::serialize<System>(&system, "System", binary);
+    copy = BinarySerializer::deserialize<System>(binary);
+    compareStreamedForces(system, *copy);
+    delete copy;
+
+    // Other children of a Force may come after its element lists.  Move the Particles and Exceptions
+    // of the NonbondedForce before its GlobalParameters and make sure it still is read correctly.
+
+    string xml = buffer.str();
+    size_t forceStart = xml.find("<Force ");
+    size_t headerStart = xml.rfind('\n', xml.find("<GlobalParameters", forceStart))+1;
+    size_t listStart = xml.rfind('\n', xml.find("<Particles>", forceStart))+1;
+    size_t listEnd = xml.find('\n', xml.find("</Exceptions>", forceStart))+1;
+    string reordered = xml.substr(0, headerStart)+xml.substr(listStart, listEnd-listStart)+
+            xml.substr(headerStart, listStart-headerStart)+xml.substr(listEnd);
+    stringstream reorderedXml(reordered);
+    copy = XmlSerializer::deserialize<System>(reorderedXml);
+    compareStreamedForces(system, *copy);
+    delete copy;
+
+    // Do the same thing with the binary format.  The element lists come last in each Force.
+
+    string data = binary.str();
+    vector<size_t> sections, forces, children;
+    size_t rootStart = sizeof("OpenMM Binary Object\n")+2*sizeof(int);
+    findBinaryChildren(data, rootStart, sections);
+    for (size_t section : sections)
+        if (getBinaryNodeName(data, section) == "Forces")
+            findBinaryChildren(data, section, forces);
+    size_t forceEnd = findBinaryChildren(data, forces[0], children);
+    int numChildren = children.size();
+    ASSERT_EQUAL("Particles", getBinaryNodeName(data, children[numChildren-2]));
+    headerStart = children[0];
+    listStart = children[numChildren-2];
+    string reorderedData = data.substr(0, headerStart)+data.substr(listStart, forceEnd-listStart)+
+            data.substr(headerStart, listStart-headerStart)+data.substr(forceEnd);
+    stringstream reorderedBinary(reorderedData, ios_base::in | ios_base::binary);
+    copy = BinarySerializer::deserialize<System>(reorderedBinary);
+    compareStreamedForces(system, *copy);
+    delete copy;
+}
+
 int main() {
     try {
         testSerialization();
+        testBinarySerialization();
+        testEmptySystem();
+        testStreamedForces();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
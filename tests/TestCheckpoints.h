@@ -116,12 +116,81 @@ void testSetState() {
     }
 }
 
+void testReuseState() {
+    const int numParticles = 10;
+    const double boxSize = 3.0;
+    System system;
+    NonbondedForce* nonbonded = new NonbondedForce();
+    system.addForce(nonbonded);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    vector<Vec3> positions(numParticles);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        nonbonded->addParticle(i%2 == 0 ? 0.1 : -0.1, 0.2, 0.1);
+        positions[i] = Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+    }
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    VerletIntegrator integrator(0.001);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setVelocitiesToTemperature(300.0);
+    int types = State::Positions | State::Velocities | State::Forces | State::Energy;
+    State state;
+    context.getState(state, types);
+    const double* positionData = state.getRawData(State::Positions);
+    const double* forceData = state.getRawData(State::Forces);
+    vector<float> floatPositions;
+    for (int step = 0; step < 5; step++) {
+        integrator.step(10);
+
+        // Refilling the same State should give the same results as creating a new one, without
+        // reallocating its storage.
+
+        context.getState(state, types);
+        State expected = context.getState(types);
+        ASSERT_EQUAL(types, state.getDataTypes());
+        ASSERT_EQUAL(expected.getStepCount(), state.getStepCount());
+        ASSERT_EQUAL_TOL(expected.getTime(), state.getTime(), TOL);
+        ASSERT_EQUAL_TOL(expected.getPotentialEnergy(), state.getPotentialEnergy(), TOL);
+        ASSERT_EQUAL_TOL(expected.getKineticEnergy(), state.getKineticEnergy(), TOL);
+        ASSERT(positionData == state.getRawData(State::Positions));
+        ASSERT(forceData == state.getRawData(State::Forces));
+        state.getRawData(State::Positions, floatPositions);
+        ASSERT_EQUAL(3*numParticles, floatPositions.size());
+        for (int i = 0; i < numParticles; i++) {
+            ASSERT_EQUAL_VEC(expected.getPositions()[i], state.getPositions()[i], TOL);
+            ASSERT_EQUAL_VEC(expected.getVelocities()[i], state.getVelocities()[i], TOL);
+            ASSERT_EQUAL_VEC(expected.getForces()[i], state.getForces()[i], TOL);
+            for (int j = 0; j < 3; j++) {
+                ASSERT_EQUAL(expected.getPositions()[i][j], positionData[3*i+j]);
+                ASSERT_EQUAL_TOL(expected.getPositions()[i][j], floatPositions[3*i+j], 1e-6);
+            }
+        }
+    }
+
+    // Requesting less data should discard whatever is not requested.
+
+    context.getState(state, State::Velocities);
+    ASSERT_EQUAL(State::Velocities, state.getDataTypes());
+    bool failed = false;
+    try {
+        state.getRawData(State::Positions);
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
     try {
         initializeTests(argc, argv);
         testSetState();
+        testReuseState();
         runPlatformTests();
     }
     catch(const exception& e) {
@@ -36,6 +36,7 @@
 #include "openmm/Platform.h"
 #include "openmm/System.h"
 #include "openmm/VerletIntegrator.h"
+#include "sfmt/SFMT.h"
 #include <iostream>
 #include <vector>
 
@@ -68,9 +69,69 @@ void testFindMolecules() {
     }
 }
 
+void testInterleavedMolecules() {
+    // Create molecules whose particles are scattered randomly through the System, and make sure
+    // the result matches findMolecules().
+
+    const int numParticles = 50000;
+    const int numMolecules = 2000;
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    vector<int> lastParticle(numMolecules, -1);
+    vector<vector<int> > particleBonds(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        int molecule = (int) (genrand_real2(sfmt)*numMolecules);
+        if (lastParticle[molecule] != -1) {
+            int other = (int) (genrand_real2(sfmt)*(i-lastParticle[molecule]))+lastParticle[molecule];
+            if (i%2 == 0)
+                other = lastParticle[molecule];
+            bonds->addBond(i, other, 1.0, 1.0);
+            particleBonds[i].push_back(other);
+            particleBonds[other].push_back(i);
+        }
+        lastParticle[molecule] = i;
+    }
+    vector<vector<int> > expected = ContextImpl::findMolecules(numParticles, particleBonds);
+    VerletIntegrator integrator(1.0);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    const vector<vector<int> >& molecules = context.getMolecules();
+    ASSERT_EQUAL(expected.size(), molecules.size());
+    for (int i = 0; i < expected.size(); i++) {
+        ASSERT_EQUAL(expected[i].size(), molecules[i].size());
+        for (int j = 0; j < expected[i].size(); j++)
+            ASSERT_EQUAL(expected[i][j], molecules[i][j]);
+    }
+}
+
+void testInitializationTimes() {
+    System system;
+    system.addParticle(1.0);
+    system.addParticle(1.0);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->addBond(0, 1, 1.0, 1.0);
+    system.addForce(bonds);
+    VerletIntegrator integrator(1.0);
+    Context context(system, integrator, Platform::getPlatformByName("Reference"));
+    const map<string, double>& times = context.getInitializationTimes();
+    const string phases[] = {"Validate System", "Create ForceImpls", "Create Platform Data", "Initialize Platform Kernels", "Initialize HarmonicBondForce", "Initialize Integrator"};
+    for (const string& phase : phases) {
+        ASSERT(times.find(phase) != times.end());
+        ASSERT(times.at(phase) >= 0.0);
+    }
+    ASSERT(times.find("Find Molecules") == times.end());
+    context.getMolecules();
+    ASSERT(times.find("Find Molecules") != times.end());
+}
+
 int main() {
     try {
         testFindMolecules();
+        testInterleavedMolecules();
+        testInitializationTimes();
     }
     catch(const exception& e) {
         cout << "exception: " << e.what() << endl;
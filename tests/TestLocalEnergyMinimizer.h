@@ -259,6 +259,138 @@ void testForceGroups() {
     ASSERT_EQUAL_TOL(2.0, sqrt(delta.dot(delta)), 1e-4);
 }
 
+void testSharedConstraints() {
+    // Create a set of rigid triangles, so every particle is involved in more than one constraint.
+
+    const int numMolecules = 20;
+    const int numParticles = 3*numMolecules;
+    const double boxSize = 3.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    system.addForce(nonbonded);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<Vec3> positions;
+    for (int i = 0; i < numMolecules; i++) {
+        Vec3 pos(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt));
+        for (int j = 0; j < 3; j++) {
+            system.addParticle(1.0);
+            nonbonded->addParticle(j == 0 ? -0.8 : 0.4, 0.3, 0.5);
+        }
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0, 0));
+        positions.push_back(pos+Vec3(0.05, 0.08, 0));
+        for (int j = 0; j < 3; j++) {
+            int p1 = 3*i+j, p2 = 3*i+(j+1)%3;
+            Vec3 delta = positions[p2]-positions[p1];
+            system.addConstraint(p1, p2, sqrt(delta.dot(delta)));
+            nonbonded->addException(p1, p2, 0.0, 1.0, 0.0);
+        }
+    }
+
+    // Minimize it and verify that the energy has decreased and the constraints are satisfied.
+
+    VerletIntegrator integrator(0.001);
+    integrator.setConstraintTolerance(1e-5);
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    double initialEnergy = context.getState(State::Energy).getPotentialEnergy();
+    LocalEnergyMinimizer::minimize(context, 1.0);
+    State state = context.getState(State::Energy | State::Positions);
+    ASSERT(state.getPotentialEnergy() < initialEnergy);
+    for (int i = 0; i < system.getNumConstraints(); i++) {
+        int p1, p2;
+        double distance;
+        system.getConstraintParameters(i, p1, p2, distance);
+        Vec3 delta = state.getPositions()[p2]-state.getPositions()[p1];
+        ASSERT_EQUAL_TOL(distance, sqrt(delta.dot(delta)), 1e-4);
+    }
+}
+
+void testAlgorithms() {
+    // Create a chain of particles connected by a mix of harmonic bonds with very different
+    // force constants and constraints.
+
+    const int numParticles = 10;
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0+i);
+        positions[i] = Vec3(i, 0.2*(i%2), 0);
+        if (i > 0) {
+            if (i%3 == 0)
+                system.addConstraint(i-1, i, 1+0.1*i);
+            else
+                bonds->addBond(i-1, i, 1+0.1*i, 100.0*i*i);
+        }
+    }
+
+    // Minimize it with each algorithm and check that all distances are correct.
+
+    LocalEnergyMinimizer::Algorithm algorithms[] = {LocalEnergyMinimizer::LBFGS, LocalEnergyMinimizer::PreconditionedLBFGS, LocalEnergyMinimizer::FIRE};
+    for (LocalEnergyMinimizer::Algorithm algorithm : algorithms) {
+        VerletIntegrator integrator(0.01);
+        integrator.setConstraintTolerance(1e-5);
+        Context context(system, integrator, platform);
+        context.setPositions(positions);
+        LocalEnergyMinimizer::minimize(context, 1e-5, 0, algorithm);
+        State state = context.getState(State::Positions);
+        for (int i = 1; i < numParticles; i++) {
+            Vec3 delta = state.getPositions()[i]-state.getPositions()[i-1];
+            ASSERT_EQUAL_TOL(1+0.1*i, sqrt(delta.dot(delta)), 1e-4);
+        }
+    }
+}
+
+void testBatch() {
+    // Create a chain of particles connected by harmonic bonds.
+
+    const int numParticles = 10;
+    const int numConformations = 4;
+    System system;
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    system.addForce(bonds);
+    for (int i = 0; i < numParticles; i++) {
+        system.addParticle(1.0);
+        if (i > 0)
+            bonds->addBond(i-1, i, 1+0.1*i, 100.0);
+    }
+
+    // Create several random starting conformations.
+
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    vector<vector<Vec3> > positions(numConformations);
+    for (int i = 0; i < numConformations; i++)
+        for (int j = 0; j < numParticles; j++)
+            positions[i].push_back(Vec3(j+0.3*genrand_real2(sfmt), 0.3*genrand_real2(sfmt), 0.3*genrand_real2(sfmt)));
+    vector<vector<Vec3> > initialPositions = positions;
+
+    // Minimize them all and check the results.
+
+    VerletIntegrator integrator(0.01);
+    Context context(system, integrator, platform);
+    vector<double> energies = LocalEnergyMinimizer::minimizeBatch(context, positions, 1e-5);
+    ASSERT_EQUAL(numConformations, energies.size());
+    for (int i = 0; i < numConformations; i++) {
+        ASSERT(positions[i][0] != initialPositions[i][0]);
+        for (int j = 1; j < numParticles; j++) {
+            Vec3 delta = positions[i][j]-positions[i][j-1];
+            ASSERT_EQUAL_TOL(1+0.1*j, sqrt(delta.dot(delta)), 1e-4);
+        }
+        ASSERT(energies[i] < 1e-6);
+    }
+    State state = context.getState(State::Positions | State::Energy);
+    ASSERT_EQUAL_TOL(energies[numConformations-1], state.getPotentialEnergy(), 1e-6);
+    for (int j = 0; j < numParticles; j++)
+        ASSERT_EQUAL_VEC(positions[numConformations-1][j], state.getPositions()[j], 1e-6);
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -269,6 +401,9 @@ int main(int argc, char* argv[]) {
         testVirtualSites();
         testLargeForces();
         testForceGroups();
+        testSharedConstraints();
+        testAlgorithms();
+        testBatch();
         runPlatformTests();
     }
     catch(const exception& e) {
@@ -0,0 +1,301 @@
+/* -------------------------------------------------------------------------- *
+ *                                   OpenMM                                   *
+ * -------------------------------------------------------------------------- *
+ * This is part of the OpenMM molecular simulation toolkit originating from   *
+ * Simbios, the NIH National Center for Physics-Based Simulation of           *
+ * Biological Structures at Stanford, funded under the NIH Roadmap for        *
+ * Medical Research, grant U54 GM072970. See https://simtk.org.               *
+ *                                                                            *
+ * Portions copyright (c) 2026 Stanford University and the Authors.           *
+ * Authors: Peter Eastman                                                     *
+ * Contributors:                                                              *
+ *                                                                            *
+ * Permission is hereby granted, free of charge, to any person obtaining a    *
+ * copy of this software and associated documentation files (the "Software"), *
+ * to deal in the Software without restriction, including without limitation  *
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,   *
+ * and/or sell copies of the Software, and to permit persons to whom the      *
+ * Software is furnished to do so, subject to the following conditions:       *
+ *                                                                            *
+ * The above copyright notice and this permission notice shall be included in *
+ * all copies or substantial portions of the Software.                        *
+ *                                                                            *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,   *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL    *
+ * THE AUTHORS, CONTRIBUTORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,    *
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR      *
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE  *
+ * USE OR OTHER DEALINGS IN THE SOFTWARE.                                     *
+ * -------------------------------------------------------------------------- */
+
+#include "openmm/internal/AssertionUtilities.h"
+#include "openmm/Context.h"
+#include "openmm/CustomExternalForce.h"
+#include "openmm/CustomIntegrator.h"
+#include "openmm/HarmonicBondForce.h"
+#include "openmm/NonbondedForce.h"
+#include "openmm/System.h"
+#include "openmm/MTSLangevinIntegrator.h"
+#include "SimTKOpenMMRealType.h"
+#include "sfmt/SFMT.h"
+#include <iostream>
+#include <vector>
+
+using namespace OpenMM;
+using namespace std;
+
+/**
+ * Build a CustomIntegrator that implements the same algorithm as MTSLangevinIntegrator
+ * with zero friction.
+ */
+void addSubsteps(CustomIntegrator& integrator, int parentSubsteps, const vector<pair<int, int> >& groups, int level) {
+    int group = groups[level].first;
+    int substeps = groups[level].second;
+    string f = "f"+to_string(group);
+    string dt = "(dt/"+to_string(substeps)+")";
+    for (int i = 0; i < substeps/parentSubsteps; i++) {
+        integrator.addComputePerDof("v", "v+0.5*"+dt+"*"+f+"/m");
+        if (level == groups.size()-1) {
+            integrator.addComputePerDof("x", "x+"+dt+"*v");
+            integrator.addComputePerDof("x1", "x");
+            integrator.addConstrainPositions();
+            integrator.addComputePerDof("v", "v+(x-x1)/"+dt);
+            integrator.addConstrainVelocities();
+        }
+        else
+            addSubsteps(integrator, substeps, groups, level+1);
+        integrator.addComputePerDof("v", "v+0.5*"+dt+"*"+f+"/m");
+    }
+}
+
+System* createMultipleGroupSystem(vector<Vec3>& positions) {
+    const int numParticles = 20;
+    const double boxSize = 3.0;
+    System* system = new System();
+    system->setDefaultPeriodicBoxVectors(Vec3(boxSize, 0, 0), Vec3(0, boxSize, 0), Vec3(0, 0, boxSize));
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.0);
+    nonbonded->setForceGroup(1);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    CustomExternalForce* external = new CustomExternalForce("0.5*(x^2+y^2+z^2)");
+    external->setForceGroup(2);
+    OpenMM_SFMT::SFMT sfmt;
+    init_gen_rand(0, sfmt);
+    for (int i = 0; i < numParticles; i++) {
+        system->addParticle(i%2 == 0 ? 10.0 : 1.0);
+        nonbonded->addParticle((i%2 == 0 ? 0.2 : -0.2), 0.3, 0.5);
+        external->addParticle(i);
+        if (i%2 == 0)
+            positions.push_back(Vec3(boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt), boxSize*genrand_real2(sfmt)));
+        else
+            positions.push_back(positions[i-1]+Vec3(0.1, 0, 0));
+    }
+    for (int i = 0; i < numParticles; i += 2) {
+        if (i%4 == 0) {
+            bonds->addBond(i, i+1, 0.1, 5000.0);
+            nonbonded->addException(i, i+1, 0.0, 1.0, 0.0);
+        }
+        else {
+            system->addConstraint(i, i+1, 0.1);
+            nonbonded->addException(i, i+1, 0.0, 1.0, 0.0);
+        }
+    }
+    system->addForce(nonbonded);
+    system->addForce(bonds);
+    system->addForce(external);
+    return system;
+}
+
+void testCompareToCustomIntegrator() {
+    vector<Vec3> positions;
+    System* system = createMultipleGroupSystem(positions);
+    vector<pair<int, int> > groups = {{1, 1}, {0, 2}, {2, 4}};
+    const double dt = 0.004;
+    MTSLangevinIntegrator integrator1(0.0, 0.0, dt, groups);
+    CustomIntegrator integrator2(dt);
+    integrator2.addPerDofVariable("x1", 0);
+    integrator2.addUpdateContextState();
+    addSubsteps(integrator2, 1, groups, 0);
+    integrator2.addConstrainVelocities();
+    Context context1(*system, integrator1, platform);
+    Context context2(*system, integrator2, platform);
+    context1.setPositions(positions);
+    context2.setPositions(positions);
+    context1.setVelocitiesToTemperature(300.0, 1);
+    context2.setVelocities(context1.getState(State::Velocities).getVelocities());
+
+    // With no friction, the two integrators should produce identical trajectories.
+
+    for (int i = 0; i < 10; i++) {
+        integrator1.step(5);
+        integrator2.step(5);
+        State state1 = context1.getState(State::Positions | State::Velocities);
+        State state2 = context2.getState(State::Positions | State::Velocities);
+        for (int j = 0; j < system->getNumParticles(); j++) {
+            ASSERT_EQUAL_VEC(state2.getPositions()[j], state1.getPositions()[j], 1e-5);
+            ASSERT_EQUAL_VEC(state2.getVelocities()[j], state1.getVelocities()[j], 1e-4);
+        }
+
+        // Querying forces should not disturb the forces cached by the integrator.
+
+        context1.getState(State::Forces, false, 1<<0);
+    }
+    delete system;
+}
+
+void testTemperature() {
+    const int numParticles = 8;
+    const double temp = 100.0;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(5, 0, 0), Vec3(0, 5, 0), Vec3(0, 0, 5));
+    MTSLangevinIntegrator integrator(temp, 3.0, 0.02, {{0, 1}, {1, 2}});
+    NonbondedForce* forceField = new NonbondedForce();
+    forceField->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    CustomExternalForce* external = new CustomExternalForce("0.1*(x^2+y^2+z^2)");
+    external->setForceGroup(1);
+    for (int i = 0; i < numParticles; ++i) {
+        system.addParticle(2.0);
+        forceField->addParticle((i%2 == 0 ? 1.0 : -1.0), 1.0, 5.0);
+        external->addParticle(i);
+    }
+    system.addForce(forceField);
+    system.addForce(external);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        positions[i] = Vec3((i%2 == 0 ? 2 : -2), (i%4 < 2 ? 2 : -2), (i < 4 ? 2 : -2));
+    context.setPositions(positions);
+    
+    // Let it equilibrate.
+    
+    integrator.step(2500);
+    
+    // Now run it for a while and see if the temperature is correct.
+    
+    double ke = 0.0;
+    int steps = 5000;
+    for (int i = 0; i < steps; ++i) {
+        State state = context.getState(State::Energy);
+        ke += state.getKineticEnergy();
+        integrator.step(1);
+    }
+    ke /= steps;
+    double expected = 0.5*numParticles*3*BOLTZ*temp;
+    ASSERT_USUALLY_EQUAL_TOL(expected, ke, 6/std::sqrt((double) steps));
+}
+
+void testConstraints() {
+    vector<Vec3> positions;
+    System* system = createMultipleGroupSystem(positions);
+    MTSLangevinIntegrator integrator(300.0, 2.0, 0.004, {{1, 1}, {0, 2}, {2, 4}});
+    integrator.setConstraintTolerance(1e-5);
+    Context context(*system, integrator, platform);
+    context.setPositions(positions);
+    context.setVelocitiesToTemperature(300.0);
+
+    // Simulate it and see whether the constraints remain satisfied.
+
+    for (int i = 0; i < 500; ++i) {
+        integrator.step(1);
+        State state = context.getState(State::Positions);
+        for (int j = 0; j < system->getNumConstraints(); ++j) {
+            int particle1, particle2;
+            double distance;
+            system->getConstraintParameters(j, particle1, particle2, distance);
+            Vec3 delta = state.getPositions()[particle1]-state.getPositions()[particle2];
+            ASSERT_EQUAL_TOL(distance, sqrt(delta.dot(delta)), 1e-4);
+        }
+    }
+    delete system;
+}
+
+void testRandomSeed() {
+    vector<Vec3> positions;
+    System* system = createMultipleGroupSystem(positions);
+    MTSLangevinIntegrator integrator(300.0, 2.0, 0.004, {{1, 1}, {0, 2}});
+    vector<Vec3> velocities(system->getNumParticles(), Vec3());
+
+    // Try twice with the same random seed, then once with a different one.
+
+    integrator.setRandomNumberSeed(5);
+    Context context(*system, integrator, platform);
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+    integrator.step(10);
+    State state1 = context.getState(State::Positions);
+    context.reinitialize();
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+    integrator.step(10);
+    State state2 = context.getState(State::Positions);
+    integrator.setRandomNumberSeed(10);
+    context.reinitialize();
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+    integrator.step(10);
+    State state3 = context.getState(State::Positions);
+    for (int i = 0; i < system->getNumParticles(); i++) {
+        for (int j = 0; j < 3; j++) {
+            ASSERT_EQUAL_TOL(state1.getPositions()[i][j], state2.getPositions()[i][j], 1e-6);
+            ASSERT(state1.getPositions()[i][j] != state3.getPositions()[i][j]);
+        }
+    }
+    delete system;
+}
+
+void testInvalidGroups() {
+    bool failed = false;
+    try {
+        MTSLangevinIntegrator integrator(300.0, 1.0, 0.004, {});
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+    failed = false;
+    try {
+        MTSLangevinIntegrator integrator(300.0, 1.0, 0.004, {{0, 2}, {1, 3}});
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+    failed = false;
+    try {
+        MTSLangevinIntegrator integrator(300.0, 1.0, 0.004, {{32, 1}});
+    }
+    catch (OpenMMException& ex) {
+        failed = true;
+    }
+    ASSERT(failed);
+
+    // Groups should be sorted by number of substeps.
+
+    MTSLangevinIntegrator integrator(300.0, 1.0, 0.004, {{2, 4}, {0, 1}, {1, 2}});
+    ASSERT_EQUAL(3, integrator.getGroups().size());
+    ASSERT_EQUAL(0, integrator.getGroups()[0].first);
+    ASSERT_EQUAL(1, integrator.getGroups()[1].first);
+    ASSERT_EQUAL(2, integrator.getGroups()[2].first);
+}
+
+void runPlatformTests();
+
+int main(int argc, char* argv[]) {
+    try {
+        initializeTests(argc, argv);
+        testCompareToCustomIntegrator();
+        testTemperature();
+        testConstraints();
+        testRandomSeed();
+        testInvalidGroups();
+        runPlatformTests();
+    }
+    catch(const exception& e) {
+        cout << "exception: " << e.what() << endl;
+        return 1;
+    }
+    cout << "Done" << endl;
+    return 0;
+}
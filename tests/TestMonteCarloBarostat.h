@@ -32,6 +32,7 @@
 #include "openmm/internal/AssertionUtilities.h"
 #include "openmm/MonteCarloBarostat.h"
 #include "openmm/Context.h"
+#include "openmm/HarmonicAngleForce.h"
 #include "openmm/HarmonicBondForce.h"
 #include "openmm/NonbondedForce.h"
 #include "openmm/System.h"
@@ -268,6 +269,64 @@ void testWater() {
     ASSERT_USUALLY_EQUAL_TOL(1.0, density, 0.02);
 }
 
+void testIncrementalEnergy() {
+    // Simulate a system of diatomic molecules, where the bonds are in a separate force group and can be
+    // skipped by the barostat.  An angle force spanning several molecules must still be included.  The
+    // trajectory should be the same whether or not incremental energies are used.
+
+    const int numMolecules = 20;
+    const double temp = 300.0;
+    const double pressure = 1.5;
+    System system;
+    system.setDefaultPeriodicBoxVectors(Vec3(4, 0, 0), Vec3(0, 4, 0), Vec3(0, 0, 4));
+    VerletIntegrator integrator(0.001);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    nonbonded->setNonbondedMethod(NonbondedForce::CutoffPeriodic);
+    nonbonded->setCutoffDistance(1.5);
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    bonds->setForceGroup(1);
+    HarmonicAngleForce* angles = new HarmonicAngleForce();
+    angles->setForceGroup(2);
+    vector<Vec3> positions;
+    for (int i = 0; i < numMolecules; i++) {
+        system.addParticle(10.0);
+        system.addParticle(10.0);
+        nonbonded->addParticle(0.2, 0.3, 0.5);
+        nonbonded->addParticle(-0.2, 0.3, 0.5);
+        nonbonded->addException(2*i, 2*i+1, 0.0, 1.0, 0.0);
+        bonds->addBond(2*i, 2*i+1, 0.12, 1000.0);
+        Vec3 pos((i%3)*1.3, ((i/3)%3)*1.3, (i/9)*1.3);
+        positions.push_back(pos);
+        positions.push_back(pos+Vec3(0.1, 0.05, 0));
+    }
+    angles->addAngle(0, 2, 4, 2.0, 10.0);
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    system.addForce(angles);
+    MonteCarloBarostat* barostat = new MonteCarloBarostat(pressure, temp, 1);
+    barostat->setRandomNumberSeed(5);
+    system.addForce(barostat);
+    vector<Vec3> velocities(system.getNumParticles(), Vec3());
+    Context context(system, integrator, platform);
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+    integrator.step(20);
+    State state1 = context.getState(State::Positions);
+    barostat->setUseIncrementalEnergy(true);
+    context.reinitialize();
+    context.setPositions(positions);
+    context.setVelocities(velocities);
+    integrator.step(20);
+    State state2 = context.getState(State::Positions);
+    Vec3 box1[3], box2[3];
+    state1.getPeriodicBoxVectors(box1[0], box1[1], box1[2]);
+    state2.getPeriodicBoxVectors(box2[0], box2[1], box2[2]);
+    ASSERT(box1[0][0] != 4.0);
+    ASSERT_EQUAL_TOL(box1[0][0], box2[0][0], 1e-5);
+    for (int i = 0; i < system.getNumParticles(); i++)
+        ASSERT_EQUAL_VEC(state1.getPositions()[i], state2.getPositions()[i], 1e-5);
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -276,6 +335,7 @@ int main(int argc, char* argv[]) {
         testChangingBoxSize();
         testIdealGas();
         testRandomSeed();
+        testIncrementalEnergy();
         // Don't run testWater() here, because it's very slow on Reference platform.
         // Individual platforms can run it from runPlatformTests().
         runPlatformTests();
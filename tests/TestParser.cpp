@@ -114,6 +114,35 @@ void verifyEvaluation(const string& expression, double x, double y, double expec
     ASSERT_EQUAL(&x, &compiled2.getVariableReference("x"));
     ASSERT_EQUAL(&y, &compiled2.getVariableReference("y"));
 
+    // Create a CompiledVectorExpression for each supported width and make sure every element of the
+    // result is correct.
+
+    for (int width : CompiledVectorExpression::getAllowedWidths()) {
+        CompiledVectorExpression vectorCompiled = parsed.createCompiledVectorExpression(width);
+        ASSERT_EQUAL(width, vectorCompiled.getWidth());
+        if (vectorCompiled.getVariables().find("x") != vectorCompiled.getVariables().end())
+            for (int i = 0; i < width; i++)
+                vectorCompiled.getVariablePointer("x")[i] = (float) x;
+        if (vectorCompiled.getVariables().find("y") != vectorCompiled.getVariables().end())
+            for (int i = 0; i < width; i++)
+                vectorCompiled.getVariablePointer("y")[i] = (float) y;
+        const float* result = vectorCompiled.evaluate();
+        for (int i = 0; i < width; i++)
+            ASSERT_EQUAL_TOL(expectedValue, result[i], 1e-5);
+
+        // Try specifying memory locations for the variables.
+
+        vector<float> xvec(width, (float) x), yvec(width, (float) y);
+        map<string, float*> vectorPointers;
+        vectorPointers["x"] = &xvec[0];
+        vectorPointers["y"] = &yvec[0];
+        CompiledVectorExpression vectorCompiled2 = parsed.createCompiledVectorExpression(width);
+        vectorCompiled2.setVariableLocations(vectorPointers);
+        result = vectorCompiled2.evaluate();
+        for (int i = 0; i < width; i++)
+            ASSERT_EQUAL_TOL(expectedValue, result[i], 1e-5);
+    }
+
     // Make sure that variable renaming works.
 
     variables.clear();
@@ -125,6 +154,30 @@ void verifyEvaluation(const string& expression, double x, double y, double expec
     ASSERT_EQUAL_TOL(expectedValue, value, 1e-10);
 }
 
+/**
+ * Verify that a CompiledVectorExpression computes each element of a vector independently.
+ */
+
+void verifyVectorEvaluation(const string& expression) {
+    ParsedExpression parsed = Parser::parse(expression);
+    for (int width : CompiledVectorExpression::getAllowedWidths()) {
+        CompiledVectorExpression compiled = parsed.createCompiledVectorExpression(width);
+        float* x = compiled.getVariablePointer("x");
+        float* y = compiled.getVariablePointer("y");
+        for (int i = 0; i < width; i++) {
+            x[i] = 0.5f*i-1.2f;
+            y[i] = 0.3f*i+0.1f;
+        }
+        const float* result = compiled.evaluate();
+        for (int i = 0; i < width; i++) {
+            map<string, double> variables;
+            variables["x"] = 0.5f*i-1.2f;
+            variables["y"] = 0.3f*i+0.1f;
+            ASSERT_EQUAL_TOL(parsed.evaluate(variables), result[i], 1e-5);
+        }
+    }
+}
+
 /**
  * Confirm that a parse error gets thrown.
  */
@@ -268,6 +321,9 @@ int main() {
         verifyEvaluation("atan2(x, y)", 3.0, 1.5, std::atan(2.0));
         verifyEvaluation("sqrt(x^2)", -2.2, 0.0, 2.2);
         verifyEvaluation("sqrt(x)^2", 2.2, 0.0, 2.2);
+        verifyVectorEvaluation("x*exp(-y)+abs(x)^3-step(x)*y");
+        verifyVectorEvaluation("select(step(x), sqrt(y), floor(x))+min(x, y)/max(y, 0.5)");
+        verifyVectorEvaluation("erfc(y)*atan2(x, y)+x^-2+sin(x)*cos(y)");
         verifyInvalidExpression("1..2");
         verifyInvalidExpression("1*(2+3");
         verifyInvalidExpression("5++4");
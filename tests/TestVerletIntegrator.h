@@ -39,6 +39,7 @@
 #include "SimTKOpenMMRealType.h"
 #include "sfmt/SFMT.h"
 #include <iostream>
+#include <map>
 #include <vector>
 
 using namespace OpenMM;
@@ -326,6 +327,64 @@ void testForceGroups() {
     ASSERT(pos[2] == 0);
 }
 
+void testTimingReport() {
+    const int numParticles = 8;
+    System system;
+    VerletIntegrator integrator(0.001);
+    NonbondedForce* nonbonded = new NonbondedForce();
+    HarmonicBondForce* bonds = new HarmonicBondForce();
+    for (int i = 0; i < numParticles; ++i) {
+        system.addParticle(i%2 == 0 ? 5.0 : 10.0);
+        nonbonded->addParticle((i%2 == 0 ? 0.2 : -0.2), 0.5, 5.0);
+    }
+    system.addConstraint(0, 1, 1.0);
+    system.addConstraint(1, 2, 1.0);
+    system.addConstraint(2, 3, 1.0);
+    bonds->addBond(4, 5, 1.0, 100.0);
+    bonds->addBond(6, 7, 1.0, 100.0);
+    system.addForce(nonbonded);
+    system.addForce(bonds);
+    Context context(system, integrator, platform);
+    vector<Vec3> positions(numParticles);
+    for (int i = 0; i < numParticles; ++i)
+        positions[i] = Vec3(i/2, (i+1)/2, 0);
+    context.setPositions(positions);
+
+    // Nothing should be timed until timing is enabled.
+
+    ASSERT(!context.getTimingEnabled());
+    integrator.step(5);
+    map<string, double> report = context.getTimingReport();
+    ASSERT(report.find("Force Evaluations") == report.end());
+    ASSERT(report.find("Integrate") == report.end());
+
+    // Enable it and check that every step was recorded.
+
+    context.setTimingEnabled(true);
+    ASSERT(context.getTimingEnabled());
+    context.resetTimingReport();
+    integrator.step(10);
+    report = context.getTimingReport();
+    ASSERT_EQUAL(10.0, report["Force Evaluations"]);
+    for (string name : {"Integrate", "Update Context State", "Begin Force Computation", "Finish Force Computation", "NonbondedForce", "HarmonicBondForce"}) {
+        ASSERT(report.find(name) != report.end());
+        ASSERT(report[name] >= 0.0);
+    }
+    if (report.find("Constraint Iterations") != report.end()) {
+        ASSERT(report["Constraint Applications"] >= 10.0);
+        ASSERT(report["Constraint Iterations"] > 0.0);
+    }
+
+    // Resetting it should discard everything recorded so far.
+
+    context.resetTimingReport();
+    context.setTimingEnabled(false);
+    integrator.step(5);
+    report = context.getTimingReport();
+    ASSERT(report.find("Force Evaluations") == report.end());
+    ASSERT(report.find("Integrate") == report.end());
+}
+
 void runPlatformTests();
 
 int main(int argc, char* argv[]) {
@@ -339,6 +398,7 @@ int main(int argc, char* argv[]) {
         testConstrainedChain(1500);
         testInitialTemperature();
         testForceGroups();
+        testTimingReport();
         runPlatformTests();
     }
     catch(const exception& e) {
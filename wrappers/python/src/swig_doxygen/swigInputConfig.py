@@ -19,6 +19,12 @@ SKIP_METHODS = [('State', 'getPositions'),
                 ('StateBuilder',),
                 ('Vec3',),
                 ('OpenMMException',),
+                ('MTSLangevinIntegrator',),
+                ('State', 'getRawData'),
+                ('Context', 'getState', 4),
+                ('BinarySerializer',),
+                ('CheckpointReader',),
+                ('CheckpointWriter',),
                 ('AngleInfo',),
                 ('ApplyAndersenThermostatKernel',),
                 ('ApplyConstraintsKernel',),
@@ -94,6 +100,9 @@ SKIP_METHODS = [('State', 'getPositions'),
                 ('Platform', 'registerStreamFactory'),
                 ('Platform', 'contextCreated'),
                 ('Platform', 'contextDestroyed'),
+                ('Platform', 'synchronizeContext'),
+                ('LocalEnergyMinimizer', 'minimizeBatch'),
+                ('Platform', 'getTimingStatistics'),
                 ('Platform', 'createKernel'),
                 ('Platform', 'registerKernelFactory'),
                 ('IntegrateRPMDStepKernel',),